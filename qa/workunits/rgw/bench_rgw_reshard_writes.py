@@ -0,0 +1,116 @@
+#!/usr/bin/python3
+
+import argparse
+import logging as log
+import subprocess
+import threading
+import time
+import boto3
+
+"""
+Measure the latency of object writes to a bucket while it is being resharded.
+
+Fills a bucket, keeps a number of writers uploading small objects into it,
+reshards it with radosgw-admin, and reports the write latencies observed
+before, during and after the reshard. Run it against a running instance
+with and without rgw_reshard_log_writes to compare.
+"""
+
+log.basicConfig(level=log.INFO)
+log.getLogger('botocore').setLevel(log.CRITICAL)
+log.getLogger('boto3').setLevel(log.CRITICAL)
+log.getLogger('urllib3').setLevel(log.CRITICAL)
+
+USER = 'tester'
+DISPLAY_NAME = 'Testing'
+ACCESS_KEY = 'NX5QOQKC6BH2IDN8HC7A'
+SECRET_KEY = 'LnEsqNNqZIpkzauboDcLXLcYaWwLQ3Kop0zAnKIn'
+
+
+def exec_cmd(cmd):
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, shell=True)
+    if proc.returncode != 0:
+        raise Exception("error: %s \nreturncode: %s" % (proc.stderr, proc.returncode))
+    return proc.stdout
+
+
+def percentile(sorted_samples, p):
+    if not sorted_samples:
+        return 0.0
+    idx = min(len(sorted_samples) - 1, int(len(sorted_samples) * p / 100))
+    return sorted_samples[idx]
+
+
+def report(phase, samples):
+    lat = sorted(ms for _, ms in samples)
+    log.info('%-7s writes %6d  p50 %8.2fms  p99 %8.2fms  p99.9 %8.2fms  max %8.2fms',
+             phase, len(lat), percentile(lat, 50), percentile(lat, 99),
+             percentile(lat, 99.9), lat[-1] if lat else 0.0)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--endpoint', default='http://localhost:80')
+    parser.add_argument('--bucket', default='reshard-bench')
+    parser.add_argument('--prefill', type=int, default=100000,
+                        help='objects written before resharding')
+    parser.add_argument('--writers', type=int, default=16)
+    parser.add_argument('--num-shards', type=int, default=101)
+    parser.add_argument('--settle', type=float, default=10.0,
+                        help='seconds measured before and after the reshard')
+    args = parser.parse_args()
+
+    exec_cmd('radosgw-admin user create --uid %s --display-name %s --access-key %s --secret %s'
+             % (USER, DISPLAY_NAME, ACCESS_KEY, SECRET_KEY))
+    session = boto3.session.Session()
+
+    def client():
+        return session.client('s3', aws_access_key_id=ACCESS_KEY,
+                              aws_secret_access_key=SECRET_KEY,
+                              endpoint_url=args.endpoint, verify=False)
+
+    s3 = client()
+    s3.create_bucket(Bucket=args.bucket)
+
+    log.info('writing %d objects', args.prefill)
+    for i in range(args.prefill):
+        s3.put_object(Bucket=args.bucket, Key='prefill-%08d' % i, Body=b'')
+
+    samples = []
+    lock = threading.Lock()
+    stop = threading.Event()
+
+    def writer(n):
+        c = client()
+        i = 0
+        while not stop.is_set():
+            start = time.monotonic()
+            c.put_object(Bucket=args.bucket, Key='w%d-%08d' % (n, i), Body=b'x' * 128)
+            end = time.monotonic()
+            with lock:
+                samples.append((end, (end - start) * 1000))
+            i += 1
+
+    threads = [threading.Thread(target=writer, args=(n,)) for n in range(args.writers)]
+    for t in threads:
+        t.start()
+
+    time.sleep(args.settle)
+    reshard_start = time.monotonic()
+    exec_cmd('radosgw-admin bucket reshard --bucket %s --num-shards %d --yes-i-really-mean-it'
+             % (args.bucket, args.num_shards))
+    reshard_end = time.monotonic()
+    time.sleep(args.settle)
+
+    stop.set()
+    for t in threads:
+        t.join()
+
+    log.info('reshard to %d shards took %.2fs', args.num_shards, reshard_end - reshard_start)
+    report('before', [s for s in samples if s[0] < reshard_start])
+    report('during', [s for s in samples if reshard_start <= s[0] < reshard_end])
+    report('after', [s for s in samples if s[0] >= reshard_end])
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,177 @@
+#!/usr/bin/python3
+
+import logging as log
+import subprocess
+import boto3
+import botocore.exceptions
+
+"""
+Rgw ordered bucket listing over unevenly filled index shards
+"""
+# The test cases in this file have been annotated for inventory.
+# To extract the inventory (in csv format) use the command:
+#
+#   grep '^ *# TESTCASE' | sed 's/^ *# TESTCASE //'
+#
+#
+
+log.basicConfig(level=log.DEBUG)
+log.getLogger('botocore').setLevel(log.CRITICAL)
+log.getLogger('boto3').setLevel(log.CRITICAL)
+log.getLogger('urllib3').setLevel(log.CRITICAL)
+
+""" Constants """
+USER = 'lister'
+DISPLAY_NAME = 'Listing'
+ACCESS_KEY = 'K2DPNJDFDOXLSNEOVBSB'
+SECRET_KEY = 'e1pIgbTWsJKxfYTWwHRuSvPNyNa3VWv8UF4lf8Ot'
+BUCKET_NAME = 'unevenshards'
+NUM_SHARDS = 11
+# the shard which gets most of the objects
+HOT_SHARD = 3
+HOT_OBJS = 300
+PAGE_SIZE = 100
+
+
+def exec_cmd(cmd):
+    log.debug('running %s', cmd)
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, shell=True)
+    if proc.returncode != 0:
+        raise Exception("error: %s \nreturncode: %s" % (proc.stderr, proc.returncode))
+    return proc.stdout
+
+
+def bucket_shard_index(key, num_shards):
+    """
+    the index shard of an object, as RGWSI_BucketIndex_RADOS::bucket_shard_index()
+    """
+    sid = 0
+    for c in key.encode():
+        sid = ((sid + (c << 4) + (c >> 4)) * 11) & 0xffffffff
+    sid2 = (sid ^ ((sid & 0xff) << 24)) & 0xffffffff
+    prime = 7877 if num_shards <= 7877 else 65521
+    return sid2 % prime % num_shards
+
+
+def make_keys():
+    """
+    HOT_OBJS keys on HOT_SHARD, one or two on each of the other shards, all
+    of them interleaved in lexical order. Half of the hot keys are under
+    "subdirectories".
+    """
+    hot = []
+    cold = {}
+    i = 0
+    while len(hot) < HOT_OBJS or len(cold) < NUM_SHARDS - 1:
+        key = 'obj-%06d' % i if i % 2 else 'dir-%03d/obj-%06d' % (i % 40, i)
+        shard = bucket_shard_index(key, NUM_SHARDS)
+        if shard == HOT_SHARD:
+            if len(hot) < HOT_OBJS:
+                hot.append(key)
+        elif len(cold.get(shard, [])) < 2:
+            cold.setdefault(shard, []).append(key)
+        i += 1
+    return sorted(hot + [k for keys in cold.values() for k in keys])
+
+
+def list_all(bucket, **kwargs):
+    """
+    lists the bucket a page at a time, passing the last key (or common
+    prefix) of a page as the marker of the next one
+    """
+    keys = []
+    prefixes = []
+    pages = []
+    marker = ''
+    while True:
+        resp = bucket.meta.client.list_objects(Bucket=bucket.name, Marker=marker,
+                                               MaxKeys=PAGE_SIZE, **kwargs)
+        page = [o['Key'] for o in resp.get('Contents', [])]
+        page_prefixes = [p['Prefix'] for p in resp.get('CommonPrefixes', [])]
+        entries = sorted(page + page_prefixes)
+        # entries are returned in order, after the marker
+        assert entries == sorted(set(entries)), 'duplicates in a page'
+        if marker and entries:
+            assert entries[0] > marker, \
+                'page starts at %s, not after marker %s' % (entries[0], marker)
+        assert page == sorted(page), 'page not in order'
+        keys += page
+        prefixes += page_prefixes
+        pages.append(len(entries))
+        if not resp['IsTruncated']:
+            break
+        marker = resp.get('NextMarker', entries[-1] if entries else marker)
+        assert marker == entries[-1], \
+            'next marker %s is not the last entry %s' % (marker, entries[-1])
+    return keys, prefixes, pages
+
+
+def main():
+    """
+    list a bucket whose entries are mostly on one index shard
+    """
+    exec_cmd('radosgw-admin user create --uid %s --display-name %s --access-key %s --secret %s'
+             % (USER, DISPLAY_NAME, ACCESS_KEY, SECRET_KEY))
+
+    def boto_connect(portnum, ssl, proto):
+        endpoint = proto + '://localhost:' + portnum
+        conn = boto3.resource('s3',
+                              aws_access_key_id=ACCESS_KEY,
+                              aws_secret_access_key=SECRET_KEY,
+                              use_ssl=ssl,
+                              endpoint_url=endpoint,
+                              verify=False,
+                              config=None,
+                              )
+        try:
+            list(conn.buckets.limit(1)) # just verify we can list buckets
+        except botocore.exceptions.ConnectionError as e:
+            print(e)
+            raise
+        print('connected to', endpoint)
+        return conn
+
+    try:
+        connection = boto_connect('80', False, 'http')
+    except botocore.exceptions.ConnectionError:
+        try: # retry on non-privileged http port
+            connection = boto_connect('8000', False, 'http')
+        except botocore.exceptions.ConnectionError:
+            # retry with ssl
+            connection = boto_connect('443', True, 'https')
+
+    bucket = connection.create_bucket(Bucket=BUCKET_NAME)
+    exec_cmd('radosgw-admin bucket reshard --bucket %s --num-shards %d'
+             % (BUCKET_NAME, NUM_SHARDS))
+
+    keys = make_keys()
+    for key in keys:
+        connection.Object(BUCKET_NAME, key).put(Body=b"")
+
+    # TESTCASE 'uneven-shards','bucket','list','ordered listing with one hot shard','succeeds'
+    log.debug(' test: ordered listing of uneven shards')
+    listed, prefixes, pages = list_all(bucket)
+    assert not prefixes
+    assert listed == keys, 'listing differs from the objects written'
+    # the hot shard is refilled rather than cutting the pages short
+    assert all(n == PAGE_SIZE for n in pages[:-1]), 'short pages: %s' % pages
+
+    # TESTCASE 'uneven-shards-delimiter','bucket','list','delimiter listing with one hot shard','succeeds'
+    log.debug(' test: delimiter listing of uneven shards')
+    listed, prefixes, pages = list_all(bucket, Delimiter='/')
+    assert listed == [k for k in keys if '/' not in k]
+    assert prefixes == sorted(set(k.split('/')[0] + '/' for k in keys if '/' in k))
+
+    # TESTCASE 'uneven-shards-prefix','bucket','list','prefix listing with one hot shard','succeeds'
+    log.debug(' test: prefix listing of uneven shards')
+    listed, prefixes, pages = list_all(bucket, Prefix='dir-01')
+    assert listed == [k for k in keys if k.startswith('dir-01')]
+
+    # Clean up
+    log.debug("Deleting bucket %s", BUCKET_NAME)
+    bucket.objects.all().delete()
+    bucket.delete()
+
+
+main()
+log.info("Completed bucket listing tests")
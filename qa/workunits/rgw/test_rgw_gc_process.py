@@ -0,0 +1,142 @@
+#!/usr/bin/python3
+
+import logging as log
+import json
+import subprocess
+import boto3
+import botocore.exceptions
+
+"""
+Rgw garbage collection over several shards processed concurrently
+"""
+# The test cases in this file have been annotated for inventory.
+# To extract the inventory (in csv format) use the command:
+#
+#   grep '^ *# TESTCASE' | sed 's/^ *# TESTCASE //'
+#
+#
+
+log.basicConfig(level=log.DEBUG)
+log.getLogger('botocore').setLevel(log.CRITICAL)
+log.getLogger('boto3').setLevel(log.CRITICAL)
+log.getLogger('urllib3').setLevel(log.CRITICAL)
+
+""" Constants """
+USER = 'collector'
+DISPLAY_NAME = 'Collector'
+ACCESS_KEY = 'PGM4J5LOIT0VGH2IZY1A'
+SECRET_KEY = 'nCSa2BD1b3Fgs0Phq1Nx6xW5pNrcfOKwi7lb7ZCu'
+BUCKET_NAME = 'gcshards'
+DATA_POOL = 'default.rgw.buckets.data'
+# larger than rgw_max_chunk_size, so that each object has a tail
+OBJ_SIZE = 4 * 1024 * 1024 + 1024
+NUM_OBJS = 40
+# a batch which doesn't divide the entries of a shard, so that some are
+# left to trim when the shard is done
+GC_OPTS = '--rgw_gc_max_concurrent_shards=4 --rgw_gc_queue_trim_batch=3 ' \
+          '--rgw_gc_max_concurrent_io=4'
+
+
+def exec_cmd(cmd):
+    log.debug('running %s', cmd)
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, shell=True)
+    if proc.returncode != 0:
+        raise Exception("error: %s \nreturncode: %s" % (proc.stderr, proc.returncode))
+    return proc.stdout
+
+
+def gc_list():
+    """
+    the gc entries, expired or not
+    """
+    return json.loads(exec_cmd('radosgw-admin gc list --include-all'))
+
+
+def tail_objs():
+    """
+    the tail objects in the data pool
+    """
+    objs = exec_cmd('rados -p %s ls' % DATA_POOL).decode().split()
+    return [o for o in objs if '_shadow_' in o]
+
+
+def main():
+    """
+    remove the tails of many deleted objects with concurrent gc shards
+    """
+    exec_cmd('radosgw-admin user create --uid %s --display-name %s --access-key %s --secret %s'
+             % (USER, DISPLAY_NAME, ACCESS_KEY, SECRET_KEY))
+
+    def boto_connect(portnum, ssl, proto):
+        endpoint = proto + '://localhost:' + portnum
+        conn = boto3.resource('s3',
+                              aws_access_key_id=ACCESS_KEY,
+                              aws_secret_access_key=SECRET_KEY,
+                              use_ssl=ssl,
+                              endpoint_url=endpoint,
+                              verify=False,
+                              config=None,
+                              )
+        try:
+            list(conn.buckets.limit(1)) # just verify we can list buckets
+        except botocore.exceptions.ConnectionError as e:
+            print(e)
+            raise
+        print('connected to', endpoint)
+        return conn
+
+    try:
+        connection = boto_connect('80', False, 'http')
+    except botocore.exceptions.ConnectionError:
+        try: # retry on non-privileged http port
+            connection = boto_connect('8000', False, 'http')
+        except botocore.exceptions.ConnectionError:
+            # retry with ssl
+            connection = boto_connect('443', True, 'https')
+
+    # flush what earlier tests left to collect
+    exec_cmd('radosgw-admin gc process --include-all')
+    tails_before = set(tail_objs())
+
+    bucket = connection.create_bucket(Bucket=BUCKET_NAME)
+    body = b'g' * OBJ_SIZE
+    keys = ['obj-%03d' % i for i in range(NUM_OBJS)]
+    for key in keys:
+        connection.Object(BUCKET_NAME, key).put(Body=body)
+    tails = set(tail_objs()) - tails_before
+    assert len(tails) >= NUM_OBJS, 'objects written without tails'
+
+    for key in keys:
+        connection.Object(BUCKET_NAME, key).delete()
+    # the entries are spread over several gc shards
+    entries = gc_list()
+    assert len(entries) == NUM_OBJS, \
+        '%d gc entries for %d objects' % (len(entries), NUM_OBJS)
+    for entry in entries:
+        assert entry['chain']['objs'], 'gc entry %s without tails' % entry['tag']
+
+    # TESTCASE 'gc-concurrent-shards','gc','process','tails removed by concurrent shards','succeeds'
+    log.debug(' test: gc process with concurrent shards')
+    exec_cmd('radosgw-admin gc process --include-all ' + GC_OPTS)
+    left = tails & set(tail_objs())
+    assert not left, 'tails left after gc: %s' % sorted(left)
+
+    # TESTCASE 'gc-trim-batch','gc','process','processed entries trimmed in batches','succeeds'
+    log.debug(' test: gc entries trimmed in batches')
+    # the entries processed since the last batch are trimmed as well
+    entries = gc_list()
+    assert not entries, 'gc entries left after processing: %s' % \
+        [e['tag'] for e in entries]
+
+    # processing the emptied queue again is a no-op
+    exec_cmd('radosgw-admin gc process --include-all ' + GC_OPTS)
+    assert not gc_list()
+
+    # Clean up
+    log.debug("Deleting bucket %s", BUCKET_NAME)
+    bucket.objects.all().delete()
+    bucket.delete()
+
+
+main()
+log.info("Completed gc process tests")
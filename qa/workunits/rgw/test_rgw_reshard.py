@@ -1,6 +1,7 @@
 #!/usr/bin/python3
 
 import logging as log
+import threading
 import time
 import subprocess
 import json
@@ -30,6 +31,7 @@ SECRET_KEY = 'LnEsqNNqZIpkzauboDcLXLcYaWwLQ3Kop0zAnKIn'
 BUCKET_NAME1 = 'myfoo'
 BUCKET_NAME2 = 'mybar'
 VER_BUCKET_NAME = 'myver'
+REPLAY_BUCKET_NAME = 'myreplay'
 
 
 def exec_cmd(cmd):
@@ -92,6 +94,24 @@ def get_bucket_num_shards(bucket_name, bucket_id):
     return num_shards
 
 
+def versioned_writer(connection, bucket_name, stop, versions):
+    """
+    keep writing and removing versions of a few objects, tracking the
+    versions that should remain
+    """
+    i = 0
+    while not stop.is_set():
+        key = 'obj%d' % (i % 16)
+        resp = connection.Object(bucket_name, key).put(Body=b"some_data")
+        key_versions = versions.setdefault(key, [])
+        key_versions.append(resp['VersionId'])
+        if i % 3 == 0 and len(key_versions) > 1:
+            # remove an older version, which unlinks an instance
+            version_id = key_versions.pop(0)
+            connection.ObjectVersion(bucket_name, key, version_id).delete()
+        i += 1
+
+
 def main():
     """
     execute manual and dynamic resharding commands
@@ -211,6 +231,39 @@ def main():
     ver_bucket_stats = get_bucket_stats(VER_BUCKET_NAME)
     assert ver_bucket_stats.num_shards == num_shards_expected
 
+    # TESTCASE 'reshard during writes','bucket','reshard','replay writes made while resharding','succeeds'
+    log.debug(' test: reshard versioned bucket during writes')
+    replay_bucket = connection.create_bucket(Bucket=REPLAY_BUCKET_NAME)
+    connection.BucketVersioning(REPLAY_BUCKET_NAME).enable()
+    replay_bucket_stats = get_bucket_stats(REPLAY_BUCKET_NAME)
+    for i in range(0, 500):
+        connection.Object(REPLAY_BUCKET_NAME, ('key' + str(i))).put(Body=b"some_data")
+
+    stop = threading.Event()
+    versions = {}
+    writer = threading.Thread(target=versioned_writer,
+                              args=(connection, REPLAY_BUCKET_NAME, stop, versions))
+    writer.start()
+    time.sleep(1)
+    num_shards_expected = replay_bucket_stats.num_shards + 7
+    cmd = exec_cmd('radosgw-admin bucket reshard --bucket %s --num-shards %s' % (REPLAY_BUCKET_NAME,
+                                                                                 num_shards_expected))
+    time.sleep(1)
+    stop.set()
+    writer.join()
+
+    replay_bucket_stats = get_bucket_stats(REPLAY_BUCKET_NAME)
+    assert replay_bucket_stats.num_shards == num_shards_expected
+    # the writes made while the index was copied were replayed to it
+    listed = {}
+    for version in replay_bucket.object_versions.filter(Prefix='obj'):
+        listed.setdefault(version.object_key, set()).add(version.id)
+        if version.is_latest:
+            assert version.id == versions[version.object_key][-1]
+    assert listed == {key: set(ids) for key, ids in versions.items()}
+    num_versions = sum(len(ids) for ids in versions.values())
+    assert replay_bucket_stats.num_objs == 500 + num_versions
+
     # TESTCASE 'check acl'
     new_bucket1_acl = connection.BucketAcl(BUCKET_NAME1).load()
     assert new_bucket1_acl == bucket1_acl
@@ -228,6 +281,9 @@ def main():
     bucket2.delete()
     log.debug("Deleting bucket %s", VER_BUCKET_NAME)
     ver_bucket.delete()
+    log.debug("Deleting bucket %s", REPLAY_BUCKET_NAME)
+    replay_bucket.object_versions.all().delete()
+    replay_bucket.delete()
 
 
 main()
@@ -45,13 +45,15 @@ CLS_NAME(rgw)
 #define BI_BUCKET_LOG_INDEX           1
 #define BI_BUCKET_OBJ_INSTANCE_INDEX  2
 #define BI_BUCKET_OLH_DATA_INDEX      3
+#define BI_BUCKET_RESHARD_LOG_INDEX   4
 
-#define BI_BUCKET_LAST_INDEX          4
+#define BI_BUCKET_LAST_INDEX          5
 
 static std::string bucket_index_prefixes[] = { "", /* special handling for the objs list index */
                                           "0_",     /* bucket log index */
                                           "1000_",  /* obj instance index */
                                           "1001_",  /* olh data index */
+                                          "1002_",  /* reshard log index */
 
                                           /* this must be the last index */
                                           "9999_",};
@@ -165,6 +167,41 @@ static int log_index_operation(cls_method_context_t hctx, cls_rgw_obj_key& obj_k
   return cls_cxx_map_set_val(hctx, key, &bl);
 }
 
+static void reshard_log_prefix(string& key)
+{
+  key = BI_PREFIX_CHAR;
+  key.append(bucket_index_prefixes[BI_BUCKET_RESHARD_LOG_INDEX]);
+}
+
+/*
+ * While a bucket is being resharded in the IN_LOGRECORD state, index
+ * writes are still accepted by the old shards. The names they touch are
+ * recorded here, so that the resharding process can copy them once more
+ * after it blocked writes, instead of blocking them for the whole copy.
+ */
+static int reshard_log_record(cls_method_context_t hctx,
+                              const rgw_bucket_dir_header& header,
+                              const string& name)
+{
+  if (!header.new_instance.resharding_log_record()) {
+    return 0;
+  }
+  string key;
+  reshard_log_prefix(key);
+  key.append(name);
+  bufferlist empty;
+  return cls_cxx_map_set_val(hctx, key, &empty);
+}
+
+static int reshard_log_clear(cls_method_context_t hctx)
+{
+  string key_begin;
+  reshard_log_prefix(key_begin);
+  string key_end(1, BI_PREFIX_CHAR);
+  key_end.append(bucket_index_prefixes[BI_BUCKET_RESHARD_LOG_INDEX + 1]);
+  return cls_cxx_map_remove_range(hctx, key_begin, key_end);
+}
+
 /*
  * Read list of objects, skipping objects in the "ugly namespace". The
  * "ugly namespace" entries begin with BI_PREFIX_CHAR (0x80). Valid
@@ -831,11 +868,21 @@ int rgw_bucket_prepare_op(cls_method_context_t hctx, bufferlist *in, bufferlist
   CLS_LOG(1, "rgw_bucket_prepare_op(): request: op=%d name=%s instance=%s tag=%s\n",
           op.op, op.key.name.c_str(), op.key.instance.c_str(), op.tag.c_str());
 
+  rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: rgw_bucket_prepare_op(): failed to read header\n");
+    return rc;
+  }
+  rc = reshard_log_record(hctx, header, op.key.name);
+  if (rc < 0)
+    return rc;
+
   // get on-disk state
   string idx;
 
   rgw_bucket_dir_entry entry;
-  int rc = read_key_entry(hctx, op.key, &idx, &entry);
+  rc = read_key_entry(hctx, op.key, &idx, &entry);
   if (rc < 0 && rc != -ENOENT)
     return rc;
 
@@ -953,29 +1000,20 @@ static int read_key_entry(cls_method_context_t hctx, cls_rgw_obj_key& key,
   return 0;
 }
 
-int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+static int complete_op(cls_method_context_t hctx,
+                       rgw_bucket_dir_header& header,
+                       rgw_cls_obj_complete_op& op,
+                       bool *header_changed)
 {
-  CLS_LOG(10, "entered %s()\n", __func__);
-  // decode request
-  rgw_cls_obj_complete_op op;
-  auto iter = in->cbegin();
-  try {
-    decode(op, iter);
-  } catch (ceph::buffer::error& err) {
-    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to decode request\n");
-    return -EINVAL;
-  }
+  *header_changed = false;
   CLS_LOG(1, "rgw_bucket_complete_op(): request: op=%d name=%s instance=%s ver=%lu:%llu tag=%s\n",
           op.op, op.key.name.c_str(), op.key.instance.c_str(),
           (unsigned long)op.ver.pool, (unsigned long long)op.ver.epoch,
           op.tag.c_str());
 
-  rgw_bucket_dir_header header;
-  int rc = read_bucket_header(hctx, &header);
-  if (rc < 0) {
-    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to read header\n");
-    return -EINVAL;
-  }
+  int rc = reshard_log_record(hctx, header, op.key.name);
+  if (rc < 0)
+    return rc;
 
   rgw_bucket_dir_entry entry;
   bool ondisk = true;
@@ -1028,6 +1066,7 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
     return 0;
   }
 
+  *header_changed = true;
   if (entry.exists) {
     unaccount_entry(header, entry);
   }
@@ -1101,6 +1140,10 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
 	    int(remove_entry.meta.category));
     unaccount_entry(header, remove_entry);
 
+    ret = reshard_log_record(hctx, header, remove_key.name);
+    if (ret < 0)
+      return ret;
+
     if (op.log_op && !header.syncstopped) {
       ++header.ver; // increment index version, or we'll overwrite keys previously written
       rc = log_index_operation(hctx, remove_key, CLS_RGW_OP_DEL, op.tag, remove_entry.meta.mtime,
@@ -1116,6 +1159,82 @@ int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist
     }
   }
 
+  return 0;
+}
+
+int rgw_bucket_complete_op(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  CLS_LOG(10, "entered %s()\n", __func__);
+  // decode request
+  rgw_cls_obj_complete_op op;
+  auto iter = in->cbegin();
+  try {
+    decode(op, iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to decode request\n");
+    return -EINVAL;
+  }
+
+  rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: rgw_bucket_complete_op(): failed to read header\n");
+    return -EINVAL;
+  }
+
+  bool header_changed;
+  rc = complete_op(hctx, header, op, &header_changed);
+  if (rc < 0 || !header_changed) {
+    return rc;
+  }
+
+  return write_bucket_header(hctx, &header);
+}
+
+/*
+ * Apply the complete ops of several objects of the same shard, reading and
+ * writing the header only once. An op which fails fails the whole batch, so
+ * that none of its omap updates are applied and the stats stay consistent
+ * with the entries; the caller then completes the ops one by one.
+ */
+static int rgw_bucket_complete_ops(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  CLS_LOG(10, "entered %s()\n", __func__);
+  // decode request
+  rgw_cls_obj_complete_ops_op op;
+  auto iter = in->cbegin();
+  try {
+    decode(op, iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: %s(): failed to decode request\n", __func__);
+    return -EINVAL;
+  }
+
+  rgw_bucket_dir_header header;
+  int rc = read_bucket_header(hctx, &header);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to read header\n", __func__);
+    return -EINVAL;
+  }
+
+  bool header_changed = false;
+  for (auto& complete : op.ops) {
+    bool op_header_changed;
+    rc = complete_op(hctx, header, complete, &op_header_changed);
+    if (rc < 0) {
+      CLS_LOG(0, "ERROR: %s(): failed to complete op name=%s instance=%s rc=%d\n",
+              __func__, complete.key.name.c_str(), complete.key.instance.c_str(), rc);
+      return rc;
+    }
+    if (op_header_changed) {
+      ++header.ver; // next op must not overwrite the bilog keys of this one
+      header_changed = true;
+    }
+  }
+  if (!header_changed) {
+    return 0;
+  }
+
   return write_bucket_header(hctx, &header);
 }
 
@@ -1543,11 +1662,22 @@ static int rgw_bucket_link_olh(cls_method_context_t hctx, bufferlist *in, buffer
     return -EINVAL;
   }
 
+  rgw_bucket_dir_header header;
+  int ret = read_bucket_header(hctx, &header);
+  if (ret < 0) {
+    CLS_LOG(1, "ERROR: rgw_bucket_link_olh(): failed to read header\n");
+    return ret;
+  }
+  ret = reshard_log_record(hctx, header, op.key.name);
+  if (ret < 0) {
+    return ret;
+  }
+
   BIVerObjEntry obj(hctx, op.key);
   BIOLHEntry olh(hctx, op.key);
 
   /* read instance entry */
-  int ret = obj.init(op.delete_marker);
+  ret = obj.init(op.delete_marker);
   bool existed = (ret == 0);
   if (ret == -ENOENT && op.delete_marker) {
     ret = 0;
@@ -1690,17 +1820,7 @@ static int rgw_bucket_link_olh(cls_method_context_t hctx, bufferlist *in, buffer
     return ret;
   }
 
-  if (!op.log_op) {
-   return 0;
-  }
-
-  rgw_bucket_dir_header header;
-  ret = read_bucket_header(hctx, &header);
-  if (ret < 0) {
-    CLS_LOG(1, "ERROR: rgw_bucket_link_olh(): failed to read header\n");
-    return ret;
-  }
-  if (header.syncstopped) {
+  if (!op.log_op || header.syncstopped) {
     return 0;
   }
 
@@ -1744,6 +1864,17 @@ static int rgw_bucket_unlink_instance(cls_method_context_t hctx, bufferlist *in,
     return -EINVAL;
   }
 
+  rgw_bucket_dir_header header;
+  int ret = read_bucket_header(hctx, &header);
+  if (ret < 0) {
+    CLS_LOG(1, "ERROR: rgw_bucket_unlink_instance(): failed to read header\n");
+    return ret;
+  }
+  ret = reshard_log_record(hctx, header, op.key.name);
+  if (ret < 0) {
+    return ret;
+  }
+
   cls_rgw_obj_key dest_key = op.key;
   if (dest_key.instance == "null") {
     dest_key.instance.clear();
@@ -1752,7 +1883,7 @@ static int rgw_bucket_unlink_instance(cls_method_context_t hctx, bufferlist *in,
   BIVerObjEntry obj(hctx, dest_key);
   BIOLHEntry olh(hctx, dest_key);
 
-  int ret = obj.init();
+  ret = obj.init();
   if (ret == -ENOENT) {
     return 0; /* already removed */
   }
@@ -1856,17 +1987,7 @@ static int rgw_bucket_unlink_instance(cls_method_context_t hctx, bufferlist *in,
     return ret;
   }
 
-  if (!op.log_op) {
-    return 0;
-  }
-
-  rgw_bucket_dir_header header;
-  ret = read_bucket_header(hctx, &header);
-  if (ret < 0) {
-    CLS_LOG(1, "ERROR: rgw_bucket_unlink_instance(): failed to read header\n");
-    return ret;
-  }
-  if (header.syncstopped) {
+  if (!op.log_op || header.syncstopped) {
     return 0;
   }
 
@@ -1957,11 +2078,22 @@ static int rgw_bucket_trim_olh_log(cls_method_context_t hctx, bufferlist *in, bu
     return -EINVAL;
   }
 
+  rgw_bucket_dir_header header;
+  int ret = read_bucket_header(hctx, &header);
+  if (ret < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to read header\n", __func__);
+    return ret;
+  }
+  ret = reshard_log_record(hctx, header, op.olh.name);
+  if (ret < 0) {
+    return ret;
+  }
+
   /* read olh entry */
   rgw_bucket_olh_entry olh_data_entry;
   string olh_data_key;
   encode_olh_data_key(op.olh, &olh_data_key);
-  int ret = read_index_entry(hctx, olh_data_key, &olh_data_entry);
+  ret = read_index_entry(hctx, olh_data_key, &olh_data_entry);
   if (ret < 0 && ret != -ENOENT) {
     CLS_LOG(0, "ERROR: read_index_entry() olh_key=%s ret=%d", olh_data_key.c_str(), ret);
     return ret;
@@ -2009,11 +2141,22 @@ static int rgw_bucket_clear_olh(cls_method_context_t hctx, bufferlist *in, buffe
     return -EINVAL;
   }
 
+  rgw_bucket_dir_header header;
+  int ret = read_bucket_header(hctx, &header);
+  if (ret < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to read header\n", __func__);
+    return ret;
+  }
+  ret = reshard_log_record(hctx, header, op.key.name);
+  if (ret < 0) {
+    return ret;
+  }
+
   /* read olh entry */
   rgw_bucket_olh_entry olh_data_entry;
   string olh_data_key;
   encode_olh_data_key(op.key, &olh_data_key);
-  int ret = read_index_entry(hctx, olh_data_key, &olh_data_entry);
+  ret = read_index_entry(hctx, olh_data_key, &olh_data_entry);
   if (ret < 0 && ret != -ENOENT) {
     CLS_LOG(0, "ERROR: read_index_entry() olh_key=%s ret=%d", olh_data_key.c_str(), ret);
     return ret;
@@ -2101,6 +2244,10 @@ int rgw_dir_suggest_changes(cls_method_context_t hctx,
       continue;
     }
 
+    ret = reshard_log_record(hctx, header, cur_change.key.name);
+    if (ret < 0)
+      return ret;
+
     if (cur_disk_bl.length()) {
       auto cur_disk_iter = cur_disk_bl.cbegin();
       try {
@@ -4063,6 +4210,16 @@ static int rgw_set_bucket_resharding(cls_method_context_t hctx, bufferlist *in,
     return rc;
   }
 
+  if (!op.entry.resharding() ||
+      (op.entry.resharding_log_record() &&
+       !header.new_instance.resharding_log_record())) {
+    // drop whatever an aborted attempt left behind
+    rc = reshard_log_clear(hctx);
+    if (rc < 0) {
+      CLS_LOG(1, "ERROR: %s(): failed to clear reshard log\n", __func__);
+      return rc;
+    }
+  }
   header.new_instance.set_status(op.entry.new_bucket_instance_id, op.entry.num_shards, op.entry.reshard_status);
 
   return write_bucket_header(hctx, &header);
@@ -4087,6 +4244,11 @@ static int rgw_clear_bucket_resharding(cls_method_context_t hctx, bufferlist *in
     CLS_LOG(1, "ERROR: %s(): failed to read header\n", __func__);
     return rc;
   }
+  rc = reshard_log_clear(hctx);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to clear reshard log\n", __func__);
+    return rc;
+  }
   header.new_instance.clear();
 
   return write_bucket_header(hctx, &header);
@@ -4112,7 +4274,7 @@ static int rgw_guard_bucket_resharding(cls_method_context_t hctx, bufferlist *in
     return rc;
   }
 
-  if (header.resharding()) {
+  if (header.new_instance.resharding_blocks_writes()) {
     return op.ret_err;
   }
 
@@ -4148,6 +4310,41 @@ static int rgw_get_bucket_resharding(cls_method_context_t hctx,
   return 0;
 }
 
+static int rgw_reshard_log_list(cls_method_context_t hctx,
+				bufferlist *in, bufferlist *out)
+{
+  CLS_LOG(10, "entered %s()\n", __func__);
+  cls_rgw_reshard_log_list_op op;
+
+  auto in_iter = in->cbegin();
+  try {
+    decode(op, in_iter);
+  } catch (ceph::buffer::error& err) {
+    CLS_LOG(1, "ERROR: %s(): failed to decode entry\n", __func__);
+    return -EINVAL;
+  }
+
+  string prefix;
+  reshard_log_prefix(prefix);
+  string start_after = prefix + op.marker;
+
+  std::map<string, bufferlist> keys;
+  cls_rgw_reshard_log_list_ret op_ret;
+  int rc = cls_cxx_map_get_vals(hctx, start_after, prefix, op.max, &keys,
+				&op_ret.is_truncated);
+  if (rc < 0) {
+    CLS_LOG(1, "ERROR: %s(): failed to list reshard log rc=%d\n", __func__, rc);
+    return rc;
+  }
+  for (auto& [key, bl] : keys) {
+    op_ret.names.push_back(key.substr(prefix.size()));
+  }
+
+  encode(op_ret, *out);
+
+  return 0;
+}
+
 CLS_INIT(rgw)
 {
   CLS_LOG(1, "Loaded rgw class!");
@@ -4161,6 +4358,7 @@ CLS_INIT(rgw)
   cls_method_handle_t h_rgw_bucket_update_stats;
   cls_method_handle_t h_rgw_bucket_prepare_op;
   cls_method_handle_t h_rgw_bucket_complete_op;
+  cls_method_handle_t h_rgw_bucket_complete_ops;
   cls_method_handle_t h_rgw_bucket_link_olh;
   cls_method_handle_t h_rgw_bucket_unlink_instance_op;
   cls_method_handle_t h_rgw_bucket_read_olh_log;
@@ -4199,6 +4397,7 @@ CLS_INIT(rgw)
   cls_method_handle_t h_rgw_clear_bucket_resharding;
   cls_method_handle_t h_rgw_guard_bucket_resharding;
   cls_method_handle_t h_rgw_get_bucket_resharding;
+  cls_method_handle_t h_rgw_reshard_log_list;
 
   cls_register(RGW_CLASS, &h_class);
 
@@ -4211,6 +4410,7 @@ CLS_INIT(rgw)
   cls_register_cxx_method(h_class, RGW_BUCKET_UPDATE_STATS, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_update_stats, &h_rgw_bucket_update_stats);
   cls_register_cxx_method(h_class, RGW_BUCKET_PREPARE_OP, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_prepare_op, &h_rgw_bucket_prepare_op);
   cls_register_cxx_method(h_class, RGW_BUCKET_COMPLETE_OP, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_complete_op, &h_rgw_bucket_complete_op);
+  cls_register_cxx_method(h_class, RGW_BUCKET_COMPLETE_OPS, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_complete_ops, &h_rgw_bucket_complete_ops);
   cls_register_cxx_method(h_class, RGW_BUCKET_LINK_OLH, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_link_olh, &h_rgw_bucket_link_olh);
   cls_register_cxx_method(h_class, RGW_BUCKET_UNLINK_INSTANCE, CLS_METHOD_RD | CLS_METHOD_WR, rgw_bucket_unlink_instance, &h_rgw_bucket_unlink_instance_op);
   cls_register_cxx_method(h_class, RGW_BUCKET_READ_OLH_LOG, CLS_METHOD_RD, rgw_bucket_read_olh_log, &h_rgw_bucket_read_olh_log);
@@ -4269,6 +4469,8 @@ CLS_INIT(rgw)
 			  rgw_guard_bucket_resharding, &h_rgw_guard_bucket_resharding);
   cls_register_cxx_method(h_class, RGW_GET_BUCKET_RESHARDING, CLS_METHOD_RD ,
 			  rgw_get_bucket_resharding, &h_rgw_get_bucket_resharding);
+  cls_register_cxx_method(h_class, RGW_RESHARD_LOG_LIST, CLS_METHOD_RD ,
+			  rgw_reshard_log_list, &h_rgw_reshard_log_list);
 
   return;
 }
@@ -215,6 +215,16 @@ void cls_rgw_bucket_complete_op(ObjectWriteOperation& o, RGWModifyOp op, string&
   o.exec(RGW_CLASS, RGW_BUCKET_COMPLETE_OP, in);
 }
 
+void cls_rgw_bucket_complete_ops(ObjectWriteOperation& o,
+                                 const std::vector<rgw_cls_obj_complete_op>& ops)
+{
+  bufferlist in;
+  rgw_cls_obj_complete_ops_op call;
+  call.ops = ops;
+  encode(call, in);
+  o.exec(RGW_CLASS, RGW_BUCKET_COMPLETE_OPS, in);
+}
+
 void cls_rgw_bucket_list_op(librados::ObjectReadOperation& op,
                             const cls_rgw_obj_key& start_obj,
                             const std::string& filter_prefix,
@@ -376,6 +386,33 @@ int cls_rgw_bi_list(librados::IoCtx& io_ctx, const string oid,
   return 0;
 }
 
+int cls_rgw_reshard_log_list(librados::IoCtx& io_ctx, const string& oid,
+                             const string& marker, uint32_t max,
+                             list<string> *names, bool *is_truncated)
+{
+  bufferlist in, out;
+  cls_rgw_reshard_log_list_op call;
+  call.marker = marker;
+  call.max = max;
+  encode(call, in);
+  int r = io_ctx.exec(oid, RGW_CLASS, RGW_RESHARD_LOG_LIST, in, out);
+  if (r < 0)
+    return r;
+
+  cls_rgw_reshard_log_list_ret op_ret;
+  auto iter = out.cbegin();
+  try {
+    decode(op_ret, iter);
+  } catch (ceph::buffer::error& err) {
+    return -EIO;
+  }
+
+  names->swap(op_ret.names);
+  *is_truncated = op_ret.is_truncated;
+
+  return 0;
+}
+
 int cls_rgw_bucket_link_olh(librados::IoCtx& io_ctx, const string& oid, 
                             const cls_rgw_obj_key& key, bufferlist& olh_tag,
                             bool delete_marker, const string& op_tag, rgw_bucket_dir_entry_meta *meta,
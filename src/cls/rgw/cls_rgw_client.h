@@ -369,6 +369,10 @@ void cls_rgw_bucket_complete_op(librados::ObjectWriteOperation& o, RGWModifyOp o
 				std::list<cls_rgw_obj_key> *remove_objs, bool log_op,
                                 uint16_t bilog_op, rgw_zone_set *zones_trace);
 
+/* applies several complete ops of the same bucket index shard at once */
+void cls_rgw_bucket_complete_ops(librados::ObjectWriteOperation& o,
+                                 const std::vector<rgw_cls_obj_complete_op>& ops);
+
 void cls_rgw_remove_obj(librados::ObjectWriteOperation& o, std::list<std::string>& keep_attr_prefixes);
 void cls_rgw_obj_store_pg_ver(librados::ObjectWriteOperation& o, const std::string& attr);
 void cls_rgw_obj_check_attrs_prefix(librados::ObjectOperation& o, const std::string& prefix, bool fail_if_exist);
@@ -382,6 +386,10 @@ void cls_rgw_bi_put(librados::ObjectWriteOperation& op, const std::string oid, r
 int cls_rgw_bi_list(librados::IoCtx& io_ctx, const std::string oid,
                    const std::string& name, const std::string& marker, uint32_t max,
                    std::list<rgw_cls_bi_entry> *entries, bool *is_truncated);
+/* names modified on a bucket index shard while it was being resharded */
+int cls_rgw_reshard_log_list(librados::IoCtx& io_ctx, const std::string& oid,
+                             const std::string& marker, uint32_t max,
+                             std::list<std::string> *names, bool *is_truncated);
 
 
 void cls_rgw_bucket_link_olh(librados::ObjectWriteOperation& op,
@@ -157,6 +157,25 @@ void rgw_cls_obj_complete_op::dump(Formatter *f) const
   encode_json("zones_trace", zones_trace, f);
 }
 
+void rgw_cls_obj_complete_ops_op::generate_test_instances(list<rgw_cls_obj_complete_ops_op*>& o)
+{
+  list<rgw_cls_obj_complete_op*> l;
+  rgw_cls_obj_complete_op::generate_test_instances(l);
+  rgw_cls_obj_complete_ops_op *op = new rgw_cls_obj_complete_ops_op;
+  for (auto complete : l) {
+    op->ops.push_back(*complete);
+    delete complete;
+  }
+  o.push_back(op);
+
+  o.push_back(new rgw_cls_obj_complete_ops_op);
+}
+
+void rgw_cls_obj_complete_ops_op::dump(Formatter *f) const
+{
+  encode_json("ops", ops, f);
+}
+
 void rgw_cls_link_olh_op::generate_test_instances(list<rgw_cls_link_olh_op*>& o)
 {
   rgw_cls_link_olh_op *op = new rgw_cls_link_olh_op;
@@ -545,3 +564,33 @@ void cls_rgw_get_bucket_resharding_op::generate_test_instances(
 void cls_rgw_get_bucket_resharding_op::dump(Formatter *f) const
 {
 }
+
+void cls_rgw_reshard_log_list_op::generate_test_instances(
+  list<cls_rgw_reshard_log_list_op*>& ls)
+{
+  ls.push_back(new cls_rgw_reshard_log_list_op);
+  ls.push_back(new cls_rgw_reshard_log_list_op);
+  ls.back()->marker = "marker";
+  ls.back()->max = 1000;
+}
+
+void cls_rgw_reshard_log_list_op::dump(Formatter *f) const
+{
+  encode_json("marker", marker, f);
+  encode_json("max", max, f);
+}
+
+void cls_rgw_reshard_log_list_ret::generate_test_instances(
+  list<cls_rgw_reshard_log_list_ret*>& ls)
+{
+  ls.push_back(new cls_rgw_reshard_log_list_ret);
+  ls.push_back(new cls_rgw_reshard_log_list_ret);
+  ls.back()->names.push_back("obj");
+  ls.back()->is_truncated = true;
+}
+
+void cls_rgw_reshard_log_list_ret::dump(Formatter *f) const
+{
+  encode_json("names", names, f);
+  encode_json("is_truncated", is_truncated, f);
+}
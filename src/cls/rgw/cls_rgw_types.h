@@ -721,7 +721,8 @@ WRITE_CLASS_ENCODER(rgw_bucket_category_stats)
 enum class cls_rgw_reshard_status : uint8_t {
   NOT_RESHARDING  = 0,
   IN_PROGRESS     = 1,
-  DONE            = 2
+  DONE            = 2,
+  IN_LOGRECORD    = 3, // copying entries, writes allowed and logged
 };
 
 inline std::string to_string(const cls_rgw_reshard_status status)
@@ -733,6 +734,8 @@ inline std::string to_string(const cls_rgw_reshard_status status)
     return "in-progress";
   case cls_rgw_reshard_status::DONE:
     return "done";
+  case cls_rgw_reshard_status::IN_LOGRECORD:
+    return "in-logrecord";
   };
   return "Unknown reshard status";
 }
@@ -784,6 +787,13 @@ struct cls_rgw_bucket_instance_entry {
   bool resharding_in_progress() const {
     return reshard_status == RESHARD_STATUS::IN_PROGRESS;
   }
+  bool resharding_log_record() const {
+    return reshard_status == RESHARD_STATUS::IN_LOGRECORD;
+  }
+  // whether index writes must wait for the new bucket instance
+  bool resharding_blocks_writes() const {
+    return resharding() && !resharding_log_record();
+  }
 };
 WRITE_CLASS_ENCODER(cls_rgw_bucket_instance_entry)
 
@@ -749,6 +749,13 @@ static ceph::spinlock debug_lock;
   void buffer::list::iterator_impl<is_const>::copy(unsigned len, char *dest)
   {
     if (p == ls->end()) seek(off);
+    if (p != ls->end() && p_off + len < p->length()) {
+      // fast path: the data is all in the current segment, and we stay in it
+      memcpy(dest, p->c_str() + p_off, len);
+      p_off += len;
+      off += len;
+      return;
+    }
     while (len > 0) {
       if (p == ls->end())
 	throw end_of_buffer();
@@ -1366,15 +1373,16 @@ static ceph::spinlock debug_lock;
   buffer::list::reserve_t buffer::list::obtain_contiguous_space(
     const unsigned len)
   {
-    // note: if len < the normal append_buffer size it *might*
-    // be better to allocate a normal-sized append_buffer and
-    // use part of it.  however, that optimizes for the case of
-    // old-style types including new-style types.  and in most
-    // such cases, this won't be the very first thing encoded to
-    // the list, so append_buffer will already be allocated.
-    // OTOH if everything is new-style, we *should* allocate
-    // only what we need and conserve memory.
+    // small requests are usually followed by more of them (a message
+    // encoding one denc type after another), so they get a normal-sized
+    // append_buffer that the following ones can share instead of a buffer
+    // of their own each. large ones allocate only what they need to
+    // conserve memory.
     if (unlikely(get_append_buffer_unused_tail_length() < len)) {
+      if (len <= CEPH_BUFFER_APPEND_SIZE / 4) {
+	auto& new_back = refill_append_space(len);
+	return { new_back.c_str(), &new_back._len, &_len };
+      }
       auto new_back = \
 	buffer::ptr_node::create(buffer::create(len)).release();
       new_back->set_length(0);   // unused, so far.
@@ -1517,6 +1525,30 @@ static ceph::spinlock debug_lock;
   /*
    * return a contiguous ptr to whole bufferlist contents.
    */
+  bool buffer::list::merge_adjacent()
+  {
+    // the segments are views of the same raw buffer, one right after the
+    // other, e.g. because appending resumed in the append_buffer after a
+    // foreign ptr was pushed: a single ptr can cover all of them.
+    const auto& front = _buffers.front();
+    unsigned end = front.offset() + front.length();
+    for (auto it = std::next(std::cbegin(_buffers));
+	 it != std::cend(_buffers); ++it) {
+      if (it->_raw != front._raw || it->offset() != end) {
+	return false;
+      }
+      end += it->length();
+    }
+    const bool was_carriage = (_carriage == &_buffers.back());
+    auto nb = ptr_node::create(front);
+    nb->set_length(_len);
+    _buffers.clear_and_dispose();
+    _carriage = was_carriage ? nb.get() : &always_empty_bptr;
+    _buffers.push_back(*nb.release());
+    _num = 1;
+    return true;
+  }
+
   char *buffer::list::c_str()
   {
     if (_buffers.empty())
@@ -1525,7 +1557,7 @@ static ceph::spinlock debug_lock;
     auto iter = std::cbegin(_buffers);
     ++iter;
 
-    if (iter != std::cend(_buffers)) {
+    if (iter != std::cend(_buffers) && !merge_adjacent()) {
       rebuild();
     }
     return _buffers.front().c_str();  // good, we're already contiguous.
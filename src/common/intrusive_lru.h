@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <limits>
+
 #include <boost/intrusive_ptr.hpp>
 #include <boost/intrusive/set.hpp>
 #include <boost/intrusive/list.hpp>
@@ -12,6 +14,14 @@ namespace ceph::common {
 /**
  * intrusive_lru: lru implementation with embedded map and list hook
  *
+ * Each entry is charged 1 against the target size by default; with
+ * set_charge(), entries can be charged e.g. their size in bytes instead.
+ *
+ * If a hot threshold is set, an unreferenced entry which was accessed at
+ * least that many times since it was last considered for eviction is
+ * given a second chance, so that frequently used entries stay cached even
+ * when a scan goes through the cache.
+ *
  * Note, this implementation currently is entirely thread-unsafe.
  */
 
@@ -42,6 +52,10 @@ class intrusive_lru_base {
   // null if unreferenced
   intrusive_lru<Config> *lru = nullptr;
 
+  size_t charge = 1;
+  // accesses since last considered for eviction
+  unsigned hits = 0;
+
 public:
   boost::intrusive::set_member_hook<> set_hook;
   boost::intrusive::list_member_hook<> list_hook;
@@ -91,13 +105,22 @@ class intrusive_lru {
   lru_list_t unreferenced_list;
 
   size_t lru_target_size = 0;
+  size_t lru_charged = 0;
+  unsigned hot_threshold = 0;
 
   void evict() {
     while (!unreferenced_list.empty() &&
-	   lru_set.size() > lru_target_size) {
+	   lru_charged > lru_target_size) {
       auto &b = unreferenced_list.front();
       assert(!b.lru);
       unreferenced_list.pop_front();
+      if (hot_threshold && b.hits >= hot_threshold) {
+	// second chance; terminates as the entry is not hot anymore
+	b.hits = 0;
+	unreferenced_list.push_back(b);
+	continue;
+      }
+      lru_charged -= b.charge;
       lru_set.erase_and_dispose(
 	lru_set.iterator_to(b),
 	[](auto *p) { delete p; }
@@ -106,6 +129,8 @@ class intrusive_lru {
   }
 
   void access(base_t &b) {
+    if (b.hits < std::numeric_limits<unsigned>::max())
+      ++b.hits;
     if (b.lru)
       return;
     unreferenced_list.erase(lru_list_t::s_iterator_to(b));
@@ -115,6 +140,7 @@ class intrusive_lru {
   void insert(base_t &b) {
     assert(!b.lru);
     lru_set.insert(b);
+    lru_charged += b.charge;
     b.lru = this;
     evict();
   }
@@ -166,6 +192,25 @@ public:
     evict();
   }
 
+  /// Charge the referenced entry b with charge rather than with 1
+  void set_charge(T &b, size_t charge) {
+    assert(static_cast<base_t&>(b).lru == this);
+    lru_charged -= static_cast<base_t&>(b).charge;
+    static_cast<base_t&>(b).charge = charge;
+    lru_charged += charge;
+    evict();
+  }
+
+  /// Entries accessed this many times are given a second chance, 0 to
+  /// disable
+  void set_hot_threshold(unsigned threshold) {
+    hot_threshold = threshold;
+  }
+
+  size_t get_charged() const {
+    return lru_charged;
+  }
+
   friend void intrusive_ptr_add_ref<>(intrusive_lru_base<Config> *);
   friend void intrusive_ptr_release<>(intrusive_lru_base<Config> *);
 };
@@ -483,6 +483,10 @@ ProtocolV2::banner_exchange(bool is_connect)
       const bool is_rev1 = HAVE_MSGR2_FEATURE(peer_supported_features, REVISION_1);
       tx_frame_asm.set_is_rev1(is_rev1);
       rx_frame_asm.set_is_rev1(is_rev1);
+      const bool is_chunked_seal = HAVE_MSGR2_FEATURE(peer_supported_features,
+                                                      CHUNKED_SEAL);
+      tx_frame_asm.set_is_chunked_seal(is_chunked_seal);
+      rx_frame_asm.set_is_chunked_seal(is_chunked_seal);
 
       auto hello = HelloFrame::Encode(messenger.get_mytype(),
                                       conn.target_addr);
@@ -1066,6 +1070,7 @@ ProtocolV2::reuse_connection(
                                     connection_features,
                                     tx_frame_asm.get_is_rev1(),
                                     rx_frame_asm.get_is_rev1(),
+                                    tx_frame_asm.get_is_chunked_seal(),
                                     conn_seq,
                                     msg_seq);
 #ifdef UNIT_TESTS_BUILT
@@ -1693,6 +1698,7 @@ void ProtocolV2::trigger_replacing(bool reconnect,
                                    uint64_t new_conn_features,
                                    bool tx_is_rev1,
                                    bool rx_is_rev1,
+                                   bool is_chunked_seal,
                                    uint64_t new_connect_seq,
                                    uint64_t new_msg_seq)
 {
@@ -1709,7 +1715,7 @@ void ProtocolV2::trigger_replacing(bool reconnect,
                   new_socket = std::move(new_socket),
                   new_auth_meta = std::move(new_auth_meta),
                   new_rxtx = std::move(new_rxtx),
-                  tx_is_rev1, rx_is_rev1,
+                  tx_is_rev1, rx_is_rev1, is_chunked_seal,
                   new_client_cookie, new_peer_name,
                   new_conn_features, new_peer_global_seq,
                   new_connect_seq, new_msg_seq] () mutable {
@@ -1724,7 +1730,7 @@ void ProtocolV2::trigger_replacing(bool reconnect,
              new_socket = std::move(new_socket),
              new_auth_meta = std::move(new_auth_meta),
              new_rxtx = std::move(new_rxtx),
-             tx_is_rev1, rx_is_rev1,
+             tx_is_rev1, rx_is_rev1, is_chunked_seal,
              new_client_cookie, new_peer_name,
              new_conn_features, new_peer_global_seq,
              new_connect_seq, new_msg_seq] () mutable {
@@ -1762,6 +1768,8 @@ void ProtocolV2::trigger_replacing(bool reconnect,
         connection_features = new_conn_features;
         tx_frame_asm.set_is_rev1(tx_is_rev1);
         rx_frame_asm.set_is_rev1(rx_is_rev1);
+        tx_frame_asm.set_is_chunked_seal(is_chunked_seal);
+        rx_frame_asm.set_is_chunked_seal(is_chunked_seal);
         return send_server_ident();
       }
     }).then([this, reconnect] {
@@ -204,6 +204,7 @@ class ProtocolV2 final : public Protocol {
                          uint64_t new_conn_features,
                          bool tx_is_rev1,
                          bool rx_is_rev1,
+                         bool is_chunked_seal,
                          // reconnect
                          uint64_t new_connect_seq,
                          uint64_t new_msg_seq);
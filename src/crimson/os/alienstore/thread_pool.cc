@@ -13,16 +13,51 @@ using crimson::common::local_conf;
 
 namespace crimson::os {
 
+SubmitQueue::SubmitQueue(size_t num_free_slots)
+  : free_slots(num_free_slots),
+    done(num_free_slots),
+    wakeup_write(wakeup.write_side())
+{
+  drained = drain();
+}
+
+seastar::future<> SubmitQueue::drain()
+{
+  return seastar::do_until([this] { return stopping; }, [this] {
+    return wakeup.wait().then([this](size_t) {
+      // clear the flag before draining, so that any item pushed from now
+      // on signals again
+      wakeup_pending.exchange(false);
+      WorkItem* work_item = nullptr;
+      while (done.pop(work_item)) {
+        work_item->on_done.set_value();
+      }
+    });
+  });
+}
+
+seastar::future<> SubmitQueue::stop()
+{
+  return pending_tasks.close().then([this] {
+    stopping = true;
+    wakeup_write.signal(1);
+    return std::move(drained);
+  });
+}
+
 ThreadPool::ThreadPool(size_t n_threads,
                        size_t queue_sz,
                        std::vector<uint64_t> cpus)
   : n_threads(n_threads),
-    queue_size{round_up_to(queue_sz, seastar::smp::count)},
-    pending_queues(n_threads)
+    queue_size{round_up_to(queue_sz, seastar::smp::count)}
 {
+  for (size_t i = 0; i < n_threads; i++) {
+    // any reactor may fill up the queue of a single thread
+    pending_queues.emplace_back(queue_size);
+  }
   auto queue_max_wait = std::chrono::seconds(local_conf()->threadpool_empty_queue_max_wait);
   for (size_t i = 0; i < n_threads; i++) {
-    threads.emplace_back([this, cpus, queue_max_wait, i] {
+    threads.emplace_back([this, cpus=cpus_of(i, cpus), queue_max_wait, i] {
       if (!cpus.empty()) {
         pin(cpus);
       }
@@ -52,6 +87,18 @@ void ThreadPool::pin(const std::vector<uint64_t>& cpus)
   ceph_assert(r == 0);
 }
 
+std::vector<uint64_t> ThreadPool::cpus_of(size_t i,
+                                           const std::vector<uint64_t>& cpus)
+{
+  if (cpus.size() >= n_threads) {
+    // a core of its own for each thread, so they don't bounce between
+    // cores, and between the caches of different NUMA nodes
+    return {cpus[i]};
+  } else {
+    return cpus;
+  }
+}
+
 void ThreadPool::block_sighup()
 {
   sigset_t sigs;
@@ -73,6 +120,7 @@ void ThreadPool::loop(std::chrono::milliseconds queue_max_wait, size_t shard)
     work_item = pending.pop_front(queue_max_wait);
     if (work_item) {
       work_item->process();
+      work_item->origin->complete(work_item);
     } else if (is_stopping()) {
       break;
     }
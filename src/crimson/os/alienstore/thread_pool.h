@@ -4,6 +4,8 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <tuple>
 #include <type_traits>
 #include <boost/lockfree/queue.hpp>
@@ -16,9 +18,16 @@
 
 namespace crimson::os {
 
+struct SubmitQueue;
+
 struct WorkItem {
   virtual ~WorkItem() {}
   virtual void process() = 0;
+  /// the queue of the submitting reactor, which gets the item back once
+  /// processed
+  SubmitQueue* origin = nullptr;
+  /// resolved on the submitting reactor
+  seastar::promise<> on_done;
 };
 
 template<typename Func>
@@ -44,10 +53,9 @@ public:
     } catch (...) {
       state.set_exception(std::current_exception());
     }
-    on_done.write_side().signal(1);
   }
   typename futurator_t::type get_future() {
-    return on_done.wait().then([this](size_t) {
+    return on_done.get_future().then([this] {
       if (state.failed()) {
 	return futurator_t::make_exception_future(state.get_exception());
       } else {
@@ -58,53 +66,85 @@ public:
 private:
   Func func;
   seastar::future_state<future_stored_type_t> state;
-  seastar::readable_eventfd on_done;
 };
 
+/// the per-reactor side of the pool: throttles the submissions, and takes
+/// the processed items back from the worker threads
 struct SubmitQueue {
   seastar::semaphore free_slots;
   seastar::gate pending_tasks;
-  explicit SubmitQueue(size_t num_free_slots)
-    : free_slots(num_free_slots)
-  {}
-  seastar::future<> stop() {
-    return pending_tasks.close();
+  explicit SubmitQueue(size_t num_free_slots);
+  seastar::future<> stop();
+  /// called by the worker threads
+  void complete(WorkItem* work_item) {
+    while (!done.push(work_item)) {
+      // can only fail if no node can be allocated
+    }
+    // a single wakeup for all of the items completed since the last one
+    if (!wakeup_pending.exchange(true)) {
+      wakeup_write.signal(1);
+    }
   }
+private:
+  /// resolve the processed items, until stopped
+  seastar::future<> drain();
+  boost::lockfree::queue<WorkItem*> done;
+  std::atomic<bool> wakeup_pending = false;
+  seastar::readable_eventfd wakeup;
+  seastar::writeable_eventfd wakeup_write;
+  bool stopping = false;
+  seastar::future<> drained = seastar::now();
 };
 
+/// items waiting for a worker thread; pushed to by any reactor without
+/// locking, the mutex is only taken to put the worker to sleep and to wake
+/// it up
 struct ShardedWorkQueue {
 public:
+  explicit ShardedWorkQueue(size_t capacity)
+    : pending(capacity)
+  {}
   WorkItem* pop_front(std::chrono::milliseconds& queue_max_wait) {
     WorkItem* work_item = nullptr;
+    if (pending.pop(work_item)) {
+      return work_item;
+    }
     std::unique_lock lock{mutex};
+    sleeping.store(true);
+    // pairs with the fence in push_back(): either we see the item, or the
+    // producer sees that we are going to sleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
     cond.wait_for(lock, queue_max_wait,
 		  [this, &work_item] {
-      bool empty = true;
-      if (!pending.empty()) {
-        empty = false;
-        work_item = pending.front();
-        pending.pop_front();
-      }
-      return !empty || is_stopping();
+      return pending.pop(work_item) || is_stopping();
     });
+    sleeping.store(false, std::memory_order_relaxed);
     return work_item;
   }
   void stop() {
+    std::lock_guard lock{mutex};
     stopping = true;
     cond.notify_all();
   }
   void push_back(WorkItem* work_item) {
-    pending.push_back(work_item);
-    cond.notify_one();
+    while (!pending.push(work_item)) {
+      // can only fail if no node can be allocated
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) {
+      std::lock_guard lock{mutex};
+      cond.notify_one();
+    }
   }
 private:
   bool is_stopping() const {
     return stopping;
   }
   bool stopping = false;
+  std::atomic<bool> sleeping = false;
   std::mutex mutex;
   std::condition_variable cond;
-  std::deque<WorkItem*> pending;
+  boost::lockfree::queue<WorkItem*> pending;
 };
 
 /// an engine for scheduling non-seastar tasks from seastar fibers
@@ -114,13 +154,15 @@ class ThreadPool {
   std::vector<std::thread> threads;
   seastar::sharded<SubmitQueue> submit_queue;
   const size_t queue_size;
-  std::vector<ShardedWorkQueue> pending_queues;
+  std::deque<ShardedWorkQueue> pending_queues;
 
   void loop(std::chrono::milliseconds queue_max_wait, size_t shard);
   bool is_stopping() const {
     return stopping.load(std::memory_order_relaxed);
   }
   static void pin(const std::vector<uint64_t>& cpus);
+  /// the CPUs thread i may run on
+  std::vector<uint64_t> cpus_of(size_t i, const std::vector<uint64_t>& cpus);
   static void block_sighup();
   seastar::semaphore& local_free_slots() {
     return submit_queue.local().free_slots;
@@ -155,6 +197,7 @@ public:
         return local_free_slots().wait()
           .then([packaged=std::move(packaged), shard, this] {
             auto task = new Task{std::move(packaged)};
+            task->origin = &submit_queue.local();
             auto fut = task->get_future();
 	    pending_queues[shard].push_back(task);
             return fut.finally([task, this] {
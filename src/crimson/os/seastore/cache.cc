@@ -1,6 +1,7 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
 // vim: ts=8 sw=2 smarttab
 
+#include "crimson/common/config_proxy.h"
 #include "crimson/os/seastore/logging.h"
 #include "crimson/os/seastore/cache.h"
 
@@ -11,12 +12,19 @@
 #include "crimson/os/seastore/object_data_handler.h"
 #include "crimson/os/seastore/collection_manager/collection_flat_node.h"
 #include "crimson/os/seastore/onode_manager/staged-fltree/node_extent_manager/seastore.h"
+#include "crimson/os/seastore/onode_manager/staged-fltree/stages/node_stage_layout.h"
 #include "test/crimson/seastore/test_block.h"
 
 namespace crimson::os::seastore {
 
 Cache::Cache(SegmentManager &segment_manager) :
-  segment_manager(segment_manager) {}
+  segment_manager(segment_manager),
+  capacity(crimson::common::get_conf<Option::size_t>("seastore_cache_size")),
+  // as many as half of the capacity in pages, as suggested by the 2Q paper
+  max_ghosts(capacity / 2 / CEPH_PAGE_SIZE)
+{
+  register_metrics();
+}
 
 Cache::~Cache()
 {
@@ -48,6 +56,57 @@ Cache::retire_extent_ret Cache::retire_extent(
   }
 }
 
+void Cache::register_metrics()
+{
+  namespace sm = seastar::metrics;
+  metrics.add_group("cache", {
+    sm::make_counter("hits", stats.hits,
+		     sm::description("total number of extents read from the cache")),
+    sm::make_counter("misses", stats.misses,
+		     sm::description("total number of extents read from the disk")),
+    sm::make_counter("evictions", stats.evictions,
+		     sm::description("total number of clean extents evicted")),
+    sm::make_counter("evicted_bytes", stats.evicted_bytes,
+		     sm::description("total size of clean extents evicted")),
+    sm::make_gauge("probation_bytes", probation_bytes,
+		   sm::description("size of clean extents seen once")),
+    sm::make_gauge("main_bytes", main_bytes,
+		   sm::description("size of clean extents seen more than once")),
+  });
+
+  auto src_label = sm::label("src");
+  const std::array<std::pair<Transaction::src_t, const char*>,
+		   Transaction::SRC_MAX> srcs = {{
+    {Transaction::src_t::MUTATE, "MUTATE"},
+    {Transaction::src_t::READ, "READ"},
+    {Transaction::src_t::CLEANER, "CLEANER"},
+  }};
+  for (auto [src, name] : srcs) {
+    metrics.add_group("cache", {
+      sm::make_counter("trans_created",
+		       get_by_src(stats.trans_created, src),
+		       sm::description("total number of transactions created"),
+		       {src_label(name)}),
+      sm::make_counter("trans_committed",
+		       get_by_src(stats.trans_committed, src),
+		       sm::description("total number of transactions committed"),
+		       {src_label(name)}),
+      sm::make_counter("trans_conflicts",
+		       get_by_src(stats.trans_conflicts, src),
+		       sm::description("total number of transactions invalidated "
+				       "by a conflicting commit, each of them "
+				       "is retried"),
+		       {src_label(name)}),
+      sm::make_counter("trans_conflicts_avoided",
+		       get_by_src(stats.trans_conflicts_avoided, src),
+		       sm::description("total number of transactions which read "
+				       "an extent mutated by another commit, "
+				       "but none of the keys it changed"),
+		       {src_label(name)}),
+    });
+  }
+}
+
 void Cache::dump_contents()
 {
   LOG_PREFIX(Cache::dump_contents);
@@ -80,6 +139,7 @@ void Cache::mark_dirty(CachedExtentRef ref)
     return;
   }
 
+  uncache_extent(*ref);
   add_to_dirty(ref);
   ref->state = CachedExtent::extent_state_t::DIRTY;
 
@@ -105,11 +165,116 @@ void Cache::remove_from_dirty(CachedExtentRef ref)
   }
 }
 
+namespace {
+
+/// Whether extent is an interior node of one of the trees
+bool is_interior_node(const CachedExtent &extent)
+{
+  switch (extent.get_type()) {
+  case extent_types_t::LADDR_INTERNAL:
+  case extent_types_t::OMAP_INNER:
+    return true;
+  case extent_types_t::ONODE_BLOCK_STAGED: {
+    auto header = reinterpret_cast<const onode::node_header_t*>(
+      extent.get_bptr().c_str());
+    return header->get_node_type() == onode::node_type_t::INTERNAL;
+  }
+  default:
+    return false;
+  }
+}
+
+}
+
+void Cache::touch_extent(CachedExtent &extent)
+{
+  if (extent.state != CachedExtent::extent_state_t::CLEAN) {
+    return;
+  }
+  if (extent.primary_ref_list_hook.is_linked()) {
+    // a clean extent can only be linked into one of our queues.  hits in
+    // probation leave it where it is, it has yet to prove itself.
+    if (extent.in_main_queue) {
+      main.erase(main.s_iterator_to(extent));
+      main.push_back(extent);
+    }
+    return;
+  }
+  intrusive_ptr_add_ref(&extent);
+  bool promote = is_interior_node(extent);
+  if (auto ghost = ghost_index.find(extent.get_paddr());
+      ghost != ghost_index.end()) {
+    ghosts.erase(ghost->second);
+    ghost_index.erase(ghost);
+    promote = true;
+  }
+  extent.in_main_queue = promote;
+  if (promote) {
+    main.push_back(extent);
+    main_bytes += extent.get_length();
+  } else {
+    probation.push_back(extent);
+    probation_bytes += extent.get_length();
+  }
+  evict_extents();
+}
+
+void Cache::uncache_extent(CachedExtent &extent)
+{
+  if (!is_cached_clean(extent)) {
+    return;
+  }
+  if (extent.in_main_queue) {
+    main.erase(main.s_iterator_to(extent));
+    main_bytes -= extent.get_length();
+  } else {
+    probation.erase(probation.s_iterator_to(extent));
+    probation_bytes -= extent.get_length();
+  }
+  // our caller still holds a reference
+  intrusive_ptr_release(&extent);
+}
+
+void Cache::evict_extents()
+{
+  LOG_PREFIX(Cache::evict_extents);
+  while (probation_bytes + main_bytes > capacity) {
+    // probation gets a quarter of the capacity, or whatever main leaves
+    bool from_probation = main.empty() ||
+      (!probation.empty() && probation_bytes > capacity / 4);
+    auto &queue = from_probation ? probation : main;
+    auto &extent = queue.front();
+    queue.pop_front();
+    auto length = extent.get_length();
+    if (from_probation) {
+      probation_bytes -= length;
+      if (max_ghosts) {
+	if (ghosts.size() >= max_ghosts) {
+	  ghost_index.erase(ghosts.front());
+	  ghosts.pop_front();
+	}
+	auto paddr = extent.get_paddr();
+	if (auto [ghost, inserted] = ghost_index.emplace(paddr, ghosts.end());
+	    inserted) {
+	  ghost->second = ghosts.insert(ghosts.end(), paddr);
+	}
+      }
+    } else {
+      main_bytes -= length;
+    }
+    ++stats.evictions;
+    stats.evicted_bytes += length;
+    DEBUG("extent {}", extent);
+    intrusive_ptr_release(&extent);
+  }
+}
+
 void Cache::remove_extent(CachedExtentRef ref)
 {
   LOG_PREFIX(Cache::remove_extent);
   DEBUG("extent {}", *ref);
   assert(ref->is_valid());
+  uncache_extent(*ref);
   remove_from_dirty(ref);
   extents.erase(*ref);
 }
@@ -120,6 +285,7 @@ void Cache::retire_extent(CachedExtentRef ref)
   DEBUG("extent {}", *ref);
   assert(ref->is_valid());
 
+  uncache_extent(*ref);
   remove_from_dirty(ref);
   ref->dirty_from_or_retired_at = JOURNAL_SEQ_MAX;
   retired_extent_gate.add_extent(*ref);
@@ -133,6 +299,7 @@ void Cache::replace_extent(CachedExtentRef next, CachedExtentRef prev)
   assert(next->get_paddr() == prev->get_paddr());
   assert(next->version == prev->version + 1);
   extents.replace(*next, *prev);
+  uncache_extent(*prev);
 
   if (prev->get_type() == extent_types_t::ROOT) {
     assert(prev->primary_ref_list_hook.is_linked());
@@ -155,6 +322,86 @@ void Cache::replace_extent(CachedExtentRef next, CachedExtentRef prev)
   prev->state = CachedExtent::extent_state_t::INVALID;
 }
 
+void Cache::mark_readers_conflicted(
+  Transaction &t,
+  CachedExtent &extent,
+  CachedExtentRef next)
+{
+  LOG_PREFIX(Cache::mark_readers_conflicted);
+  std::optional<conflict_key_ranges_t> changed;
+  if (next) {
+    changed = next->get_changed_keys();
+  }
+  for (auto iter = extent.readers.begin(); iter != extent.readers.end(); ) {
+    auto &item = *iter++;
+    if (item.t == &t || item.t->conflicted) {
+      continue;
+    }
+    if (changed && item.keys &&
+	!overlaps(*item.keys, *changed) &&
+	!item.t->is_writing(extent)) {
+      DEBUGT("{} read none of the keys changed in {}",
+	     t, (void*)item.t, extent);
+      ++get_by_src(stats.trans_conflicts_avoided, item.t->get_src());
+      extent.readers.erase(extent.readers.iterator_to(item));
+      next->readers.push_back(item);
+      item.extent = next;
+      continue;
+    }
+    DEBUGT("conflicts with {} on {}", t, (void*)item.t, extent);
+    mark_conflicted(*item.t);
+  }
+}
+
+void Cache::mark_conflicted(Transaction &t)
+{
+  assert(!t.conflicted);
+  t.conflicted = true;
+  t.retry_after = last_prepared_commit;
+  ++get_by_src(stats.trans_conflicts, t.get_src());
+}
+
+void Cache::track_read_keys(Transaction &t, CachedExtent &extent)
+{
+  if (auto item = find_read_item(t, extent); item && !item->keys) {
+    item->keys.emplace();
+  }
+}
+
+bool Cache::add_read_keys(
+  Transaction &t,
+  CachedExtent &extent,
+  conflict_key_range_t keys)
+{
+  LOG_PREFIX(Cache::add_read_keys);
+  if (t.is_weak() || extent.is_pending()) {
+    // pending extents are written by t, any change to them conflicts
+    return true;
+  }
+  if (!extent.is_valid()) {
+    DEBUGT("{} was replaced since it was read", t, extent);
+    if (!t.conflicted) {
+      mark_conflicted(t);
+    }
+    return false;
+  }
+  if (auto item = find_read_item(t, extent); item && item->keys) {
+    item->keys->push_back(std::move(keys));
+  }
+  return true;
+}
+
+seastar::future<> Cache::wait_for_retry(const Transaction &t)
+{
+  assert(t.conflicted);
+  if (t.retry_after <= last_completed_commit) {
+    return seastar::now();
+  }
+  return retry_waiters.emplace(
+    t.retry_after, seastar::promise<>()
+  )->second.get_future();
+}
+
 CachedExtentRef Cache::alloc_new_extent_by_type(
   Transaction &t,       ///< [in, out] current transaction
   extent_types_t type,  ///< [in] type tag
@@ -203,6 +450,13 @@ CachedExtentRef Cache::duplicate_for_write(
   if (i->is_pending())
     return i;
 
+  if (!i->is_valid() && !t.is_conflicted()) {
+    // i was replaced by a commit changing none of the keys t read from
+    // it, see track_read_keys(), but t cannot write it any more
+    DEBUGT("{} was replaced since it was read", t, *i);
+    mark_conflicted(t);
+  }
+
   auto ret = i->duplicate_for_write();
   ret->prior_instance = i;
   t.add_mutated_extent(ret);
@@ -223,14 +477,21 @@ std::optional<record_t> Cache::try_construct_record(Transaction &t)
   LOG_PREFIX(Cache::try_construct_record);
   DEBUGT("enter", t);
 
-  // First, validate read set
+  // First, validate read set: any extent of it invalidated since it was
+  // read flagged t as conflicted
+  if (t.is_conflicted()) {
+    return std::nullopt;
+  }
+#ifndef NDEBUG
+  // extents replaced by commits which changed none of the keys t read
+  // from them stay in the read set, t follows the readers of the new ones
   for (auto &i: t.read_set) {
-    if (i->state == CachedExtent::extent_state_t::INVALID) {
-      return std::nullopt;
-    }
+    assert(i->is_valid() || find_read_item(t, *i) == nullptr);
   }
+#endif
 
   DEBUGT("read_set validated", t);
+  t.commit_id = ++last_prepared_commit;
 
   record_t record;
 
@@ -246,6 +507,7 @@ std::optional<record_t> Cache::try_construct_record(Transaction &t)
     DEBUGT("mutating {}", t, *i);
 
     assert(i->prior_instance);
+    mark_readers_conflicted(t, *i->prior_instance, i);
     replace_extent(i, i->prior_instance);
 
     i->prepare_write();
@@ -289,6 +551,7 @@ std::optional<record_t> Cache::try_construct_record(Transaction &t)
   // invalidate now invalid blocks
   for (auto &i: t.retired_set) {
     DEBUGT("retiring {}", t, *i);
+    mark_readers_conflicted(t, *i);
     retire_extent(i);
   }
 
@@ -339,6 +602,15 @@ void Cache::complete_commit(
 {
   LOG_PREFIX(Cache::complete_commit);
   DEBUGT("enter", t);
+  ++get_by_src(stats.trans_committed, t.get_src());
+
+  // commits complete in the order they were prepared
+  last_completed_commit = std::max(last_completed_commit, t.commit_id);
+  while (!retry_waiters.empty() &&
+	 retry_waiters.begin()->first <= last_completed_commit) {
+    retry_waiters.begin()->second.set_value();
+    retry_waiters.erase(retry_waiters.begin());
+  }
 
   for (auto &i: t.fresh_block_list) {
     i->set_paddr(final_block_start.add_relative(i->get_paddr()));
@@ -353,6 +625,7 @@ void Cache::complete_commit(
     i->state = CachedExtent::extent_state_t::CLEAN;
     DEBUGT("fresh {}", t, *i);
     add_extent(i);
+    touch_extent(*i);
     if (cleaner) {
       cleaner->mark_space_used(
 	i->get_paddr(),
@@ -423,7 +696,19 @@ Cache::mkfs_ertr::future<> Cache::mkfs(Transaction &t)
 
 Cache::close_ertr::future<> Cache::close()
 {
+  for (auto &[after, waiter] : retry_waiters) {
+    waiter.set_value();
+  }
+  retry_waiters.clear();
   root.reset();
+  for (auto queue : {&probation, &main}) {
+    queue->clear_and_dispose([](CachedExtent *extent) {
+      intrusive_ptr_release(extent);
+    });
+  }
+  probation_bytes = main_bytes = 0;
+  ghosts.clear();
+  ghost_index.clear();
   for (auto i = dirty.begin(); i != dirty.end(); ) {
     auto ptr = &*i;
     dirty.erase(i++);
@@ -3,7 +3,10 @@
 
 #pragma once
 
+#include <array>
 #include <iostream>
+#include <list>
+#include <map>
 
 #include "seastar/core/shared_future.hh"
 
@@ -82,6 +85,18 @@ namespace crimson::os::seastore {
  *   CachedExtent::delta_written(paddr_t) with the address of the start
  *   of the record
  * - Complete all promises with the final record start paddr_t
+ *
+ * Cache::extents only refers weakly to the extents it indexes: dirty
+ * extents are held by Cache::dirty, and the clean ones are kept alive
+ * by a 2Q replacement policy within seastore_cache_size bytes.  A clean
+ * extent first goes into the probation queue, where further hits don't
+ * change its position, so that a one-off scan doesn't flush the cache.
+ * It is only promoted to the main LRU queue if it's read back after
+ * having been evicted from probation, which we tell from the addresses
+ * remembered in the ghost queue.  Interior nodes of the LBA, omap and
+ * onode trees go straight to the main queue.  Evicting an extent drops
+ * the cache's reference only: an extent still in use stays valid and
+ * indexed.
  */
 class Cache {
 public:
@@ -95,11 +110,14 @@ public:
   retired_extent_gate_t retired_extent_gate;
 
   /// Creates empty transaction
-  TransactionRef create_transaction() {
+  TransactionRef create_transaction(
+    Transaction::src_t src = Transaction::src_t::MUTATE) {
     LOG_PREFIX(Cache::create_transaction);
+    ++get_by_src(stats.trans_created, src);
     auto ret = std::make_unique<Transaction>(
       get_dummy_ordering_handle(),
       false,
+      src,
       last_commit
     );
     retired_extent_gate.add_token(ret->retired_gate_token);
@@ -110,9 +128,11 @@ public:
   /// Creates empty weak transaction
   TransactionRef create_weak_transaction() {
     LOG_PREFIX(Cache::create_weak_transaction);
+    ++get_by_src(stats.trans_created, Transaction::src_t::READ);
     auto ret = std::make_unique<Transaction>(
       get_dummy_ordering_handle(),
       true,
+      Transaction::src_t::READ,
       last_commit
     );
     retired_extent_gate.add_token(ret->retired_gate_token);
@@ -178,10 +198,12 @@ public:
   ) {
     if (auto iter = extents.find_offset(offset);
 	       iter != extents.end()) {
+      ++stats.hits;
       auto ret = TCachedExtentRef<T>(static_cast<T*>(&*iter));
       return ret->wait_io(
-      ).then([ret=std::move(ret)]() mutable -> get_extent_ret<T> {
+      ).then([this, ret=std::move(ret)]() mutable -> get_extent_ret<T> {
         if (ret->is_valid()) {
+	  touch_extent(*ret);
           return get_extent_ret<T>(
             get_extent_ertr::ready_future_marker{},
             std::move(ret));
@@ -190,6 +212,7 @@ public:
 	}
       });
     } else {
+      ++stats.misses;
       auto ref = CachedExtent::make_cached_extent_ref<T>(
 	alloc_cache_buf(length));
       ref->set_io_wait();
@@ -201,12 +224,14 @@ public:
 	offset,
 	length,
 	ref->get_bptr()).safe_then(
-	  [ref=std::move(ref)]() mutable {
+	  [this, ref=std::move(ref)]() mutable {
 	    /* TODO: crc should be checked against LBA manager */
 	    ref->last_committed_crc = ref->get_crc32c();
 
 	    ref->on_clean_read();
 	    ref->complete_io();
+	    // only now can we tell an interior node by its contents
+	    touch_extent(*ref);
 	    return get_extent_ertr::make_ready_future<TCachedExtentRef<T>>(
 	      std::move(ref));
 	  },
@@ -247,6 +272,9 @@ public:
    * - disk
    *
    * t *must not* have retired offset
+   *
+   * Fails with eagain if t is already conflicted, after
+   * wait_for_retry().
    */
   template <typename T>
   get_extent_ertr::future<TCachedExtentRef<T>> get_extent(
@@ -254,6 +282,13 @@ public:
     paddr_t offset,       ///< [in] starting addr
     segment_off_t length  ///< [in] length
   ) {
+    if (t.is_conflicted()) {
+      return get_extent_ertr::now().safe_then([this, &t] {
+	return wait_for_retry(t);
+      }).safe_then([]() -> get_extent_ertr::future<TCachedExtentRef<T>> {
+	return crimson::ct_error::eagain::make();
+      });
+    }
     CachedExtentRef ret;
     auto result = t.get_extent(offset, &ret);
     if (result != Transaction::get_extent_ret::ABSENT) {
@@ -380,6 +415,45 @@ public:
     CachedExtentRef i  ///< [in] ref to existing extent
   );
 
+  /**
+   * track_read_keys
+   *
+   * From now on, t only depends on the keys of extent it adds with
+   * add_read_keys(), rather than on the whole extent: a commit mutating
+   * extent only conflicts t if it changes one of them, as told by
+   * CachedExtent::get_changed_keys(), or if t mutates or retires extent
+   * itself.  Does nothing if t already tracks the keys it read from
+   * extent, or if extent is not in the read set of t.
+   *
+   * Every user of the contents of extent in t must then call
+   * add_read_keys() before reading them.
+   */
+  void track_read_keys(Transaction &t, CachedExtent &extent);
+
+  /**
+   * add_read_keys
+   *
+   * Adds keys to those of extent t depends on, see track_read_keys().
+   * Returns false, and flags t as conflicted, if extent has been
+   * replaced by a commit since t read it: it must not be read any
+   * further, and t should fail with eagain.
+   */
+  bool add_read_keys(
+    Transaction &t,
+    CachedExtent &extent,
+    conflict_key_range_t keys);
+
+  /**
+   * wait_for_retry
+   *
+   * Resolves once the commit which conflicted t has completed, for t to
+   * fail with eagain and be retried then.  Conflicted transactions are
+   * queued in the order of the commits which conflicted them, so that
+   * their retries neither race the writes they conflicted with, nor
+   * overtake one another.
+   */
+  seastar::future<> wait_for_retry(const Transaction &t);
+
   /**
    * try_construct_record
    *
@@ -462,6 +536,10 @@ public:
   {
     std::vector<CachedExtentRef> dirty;
     for (auto &e : extents) {
+      if (e.use_count() == 1 && is_cached_clean(e)) {
+	// only alive because the cache holds on to it
+	continue;
+      }
       dirty.push_back(CachedExtentRef(&e));
     }
     return seastar::do_with(
@@ -543,13 +621,67 @@ public:
   /// Dump live extents
   void dump_contents();
 
+  /// Size of the clean extents kept cached
+  size_t get_cached_bytes() const {
+    return probation_bytes + main_bytes;
+  }
+
+  const auto &get_stats() const {
+    return stats;
+  }
+
 private:
   SegmentManager &segment_manager; ///< ref to segment_manager
   RootBlockRef root;               ///< ref to current root
   ExtentIndex extents;             ///< set of live extents
 
+  /// memory budget of the clean extents in probation and main
+  const size_t capacity;
+  CachedExtent::list probation;    ///< seen once, oldest first
+  CachedExtent::list main;         ///< seen again, least recent first
+  size_t probation_bytes = 0;
+  size_t main_bytes = 0;
+
+  /// addresses of extents recently evicted from probation, oldest first
+  std::list<paddr_t> ghosts;
+  std::map<paddr_t, std::list<paddr_t>::iterator> ghost_index;
+  const size_t max_ghosts;
+
+  struct {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t evicted_bytes = 0;
+
+    /// indexed by Transaction::src_t
+    using counter_by_src_t = std::array<uint64_t, Transaction::SRC_MAX>;
+    counter_by_src_t trans_created = {};
+    counter_by_src_t trans_committed = {};
+    /// transactions invalidated by the commit of another one
+    counter_by_src_t trans_conflicts = {};
+    /// transactions which read an extent replaced by the commit of
+    /// another one, but none of the keys it changed
+    counter_by_src_t trans_conflicts_avoided = {};
+  } stats;
+
+  template <typename CounterT>
+  static auto &get_by_src(CounterT &counters, Transaction::src_t src) {
+    assert(static_cast<std::size_t>(src) < counters.size());
+    return counters[static_cast<std::size_t>(src)];
+  }
+  seastar::metrics::metric_group metrics;
+  void register_metrics();
+
   journal_seq_t last_commit = JOURNAL_SEQ_MIN;
 
+  /// ids of the commits, see Transaction::commit_id
+  uint64_t last_prepared_commit = 0;
+  uint64_t last_completed_commit = 0;
+
+  /// conflicted transactions waiting in wait_for_retry(), by the id of
+  /// the commit which conflicted them
+  std::multimap<uint64_t, seastar::promise<>> retry_waiters;
+
   /**
    * dirty
    *
@@ -578,6 +710,21 @@ private:
   /// Remove from dirty list
   void remove_from_dirty(CachedExtentRef ref);
 
+  /// Whether extent is a clean extent in probation or main
+  static bool is_cached_clean(const CachedExtent &extent) {
+    return extent.state == CachedExtent::extent_state_t::CLEAN &&
+      extent.primary_ref_list_hook.is_linked();
+  }
+
+  /// Keep clean extent cached, or refresh it if it already is
+  void touch_extent(CachedExtent &extent);
+
+  /// Stop keeping extent cached, it's about to become dirty or invalid
+  void uncache_extent(CachedExtent &extent);
+
+  /// Evict clean extents until within capacity
+  void evict_extents();
+
   /// Remove extent from extents handling dirty and refcounting
   void remove_extent(CachedExtentRef ref);
 
@@ -587,6 +734,30 @@ private:
   /// Replace prev with next
   void replace_extent(CachedExtentRef next, CachedExtentRef prev);
 
+  /// Flag the transactions other than t which have read extent, it is
+  /// about to be retired by t, or replaced with next. Readers which only
+  /// depended on keys next did not change are linked to next instead,
+  /// see track_read_keys() and doc/dev/seastore.rst
+  void mark_readers_conflicted(
+    Transaction &t,
+    CachedExtent &extent,
+    CachedExtentRef next = CachedExtentRef());
+
+  /// Flag t as conflicted by the last prepared commit
+  void mark_conflicted(Transaction &t);
+
+  /// Returns the item linking t into the readers of extent, or nullptr
+  static read_set_item_t *find_read_item(
+    Transaction &t,
+    CachedExtent &extent) {
+    for (auto &item : extent.readers) {
+      if (item.t == &t) {
+	return &item;
+      }
+    }
+    return nullptr;
+  }
+
   Transaction::get_extent_ret query_cache_for_extent(
     paddr_t offset,
     CachedExtentRef *out) {
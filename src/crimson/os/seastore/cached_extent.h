@@ -4,6 +4,9 @@
 #pragma once
 
 #include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive_ptr.hpp>
@@ -31,6 +34,83 @@ void intrusive_ptr_release(CachedExtent *);
 template <typename T>
 using TCachedExtentRef = boost::intrusive_ptr<T>;
 
+class Transaction;
+
+/**
+ * conflict_key_range_t
+ *
+ * Closed range of the keys of an extent, in a key space up to the
+ * extent type. Used to tell which keys a transaction depended on when
+ * reading an extent, and which ones a commit changed when mutating it.
+ * last == nullopt stands for the end of the key space, so a default
+ * constructed range covers all of it.
+ */
+struct conflict_key_range_t {
+  std::string first;
+  std::optional<std::string> last;
+
+  bool overlaps(const conflict_key_range_t &rhs) const {
+    return (!last || rhs.first <= *last) &&
+      (!rhs.last || first <= *rhs.last);
+  }
+};
+using conflict_key_ranges_t = std::vector<conflict_key_range_t>;
+
+inline bool overlaps(
+  const conflict_key_ranges_t &lhs,
+  const conflict_key_ranges_t &rhs) {
+  for (auto &l : lhs) {
+    for (auto &r : rhs) {
+      if (l.overlaps(r)) {
+	return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * read_set_item_t
+ *
+ * Links a transaction into the readers of an extent it holds in its
+ * read set, so that committing a conflicting write can flag the reader
+ * at once rather than leaving it to find out when it tries to commit.
+ * Unlinks itself when destroyed along with the transaction.
+ */
+struct read_set_item_t {
+  using hook_t = boost::intrusive::list_member_hook<
+    boost::intrusive::link_mode<boost::intrusive::auto_unlink>>;
+  hook_t hook;
+  Transaction *t;
+
+  /**
+   * keys
+   *
+   * Keys of the extent t depended on, see Cache::track_read_keys().
+   * nullopt, the default, means the whole extent.
+   */
+  std::optional<conflict_key_ranges_t> keys;
+
+  /**
+   * extent
+   *
+   * Set once a commit which changed none of the keys replaced the
+   * extent t read: *this then links t into the readers of the new
+   * instance, which it keeps alive.
+   */
+  CachedExtentRef extent;
+
+  explicit read_set_item_t(Transaction *t) : t(t) {}
+
+  using list = boost::intrusive::list<
+    read_set_item_t,
+    boost::intrusive::member_hook<
+      read_set_item_t,
+      hook_t,
+      &read_set_item_t::hook>,
+    boost::intrusive::constant_time_size<false>>;
+};
+
 /**
  * CachedExtent
  */
@@ -119,6 +199,18 @@ public:
    */
   virtual extent_types_t get_type() const = 0;
 
+  /**
+   * get_changed_keys
+   *
+   * Called on a mutation pending extent prior to get_delta(). Returns
+   * the keys changed since duplicate_for_write(), readers of the prior
+   * instance which depended on none of them are not invalidated by
+   * its commit. nullopt, the default, means the whole extent.
+   */
+  virtual std::optional<conflict_key_ranges_t> get_changed_keys() const {
+    return std::nullopt;
+  }
+
   virtual bool is_logical() const {
     return false;
   }
@@ -314,6 +406,13 @@ private:
     primary_ref_list_member_options>;
   friend class retired_extent_gate_t;
 
+  /// Set if primary_ref_list_hook links this clean extent into the main
+  /// queue of Cache, rather than into its probation queue
+  bool in_main_queue = false;
+
+  /// transactions with this extent in their read set
+  read_set_item_t::list readers;
+
   /**
    * dirty_from_or_retired_at
    *
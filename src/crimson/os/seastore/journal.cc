@@ -5,9 +5,12 @@
 
 #include <boost/iterator/counting_iterator.hpp>
 
+#include <seastar/core/reactor.hh>
+
 #include "crimson/os/seastore/journal.h"
 
 #include "include/intarith.h"
+#include "crimson/common/config_proxy.h"
 #include "crimson/os/seastore/segment_manager.h"
 
 namespace {
@@ -49,7 +52,129 @@ segment_nonce_t generate_nonce(
 }
 
 Journal::Journal(SegmentManager &segment_manager)
-  : segment_manager(segment_manager) {}
+  : segment_manager(segment_manager),
+    batch_timer([this] { flush_batch(); }),
+    batch_capacity(crimson::common::get_conf<uint64_t>(
+      "seastore_journal_batch_capacity")),
+    batch_flush_size(crimson::common::get_conf<Option::size_t>(
+      "seastore_journal_batch_flush_size")),
+    batch_latency(crimson::common::get_conf<uint64_t>(
+      "seastore_journal_batch_latency_us"))
+{
+  register_metrics();
+}
+
+void Journal::batch_histogram_t::add(uint64_t value)
+{
+  ++sample_count;
+  sample_sum += value;
+  for (unsigned i = 0; i < NUM_BUCKETS; ++i) {
+    if (value <= (base << i)) {
+      ++buckets[i];
+      return;
+    }
+  }
+  // only accounted in sample_count, i.e. the +Inf bucket
+}
+
+seastar::metrics::histogram Journal::batch_histogram_t::get_histogram() const
+{
+  seastar::metrics::histogram h;
+  h.sample_count = sample_count;
+  h.sample_sum = sample_sum;
+  h.buckets.resize(NUM_BUCKETS);
+  uint64_t cumulative = 0;
+  for (unsigned i = 0; i < NUM_BUCKETS; ++i) {
+    cumulative += buckets[i];
+    h.buckets[i].count = cumulative;
+    h.buckets[i].upper_bound = base << i;
+  }
+  return h;
+}
+
+void Journal::register_metrics()
+{
+  namespace sm = seastar::metrics;
+  metrics.add_group("journal", {
+    sm::make_counter("batches", stats.batches,
+		     sm::description("total number of journal writes")),
+    sm::make_counter("records", stats.records,
+		     sm::description("total number of records written")),
+    sm::make_counter("bytes", stats.bytes,
+		     sm::description("total size of records written")),
+    sm::make_gauge("writes_in_flight", writes_in_flight,
+		   sm::description("number of outstanding journal writes")),
+    sm::make_histogram("records_per_batch",
+		       sm::description("number of records per journal write"),
+		       [this] {
+			 return stats.records_per_batch.get_histogram();
+		       }),
+    sm::make_histogram("bytes_per_batch",
+		       sm::description("size of journal writes"),
+		       [this] {
+			 return stats.bytes_per_batch.get_histogram();
+		       }),
+  });
+}
+
+void Journal::flush_batch()
+{
+  assert(pending_batch);
+  batch_timer.cancel();
+  auto batch = std::move(pending_batch);
+  logger().debug(
+    "flush_batch: {} records, {} bytes at {}",
+    batch->num_records,
+    batch->bl.length(),
+    batch->start);
+  ++stats.batches;
+  stats.records += batch->num_records;
+  stats.bytes += batch->bl.length();
+  stats.records_per_batch.add(batch->num_records);
+  stats.bytes_per_batch.add(batch->bl.length());
+
+  ++writes_in_flight;
+  auto &segment = *batch->segment;
+  auto start = batch->start;
+  std::ignore = segment.write(
+    start, batch->bl
+  ).safe_then([] {
+    return true;
+  }).handle_error(
+    crimson::ct_error::all_same_way([start](const auto &) {
+      // every record of the batch fails, see write_record()
+      logger().error("flush_batch: write at {} failed", start);
+      return false;
+    })
+  ).then([this, batch = std::move(batch)](bool ok) {
+    batch->written.set_value(ok);
+    --writes_in_flight;
+    // records submitted while the write was in flight
+    if (pending_batch) {
+      flush_batch();
+    }
+    if (writes_in_flight == 0 && writes_done) {
+      // the journal may be destroyed from here on
+      auto done = std::move(*writes_done);
+      writes_done.reset();
+      done.set_value();
+    }
+  });
+}
+
+seastar::future<> Journal::wait_for_writes()
+{
+  if (pending_batch) {
+    flush_batch();
+  }
+  if (writes_in_flight == 0) {
+    return seastar::now();
+  }
+  if (!writes_done) {
+    writes_done.emplace();
+  }
+  return writes_done->get_future();
+}
 
 
 Journal::initialize_segment_ertr::future<segment_seq_t>
@@ -200,26 +325,42 @@ Journal::write_record_ret Journal::write_record(
 
   auto segment_id = current_journal_segment->get_segment_id();
 
-  // Start write under the current exclusive stage, but wait for it
-  // in the device_submission concurrent stage to permit multiple
-  // overlapping writes.
-  auto write_fut = current_journal_segment->write(target, to_write);
+  // Queue the record under the current exclusive stage, but wait for
+  // its batch to be written in the device_submission concurrent stage,
+  // which permits multiple overlapping writes.
+  if (!pending_batch) {
+    pending_batch = std::make_unique<record_batch_t>(
+      current_journal_segment, target);
+  }
+  auto &batch = *pending_batch;
+  assert(batch.start + batch.bl.length() == target);
+  batch.bl.claim_append(to_write);
+  ++batch.num_records;
+  auto write_fut = batch.written.get_shared_future();
+  if (batch.num_records >= batch_capacity ||
+      batch.bl.length() >= batch_flush_size ||
+      (writes_in_flight == 0 && batch_latency.count() == 0)) {
+    flush_batch();
+  } else if (writes_in_flight == 0 && !batch_timer.armed()) {
+    // otherwise the completion of the in-flight write flushes the batch
+    batch_timer.arm(batch_latency);
+  }
   return handle.enter(write_pipeline->device_submission
   ).then([write_fut = std::move(write_fut)]() mutable {
-    return std::move(write_fut
-    ).handle_error(
-      write_record_ertr::pass_further{},
-      crimson::ct_error::assert_all{
-	"Invalid error in Journal::write_record"
+    return std::move(write_fut).then([](bool ok) -> write_record_ertr::future<> {
+      if (!ok) {
+	return crimson::ct_error::input_output_error::make();
       }
-    );
+      return write_record_ertr::now();
+    });
   }).safe_then([this, &handle] {
     return handle.enter(write_pipeline->finalize);
   }).safe_then([this, target, segment_id] {
     logger().debug(
       "write_record: commit target {}",
       target);
-    if (segment_id == current_journal_segment->get_segment_id()) {
+    if (current_journal_segment &&
+	segment_id == current_journal_segment->get_segment_id()) {
       assert(committed_to < target);
       committed_to = target;
     }
@@ -261,10 +402,19 @@ Journal::roll_journal_segment()
   auto old_segment_id = current_journal_segment ?
     current_journal_segment->get_segment_id() :
     NULL_SEG_ID;
+  if (pending_batch) {
+    // the records left belong to the segment being closed
+    flush_batch();
+  }
 
-  return (current_journal_segment ?
-	  current_journal_segment->close() :
-	  Segment::close_ertr::now()).safe_then([this] {
+  // the segment is closed once its last batch is written
+  return Segment::close_ertr::now().safe_then([this] {
+    return wait_for_writes();
+  }).safe_then([this] {
+    return current_journal_segment ?
+      current_journal_segment->close() :
+      Segment::close_ertr::now();
+  }).safe_then([this] {
       return segment_provider->get_segment();
     }).safe_then([this](auto segment) {
       return segment_manager.open(segment);
@@ -5,9 +5,15 @@
 
 #include "crimson/common/log.h"
 
+#include <array>
+#include <optional>
+
 #include <boost/intrusive_ptr.hpp>
 
 #include <seastar/core/future.hh>
+#include <seastar/core/metrics.hh>
+#include <seastar/core/shared_future.hh>
+#include <seastar/core/timer.hh>
 
 #include "include/ceph_assert.h"
 #include "include/buffer.h"
@@ -123,6 +129,13 @@ public:
 
 /**
  * Manages stream of atomically written records to a SegmentManager.
+ *
+ * Records are written in batches (group commit): while a journal write
+ * is in flight, the records submitted meanwhile are appended to a
+ * pending batch, which is written as a whole once the in-flight write
+ * completes, or as soon as it reaches seastore_journal_batch_capacity
+ * records or seastore_journal_batch_flush_size bytes.  Each record keeps
+ * its own header, so the on-disk format and replay are unaffected.
  */
 class Journal {
 public:
@@ -160,11 +173,16 @@ public:
   using close_ertr = crimson::errorator<
     crimson::ct_error::input_output_error>;
   close_ertr::future<> close() {
-    return (
-      current_journal_segment ?
-      current_journal_segment->close() :
-      Segment::close_ertr::now()
-    ).handle_error(
+    if (pending_batch) {
+      flush_batch();
+    }
+    return Segment::close_ertr::now().safe_then([this] {
+      return wait_for_writes();
+    }).safe_then([this] {
+      return current_journal_segment ?
+	current_journal_segment->close() :
+	Segment::close_ertr::now();
+    }).handle_error(
       close_ertr::pass_further{},
       crimson::ct_error::assert_all{
 	"Error during Journal::close()"
@@ -257,6 +275,10 @@ public:
     write_pipeline = _write_pipeline;
   }
 
+  const auto &get_stats() const {
+    return stats;
+  }
+
 private:
   JournalSegmentProvider *segment_provider = nullptr;
   SegmentManager &segment_manager;
@@ -270,6 +292,59 @@ private:
 
   WritePipeline *write_pipeline = nullptr;
 
+  /// records encoded back to back, written with a single segment write
+  struct record_batch_t {
+    SegmentRef segment;
+    segment_off_t start;
+    ceph::bufferlist bl;
+    unsigned num_records = 0;
+    /// false if the segment write failed
+    seastar::shared_promise<bool> written;
+
+    record_batch_t(SegmentRef segment, segment_off_t start)
+      : segment(std::move(segment)), start(start) {}
+  };
+  std::unique_ptr<record_batch_t> pending_batch;
+  unsigned writes_in_flight = 0;
+  /// set once writes_in_flight drops to 0, see wait_for_writes()
+  std::optional<seastar::promise<>> writes_done;
+  seastar::timer<> batch_timer;
+
+  const unsigned batch_capacity;
+  const size_t batch_flush_size;
+  const std::chrono::microseconds batch_latency;
+
+  /// writes out pending_batch
+  void flush_batch();
+
+  /// writes out pending_batch if any, and resolves once all the batches
+  /// are written and the continuations of their writes are done with the
+  /// journal
+  seastar::future<> wait_for_writes();
+
+  /// histogram with power of two buckets, starting at base
+  class batch_histogram_t {
+    static constexpr unsigned NUM_BUCKETS = 16;
+    const uint64_t base;
+    std::array<uint64_t, NUM_BUCKETS> buckets = {};
+    uint64_t sample_count = 0;
+    uint64_t sample_sum = 0;
+  public:
+    explicit batch_histogram_t(uint64_t base) : base(base) {}
+    void add(uint64_t value);
+    seastar::metrics::histogram get_histogram() const;
+  };
+
+  struct {
+    uint64_t batches = 0;
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    batch_histogram_t records_per_batch{1};
+    batch_histogram_t bytes_per_batch{4096};
+  } stats;
+  seastar::metrics::metric_group metrics;
+  void register_metrics();
+
   void reset_soft_state() {
     next_journal_segment_seq = 0;
     current_segment_nonce = 0;
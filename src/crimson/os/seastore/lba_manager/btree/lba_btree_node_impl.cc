@@ -7,6 +7,8 @@
 #include <memory>
 #include <string.h>
 
+#include <boost/iterator/counting_iterator.hpp>
+
 #include "include/buffer.h"
 #include "include/byteorder.h"
 
@@ -59,32 +61,47 @@ LBAInternalNode::lookup_range_ret LBAInternalNode::lookup_range(
   extent_len_t len)
 {
   auto [begin, end] = bound(addr, addr + len);
-  auto result_up = std::make_unique<lba_pin_list_t>();
-  auto &result = *result_up;
-  return crimson::do_for_each(
-    std::move(begin),
-    std::move(end),
-    [this, c, &result, addr, len](const auto &val) mutable {
+  std::vector<paddr_t> child_addrs;
+  for (auto i = begin; i != end; ++i) {
+    child_addrs.push_back(i->get_val());
+  }
+  auto children_up = std::make_unique<std::vector<LBANodeRef>>(
+    child_addrs.size());
+  auto &children = *children_up;
+  // Fetch all of the children covering addr~len at once, so that a range
+  // spanning several leaves doesn't wait for each leaf read in turn.
+  return lookup_range_ertr::parallel_for_each(
+    boost::make_counting_iterator(size_t(0)),
+    boost::make_counting_iterator(child_addrs.size()),
+    [this, c, &children, child_addrs=std::move(child_addrs)](size_t i) {
       return get_lba_btree_extent(
 	c,
 	this,
 	get_meta().depth - 1,
-	val.get_val(),
-	get_paddr()).safe_then(
-	  [c, &result, addr, len](auto extent) mutable {
-	    return extent->lookup_range(
-	      c,
-	      addr,
-	      len).safe_then(
-		[&result](auto pin_list) mutable {
-		  result.splice(result.end(), pin_list,
-				pin_list.begin(), pin_list.end());
-		});
-	  });
-    }).safe_then([result=std::move(result_up), ref=LBANodeRef(this)] {
-      return lookup_range_ertr::make_ready_future<lba_pin_list_t>(
-	std::move(*result));
-    });
+	child_addrs[i],
+	get_paddr()).safe_then([&children, i](auto extent) {
+	  children[i] = std::move(extent);
+	});
+    }).safe_then([c, addr, len, &children] {
+      auto result_up = std::make_unique<lba_pin_list_t>();
+      auto &result = *result_up;
+      return crimson::do_for_each(
+	children.begin(),
+	children.end(),
+	[c, &result, addr, len](auto &child) {
+	  return child->lookup_range(
+	    c,
+	    addr,
+	    len).safe_then(
+	      [&result](auto pin_list) mutable {
+		result.splice(result.end(), pin_list,
+			      pin_list.begin(), pin_list.end());
+	      });
+	}).safe_then([result=std::move(result_up)] {
+	  return lookup_range_ertr::make_ready_future<lba_pin_list_t>(
+	    std::move(*result));
+	});
+    }).finally([children=std::move(children_up), ref=LBANodeRef(this)] {});
 }
 
 LBAInternalNode::lookup_pin_ret LBAInternalNode::lookup_pin(
@@ -4,6 +4,8 @@
 #include <utility>
 #include <functional>
 
+#include <boost/iterator/counting_iterator.hpp>
+
 #include "crimson/common/log.h"
 
 #include "crimson/os/seastore/object_data_handler.h"
@@ -453,48 +455,58 @@ ObjectDataHandler::read_ret ObjectDataHandler::read(
 	    ceph_assert(_pins.size() >= 1);
 	    ceph_assert((*_pins.begin())->get_laddr() <= loffset);
 	    return seastar::do_with(
-	      std::move(_pins),
-	      loffset,
-	      [ctx, loffset, len, &ret](auto &pins, auto &current) {
-		return crimson::do_for_each(
-		  std::begin(pins),
-		  std::end(pins),
-		  [ctx, loffset, len, &current, &ret](auto &pin)
-		  -> read_ertr::future<> {
+	      std::vector<LBAPinRef>(
+		std::make_move_iterator(_pins.begin()),
+		std::make_move_iterator(_pins.end())),
+	      std::vector<ObjectDataBlockRef>(_pins.size()),
+	      [ctx, loffset, len, &ret](auto &pins, auto &extents) {
+		/* A large read spans many extents: issue all of the reads
+		 * at once rather than waiting for each of them in turn, then
+		 * assemble the result in laddr order. */
+		return read_ertr::parallel_for_each(
+		  boost::make_counting_iterator(size_t(0)),
+		  boost::make_counting_iterator(pins.size()),
+		  [ctx, &pins, &extents](size_t i) -> read_ertr::future<> {
+		    if (pins[i]->get_paddr().is_zero()) {
+		      return seastar::now();
+		    }
+		    return ctx.tm.pin_to_extent<ObjectDataBlock>(
+		      ctx.t,
+		      pins[i]->duplicate()
+		    ).safe_then([&extents, i](auto extent) {
+		      extents[i] = std::move(extent);
+		    }).handle_error(
+		      read_ertr::pass_further{},
+		      crimson::ct_error::assert_all{
+			"ObjectDataHandler::read hit invalid error"
+		      }
+		    );
+		  }
+		).safe_then([loffset, len, &pins, &extents, &ret] {
+		  laddr_t current = loffset;
+		  for (size_t i = 0; i < pins.size(); ++i) {
+		    auto &pin = pins[i];
 		    ceph_assert(current <= (loffset + len));
 		    ceph_assert(
 		      (loffset + len) > pin->get_laddr());
 		    laddr_t end = std::min(
 		      pin->get_laddr() + pin->get_length(),
 		      loffset + len);
-		    if (pin->get_paddr().is_zero()) {
-		      ceph_assert(end > current); // See LBAManager::get_mappings
+		    ceph_assert(end > current); // See LBAManager::get_mappings
+		    if (auto &extent = extents[i]; !extent) {
 		      ret.append_zero(end - current);
-		      current = end;
-		      return seastar::now();
 		    } else {
-		      return ctx.tm.pin_to_extent<ObjectDataBlock>(
-			ctx.t,
-			std::move(pin)
-		      ).safe_then([&ret, &current, end](auto extent) {
-			ceph_assert(
-			  (extent->get_laddr() + extent->get_length()) >= end);
-			ceph_assert(end > current);
-			ret.append(
-			  bufferptr(
-			    extent->get_bptr(),
-			    current - extent->get_laddr(),
-			    end - current));
-			current = end;
-			return seastar::now();
-		      }).handle_error(
-			read_ertr::pass_further{},
-			crimson::ct_error::assert_all{
-			  "ObjectDataHandler::read hit invalid error"
-			}
-		      );
+		      ceph_assert(
+			(extent->get_laddr() + extent->get_length()) >= end);
+		      ret.append(
+			bufferptr(
+			  extent->get_bptr(),
+			  current - extent->get_laddr(),
+			  end - current));
 		    }
-		  });
+		    current = end;
+		  }
+		});
 	      });
 	  });
 	}).safe_then([&ret] {
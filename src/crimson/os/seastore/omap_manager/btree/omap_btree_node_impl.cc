@@ -409,6 +409,9 @@ OMapLeafNode::get_value_ret
 OMapLeafNode::get_value(omap_context_t oc, const std::string &key)
 {
   logger().debug("OMapLeafNode: {} key = {}", __func__, key);
+  if (!oc.tm.add_read_keys(oc.t, *this, {key, key})) {
+    return crimson::ct_error::eagain::make();
+  }
   auto ite = find_string_key(key);
   if (ite != iter_end()) {
     auto value = ite->get_val();
@@ -538,6 +541,16 @@ OMapLeafNode::list(
 
   complete = (iter == iter_end());
 
+  // the keys from start on, up to the last one listed, or to the end of
+  // *this if the listing went through it
+  conflict_key_range_t listed{start.value_or(std::string{})};
+  if (!complete && !result.empty()) {
+    listed.last = result.rbegin()->first;
+  }
+  if (!oc.tm.add_read_keys(oc.t, *this, std::move(listed))) {
+    return crimson::ct_error::eagain::make();
+  }
+
   return list_ertr::make_ready_future<list_bare_ret>(
     std::move(ret));
 }
@@ -552,6 +565,9 @@ OMapLeafNode::split_children_ret
 OMapLeafNode::make_split_children(omap_context_t oc)
 {
   logger().debug("OMapLeafNode: {}", __func__);
+  if (!oc.tm.add_read_keys(oc.t, *this, conflict_key_range_t{})) {
+    return crimson::ct_error::eagain::make();
+  }
   return oc.tm.alloc_extents<OMapLeafNode>(oc.t, L_ADDR_MIN, OMAP_BLOCK_SIZE, 2)
     .safe_then([this] (auto &&ext_pair) {
       auto left = ext_pair.front();
@@ -567,6 +583,10 @@ OMapLeafNode::make_full_merge(omap_context_t oc, OMapNodeRef right)
 {
   ceph_assert(right->get_type() == type);
   logger().debug("OMapLeafNode: {}", __func__);
+  if (!oc.tm.add_read_keys(oc.t, *this, conflict_key_range_t{}) ||
+      !oc.tm.add_read_keys(oc.t, *right, conflict_key_range_t{})) {
+    return crimson::ct_error::eagain::make();
+  }
   return oc.tm.alloc_extent<OMapLeafNode>(oc.t, L_ADDR_MIN, OMAP_BLOCK_SIZE)
     .safe_then([this, right] (auto &&replacement) {
       replacement->merge_from(*this, *right->cast<OMapLeafNode>());
@@ -581,6 +601,10 @@ OMapLeafNode::make_balanced(omap_context_t oc, OMapNodeRef _right)
 {
   ceph_assert(_right->get_type() == type);
   logger().debug("OMapLeafNode: {}",  __func__);
+  if (!oc.tm.add_read_keys(oc.t, *this, conflict_key_range_t{}) ||
+      !oc.tm.add_read_keys(oc.t, *_right, conflict_key_range_t{})) {
+    return crimson::ct_error::eagain::make();
+  }
   return oc.tm.alloc_extents<OMapLeafNode>(oc.t, L_ADDR_MIN, OMAP_BLOCK_SIZE, 2)
     .safe_then([this, _right] (auto &&replacement_pair) {
       auto replacement_left = replacement_pair.front();
@@ -616,7 +640,10 @@ omap_load_extent(omap_context_t oc, laddr_t laddr, depth_t depth)
       omap_load_extent_ertr::pass_further{},
       crimson::ct_error::assert_all{ "Invalid error in omap_load_extent" }
     ).safe_then(
-      [](auto&& e) {
+      [oc](auto&& e) {
+      // readers of a leaf only depend on the keys they look up or list,
+      // the leaf methods add them, see Cache::track_read_keys()
+      oc.tm.track_read_keys(oc.t, *e);
       return seastar::make_ready_future<OMapNodeRef>(std::move(e));
     });
   }
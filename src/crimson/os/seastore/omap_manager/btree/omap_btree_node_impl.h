@@ -214,6 +214,16 @@ struct OMapLeafNode
     return bl;
   }
 
+  /// Readers only depend on the keys they looked up or listed, see
+  /// omap_load_extent()
+  std::optional<conflict_key_ranges_t> get_changed_keys() const final {
+    conflict_key_ranges_t ret;
+    delta_buffer.for_each_key([&ret](const std::string &key) {
+      ret.push_back(conflict_key_range_t{key, key});
+    });
+    return ret;
+  }
+
   void apply_delta(const ceph::bufferlist &_bl) final {
     assert(_bl.length());
     ceph::bufferlist bl = _bl;
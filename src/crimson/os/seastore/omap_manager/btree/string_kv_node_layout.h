@@ -240,6 +240,14 @@ public:
     }
   }
 
+  /// Calls f with the key of each buffered delta
+  template <typename F>
+  void for_each_key(F &&f) const {
+    for (auto &i: buffer) {
+      f(i.key);
+    }
+  }
+
   void clear() {
     buffer.clear();
   }
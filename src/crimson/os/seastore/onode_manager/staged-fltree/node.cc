@@ -2044,6 +2044,28 @@ eagain_future<Ref<tree_cursor_t>> LeafNode::insert_value(
   });
 }
 
+eagain_future<Ref<tree_cursor_t>> LeafNode::try_append_value(
+    context_t c, const key_hobj_t& key, value_config_t vconf)
+{
+  if (!impl->is_level_tail() || impl->is_keys_empty()) {
+    return eagain_ertr::make_ready_future<Ref<tree_cursor_t>>();
+  }
+  key_view_t largest_key;
+  impl->get_largest_slot(nullptr, &largest_key, nullptr);
+  if (key.compare_to(largest_key) != MatchKindCMP::GT) {
+    return eagain_ertr::make_ready_future<Ref<tree_cursor_t>>();
+  }
+  Ref<Node> this_ref = this;
+  return seastar::do_with(
+    MatchHistory(), [this, this_ref, c, &key, vconf](auto& history) {
+      auto result = impl->lower_bound(key, history);
+      assert(result.position.is_end());
+      return insert_value(
+          c, key, vconf, result.position, history, result.mstat);
+    }
+  );
+}
+
 eagain_future<Ref<LeafNode>> LeafNode::allocate_root(
     context_t c, RootNodeTracker& root_tracker)
 {
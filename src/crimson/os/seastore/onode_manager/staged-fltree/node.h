@@ -662,6 +662,19 @@ class LeafNode final : public Node {
   std::pair<NodeExtentMutable&, ValueDeltaRecorder*>
   prepare_mutate_value_payload(context_t);
 
+  // public to Btree
+  /**
+   * try_append_value
+   *
+   * Fast path for keys inserted in increasing order. If this is the rightmost
+   * leaf and the key is larger than all of its keys, the key is the largest
+   * one of the tree and is appended here without a lookup from the root.
+   *
+   * Returns nullptr if the key may belong to another position.
+   */
+  eagain_future<Ref<tree_cursor_t>> try_append_value(
+      context_t, const key_hobj_t&, value_config_t);
+
  protected:
   eagain_future<Ref<tree_cursor_t>> lookup_smallest(context_t) override;
   eagain_future<Ref<tree_cursor_t>> lookup_largest(context_t) override;
@@ -246,20 +246,7 @@ class Btree {
     crimson::ct_error::value_too_large>;
   insert_ertr::future<std::pair<Cursor, bool>>
   insert(Transaction& t, const ghobject_t& obj, tree_value_config_t _vconf) {
-    LOG_PREFIX(OTree::insert);
-    if (_vconf.payload_size > value_builder.get_max_value_payload_size()) {
-      ERRORT("value payload size {} too large to insert {}",
-             t, _vconf.payload_size, key_hobj_t{obj});
-      return crimson::ct_error::value_too_large::make();
-    }
-    if (obj.hobj.nspace.size() > value_builder.get_max_ns_size()) {
-      ERRORT("namespace size {} too large to insert {}",
-             t, obj.hobj.nspace.size(), key_hobj_t{obj});
-      return crimson::ct_error::value_too_large::make();
-    }
-    if (obj.hobj.oid.name.size() > value_builder.get_max_oid_size()) {
-      ERRORT("oid size {} too large to insert {}",
-             t, obj.hobj.oid.name.size(), key_hobj_t{obj});
+    if (!check_insert(t, obj, _vconf)) {
       return crimson::ct_error::value_too_large::make();
     }
     value_config_t vconf{value_builder.get_header_magic(), _vconf.payload_size};
@@ -277,6 +264,51 @@ class Btree {
     );
   }
 
+  /**
+   * insert with a hint
+   *
+   * The hint is the cursor returned by the previous insert within the same
+   * transaction. If the objects are inserted in increasing order, e.g. when
+   * loading a sorted batch of onodes, each of them is appended to the
+   * rightmost leaf directly instead of being looked up from the root.
+   * Otherwise, it is the same as insert() without a hint.
+   */
+  insert_ertr::future<std::pair<Cursor, bool>>
+  insert(Transaction& t, const ghobject_t& obj, tree_value_config_t _vconf,
+         const Cursor& hint) {
+    if (hint.is_end()) {
+      return insert(t, obj, _vconf);
+    }
+    assert(hint.p_tree == this);
+    if (!check_insert(t, obj, _vconf)) {
+      return crimson::ct_error::value_too_large::make();
+    }
+    value_config_t vconf{value_builder.get_header_magic(), _vconf.payload_size};
+    return seastar::do_with(
+      full_key_t<KeyT::HOBJ>(obj),
+      [this, &t, vconf, leaf = hint.p_cursor->get_leaf_node()](auto& key)
+      -> eagain_future<std::pair<Cursor, bool>> {
+        ceph_assert(key.is_valid());
+        return leaf->try_append_value(get_context(t), key, vconf
+        ).safe_then([this, &t, &key, vconf](auto cursor)
+                    -> eagain_future<std::pair<Ref<tree_cursor_t>, bool>> {
+          if (cursor) {
+            ++hint_stats.appended;
+            return seastar::make_ready_future<std::pair<Ref<tree_cursor_t>, bool>>(
+                std::make_pair(cursor, true));
+          }
+          ++hint_stats.fallbacks;
+          return get_root(t).safe_then([this, &t, &key, vconf](auto root) {
+            return root->insert(get_context(t), key, vconf);
+          });
+        }).safe_then([this](auto ret) {
+          auto& [cursor, success] = ret;
+          return std::make_pair(Cursor(this, cursor), success);
+        });
+      }
+    );
+  }
+
   eagain_future<std::size_t> erase(Transaction& t, const ghobject_t& obj) {
     return seastar::do_with(
       full_key_t<KeyT::HOBJ>(obj),
@@ -323,6 +355,15 @@ class Btree {
     });
   }
 
+  /// outcome of the inserts given a hint other than end()
+  struct hint_stats_t {
+    uint64_t appended = 0;   ///< appended to the rightmost leaf
+    uint64_t fallbacks = 0;  ///< looked up from the root instead
+  };
+  const hint_stats_t& get_hint_stats() const {
+    return hint_stats;
+  }
+
   std::ostream& dump(Transaction& t, std::ostream& os) {
     auto root = root_tracker->get_root(t);
     if (root) {
@@ -370,7 +411,29 @@ class Btree {
     }
   }
 
+  bool check_insert(Transaction& t, const ghobject_t& obj,
+                    const tree_value_config_t& vconf) const {
+    LOG_PREFIX(OTree::insert);
+    if (vconf.payload_size > value_builder.get_max_value_payload_size()) {
+      ERRORT("value payload size {} too large to insert {}",
+             t, vconf.payload_size, key_hobj_t{obj});
+      return false;
+    }
+    if (obj.hobj.nspace.size() > value_builder.get_max_ns_size()) {
+      ERRORT("namespace size {} too large to insert {}",
+             t, obj.hobj.nspace.size(), key_hobj_t{obj});
+      return false;
+    }
+    if (obj.hobj.oid.name.size() > value_builder.get_max_oid_size()) {
+      ERRORT("oid size {} too large to insert {}",
+             t, obj.hobj.oid.name.size(), key_hobj_t{obj});
+      return false;
+    }
+    return true;
+  }
+
   NodeExtentManagerURef nm;
+  hint_stats_t hint_stats;
   const ValueBuilderImpl<ValueImpl> value_builder;
   RootNodeTrackerURef root_tracker;
 
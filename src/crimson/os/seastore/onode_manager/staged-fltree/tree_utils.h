@@ -387,6 +387,47 @@ class TreeBuilder {
     });
   }
 
+  // insert in increasing order, passing the previous cursor as the hint to
+  // append to the rightmost leaf if use_hint
+  eagain_future<> insert_sorted(Transaction& t, bool use_hint) {
+    logger().warn("start inserting {} sorted kvs, hint={} ...",
+                  kvs.size(), use_hint);
+    auto start_time = mono_clock::now();
+    return seastar::do_with(
+      kvs.begin(), tree->end(),
+      [&t, this, use_hint, start_time](auto& iter, auto& hint) {
+        return crimson::do_until(
+            [&t, this, &iter, &hint, use_hint,
+             start_time]() -> eagain_future<bool> {
+          if (iter == kvs.end()) {
+            std::chrono::duration<double> duration = mono_clock::now() - start_time;
+            logger().warn("Insert sorted done! {}s", duration.count());
+            hint.invalidate();
+            return seastar::make_ready_future<bool>(true);
+          }
+          auto p_kv = *iter;
+          return (use_hint ?
+                  tree->insert(t, p_kv->key,
+                               {p_kv->value.get_payload_size()}, hint) :
+                  tree->insert(t, p_kv->key,
+                               {p_kv->value.get_payload_size()})
+          ).safe_then([&t, &iter, &hint, p_kv](auto ret) {
+            auto& [cursor, success] = ret;
+            ceph_assert(success);
+            initialize_cursor_from_item(t, p_kv->key, p_kv->value, cursor, success);
+            hint = cursor;
+            ++iter;
+            return seastar::make_ready_future<bool>(false);
+          }).handle_error(
+            [] (const crimson::ct_error::value_too_large& e) {
+              ceph_abort("impossible path");
+            },
+            crimson::ct_error::pass_further_all{}
+          );
+        });
+      });
+  }
+
   eagain_future<> erase_one(
       Transaction& t, const iterator_t& iter_rd) {
     auto p_kv = *iter_rd;
@@ -495,6 +536,10 @@ class TreeBuilder {
     return tree->height(t);
   }
 
+  const typename BtreeImpl::hint_stats_t& get_hint_stats() const {
+    return tree->get_hint_stats();
+  }
+
   void reload(NodeExtentManagerURef&& nm) {
     tree.emplace(std::move(nm));
   }
@@ -168,77 +168,24 @@ NVMeManager::mkfs_ertr::future<> NVMeManager::mkfs(mkfs_config_t config)
 
 NVMeManager::find_block_ret NVMeManager::find_free_block(Transaction &t, size_t size)
 {
-  auto bp = bufferptr(ceph::buffer::create_page_aligned(super.block_size));
-  return seastar::do_with(uint64_t(0),
-    uint64_t(super.start_alloc_area),
-    interval_set<blk_id_t>(),
-    bp,
-    [&, this] (auto &allocated, auto &addr, auto &alloc_extent, auto &bp) mutable {
-    return crimson::do_until(
-	[&, this] () mutable {
-	return device->read(
-	    addr,
-	    bp
-	    ).safe_then(
-	      [&bp, &addr, size, &allocated, &alloc_extent, this]() mutable {
-	      logger().debug("find_free_list: allocate {}, addr {}", allocated, addr);
-	      rbm_bitmap_block_t b_block(super.block_size);
-	      bufferlist bl_bitmap_block;
-	      bl_bitmap_block.append(bp);
-	      decode(b_block, bl_bitmap_block);
-	      auto max = max_block_by_bitmap_block();
-	      for (uint64_t i = 0;
-		  i < max && (uint64_t)size/super.block_size > allocated; i++) {
-		auto block_id = convert_bitmap_block_no_to_block_id(i, addr);
-		if (b_block.is_allocated(i)) {
-		  continue;
-		}
-		logger().debug("find_free_list: allocated block no {} i {}",
-			       convert_bitmap_block_no_to_block_id(i, addr), i);
-		if (allocated != 0 && alloc_extent.range_end() != block_id) {
-		  /*
-		   * if not continous block, just restart to find continuous blocks
-		   * at the next block.
-		   * in-memory allocator can handle this efficiently.
-		   */
-		  allocated = 0;
-		  alloc_extent.clear(); // a range of block allocation
-		  logger().debug("find_free_list: rety to find continuous blocks");
-		  continue;
-		}
-		allocated += 1;
-		alloc_extent.insert(block_id);
-	      }
-	      addr += super.block_size;
-	      logger().debug("find_free_list: allocated: {} alloc_extent {}",
-			      allocated, alloc_extent);
-	      if (((uint64_t)size)/super.block_size == allocated) {
-		return find_block_ertr::make_ready_future<bool>(true);
-	      } else if (addr >= super.start_data_area) {
-		alloc_extent.clear();
-		return find_block_ertr::make_ready_future<bool>(true);
-	      }
-	      return find_block_ertr::make_ready_future<bool>(false);
-	      });
-	}).safe_then([&allocated, &alloc_extent, size, this] () {
-	  logger().debug(" allocated: {} size {} ",
-			  allocated * super.block_size, size);
-	  if (allocated * super.block_size < size) {
-	    alloc_extent.clear();
-	  }
-	  return find_block_ret(
-	      find_block_ertr::ready_future_marker{},
-	      alloc_extent);
-	  }).handle_error(
-	      find_block_ertr::pass_further{},
-	      crimson::ct_error::assert_all{
-		"Invalid error in NVMeManager::find_free_block"
-	      }
-	    );
-    });
+  ceph_assert(!(size % super.block_size));
+  uint64_t needed = size / super.block_size;
+  interval_set<blk_id_t> alloc_extent;
+  for (auto [start, len] : free_extents) {
+    if (len >= needed) {
+      alloc_extent.insert(start, needed);
+      break;
+    }
+  }
+  if (!alloc_extent.empty()) {
+    free_extents.subtract(alloc_extent);
+  }
+  logger().debug("find_free_block: size {} allocated {}", size, alloc_extent);
+  return find_block_ret(
+    find_block_ertr::ready_future_marker{},
+    alloc_extent);
 }
 
-/* TODO : block allocator */
 NVMeManager::allocate_ertr::future<> NVMeManager::alloc_extent(
     Transaction &t, size_t size)
 {
@@ -248,12 +195,12 @@ NVMeManager::allocate_ertr::future<> NVMeManager::alloc_extent(
    * 2. add free blocks to transaction
    *    (the free block is reserved state, not stored)
    * 3. link free blocks to onode
-   * Due to in-memory block allocator is the next work to do,
-   * just read the block bitmap directly to find free blocks.
+   * The blocks are stored as allocated in the freebitmap by
+   * complete_allocation().
    *
    */
   return find_free_block(t, size
-      ).safe_then([] (auto alloc_extent) mutable
+      ).safe_then([&t] (auto alloc_extent) mutable
 	-> allocate_ertr::future<> {
 	logger().debug("after find_free_block: allocated {}", alloc_extent);
 	if (!alloc_extent.empty()) {
@@ -262,7 +209,7 @@ NVMeManager::allocate_ertr::future<> NVMeManager::alloc_extent(
 	    alloc_extent,
 	    rbm_alloc_delta_t::op_types_t::SET
 	  };
-	  // TODO: add alloc info to delta
+	  t.add_rbm_alloc_info_blocks(alloc_info);
 	} else {
 	  return crimson::ct_error::enospc::make();
 	}
@@ -279,7 +226,7 @@ NVMeManager::allocate_ertr::future<> NVMeManager::alloc_extent(
 NVMeManager::free_block_ertr::future<> NVMeManager::free_extent(
     Transaction &t, blk_paddr_t from, size_t len)
 {
-  return free_block_ertr::now();
+  return add_free_extent(t.get_rbm_alloc_info_blocks(), from, len);
 }
 
 NVMeManager::free_block_ertr::future<> NVMeManager::add_free_extent(
@@ -405,16 +352,23 @@ NVMeManager::write_ertr::future<> NVMeManager::rbm_sync_block_bitmap_by_range(
 NVMeManager::abort_allocation_ertr::future<> NVMeManager::abort_allocation(
     Transaction &t)
 {
-  /*
-   * TODO: clear all allocation infos associated with transaction in in-memory allocator
-   */
+  // give the blocks reserved by t back, nothing was stored yet
+  for (auto &alloc : t.get_rbm_alloc_info_blocks()) {
+    if (alloc.op == rbm_alloc_delta_t::op_types_t::SET) {
+      free_extents.insert(alloc.alloc_blk_ids);
+    }
+  }
+  t.clear_rbm_alloc_info_blocks();
   return abort_allocation_ertr::now();
 }
 
 NVMeManager::write_ertr::future<> NVMeManager::complete_allocation(
     Transaction &t)
 {
-  return write_ertr::now();
+  return sync_allocation(t.get_rbm_alloc_info_blocks()
+  ).safe_then([&t] {
+    t.clear_rbm_alloc_info_blocks();
+  });
 }
 
 NVMeManager::write_ertr::future<> NVMeManager::sync_allocation(
@@ -458,6 +412,13 @@ NVMeManager::write_ertr::future<> NVMeManager::sync_allocation(
       logger().debug("complete_alloction: complete to allocate {} blocks",
 		     alloc_block_count);
       super.free_block_count -= alloc_block_count;
+      // freed blocks may be reused from now on, allocated ones were
+      // already taken out of free_extents by find_free_block()
+      for (const auto& b : alloc_blocks) {
+	if (b.op == rbm_alloc_delta_t::op_types_t::CLEAR) {
+	  free_extents.union_of(b.alloc_blk_ids);
+	}
+      }
       return write_ertr::now();
     });
   });
@@ -596,6 +557,7 @@ NVMeManager::read_ertr::future<rbm_metadata_header_t> NVMeManager::read_rbm_head
 NVMeManager::check_bitmap_blocks_ertr::future<> NVMeManager::check_bitmap_blocks()
 {
   auto bp = bufferptr(ceph::buffer::create_page_aligned(super.block_size));
+  free_extents.clear();
   return seastar::do_with(uint64_t(super.start_alloc_area), uint64_t(0), bp,
     [&, this] (auto &addr, auto &free_blocks, auto &bp) mutable {
     return crimson::do_until([&, this] () mutable {
@@ -610,6 +572,9 @@ NVMeManager::check_bitmap_blocks_ertr::future<> NVMeManager::check_bitmap_blocks
 	for (uint64_t i = 0; i < max; i++) {
 	  if (!b_block.is_allocated(i)) {
 	    free_blocks++;
+	    // ids only grow, adjacent ones are merged
+	    free_extents.insert(
+	      convert_bitmap_block_no_to_block_id(i, addr), 1);
 	  }
 	}
 	addr += super.block_size;
@@ -191,10 +191,10 @@ public:
    * alloc_extent
    *
    * The role of this function is to find out free blocks the transaction requires.
-   * To do so, alloc_extent() looks into both in-memory allocator
-   * and freebitmap blocks.
-   * But, in-memory allocator is the future work, and is not implemented yet,
-   * we use freebitmap directly to allocate freeblocks for now.
+   * To do so, alloc_extent() looks into the in-memory allocator, which is
+   * loaded from the freebitmap blocks by open().  The blocks are reserved
+   * until the transaction completes or aborts, and recorded in the
+   * transaction as a SET rbm_alloc_delta_t.
    *
    * Each bit in freebitmap block represents whether a block is allocated or not.
    *
@@ -207,7 +207,8 @@ public:
   /*
    * free_extent
    *
-   * add a range of free blocks to transaction
+   * add a range of free blocks to transaction, they are given back to the
+   * in-memory allocator once the transaction completes
    *
    */
   // TODO: will include trim if necessary
@@ -264,9 +265,9 @@ public:
   /*
    * find_free_block
    *
-   * Try to find free blocks by reading bitmap blocks on the disk sequentially
-   * The free blocks will be added to allocated_blocks in Transaction.
-   * This needs to be improved after in-memory block allocation is introduced.
+   * Find contiguous free blocks in the in-memory allocator (first fit), and
+   * reserve them: they are not handed out again until they are freed, or
+   * given back by abort_allocation().
    *
    */
   find_block_ret find_free_block(Transaction &t, size_t size);
@@ -283,6 +284,13 @@ public:
   write_ertr::future<> rbm_sync_block_bitmap(
       rbm_bitmap_block_t &block, blk_id_t block_no);
 
+  /*
+   * check_bitmap_blocks
+   *
+   * Read all the bitmap blocks, to count the free blocks and to load them
+   * into the in-memory allocator
+   *
+   */
   using check_bitmap_blocks_ertr = crimson::errorator<
     crimson::ct_error::input_output_error,
     crimson::ct_error::invarg>;
@@ -366,7 +374,11 @@ private:
    * rbm specific information
    */
   rbm_metadata_header_t super;
-  //FreelistManager free_manager; // TODO: block management
+  /*
+   * in-memory allocator: blocks neither allocated on disk nor reserved
+   * by an in-flight transaction
+   */
+  interval_set<blk_id_t> free_extents;
   NVMeBlockDevice * device;
   std::string path;
   int stream_id; // for multi-stream
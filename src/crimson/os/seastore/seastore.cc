@@ -131,7 +131,7 @@ SeaStore::list_objects(CollectionRef ch,
       [this, start, end, limit] (auto& ret) {
     return repeat_eagain2([this, start, end, limit, &ret] {
       return seastar::do_with(
-          transaction_manager->create_transaction(),
+          transaction_manager->create_transaction(Transaction::src_t::READ),
           [this, start, end, limit, &ret] (auto& t) {
         return onode_manager->list_onodes(*t, start, end, limit
         ).safe_then([&ret] (auto&& _ret) {
@@ -173,7 +173,7 @@ seastar::future<std::vector<coll_t>> SeaStore::list_collections()
       return repeat_eagain([this, &ret] {
 
 	return seastar::do_with(
-	  transaction_manager->create_transaction(),
+	  transaction_manager->create_transaction(Transaction::src_t::READ),
 	  [this, &ret](auto &t) {
 	    return transaction_manager->read_collection_root(*t
 	    ).safe_then([this, &t](auto coll_root) {
@@ -816,7 +816,7 @@ SeaStore::omap_set_kvs_ret
 SeaStore::_omap_set_kvs(
   const omap_root_le_t& omap_root,
   Transaction& t,
-  omap_root_le_t& mutable_omap_root,
+  std::function<omap_root_le_t&()> &&get_mutable_omap_root,
   std::map<std::string, ceph::bufferlist>&& kvs)
 {
   return seastar::do_with(
@@ -837,9 +837,10 @@ SeaStore::_omap_set_kvs(
     }).safe_then([&] {
       return tm_ertr::make_ready_future<omap_root_t>(std::move(root));
     });
-  }).safe_then([&mutable_omap_root](auto root) {
+  }).safe_then([get_mutable_omap_root=std::move(get_mutable_omap_root)](
+		 auto root) {
     if (root.must_update()) {
-      mutable_omap_root.update(root);
+      get_mutable_omap_root().update(root);
     }
   });
 }
@@ -851,10 +852,14 @@ SeaStore::tm_ret SeaStore::_omap_set_values(
 {
   LOG_PREFIX(SeaStore::_omap_set_values);
   DEBUGT("{} {} keys", *ctx.transaction, *onode, aset.size());
+  // only mutate the onode if the omap root changes, otherwise readers of
+  // the onode would conflict with every omap update
   return _omap_set_kvs(
     onode->get_layout().omap_root,
     *ctx.transaction,
-    onode->get_mutable_layout(*ctx.transaction).omap_root,
+    [&ctx, &onode]() -> omap_root_le_t& {
+      return onode->get_mutable_layout(*ctx.transaction).omap_root;
+    },
     std::move(aset));
 }
 
@@ -980,7 +985,9 @@ SeaStore::tm_ret SeaStore::_setattrs(
   return _omap_set_kvs(
     onode->get_layout().xattr_root,
     *ctx.transaction,
-    layout.xattr_root,
+    [&layout]() -> omap_root_le_t& {
+      return layout.xattr_root;
+    },
     std::move(aset));
 }
 
@@ -1085,7 +1092,7 @@ seastar::future<std::tuple<int, std::string>> SeaStore::read_meta(const std::str
     key,
     [this](auto &ret, auto &t, auto& key) {
       return repeat_eagain([this, &ret, &t, &key] {
-	t = transaction_manager->create_transaction();
+	t = transaction_manager->create_transaction(Transaction::src_t::READ);
 	return transaction_manager->read_root_meta(
 	  *t, key
 	).safe_then([&ret](auto v) {
@@ -1118,7 +1125,7 @@ std::unique_ptr<SeaStore> make_seastore(
 
   auto segment_cleaner = std::make_unique<SegmentCleaner>(
     SegmentCleaner::config_t::get_default(),
-    false /* detailed */);
+    true /* detailed */);
 
   auto journal = std::make_unique<Journal>(*sm);
   auto cache = std::make_unique<Cache>(*sm);
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <map>
@@ -180,7 +181,7 @@ private:
       std::forward<F>(f),
       [=](auto &oid, auto &ret, auto &t, auto &onode, auto &f) {
 	return repeat_eagain([&, this] {
-	  t = transaction_manager->create_transaction();
+	  t = transaction_manager->create_transaction(Transaction::src_t::READ);
 	  return onode_manager->get_onode(
 	    *t, oid
 	  ).safe_then([&](auto onode_ret) {
@@ -285,7 +286,7 @@ private:
   omap_set_kvs_ret _omap_set_kvs(
     const omap_root_le_t& omap_root,
     Transaction& t,
-    omap_root_le_t& mutable_omap_root,
+    std::function<omap_root_le_t&()> &&get_mutable_omap_root,
     std::map<std::string, ceph::bufferlist>&& kvs);
 
   boost::intrusive_ptr<SeastoreCollection> _get_collection(const coll_t& cid);
@@ -103,6 +103,24 @@ int64_t SpaceTrackerDetailed::SegmentMap::release(
   return update_usage(-(int64_t)len);
 }
 
+bool SpaceTrackerDetailed::SegmentMap::is_allocated(
+  segment_off_t offset,
+  extent_len_t len,
+  const extent_len_t block_size) const
+{
+  assert(offset % block_size == 0);
+  assert(len % block_size == 0);
+
+  const auto b = (offset / block_size);
+  const auto e = (offset + len) / block_size;
+  for (auto i = b; i < e; ++i) {
+    if (bitmap[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool SpaceTrackerDetailed::equals(const SpaceTrackerI &_other) const
 {
   const auto &other = static_cast<const SpaceTrackerDetailed&>(_other);
@@ -157,6 +175,13 @@ void SegmentCleaner::register_metrics()
   metrics.add_group("segment_cleaner", {
     sm::make_counter("segments_released", stats.segments_released,
 		     sm::description("total number of extents released by SegmentCleaner")),
+    sm::make_counter("written_bytes", stats.written_bytes,
+		     sm::description("total size of extents written, including gc")),
+    sm::make_counter("reclaimed_bytes", stats.reclaimed_bytes,
+		     sm::description("total size of live extents rewritten by gc")),
+    sm::make_counter("reclaim_skipped_extents", stats.reclaim_skipped_extents,
+		     sm::description("total number of dead extents skipped by gc "
+				     "without a lookup")),
   });
 }
 
@@ -283,7 +308,7 @@ SegmentCleaner::gc_trim_journal_ret SegmentCleaner::gc_trim_journal()
   return repeat_eagain(
     [this] {
       return seastar::do_with(
-	ecb->create_transaction(),
+	ecb->create_transaction(Transaction::src_t::CLEANER),
 	[this](auto &t) {
 	  return rewrite_dirty(*t, get_dirty_tail()
 	  ).safe_then([this, &t] {
@@ -327,22 +352,32 @@ SegmentCleaner::gc_reclaim_space_ret SegmentCleaner::gc_reclaim_space()
 	    "SegmentCleaner::gc_reclaim_space: processing {} extents",
 	    extents.size());
 	  return seastar::do_with(
-	    ecb->create_transaction(),
-	    [this, &extents](auto &t) mutable {
+	    ecb->create_transaction(Transaction::src_t::CLEANER),
+	    uint64_t(0),
+	    [this, &extents](auto &t, auto &reclaimed) mutable {
 	      return crimson::do_for_each(
 		extents,
-		[this, &t](auto &extent) {
+		[this, &t, &reclaimed](auto &extent) {
 		  auto &[addr, info] = extent;
 		  logger().debug(
 		    "SegmentCleaner::gc_reclaim_space: checking extent {}",
 		    info);
+		  if (!space_tracker->may_be_live(
+			addr.segment, addr.offset, info.len)) {
+		    // released since it was written, no need to look it up
+		    logger().debug(
+		      "SegmentCleaner::gc_reclaim_space: addr {} released, skipping",
+		      addr);
+		    stats.reclaim_skipped_extents++;
+		    return ExtentCallbackInterface::rewrite_extent_ertr::now();
+		  }
 		  return ecb->get_extent_if_live(
 		    *t,
 		    info.type,
 		    addr,
 		    info.addr,
 		    info.len
-		  ).safe_then([addr=addr, &t, this](CachedExtentRef ext) {
+		  ).safe_then([addr=addr, &t, &reclaimed, this](CachedExtentRef ext) {
 		    if (!ext) {
 		      logger().debug(
 			"SegmentCleaner::gc_reclaim_space: addr {} dead, skipping",
@@ -353,6 +388,7 @@ SegmentCleaner::gc_reclaim_space_ret SegmentCleaner::gc_reclaim_space()
 			"SegmentCleaner::gc_reclaim_space: addr {} alive, gc'ing {}",
 			addr,
 			*ext);
+		      reclaimed += ext->get_length();
 		      return ecb->rewrite_extent(
 			*t,
 			ext);
@@ -364,6 +400,8 @@ SegmentCleaner::gc_reclaim_space_ret SegmentCleaner::gc_reclaim_space()
 		  t->mark_segment_to_release(scan_cursor->get_offset().segment);
 		}
 		return ecb->submit_transaction_direct(std::move(t));
+	      }).safe_then([this, &reclaimed] {
+		stats.reclaimed_bytes += reclaimed;
 	      });
 	    });
 	});
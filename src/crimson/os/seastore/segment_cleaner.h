@@ -24,6 +24,9 @@ struct segment_info_t {
   // Will be non-null for any segments in the current journal
   segment_seq_t journal_segment_seq = NULL_SEG_SEQ;
 
+  // Time of the last write to, or release of an extent in, this segment,
+  // in bytes written since mount (see SegmentCleaner::get_next_gc_target)
+  uint64_t last_modified = 0;
 
   bool is_in_journal(journal_seq_t tail_committed) const {
     return journal_segment_seq != NULL_SEG_SEQ &&
@@ -58,6 +61,12 @@ public:
   virtual int64_t get_usage(
     segment_id_t segment) const = 0;
 
+  /// false only if none of the blocks in offset~len is in use
+  virtual bool may_be_live(
+    segment_id_t segment,
+    segment_off_t offset,
+    extent_len_t len) const = 0;
+
   virtual bool equals(const SpaceTrackerI &other) const = 0;
 
   virtual std::unique_ptr<SpaceTrackerI> make_empty() const = 0;
@@ -103,6 +112,13 @@ public:
     return live_bytes_by_segment[segment];
   }
 
+  bool may_be_live(
+    segment_id_t segment,
+    segment_off_t offset,
+    extent_len_t len) const final {
+    return get_usage(segment) > 0;
+  }
+
   void dump_usage(segment_id_t) const final {}
 
   void reset() final {
@@ -147,6 +163,11 @@ class SpaceTrackerDetailed : public SpaceTrackerI {
       return used;
     }
 
+    bool is_allocated(
+      segment_off_t offset,
+      extent_len_t len,
+      const extent_len_t block_size) const;
+
     void dump_usage(extent_len_t block_size) const;
 
     void reset() {
@@ -189,6 +210,14 @@ public:
     return segment_usage[segment].get_usage();
   }
 
+  bool may_be_live(
+    segment_id_t segment,
+    segment_off_t offset,
+    extent_len_t len) const final {
+    assert(segment < segment_usage.size());
+    return segment_usage[segment].is_allocated(offset, len, block_size);
+  }
+
   void dump_usage(segment_id_t seg) const final;
 
   void reset() final {
@@ -246,7 +275,7 @@ public:
   public:
     virtual ~ExtentCallbackInterface() = default;
 
-    virtual TransactionRef create_transaction() = 0;
+    virtual TransactionRef create_transaction(Transaction::src_t src) = 0;
 
     /**
      * get_next_dirty_extent
@@ -351,6 +380,13 @@ private:
 
   struct {
     uint64_t segments_released = 0;
+    /// bytes of extents written since mount, gc included; also serves
+    /// as the clock for segment_info_t::last_modified
+    uint64_t written_bytes = 0;
+    /// bytes of live extents rewritten by gc_reclaim_space
+    uint64_t reclaimed_bytes = 0;
+    /// dead extents skipped by gc_reclaim_space without a lookup
+    uint64_t reclaim_skipped_extents = 0;
   } stats;
   seastar::metrics::metric_group metrics;
   void register_metrics();
@@ -449,6 +485,10 @@ public:
     return segments[id].journal_segment_seq;
   }
 
+  const auto &get_stats() const {
+    return stats;
+  }
+
   void mark_segment_released(segment_id_t segment) {
     stats.segments_released++;
     return mark_empty(segment);
@@ -464,6 +504,10 @@ public:
       return;
 
     used_bytes += len;
+    if (!init_scan) {
+      stats.written_bytes += len;
+      segments[addr.segment].last_modified = stats.written_bytes;
+    }
     [[maybe_unused]] auto ret = space_tracker->allocate(
       addr.segment,
       addr.offset,
@@ -480,6 +524,7 @@ public:
 
     used_bytes -= len;
     assert(addr.segment < segments.size());
+    segments[addr.segment].last_modified = stats.written_bytes;
 
     [[maybe_unused]] auto ret = space_tracker->release(
       addr.segment,
@@ -489,26 +534,51 @@ public:
     assert(ret >= 0);
   }
 
+  /**
+   * get_next_gc_target
+   *
+   * Returns the closed segment with the best cost-benefit ratio, as in
+   * LFS: (1 - u) * age / (1 + u), u being the fraction of the segment
+   * still live and age the time since the segment was last modified.
+   * A segment whose extents keep being released is hot and is likely
+   * to empty on its own, while a cold one is worth cleaning even at a
+   * higher utilization, since the data copied out of it stays live.
+   */
   segment_id_t get_next_gc_target() const {
     segment_id_t ret = NULL_SEG_ID;
-    int64_t least_live_bytes = std::numeric_limits<int64_t>::max();
+    double best_score = -1;
     for (segment_id_t i = 0; i < segments.size(); ++i) {
-      if (segments[i].is_closed() &&
-	  !segments[i].is_in_journal(journal_tail_committed) &&
-	  space_tracker->get_usage(i) < least_live_bytes) {
+      if (!segments[i].is_closed() ||
+	  segments[i].is_in_journal(journal_tail_committed)) {
+	continue;
+      }
+      auto score = get_gc_score(i);
+      if (score > best_score) {
 	ret = i;
-	least_live_bytes = space_tracker->get_usage(i);
+	best_score = score;
       }
     }
     if (ret != NULL_SEG_ID) {
       crimson::get_logger(ceph_subsys_seastore).debug(
-	"SegmentCleaner::get_next_gc_target: segment {} seq {}",
+	"SegmentCleaner::get_next_gc_target: segment {} seq {} "
+	"live bytes {} age {} score {}",
 	ret,
-	segments[ret].journal_segment_seq);
+	segments[ret].journal_segment_seq,
+	space_tracker->get_usage(ret),
+	stats.written_bytes - segments[ret].last_modified,
+	best_score);
     }
     return ret;
   }
 
+  double get_gc_score(segment_id_t segment) const {
+    double u = (double)space_tracker->get_usage(segment) / segment_size;
+    // right after mount all segments have the same age, and the score
+    // only depends on their utilization
+    double age = 1 + stats.written_bytes - segments[segment].last_modified;
+    return (1 - u) * age / (1 + u);
+  }
+
   SpaceTrackerIRef get_empty_space_tracker() const {
     return space_tracker->make_empty();
   }
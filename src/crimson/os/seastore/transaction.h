@@ -4,6 +4,7 @@
 #pragma once
 
 #include <iostream>
+#include <list>
 
 #include <boost/intrusive/list.hpp>
 
@@ -27,6 +28,16 @@ public:
   OrderingHandle handle;
 
   using Ref = std::unique_ptr<Transaction>;
+
+  /// What a transaction is for, to break the counters down by
+  enum class src_t : uint8_t {
+    MUTATE = 0,
+    READ,       // including weak transactions
+    CLEANER,
+    MAX
+  };
+  static constexpr auto SRC_MAX = static_cast<std::size_t>(src_t::MAX);
+
   enum class get_extent_ret {
     PRESENT,
     ABSENT,
@@ -75,6 +86,7 @@ public:
 
     ceph_assert(read_set.count(ref) == 0);
     read_set.insert(ref);
+    ref->readers.push_back(read_items.emplace_back(this));
   }
 
   void add_fresh_extent(CachedExtentRef ref) {
@@ -116,6 +128,39 @@ public:
     return weak;
   }
 
+  src_t get_src() const {
+    return src;
+  }
+
+  /**
+   * is_conflicted
+   *
+   * True once a committed transaction has invalidated an extent in the
+   * read set: *this is bound to fail with eagain, there is no point in
+   * carrying on with it.
+   */
+  bool is_conflicted() const {
+    return conflicted;
+  }
+
+  /// True if *this retires or mutates extent
+  bool is_writing(const CachedExtent &extent) {
+    return retired_set.count(extent.get_paddr()) ||
+      write_set.find_offset(extent.get_paddr()) != write_set.end();
+  }
+
+  void add_rbm_alloc_info_blocks(rbm_alloc_delta_t &d) {
+    rbm_alloc_info_blocks.push_back(d);
+  }
+
+  void clear_rbm_alloc_info_blocks() {
+    rbm_alloc_info_blocks.clear();
+  }
+
+  auto &get_rbm_alloc_info_blocks() {
+    return rbm_alloc_info_blocks;
+  }
+
 private:
   friend class Cache;
   friend Ref make_test_transaction();
@@ -126,11 +171,25 @@ private:
    */
   const bool weak;
 
+  const src_t src;
+
+  /// set by Cache when an extent in read_set gets invalidated
+  bool conflicted = false;
+
+  /// id of the commit which conflicted *this, see Cache::wait_for_retry()
+  uint64_t retry_after = 0;
+
+  /// id given to the commit of *this by Cache::try_construct_record()
+  uint64_t commit_id = 0;
+
   RootBlockRef root;        ///< ref to root if read or written by transaction
 
   segment_off_t offset = 0; ///< relative offset of next block
 
   pextent_set_t read_set;   ///< set of extents read by paddr
+  /// links *this into CachedExtent::readers of each extent in read_set,
+  /// must be destroyed before read_set
+  std::list<read_set_item_t> read_items;
   ExtentIndex write_set;    ///< set of extents written by paddr
 
   std::list<CachedExtentRef> fresh_block_list;   ///< list of fresh blocks
@@ -143,6 +202,9 @@ private:
 
   std::vector<std::pair<paddr_t, extent_len_t>> retired_uncached;
 
+  ///< blocks allocated and freed on a RandomBlockManager by this transaction
+  std::vector<rbm_alloc_delta_t> rbm_alloc_info_blocks;
+
   journal_seq_t initiated_after;
 
   retired_extent_gate_t::token_t retired_gate_token;
@@ -151,8 +213,9 @@ public:
   Transaction(
     OrderingHandle &&handle,
     bool weak,
+    src_t src,
     journal_seq_t initiated_after
-  ) : handle(std::move(handle)), weak(weak),
+  ) : handle(std::move(handle)), weak(weak), src(src),
       retired_gate_token(initiated_after) {}
 
   ~Transaction() {
@@ -172,6 +235,7 @@ inline TransactionRef make_test_transaction() {
   return std::make_unique<Transaction>(
     get_dummy_ordering_handle(),
     false,
+    Transaction::src_t::MUTATE,
     journal_seq_t{}
   );
 }
@@ -213,6 +213,16 @@ TransactionManager::submit_transaction(
   TransactionRef t)
 {
   LOG_PREFIX(TransactionManager::submit_transaction);
+  if (t->is_conflicted()) {
+    // no need to wait for the throttle only to fail in prepare
+    DEBUGT("conflict detected, returning eagain.", *t);
+    auto &tref = *t;
+    return submit_transaction_ertr::now().safe_then([this, &tref] {
+      return cache->wait_for_retry(tref);
+    }).safe_then([t=std::move(t)]() -> submit_transaction_ertr::future<> {
+      return crimson::ct_error::eagain::make();
+    });
+  }
   DEBUGT("about to await throttle", *t);
   auto &tref = *t;
   return tref.handle.enter(write_pipeline.wait_throttle
@@ -235,6 +245,8 @@ TransactionManager::submit_transaction_direct(
 	 -> submit_transaction_ertr::future<> {
     auto record = cache->try_construct_record(tref);
     if (!record) {
+      // fail at once rather than after Cache::wait_for_retry(), tref
+      // holds the prepare stage
       DEBUGT("conflict detected, returning eagain.", tref);
       return crimson::ct_error::eagain::make();
     }
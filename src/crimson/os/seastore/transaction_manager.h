@@ -112,8 +112,9 @@ public:
   close_ertr::future<> close();
 
   /// Creates empty transaction
-  TransactionRef create_transaction() final {
-    return cache->create_transaction();
+  TransactionRef create_transaction(
+    Transaction::src_t src = Transaction::src_t::MUTATE) final {
+    return cache->create_transaction(src);
   }
 
   /// Creates empty weak transaction
@@ -121,6 +122,19 @@ public:
     return cache->create_weak_transaction();
   }
 
+  /// see Cache::track_read_keys
+  void track_read_keys(Transaction &t, CachedExtent &extent) {
+    cache->track_read_keys(t, extent);
+  }
+
+  /// see Cache::add_read_keys
+  bool add_read_keys(
+    Transaction &t,
+    CachedExtent &extent,
+    conflict_key_range_t keys) {
+    return cache->add_read_keys(t, extent, std::move(keys));
+  }
+
   /**
    * get_pin
    *
@@ -3,21 +3,59 @@
 
 #include "crimson/osd/object_context.h"
 
+#include <seastar/core/metrics.hh>
+
 #include "common/Formatter.h"
 #include "crimson/common/config_proxy.h"
 
 namespace crimson::osd {
 
+size_t ObjectContext::get_memory_usage() const
+{
+  const auto &oid = get_oid();
+  size_t usage = sizeof(*this) +
+    // obs.oi.soid and the key of the registry
+    2 * (oid.oid.name.size() + oid.get_key().size() + oid.nspace.size());
+  if (ss) {
+    // the vectors and maps of the snapset grow with the number of clones,
+    // by about that much per clone
+    constexpr size_t per_clone = 4 * sizeof(snapid_t) + 3 * 48;
+    usage += ss->snaps.size() * sizeof(snapid_t) +
+      ss->clones.size() * per_clone;
+  }
+  return usage;
+}
+
 ObjectContextRegistry::ObjectContextRegistry(crimson::common::ConfigProxy &conf)
 {
-  obc_lru.set_target_size(conf.get_val<uint64_t>("crimson_osd_obc_lru_size"));
+  obc_lru.set_target_size(conf.get_val<Option::size_t>("crimson_osd_obc_cache_size"));
+  obc_lru.set_hot_threshold(conf.get_val<uint64_t>("crimson_osd_obc_hot_threshold"));
   conf.add_observer(this);
+  register_metrics();
+}
+
+void ObjectContextRegistry::register_metrics()
+{
+  namespace sm = seastar::metrics;
+  metrics.add_group("obc_registry", {
+    sm::make_counter("hits", stats.hits,
+		     sm::description("object contexts found loaded in the cache")),
+    sm::make_counter("misses", stats.misses,
+		     sm::description("object contexts loaded from the store")),
+    sm::make_counter("batched_loads", stats.batched_loads,
+		     sm::description("object contexts loaded by an op queued "
+				     "on the same object, while waiting")),
+    sm::make_gauge("cached_bytes", [this] { return get_cached_bytes(); },
+		   sm::description("estimated memory held by the cached "
+				   "object contexts")),
+  });
 }
 
 const char** ObjectContextRegistry::get_tracked_conf_keys() const
 {
   static const char* KEYS[] = {
-    "crimson_osd_obc_lru_size",
+    "crimson_osd_obc_cache_size",
+    "crimson_osd_obc_hot_threshold",
     nullptr
   };
   return KEYS;
@@ -27,7 +65,8 @@ void ObjectContextRegistry::handle_conf_change(
   const crimson::common::ConfigProxy& conf,
   const std::set <std::string> &changed)
 {
-  obc_lru.set_target_size(conf.get_val<uint64_t>("crimson_osd_obc_lru_size"));
+  obc_lru.set_hot_threshold(conf.get_val<uint64_t>("crimson_osd_obc_hot_threshold"));
+  obc_lru.set_target_size(conf.get_val<Option::size_t>("crimson_osd_obc_cache_size"));
 }
 
 
@@ -6,6 +6,7 @@
 #include <map>
 #include <optional>
 #include <utility>
+#include <seastar/core/metrics_registration.hh>
 #include <seastar/core/shared_future.hh>
 #include <seastar/core/shared_ptr.hh>
 
@@ -81,14 +82,24 @@ public:
     ceph_assert(is_head());
     obs = std::move(_obs);
     ss = std::move(_ss);
+    loaded = true;
   }
 
   void set_clone_state(ObjectState &&_obs, Ref &&_head) {
     ceph_assert(!is_head());
     obs = std::move(_obs);
     head = _head;
+    loaded = true;
   }
 
+  /// false until the state is loaded from the store
+  bool is_loaded() const {
+    return loaded;
+  }
+
+  /// rough estimate of the memory held, what the registry is sized with
+  size_t get_memory_usage() const;
+
   /// pass the provided exception to any waiting consumers of this ObjectContext
   template<typename Exception>
   void interrupt(Exception ex) {
@@ -101,6 +112,7 @@ public:
 private:
   tri_mutex lock;
   bool recovery_read_marker = false;
+  bool loaded = false;
 
   template <typename Lock, typename Func>
   auto _with_lock(Lock&& lock, Func&& func) {
@@ -229,18 +241,45 @@ public:
 };
 using ObjectContextRef = ObjectContext::Ref;
 
+/**
+ * ObjectContextRegistry
+ *
+ * Caches the object contexts of a reactor, up to crimson_osd_obc_cache_size
+ * bytes. Contexts accessed at least crimson_osd_obc_hot_threshold times
+ * while cached, such as RBD headers or bucket index shards, get a second
+ * chance at eviction.
+ */
 class ObjectContextRegistry : public md_config_obs_t  {
   ObjectContext::lru_t obc_lru;
+  seastar::metrics::metric_group metrics;
+  void register_metrics();
 
 public:
+  /// exported per reactor, summed over the PGs it serves
+  struct {
+    uint64_t hits = 0;          ///< found loaded in the registry
+    uint64_t misses = 0;        ///< loaded from the store
+    uint64_t batched_loads = 0; ///< loaded by another op while waiting
+  } stats;
+
   ObjectContextRegistry(crimson::common::ConfigProxy &conf);
 
+  /// the second member of the pair is true if the returned context was
+  /// cached and loaded already
   std::pair<ObjectContextRef, bool> get_cached_obc(const hobject_t &hoid) {
-    return obc_lru.get_or_create(hoid);
+    auto [obc, existed] = obc_lru.get_or_create(hoid);
+    return {obc, existed && obc->is_loaded()};
   }
   ObjectContextRef maybe_get_cached_obc(const hobject_t &hoid) {
     return obc_lru.get(hoid);
   }
+  /// account for the memory of the loaded, or reloaded, obc
+  void loaded(ObjectContext &obc) {
+    obc_lru.set_charge(obc, obc.get_memory_usage());
+  }
+  size_t get_cached_bytes() const {
+    return obc_lru.get_charged();
+  }
 
   const char** get_tracked_conf_keys() const final;
   void handle_conf_change(const crimson::common::ConfigProxy& conf,
@@ -885,9 +885,18 @@ PG::with_head_obc(ObjectContextRef obc, bool existed, with_obc_func_t&& func)
     auto loaded = load_obc_iertr::make_ready_future<ObjectContextRef>(obc);
     if (existed) {
       logger().debug("with_head_obc: found {} in cache", obc->get_oid());
+      ++shard_services.obc_registry.stats.hits;
     } else {
       logger().debug("with_head_obc: cache miss on {}", obc->get_oid());
-      loaded = obc->with_promoted_lock<State, IOInterruptCondition>([this, obc] {
+      loaded = obc->with_promoted_lock<State, IOInterruptCondition>(
+        [this, obc]() -> load_obc_iertr::future<ObjectContextRef> {
+        if (obc->is_loaded()) {
+          // by an op queued on the same object ahead of us
+          logger().debug("with_head_obc: {} loaded meanwhile", obc->get_oid());
+          ++shard_services.obc_registry.stats.batched_loads;
+          return load_obc_iertr::make_ready_future<ObjectContextRef>(obc);
+        }
+        ++shard_services.obc_registry.stats.misses;
         return load_head_obc(obc);
       });
     }
@@ -940,13 +949,22 @@ PG::with_clone_obc(hobject_t oid, with_obc_func_t&& func)
       auto loaded = load_obc_iertr::make_ready_future<ObjectContextRef>(clone);
       if (existed) {
         logger().debug("with_clone_obc: found {} in cache", coid);
+        ++shard_services.obc_registry.stats.hits;
       } else {
         logger().debug("with_clone_obc: cache miss on {}", coid);
         loaded = clone->template with_promoted_lock<State>(
-          [coid, clone, head, this] {
+          [coid, clone, head, this]() -> load_obc_iertr::future<ObjectContextRef> {
+          if (clone->is_loaded()) {
+            // by an op queued on the same object ahead of us
+            logger().debug("with_clone_obc: {} loaded meanwhile", coid);
+            ++shard_services.obc_registry.stats.batched_loads;
+            return load_obc_iertr::make_ready_future<ObjectContextRef>(clone);
+          }
+          ++shard_services.obc_registry.stats.misses;
           return backend->load_metadata(coid).safe_then_interruptible(
-            [coid, clone=std::move(clone), head=std::move(head)](auto md) mutable {
+            [coid, clone=std::move(clone), head=std::move(head), this](auto md) mutable {
             clone->set_clone_state(std::move(md->os), std::move(head));
+            shard_services.obc_registry.loaded(*clone);
             return clone;
           });
         });
@@ -984,7 +1002,7 @@ PG::load_head_obc(ObjectContextRef obc)
 {
   hobject_t oid = obc->get_oid();
   return backend->load_metadata(oid).safe_then_interruptible(
-    [obc=std::move(obc)](auto md)
+    [obc=std::move(obc), this](auto md)
     -> load_obc_ertr::future<crimson::osd::ObjectContextRef> {
     const hobject_t& oid = md->os.oi.soid;
     logger().debug(
@@ -995,6 +1013,7 @@ PG::load_head_obc(ObjectContextRef obc)
       return crimson::ct_error::object_corrupted::make();
     }
     obc->set_head_state(std::move(md->os), std::move(*(md->ss)));
+    shard_services.obc_registry.loaded(*obc);
     logger().debug(
       "load_head_obc: returning obc {} for {}",
       obc->obs.oi, obc->obs.oi.soid);
@@ -1007,7 +1026,7 @@ PG::load_obc_iertr::future<>
 PG::reload_obc(crimson::osd::ObjectContext& obc) const
 {
   assert(obc.is_head());
-  return backend->load_metadata(obc.get_oid()).safe_then_interruptible<false>([&obc](auto md)
+  return backend->load_metadata(obc.get_oid()).safe_then_interruptible<false>([&obc, this](auto md)
     -> load_obc_ertr::future<> {
     logger().debug(
       "{}: reloaded obs {} for {}",
@@ -1022,6 +1041,7 @@ PG::reload_obc(crimson::osd::ObjectContext& obc) const
       return crimson::ct_error::object_corrupted::make();
     }
     obc.set_head_state(std::move(md->os), std::move(*(md->ss)));
+    shard_services.obc_registry.loaded(obc);
     return load_obc_ertr::now();
   });
 }
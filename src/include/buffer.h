@@ -915,6 +915,7 @@ struct error_code;
     // it allows to avoid conditionals on hot paths.
     static ptr_node always_empty_bptr;
     ptr_node& refill_append_space(const unsigned len);
+    bool merge_adjacent();
 
     // for page_aligned_appender; never ever expose this publicly!
     // carriage / append_buffer is just an implementation's detail.
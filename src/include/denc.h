@@ -1702,7 +1702,10 @@ inline std::enable_if_t<traits::supported && !traits::need_contiguous> decode(
   const auto& bl = p.get_bl();
   const auto remaining = bl.length() - p.get_off();
   // it is expensive to rebuild a contigous buffer and drop it, so avoid this.
-  if (!p.is_pointing_same_raw(bl.back()) && remaining > CEPH_PAGE_SIZE) {
+  // bounded types are small enough to be decoded through the iterator at
+  // no real cost, whatever follows them in the ceph::buffer::list.
+  if (!p.is_pointing_same_raw(bl.back()) &&
+      (traits::bounded || remaining > CEPH_PAGE_SIZE)) {
     traits::decode(o, p);
   } else {
     // ensure we get a contigous buffer... until the end of the
@@ -51,8 +51,12 @@
 	(((x) & (CEPH_MSGR2_FEATUREMASK_##name)) == (CEPH_MSGR2_FEATUREMASK_##name))
 
 DEFINE_MSGR2_FEATURE( 0, 1, REVISION_1)   // msgr2.1
+// bit 1 is reserved for COMPRESSION, assigned upstream
+DEFINE_MSGR2_FEATURE( 2, 1, CHUNKED_SEAL) // msgr2.1 secure, chunked frames
 
-#define CEPH_MSGR2_SUPPORTED_FEATURES (CEPH_MSGR2_FEATURE_REVISION_1)
+#define CEPH_MSGR2_SUPPORTED_FEATURES \
+	(CEPH_MSGR2_FEATURE_REVISION_1 |   \
+	 CEPH_MSGR2_FEATURE_CHUNKED_SEAL)
 
 #define CEPH_MSGR2_REQUIRED_FEATURES  (0ull)
 
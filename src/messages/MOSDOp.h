@@ -21,6 +21,7 @@
 #include "MOSDFastDispatchOp.h"
 #include "include/ceph_features.h"
 #include "common/hobject.h"
+#include "msg/EncodeArena.h"
 
 /*
  * OSD op
@@ -248,12 +249,22 @@ public:
   }
 
   // marshalling
+  // upper bound of the encoded payload in the common case; about 170
+  // bytes go to fixed-size fields
+  unsigned estimate_payload_len() const {
+    return 256 +
+      hobj.oid.name.length() + hobj.get_key().length() + hobj.nspace.length() +
+      ops.size() * sizeof(ceph_osd_op) +
+      snaps.size() * sizeof(snapid_t);
+  }
+
   void encode_payload(uint64_t features) override {
     using ceph::encode;
     if( false == bdata_encode ) {
       OSDOp::merge_osd_op_vector_in_data(ops, data);
       bdata_encode = true;
     }
+    ceph::msgr::EncodeArena::reserve(payload, estimate_payload_len());
 
     if ((features & CEPH_FEATURE_OBJECTLOCATOR) == 0) {
       // here is the old structure we are encoding to: //
@@ -20,6 +20,7 @@
 
 #include "MOSDOp.h"
 #include "common/errno.h"
+#include "msg/EncodeArena.h"
 
 /*
  * OSD op reply
@@ -168,12 +169,20 @@ private:
   ~MOSDOpReply() final {}
 
 public:
+  // upper bound of the encoded payload unless redirected; about 100
+  // bytes go to fixed-size fields
+  unsigned estimate_payload_len() const {
+    return 128 + oid.name.length() +
+      ops.size() * (sizeof(ceph_osd_op) + sizeof(int32_t));
+  }
+
   void encode_payload(uint64_t features) override {
     using ceph::encode;
     if(false == bdata_encode) {
       OSDOp::merge_osd_op_vector_out_data(ops, data);
       bdata_encode = true;
     }
+    ceph::msgr::EncodeArena::reserve(payload, estimate_payload_len());
 
     if ((features & CEPH_FEATURE_PGID64) == 0) {
       header.version = 1;
@@ -17,6 +17,7 @@
 #define CEPH_MOSDREPOP_H
 
 #include "MOSDFastDispatchOp.h"
+#include "msg/EncodeArena.h"
 
 /*
  * OSD sub op - for internal ops on pobjects between primary and replicas(/stripes/whatever)
@@ -121,8 +122,17 @@ public:
     final_decode_needed = false;
   }
 
+  // estimate of the encoded payload; the log entries in logbl are shared,
+  // not copied, and pg_stats usually takes well below 1KB
+  unsigned estimate_payload_len() const {
+    return 1536 +
+      poid.oid.name.length() + poid.get_key().length() + poid.nspace.length() +
+      new_temp_oid.oid.name.length() + discard_temp_oid.oid.name.length();
+  }
+
   void encode_payload(uint64_t features) override {
     using ceph::encode;
+    ceph::msgr::EncodeArena::reserve(payload, estimate_payload_len());
     encode(map_epoch, payload);
     assert(HAVE_FEATURE(features, SERVER_OCTOPUS));
     header.version = HEAD_VERSION;
@@ -18,6 +18,7 @@
 
 #include "MOSDFastDispatchOp.h"
 #include "MOSDRepOp.h"
+#include "msg/EncodeArena.h"
 
 /*
  * OSD Client Subop reply
@@ -87,6 +88,8 @@ public:
   }
   void encode_payload(uint64_t features) override {
     using ceph::encode;
+    // all fields have a fixed size, about 120 bytes
+    ceph::msgr::EncodeArena::reserve(payload, 128);
     encode(map_epoch, payload);
     header.version = HEAD_VERSION;
     encode(min_epoch, payload);
@@ -0,0 +1,114 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <new>
+
+#include "include/buffer_raw.h"
+#include "include/intarith.h"
+#include "msg/EncodeArena.h"
+
+namespace ceph::msgr {
+
+std::atomic<bool> EncodeArena::enabled{true};
+
+namespace {
+
+struct chunk_t {
+  // one per live slice, plus one while the chunk is the arena's current one
+  std::atomic<unsigned> nref{1};
+
+  static chunk_t* create() {
+    return new (::operator new(EncodeArena::CHUNK_SIZE)) chunk_t;
+  }
+  void get() {
+    nref.fetch_add(1, std::memory_order_relaxed);
+  }
+  void put() {
+    if (nref.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      this->~chunk_t();
+      ::operator delete(this);
+    }
+  }
+};
+
+class raw_arena : public ceph::buffer::raw {
+  chunk_t* const chunk;
+public:
+  raw_arena(char *dataptr, unsigned l, chunk_t *c)
+    : raw(dataptr, l), chunk(c) {
+    chunk->get();
+  }
+  raw* clone_empty() override {
+    return ceph::buffer::create(len).release();
+  }
+  static void operator delete(void *ptr) {
+    // the raw lives inside the chunk, it only gives back its reference
+    static_cast<raw_arena*>(ptr)->chunk->put();
+  }
+};
+
+constexpr size_t ALIGN = alignof(std::max_align_t);
+constexpr size_t CHUNK_HEADER_SIZE = round_up_to(sizeof(chunk_t), ALIGN);
+constexpr size_t RAW_SIZE = round_up_to(sizeof(raw_arena), ALIGN);
+static_assert(CHUNK_HEADER_SIZE + RAW_SIZE + EncodeArena::MAX_SLICE <=
+	      EncodeArena::CHUNK_SIZE);
+
+struct arena_t {
+  chunk_t *chunk = nullptr;
+  size_t offset = 0;
+  EncodeArena::stats_t stats;
+
+  ~arena_t() {
+    if (chunk) {
+      chunk->put();
+    }
+  }
+  char* allocate(size_t size) {
+    if (!chunk || offset + size > EncodeArena::CHUNK_SIZE) {
+      if (chunk) {
+	chunk->put();
+      }
+      chunk = chunk_t::create();
+      offset = CHUNK_HEADER_SIZE;
+      ++stats.chunks;
+    }
+    char *p = reinterpret_cast<char*>(chunk) + offset;
+    offset += size;
+    return p;
+  }
+};
+
+thread_local arena_t arena;
+
+} // anonymous namespace
+
+void EncodeArena::reserve(ceph::buffer::list& payload, unsigned len)
+{
+  if (!enabled.load(std::memory_order_relaxed) ||
+      payload.length() > 0 || len == 0 || len > MAX_SLICE) {
+    return;
+  }
+  char *p = arena.allocate(RAW_SIZE + round_up_to(size_t(len), ALIGN));
+  auto raw = new (p) raw_arena(p + RAW_SIZE, len, arena.chunk);
+  auto node = ceph::buffer::ptr_node::create(
+    ceph::unique_leakable_ptr<ceph::buffer::raw>(raw));
+  node->set_length(0);   // unused, so far.
+  payload.push_back(std::move(node));
+  ++arena.stats.slices;
+}
+
+EncodeArena::stats_t EncodeArena::get_stats()
+{
+  return arena.stats;
+}
+
+} // namespace ceph::msgr
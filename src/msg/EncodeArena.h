@@ -0,0 +1,67 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MSG_ENCODEARENA_H
+#define CEPH_MSG_ENCODEARENA_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "include/buffer.h"
+
+namespace ceph::msgr {
+
+/**
+ * Per-thread bump allocator for the front section of small, frequently
+ * sent messages (MOSDOp, MOSDOpReply, MOSDRepOp, MOSDRepOpReply).
+ *
+ * Encoding such a message into an empty bufferlist costs a page-sized
+ * raw_combined allocation for the first append buffer. Instead, the arena
+ * carves a slice out of a large chunk: the buffer::raw describing the
+ * slice is constructed inside the chunk, right in front of its data, so
+ * only the bufferlist node is left to allocate. A chunk is freed when the
+ * last message referring to it goes away.
+ *
+ * A slice has a fixed size: if the encoder writes more than what was
+ * reserved, the bufferlist simply falls back to regular append buffers.
+ */
+class EncodeArena {
+public:
+  static constexpr unsigned CHUNK_SIZE = 64 << 10;
+  // bigger payloads don't gain much, and would pin a chunk for longer
+  static constexpr unsigned MAX_SLICE = 4 << 10;
+
+  struct stats_t {
+    uint64_t chunks = 0;  ///< chunks allocated by this thread
+    uint64_t slices = 0;  ///< payloads served by this thread
+  };
+
+  /// Make the empty `payload` append into a slice of the calling thread's
+  /// arena, with room for `len` bytes. No-op if the arena is disabled,
+  /// `payload` is not empty or `len` is over MAX_SLICE.
+  static void reserve(ceph::buffer::list& payload, unsigned len);
+
+  /// Counters of the calling thread
+  static stats_t get_stats();
+
+  /// For benchmarking and debugging: when disabled, reserve() does nothing.
+  static void set_enabled(bool on) {
+    enabled.store(on, std::memory_order_relaxed);
+  }
+
+private:
+  static std::atomic<bool> enabled;
+};
+
+} // namespace ceph::msgr
+
+#endif
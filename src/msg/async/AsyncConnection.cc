@@ -69,6 +69,7 @@ class C_handle_read : public EventCallback {
   explicit C_handle_read(AsyncConnectionRef c): conn(c) {}
   void do_request(uint64_t fd_or_id) override {
     conn->process();
+    conn->maybe_migrate();
   }
 };
 
@@ -123,6 +124,9 @@ AsyncConnection::AsyncConnection(CephContext *cct, AsyncMessenger *m, DispatchQu
     last_active(ceph::coarse_mono_clock::now()),
     connect_timeout_us(cct->_conf->ms_connection_ready_timeout*1000*1000),
     inactive_timeout_us(cct->_conf->ms_connection_idle_timeout*1000*1000),
+    rebalance_interval(
+      cct->_conf.get_val<std::chrono::seconds>("ms_async_rebalance_interval")),
+    last_rebalance_check(ceph::mono_clock::now()),
     msgr2(m2), state_offset(0),
     worker(w), center(&w->center),read_buffer(nullptr)
 {
@@ -364,6 +368,11 @@ void AsyncConnection::inject_delay() {
 
 void AsyncConnection::process() {
   std::lock_guard<std::mutex> l(lock);
+  if (!center->in_thread()) {
+    // a stale event from the worker we have been migrated away from
+    center->dispatch_event_external(read_handler);
+    return;
+  }
   last_active = ceph::coarse_mono_clock::now();
   recv_start_time = ceph::mono_clock::now();
 
@@ -463,8 +472,9 @@ void AsyncConnection::process() {
 
   protocol->read_event();
 
-  logger->tinc(l_msgr_running_recv_time,
-               ceph::mono_clock::now() - recv_start_time);
+  auto recv_time = ceph::mono_clock::now() - recv_start_time;
+  logger->tinc(l_msgr_running_recv_time, recv_time);
+  recv_busy += recv_time;
 }
 
 bool AsyncConnection::is_connected() {
@@ -709,6 +719,10 @@ void AsyncConnection::handle_write()
 
 void AsyncConnection::handle_write_callback() {
   std::lock_guard<std::mutex> l(lock);
+  if (!center->in_thread()) {
+    center->dispatch_event_external(write_callback_handler);
+    return;
+  }
   last_active = ceph::coarse_mono_clock::now();
   recv_start_time = ceph::mono_clock::now();
   write_lock.lock();
@@ -722,6 +736,113 @@ void AsyncConnection::handle_write_callback() {
   write_lock.unlock();
 }
 
+void AsyncConnection::maybe_migrate()
+{
+  if (rebalance_interval == ceph::timespan::zero() ||
+      !async_msgr->get_stack()->support_connection_migration()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> l(lock);
+  auto now = ceph::mono_clock::now();
+  auto period = now - last_rebalance_check;
+  if (period < rebalance_interval || !center->in_thread()) {
+    return;
+  }
+  // share of the worker's time spent on this connection, or of the byte
+  // rate it can take, in per mille, whichever is larger
+  const uint64_t ns = std::max<uint64_t>(1, period.count());
+  unsigned conn_load = std::max<uint64_t>(
+    std::min<uint64_t>(1000, recv_busy.count() * 1000 / ns),
+    worker->byte_load(recv_bytes * 1000000000ull / ns));
+  last_rebalance_check = now;
+  recv_busy = ceph::timespan::zero();
+  recv_bytes = 0;
+
+  if (!can_migrate()) {
+    return;
+  }
+  Worker *target =
+    async_msgr->get_stack()->get_migration_target(worker, conn_load);
+  if (!target) {
+    protocol->finish_migration();
+    return;
+  }
+  migrate_to(target);
+}
+
+bool AsyncConnection::can_migrate()
+{
+  // only move connections that are idle apart from the socket: pending
+  // timers and delayed deliveries are bound to the current EventCenter
+  if (state != STATE_CONNECTION_ESTABLISHED ||
+      !register_time_events.empty() || delay_state || writeCallback) {
+    return false;
+  }
+  return protocol->prepare_migration();
+}
+
+void AsyncConnection::request_migration(Worker *target)
+{
+  // the reference keeps us alive until the event ran
+  AsyncConnectionRef conn(this);
+  center->submit_to(center->get_id(), [this, conn, target] {
+    std::lock_guard<std::mutex> l(lock);
+    if (!center->in_thread()) {
+      // moved meanwhile
+      return;
+    }
+    if (worker == target || !can_migrate()) {
+      ldout(async_msgr->cct, 5) << "request_migration can't move to worker "
+				<< target->id << " now" << dendl;
+      return;
+    }
+    migrate_to(target);
+  }, false);
+}
+
+void AsyncConnection::migrate_to(Worker *target)
+{
+  ldout(async_msgr->cct, 5) << __func__ << " from worker " << worker->id
+			    << " to worker " << target->id << dendl;
+  ceph_assert(center->in_thread());
+  {
+    // file and time events must be removed by the thread that owns them
+    std::lock_guard<std::mutex> wl(write_lock);
+    center->delete_file_event(cs.fd(), EVENT_READABLE | EVENT_WRITABLE);
+    open_write = false;
+    if (last_tick_id) {
+      center->delete_time_event(last_tick_id);
+      last_tick_id = 0;
+    }
+    worker->references--;
+    target->references++;
+    logger = target->get_perf_counter();
+    worker = target;
+    center = &target->center;
+  }
+  logger->inc(l_msgr_migrated_connections);
+
+  AsyncConnectionRef conn(this);
+  center->submit_to(
+    center->get_id(), [conn] { conn->finish_migration(); }, true);
+}
+
+void AsyncConnection::finish_migration()
+{
+  std::lock_guard<std::mutex> l(lock);
+  ldout(async_msgr->cct, 10) << __func__ << dendl;
+  if (state == STATE_CLOSED) {
+    protocol->finish_migration();
+    return;
+  }
+  center->create_file_event(cs.fd(), EVENT_READABLE, read_handler);
+  last_tick_id = center->create_time_event(inactive_timeout_us, tick_handler);
+  protocol->finish_migration();
+  // pick up whatever arrived while no one was polling the socket
+  center->dispatch_event_external(read_handler);
+}
+
 void AsyncConnection::stop(bool queue_reset) {
   lock.lock();
   bool need_queue_reset = (state != STATE_CLOSED) && queue_reset;
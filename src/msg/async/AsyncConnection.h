@@ -62,6 +62,7 @@ class AsyncConnection : public Connection {
 
   void _connect();
   void _stop();
+  void migrate_to(Worker *target);
   void fault();
   void inject_delay();
 
@@ -127,6 +128,11 @@ public:
 	      const entity_addr_t &peer_addr);
   int send_message(Message *m) override;
 
+  // moves the connection over to @target, as the rebalancing does, unless
+  // it is busy. asynchronous, the connection's worker does the move
+  void request_migration(Worker *target);
+  unsigned get_worker_id() const { return worker->id; }
+
   void send_keepalive() override;
   void mark_down() override;
   void mark_disposable() override {
@@ -205,6 +211,12 @@ private:
   const uint64_t connect_timeout_us;
   const uint64_t inactive_timeout_us;
 
+  // Worker rebalancing, see maybe_migrate()
+  const ceph::timespan rebalance_interval;
+  ceph::mono_clock::time_point last_rebalance_check;
+  ceph::timespan recv_busy = ceph::timespan::zero();
+  uint64_t recv_bytes = 0;
+
   // Tis section are temp variables used by state transition
 
   // Accepting state
@@ -233,6 +245,9 @@ private:
   void process();
   void wakeup_from(uint64_t id);
   void tick(uint64_t id);
+  void maybe_migrate();
+  bool can_migrate();
+  void finish_migration();
   void stop(bool queue_reset);
   void cleanup();
   PerfCounters *get_perf_counter() {
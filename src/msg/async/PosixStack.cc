@@ -19,8 +19,12 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
 
 #include <algorithm>
+#include <deque>
 
 #include "PosixStack.h"
 
@@ -37,16 +41,57 @@
 #undef dout_prefix
 #define dout_prefix *_dout << "PosixStack "
 
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define CEPH_USE_MSG_ZEROCOPY
+#endif
+
+/// the smallest send to use MSG_ZEROCOPY for on this socket, 0 if none
+static size_t get_zerocopy_min_size(CephContext *cct, int fd)
+{
+#ifdef CEPH_USE_MSG_ZEROCOPY
+  int on = 0;
+  socklen_t len = sizeof(on);
+  // the option only decides whether new sockets get SO_ZEROCOPY, see
+  // NetHandler::create_socket(). without it, the kernel silently ignores
+  // MSG_ZEROCOPY and never sends the completion we would wait for.
+  if (::getsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &on, &len) == 0 && on) {
+    return std::max<size_t>(
+      cct->_conf.get_val<Option::size_t>("ms_tcp_zerocopy_min_size"), 1);
+  }
+#endif
+  return 0;
+}
+
 class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
+  CephContext *cct;
   ceph::NetHandler &handler;
+  PerfCounters *logger;
   int _fd;
   entity_addr_t sa;
   bool connected;
+#ifdef CEPH_USE_MSG_ZEROCOPY
+  size_t zerocopy_min_size;
+  // the kernel numbers the sendmsg() calls with MSG_ZEROCOPY, and tells us
+  // when it is done with the pages of a range of them
+  uint32_t zerocopy_next_id = 0;
+  struct zerocopy_send_t {
+    uint32_t first_id;
+    uint32_t num_ids;
+    uint32_t pending;  ///< ids not completed yet
+    ceph::buffer::list bl;
+  };
+  std::deque<zerocopy_send_t> zerocopy_inflight;
+#endif
 
  public:
-  explicit PosixConnectedSocketImpl(ceph::NetHandler &h, const entity_addr_t &sa,
-				    int f, bool connected)
-      : handler(h), _fd(f), sa(sa), connected(connected) {}
+  explicit PosixConnectedSocketImpl(Worker *w, ceph::NetHandler &h,
+				    const entity_addr_t &sa, int f, bool connected,
+				    size_t zerocopy_min_size)
+      : cct(w->cct), handler(h), logger(w->get_perf_counter()), _fd(f), sa(sa), connected(connected)
+#ifdef CEPH_USE_MSG_ZEROCOPY
+      , zerocopy_min_size(zerocopy_min_size)
+#endif
+  {}
 
   int is_connected() override {
     if (connected)
@@ -69,31 +114,106 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
     #else
     ssize_t r = ::read(_fd, buf, len);
     #endif
-    if (r < 0)
+    if (r < 0) {
       r = -ceph_sock_errno();
+#ifdef CEPH_USE_MSG_ZEROCOPY
+      // the completions wake us up as errors on the socket
+      if (r == -EAGAIN && !zerocopy_inflight.empty()) {
+	reap_zerocopy();
+      }
+#endif
+    }
     return r;
   }
 
+#ifdef CEPH_USE_MSG_ZEROCOPY
+  void complete_zerocopy(uint32_t lo, uint32_t hi) {
+    for (auto& s : zerocopy_inflight) {
+      if (static_cast<int32_t>(s.first_id - hi) > 0) {
+	break;
+      }
+      for (uint32_t i = 0; i < s.num_ids; i++) {
+	if (s.first_id + i - lo <= hi - lo) {
+	  ceph_assert(s.pending > 0);
+	  s.pending--;
+	}
+      }
+    }
+    while (!zerocopy_inflight.empty() && !zerocopy_inflight.front().pending) {
+      zerocopy_inflight.pop_front();
+    }
+  }
+
+  void reap_zerocopy() {
+    while (!zerocopy_inflight.empty()) {
+      char control[CMSG_SPACE(sizeof(struct sock_extended_err)) +
+		   CMSG_SPACE(sizeof(struct sockaddr_in6))];
+      struct msghdr msg = {};
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      if (::recvmsg(_fd, &msg, MSG_ERRQUEUE) < 0) {
+	// EAGAIN: nothing completed since last time
+	return;
+      }
+      for (auto cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+	if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+	    !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) {
+	  continue;
+	}
+	auto serr = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+	if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+	  continue;
+	}
+	if ((serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) && zerocopy_min_size) {
+	  // the kernel had to copy the data anyway (e.g. over loopback, or
+	  // without scatter-gather support), so zerocopy only adds overhead
+	  ldout(cct, 1) << __func__ << " fd " << _fd << " to " << sa
+			<< ": the kernel copied a zerocopy send,"
+			<< " disabling MSG_ZEROCOPY" << dendl;
+	  zerocopy_min_size = 0;
+	  logger->inc(l_msgr_zerocopy_disabled);
+	}
+	complete_zerocopy(serr->ee_info, serr->ee_data);
+      }
+    }
+  }
+#endif
+
   // return the sent length
   // < 0 means error occurred
   #ifndef _WIN32
-  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more)
+  static ssize_t do_sendmsg(int fd, struct msghdr &msg, unsigned len, bool more,
+			    bool& zerocopy, uint32_t *zerocopy_ids)
   {
     size_t sent = 0;
     while (1) {
       MSGR_SIGPIPE_STOPPER;
       ssize_t r;
-      r = ::sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+      int flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+#ifdef CEPH_USE_MSG_ZEROCOPY
+      if (zerocopy) {
+	flags |= MSG_ZEROCOPY;
+      }
+#endif
+      r = ::sendmsg(fd, &msg, flags);
       if (r < 0) {
         int err = ceph_sock_errno();
         if (err == EINTR) {
           continue;
         } else if (err == EAGAIN) {
           break;
-        }
+        } else if (err == ENOBUFS && zerocopy) {
+	  // out of optmem to track the pinned pages, copy this time
+	  zerocopy = false;
+	  continue;
+	}
         return -err;
       }
 
+      if (zerocopy && r > 0) {
+	// the kernel assigns an id to each call that sent something
+	++*zerocopy_ids;
+      }
       sent += r;
       if (len == sent) break;
 
@@ -115,6 +235,15 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
 
   ssize_t send(ceph::buffer::list &bl, bool more) override {
     size_t sent_bytes = 0;
+    bool zerocopy = false;
+    uint32_t zerocopy_ids = 0;
+#ifdef CEPH_USE_MSG_ZEROCOPY
+    if (!zerocopy_inflight.empty()) {
+      reap_zerocopy();
+    }
+    // small messages are cheaper to copy
+    zerocopy = zerocopy_min_size && bl.length() >= zerocopy_min_size;
+#endif
     auto pb = std::cbegin(bl.buffers());
     uint64_t left_pbrs = bl.get_num_buffers();
     while (left_pbrs) {
@@ -133,7 +262,8 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
 	msglen += pb->length();
 	++pb;
       }
-      ssize_t r = do_sendmsg(_fd, msg, msglen, left_pbrs || more);
+      ssize_t r = do_sendmsg(_fd, msg, msglen, left_pbrs || more,
+			     zerocopy, &zerocopy_ids);
       if (r < 0)
         return r;
 
@@ -150,8 +280,17 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
         bl.splice(sent_bytes, bl.length()-sent_bytes, &swapped);
         bl.swap(swapped);
       } else {
-        bl.clear();
+        bl.swap(swapped);
       }
+#ifdef CEPH_USE_MSG_ZEROCOPY
+      if (zerocopy_ids) {
+	logger->inc(l_msgr_zerocopy_sends, zerocopy_ids);
+	// "swapped" holds what was sent, the kernel may still read from it
+	zerocopy_inflight.push_back(
+	  {zerocopy_next_id, zerocopy_ids, zerocopy_ids, std::move(swapped)});
+	zerocopy_next_id += zerocopy_ids;
+      }
+#endif
     }
 
     return static_cast<ssize_t>(sent_bytes);
@@ -204,6 +343,17 @@ class PosixConnectedSocketImpl final : public ConnectedSocketImpl {
     ::shutdown(_fd, SHUT_RDWR);
   }
   void close() override {
+#ifdef CEPH_USE_MSG_ZEROCOPY
+    if (!zerocopy_inflight.empty()) {
+      reap_zerocopy();
+    }
+    if (!zerocopy_inflight.empty()) {
+      // reset the connection, so that the kernel drops what is left to
+      // send instead of reading it from buffers we are about to free
+      struct linger l = {1, 0};
+      ::setsockopt(_fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+    }
+#endif
     compat_closesocket(_fd);
   }
   int fd() const override {
@@ -259,7 +409,9 @@ int PosixServerSocketImpl::accept(ConnectedSocket *sock, const SocketOptions &op
   out->set_sockaddr((sockaddr*)&ss);
   handler.set_priority(sd, opt.priority, out->get_family());
 
-  std::unique_ptr<PosixConnectedSocketImpl> csi(new PosixConnectedSocketImpl(handler, *out, sd, true));
+  std::unique_ptr<PosixConnectedSocketImpl> csi(
+    new PosixConnectedSocketImpl(w, handler, *out, sd, true,
+				 get_zerocopy_min_size(w->cct, sd)));
   *sock = ConnectedSocket(std::move(csi));
   return 0;
 }
@@ -328,7 +480,9 @@ int PosixWorker::connect(const entity_addr_t &addr, const SocketOptions &opts, C
 
   net.set_priority(sd, opts.priority, addr.get_family());
   *socket = ConnectedSocket(
-      std::unique_ptr<PosixConnectedSocketImpl>(new PosixConnectedSocketImpl(net, addr, sd, !opts.nonblock)));
+      std::unique_ptr<PosixConnectedSocketImpl>(
+	new PosixConnectedSocketImpl(this, net, addr, sd, !opts.nonblock,
+				     get_zerocopy_min_size(cct, sd))));
   return 0;
 }
 
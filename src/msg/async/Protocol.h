@@ -132,6 +132,12 @@ public:
   virtual void write_event() = 0;
   virtual bool is_queued() = 0;
 
+  // quiesce the write path before the connection is moved to another
+  // worker; false -> the connection can't be moved right now
+  virtual bool prepare_migration() { return false; }
+  // called on the new worker, or on the old one if the move was called off
+  virtual void finish_migration() {}
+
   int get_con_mode() const {
     return auth_meta->con_mode;
   }
@@ -468,6 +468,30 @@ void ProtocolV2::send_keepalive() {
   }
 }
 
+bool ProtocolV2::prepare_migration() {
+  std::lock_guard<std::mutex> l(connection->write_lock);
+  if (state != READY || replacing || !can_write || write_in_progress ||
+      connection->is_queued()) {
+    return false;
+  }
+  // keep send_message() from scheduling write_event() on the old worker
+  // while the connection is moving
+  write_in_progress = true;
+  return true;
+}
+
+void ProtocolV2::finish_migration() {
+  std::lock_guard<std::mutex> l(connection->write_lock);
+  write_in_progress = false;
+  if (state == CLOSED) {
+    return;
+  }
+  if (!out_queue.empty() || keepalive || ack_left) {
+    write_in_progress = true;
+    connection->center->dispatch_event_external(connection->write_handler);
+  }
+}
+
 void ProtocolV2::read_event() {
   ldout(cct, 20) << __func__ << dendl;
 
@@ -622,6 +646,12 @@ void ProtocolV2::write_event() {
   ssize_t r = 0;
 
   connection->write_lock.lock();
+  if (!connection->center->in_thread()) {
+    // a stale event from the worker we have been migrated away from
+    connection->center->dispatch_event_external(connection->write_handler);
+    connection->write_lock.unlock();
+    return;
+  }
   if (can_write) {
     if (keepalive) {
       ldout(cct, 10) << __func__ << " appending keepalive" << dendl;
@@ -941,6 +971,10 @@ CtPtr ProtocolV2::_handle_peer_banner_payload(rx_buffer_t &&buffer, int r) {
   bool is_rev1 = HAVE_MSGR2_FEATURE(peer_supported_features, REVISION_1);
   tx_frame_asm.set_is_rev1(is_rev1);
   rx_frame_asm.set_is_rev1(is_rev1);
+  bool is_chunked_seal = HAVE_MSGR2_FEATURE(peer_supported_features,
+                                            CHUNKED_SEAL);
+  tx_frame_asm.set_is_chunked_seal(is_chunked_seal);
+  rx_frame_asm.set_is_chunked_seal(is_chunked_seal);
 
   if (state == BANNER_CONNECTING) {
     state = HELLO_CONNECTING;
@@ -1462,6 +1496,7 @@ CtPtr ProtocolV2::handle_message() {
   connection->logger->inc(l_msgr_recv_messages);
   connection->logger->inc(l_msgr_recv_bytes,
                           rx_frame_asm.get_frame_onwire_len());
+  connection->recv_bytes += rx_frame_asm.get_frame_onwire_len();
 
   messenger->ms_fast_preprocess(message);
   fast_dispatch_time = ceph::mono_clock::now();
@@ -2648,6 +2683,10 @@ CtPtr ProtocolV2::reuse_connection(const AsyncConnectionRef& existing,
     exproto->peer_supported_features = peer_supported_features;
     exproto->tx_frame_asm.set_is_rev1(tx_frame_asm.get_is_rev1());
     exproto->rx_frame_asm.set_is_rev1(rx_frame_asm.get_is_rev1());
+    exproto->tx_frame_asm.set_is_chunked_seal(
+      tx_frame_asm.get_is_chunked_seal());
+    exproto->rx_frame_asm.set_is_chunked_seal(
+      rx_frame_asm.get_is_chunked_seal());
 
     exproto->client_cookie = client_cookie;
     exproto->peer_name = peer_name;
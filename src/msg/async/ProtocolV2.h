@@ -204,6 +204,8 @@ public:
   virtual void read_event() override;
   virtual void write_event() override;
   virtual bool is_queued() override;
+  virtual bool prepare_migration() override;
+  virtual void finish_migration() override;
 
 private:
   // Client Protocol
@@ -34,6 +34,20 @@
 #undef dout_prefix
 #define dout_prefix *_dout << "stack "
 
+class NetworkStackHook : public AdminSocketHook {
+  NetworkStack *stack;
+public:
+  explicit NetworkStackHook(NetworkStack *s) : stack(s) {}
+  int call(std::string_view command,
+	   const cmdmap_t& cmdmap,
+	   ceph::Formatter *f,
+	   std::ostream& errss,
+	   ceph::buffer::list& out) override {
+    stack->dump_workers(f);
+    return 0;
+  }
+};
+
 std::function<void ()> NetworkStack::add_thread(Worker* w)
 {
   return [this, w]() {
@@ -41,10 +55,14 @@ std::function<void ()> NetworkStack::add_thread(Worker* w)
       sprintf(tp_name, "msgr-worker-%u", w->id);
       ceph_pthread_setname(pthread_self(), tp_name);
       const unsigned EventMaxWaitUs = 30000000;
+      const auto LoadSamplePeriod = std::chrono::seconds(1);
       w->center.set_owner();
       ldout(cct, 10) << __func__ << " starting" << dendl;
       w->initialize();
       w->init_done();
+      auto sample_start = ceph::mono_clock::now();
+      ceph::timespan sample_busy = ceph::timespan::zero();
+      uint64_t sample_recv_bytes = w->perf_logger->get(l_msgr_recv_bytes);
       while (!w->done) {
         ldout(cct, 30) << __func__ << " calling event process" << dendl;
 
@@ -56,6 +74,17 @@ std::function<void ()> NetworkStack::add_thread(Worker* w)
           // TODO do something?
         }
         w->perf_logger->tinc(l_msgr_running_total_time, dur);
+
+        sample_busy += dur;
+        auto now = ceph::mono_clock::now();
+        if (now - sample_start >= LoadSamplePeriod) {
+          const uint64_t recv_bytes = w->perf_logger->get(l_msgr_recv_bytes);
+          w->update_load(sample_busy, now - sample_start,
+                         recv_bytes - sample_recv_bytes);
+          sample_start = now;
+          sample_busy = ceph::timespan::zero();
+          sample_recv_bytes = recv_bytes;
+        }
       }
       w->reset();
       w->destroy();
@@ -103,6 +132,18 @@ std::shared_ptr<NetworkStack> NetworkStack::create(CephContext *c,
     stack->workers.push_back(w);
   }
 
+  stack->asok_hook = std::make_unique<NetworkStackHook>(stack.get());
+  int r = c->get_admin_socket()->register_command(
+    "dump_messenger_workers",
+    stack->asok_hook.get(),
+    "dump load and connection count of each messenger worker thread");
+  if (r < 0) {
+    // another stack in this process already serves the command
+    ldout(c, 5) << __func__ << " failed to register admin socket command: "
+		<< cpp_strerror(r) << dendl;
+    stack->asok_hook.reset();
+  }
+
   return stack;
 }
 
@@ -110,6 +151,15 @@ NetworkStack::NetworkStack(CephContext *c)
   : cct(c)
 {}
 
+NetworkStack::~NetworkStack()
+{
+  if (asok_hook) {
+    cct->get_admin_socket()->unregister_commands(asok_hook.get());
+  }
+  for (auto &&w : workers)
+    delete w;
+}
+
 void NetworkStack::start()
 {
   std::unique_lock<decltype(pool_spin)> lk(pool_spin);
@@ -157,6 +207,65 @@ Worker* NetworkStack::get_worker()
   return current_best;
 }
 
+Worker* NetworkStack::get_migration_target(Worker *from, unsigned conn_load)
+{
+  // both loads are in per mille, the threshold is in percent
+  const unsigned threshold =
+    cct->_conf.get_val<uint64_t>("ms_async_rebalance_threshold") * 10;
+  // connections this light are not worth the cost of a move
+  const unsigned MinConnectionLoad = 10;
+
+  if (conn_load < MinConnectionLoad)
+    return nullptr;
+
+  std::lock_guard lk(pool_spin);
+  Worker *target = nullptr;
+  unsigned min_load = std::numeric_limits<unsigned>::max();
+  for (Worker* worker : workers) {
+    unsigned worker_load = worker->load.load();
+    if (worker != from && worker_load < min_load) {
+      target = worker;
+      min_load = worker_load;
+    }
+  }
+  if (!target)
+    return nullptr;
+
+  unsigned from_load = from->load.load();
+  if (from_load < min_load + threshold ||
+      conn_load >= from_load - min_load) {
+    // either the workers are balanced already, or moving the connection
+    // would just turn the target into the new hot spot
+    return nullptr;
+  }
+  ldout(cct, 10) << __func__ << " worker " << from->id << " (load " << from_load
+		 << ") -> worker " << target->id << " (load " << min_load
+		 << "), connection load " << conn_load << dendl;
+  // account for the move now, so that other connections on the busy worker
+  // don't all follow this one before the next load sample is taken
+  from->load -= conn_load;
+  target->load += conn_load;
+  return target;
+}
+
+void NetworkStack::dump_workers(ceph::Formatter *f)
+{
+  // workers are only added in create(), no need for pool_spin here
+  f->open_array_section("workers");
+  for (Worker* worker : workers) {
+    f->open_object_section("worker");
+    f->dump_unsigned("id", worker->id);
+    f->dump_unsigned("connections", worker->references.load());
+    f->dump_unsigned("load", worker->load.load());
+    f->dump_unsigned("cpu_load", worker->cpu_load.load());
+    f->dump_unsigned("recv_byte_rate", worker->recv_byte_rate.load());
+    f->dump_unsigned("migrated_connections",
+		     worker->perf_logger->get(l_msgr_migrated_connections));
+    f->close_section();
+  }
+  f->close_section();
+}
+
 void NetworkStack::stop()
 {
   std::lock_guard lk(pool_spin);
@@ -18,6 +18,7 @@
 #define CEPH_MSG_ASYNC_STACK_H
 
 #include "include/spinlock.h"
+#include "common/admin_socket.h"
 #include "common/perf_counters.h"
 #include "msg/msg_types.h"
 #include "msg/async/Event.h"
@@ -203,6 +204,12 @@ enum {
   l_msgr_send_messages_queue_lat,
   l_msgr_handle_ack_lat,
 
+  l_msgr_load,
+  l_msgr_migrated_connections,
+
+  l_msgr_zerocopy_sends,
+  l_msgr_zerocopy_disabled,
+
   l_msgr_last,
 };
 
@@ -219,13 +226,20 @@ class Worker {
   unsigned id;
 
   std::atomic_uint references;
+  // the larger of the share of time the event loop was busy and of the
+  // byte rate received, relative to ms_async_rebalance_worker_byte_rate,
+  // during the last sampling period, in per mille; see update_load()
+  std::atomic_uint load;
+  std::atomic_uint cpu_load;
+  std::atomic<uint64_t> recv_byte_rate; // bytes per second
   EventCenter center;
 
   Worker(const Worker&) = delete;
   Worker& operator=(const Worker&) = delete;
 
   Worker(CephContext *c, unsigned worker_id)
-    : cct(c), perf_logger(NULL), id(worker_id), references(0), center(c) {
+    : cct(c), perf_logger(NULL), id(worker_id), references(0), load(0),
+      cpu_load(0), recv_byte_rate(0), center(c) {
     char name[128];
     sprintf(name, "AsyncMessenger::Worker-%u", id);
     // initialize perf_logger
@@ -246,6 +260,12 @@ class Worker {
     plb.add_time_avg(l_msgr_send_messages_queue_lat, "msgr_send_messages_queue_lat", "Network sent messages lat");
     plb.add_time_avg(l_msgr_handle_ack_lat, "msgr_handle_ack_lat", "Connection handle ack lat");
 
+    plb.add_u64(l_msgr_load, "msgr_load", "Load of the worker thread in per mille");
+    plb.add_u64_counter(l_msgr_migrated_connections, "msgr_migrated_connections", "Connections migrated to this worker");
+
+    plb.add_u64_counter(l_msgr_zerocopy_sends, "msgr_zerocopy_sends", "Network sends with MSG_ZEROCOPY");
+    plb.add_u64_counter(l_msgr_zerocopy_disabled, "msgr_zerocopy_disabled", "Sockets which stopped using MSG_ZEROCOPY because the kernel copied the data");
+
     perf_logger = plb.create_perf_counters();
     cct->get_perfcounters_collection()->add(perf_logger);
   }
@@ -268,6 +288,22 @@ class Worker {
     int oldref = references.fetch_sub(1);
     ceph_assert(oldref > 0);
   }
+  // per mille of ms_async_rebalance_worker_byte_rate
+  unsigned byte_load(uint64_t byte_rate) const {
+    const uint64_t full_rate = std::max<uint64_t>(
+      1, cct->_conf.get_val<Option::size_t>("ms_async_rebalance_worker_byte_rate"));
+    return std::min<uint64_t>(1000, byte_rate * 1000 / full_rate);
+  }
+  // takes the busy time of the event loop and the bytes received during
+  // the last sampling period
+  void update_load(ceph::timespan busy, ceph::timespan period,
+                   uint64_t recv_bytes) {
+    const uint64_t ns = std::max<uint64_t>(1, period.count());
+    cpu_load = std::min<uint64_t>(1000, busy.count() * 1000 / ns);
+    recv_byte_rate = recv_bytes * 1000000000ull / ns;
+    load = std::max(cpu_load.load(), byte_load(recv_byte_rate));
+    perf_logger->set(l_msgr_load, load);
+  }
   void init_done() {
     init_lock.lock();
     init = true;
@@ -295,6 +331,7 @@ class Worker {
 class NetworkStack {
   ceph::spinlock pool_spin;
   bool started = false;
+  std::unique_ptr<AdminSocketHook> asok_hook;
 
   std::function<void ()> add_thread(Worker* w);
 
@@ -308,10 +345,7 @@ class NetworkStack {
  public:
   NetworkStack(const NetworkStack &) = delete;
   NetworkStack& operator=(const NetworkStack &) = delete;
-  virtual ~NetworkStack() {
-    for (auto &&w : workers)
-      delete w;
-  }
+  virtual ~NetworkStack();
 
   static std::shared_ptr<NetworkStack> create(
     CephContext *c, const std::string &type);
@@ -324,6 +358,10 @@ class NetworkStack {
   // need to let each thread do binding port.
   virtual bool support_local_listen_table() const { return false; }
   virtual bool nonblock_connect_need_writable_event() const { return true; }
+  // backend need to override this method if an established connection can
+  // be moved from one worker to another, e.g. because its sockets are
+  // plain file descriptors that any EventCenter is able to poll.
+  virtual bool support_connection_migration() const { return false; }
 
   void start();
   void stop();
@@ -335,6 +373,12 @@ class NetworkStack {
   unsigned get_num_worker() const {
     return workers.size();
   }
+  // Returns the worker that a connection generating conn_load (per mille
+  // of a worker's time) on `from` should be moved to, or nullptr if such
+  // a move would not narrow the load gap between workers. The expected
+  // effect of the move is accounted for immediately.
+  Worker *get_migration_target(Worker *from, unsigned conn_load);
+  void dump_workers(ceph::Formatter *f);
 
   // direct is used in tests only
   virtual void spawn_worker(std::function<void ()> &&) = 0;
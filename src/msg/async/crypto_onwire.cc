@@ -1,13 +1,23 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
 // vim: ts=8 sw=2 smarttab
 
+#include <algorithm>
 #include <array>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <openssl/evp.h>
 
 #include "crypto_onwire.h"
 
 #include "common/debug.h"
 #include "common/ceph_crypto.h"
+#include "common/Thread.h"
+#include "include/intarith.h"
 #include "include/types.h"
 
 #define dout_subsys ceph_subsys_ms
@@ -31,26 +41,177 @@ static_assert(sizeof(nonce_t) == AESGCM_IV_LEN);
 
 using key_t = std::array<std::uint8_t, AESGCM_KEY_LEN>;
 
+static void advance_nonce(nonce_t& nonce, bool new_nonce_format)
+{
+  if (!new_nonce_format) {
+    // msgr2.0: 32-bit counter followed by 64-bit fixed field,
+    // susceptible to overflow!
+    nonce.fixed = nonce.fixed + 1;
+  } else {
+    nonce.counter = nonce.counter + 1;
+  }
+}
+
+using evp_ctx_ptr_t =
+  std::unique_ptr<EVP_CIPHER_CTX, decltype(&::EVP_CIPHER_CTX_free)>;
+
+// Pool of threads shared by all connections of a CephContext. It runs
+// the per-chunk seal/unseal jobs of large frames so that a few busy
+// connections do not saturate the event-center threads they are bound
+// to. The submitting thread takes part in the work, thus a pool without
+// threads (ms_crypto_threads = 0) simply processes chunks serially.
+class ChunkWorkPool {
+  struct job_t {
+    const std::function<void(std::size_t)>* fn;
+    std::size_t num_items;
+    std::size_t next_item = 0;   // protected by ChunkWorkPool::lock
+    std::size_t done_items = 0;  // protected by ChunkWorkPool::lock
+    std::exception_ptr error;    // protected by ChunkWorkPool::lock
+    std::condition_variable done_cond;
+  };
+
+  std::mutex lock;
+  std::condition_variable work_cond;
+  std::deque<job_t*> jobs;
+  std::vector<std::thread> threads;
+  bool stopping = false;
+
+  // Claims and runs items of the front job until none is left unclaimed.
+  // Called with lock held; drops it while running items.
+  void run_items(std::unique_lock<std::mutex>& l, job_t& job) {
+    while (job.next_item < job.num_items) {
+      const std::size_t item = job.next_item++;
+      if (job.next_item == job.num_items) {
+	// fully claimed, let others pick the next job
+	jobs.erase(std::find(jobs.begin(), jobs.end(), &job));
+      }
+      l.unlock();
+      std::exception_ptr error;
+      try {
+	(*job.fn)(item);
+      } catch (...) {
+	error = std::current_exception();
+      }
+      l.lock();
+      if (error && !job.error) {
+	job.error = error;
+      }
+      if (++job.done_items == job.num_items) {
+	job.done_cond.notify_all();
+      }
+    }
+  }
+
+  void worker() {
+    std::unique_lock l{lock};
+    while (true) {
+      work_cond.wait(l, [this] { return stopping || !jobs.empty(); });
+      if (stopping) {
+	return;
+      }
+      run_items(l, *jobs.front());
+    }
+  }
+
+public:
+  explicit ChunkWorkPool(CephContext* cct) {
+    const auto num_threads = cct->_conf.get_val<uint64_t>("ms_crypto_threads");
+    for (uint64_t i = 0; i < num_threads; i++) {
+      threads.emplace_back(make_named_thread("ms_crypto", &ChunkWorkPool::worker,
+                                             this));
+    }
+  }
+
+  ~ChunkWorkPool() {
+    {
+      std::lock_guard l{lock};
+      stopping = true;
+    }
+    work_cond.notify_all();
+    for (auto& t : threads) {
+      t.join();
+    }
+  }
+
+  // Calls fn(i) for every i in [0, num_items) and returns when all
+  // calls are done. The first exception thrown by fn is rethrown.
+  void parallel_for(std::size_t num_items,
+                    const std::function<void(std::size_t)>& fn) {
+    if (threads.empty() || num_items < 2) {
+      for (std::size_t i = 0; i < num_items; i++) {
+	fn(i);
+      }
+      return;
+    }
+    job_t job{&fn, num_items};
+    std::unique_lock l{lock};
+    jobs.push_back(&job);
+    work_cond.notify_all();
+    run_items(l, job);
+    job.done_cond.wait(l, [&job] { return job.done_items == job.num_items; });
+    if (job.error) {
+      std::rethrow_exception(job.error);
+    }
+  }
+};
+
+static void run_chunks(ChunkWorkPool* pool, std::size_t num_chunks,
+                       const std::function<void(std::size_t)>& fn)
+{
+  if (pool) {
+    pool->parallel_for(num_chunks, fn);
+  } else {
+    for (std::size_t i = 0; i < num_chunks; i++) {
+      fn(i);
+    }
+  }
+}
+
+// Returns iterators pointing at the beginning of every chunk_len-sized
+// chunk of bl.
+static std::vector<ceph::bufferlist::const_iterator> get_chunk_starts(
+  const ceph::bufferlist& bl, std::uint32_t chunk_len)
+{
+  const std::size_t num_chunks = div_round_up(bl.length(), chunk_len);
+  std::vector<ceph::bufferlist::const_iterator> starts;
+  starts.reserve(num_chunks);
+  auto it = bl.cbegin();
+  for (std::size_t i = 0; i < num_chunks; i++) {
+    starts.push_back(it);
+    if (i + 1 < num_chunks) {
+      it += chunk_len;
+    }
+  }
+  return starts;
+}
+
 // http://www.mindspring.com/~dmcgrew/gcm-nist-6.pdf
 // https://www.openssl.org/docs/man1.0.2/crypto/EVP_aes_128_gcm.html#GCM-mode
 // https://wiki.openssl.org/index.php/EVP_Authenticated_Encryption_and_Decryption
 // https://nvlpubs.nist.gov/nistpubs/Legacy/SP/nistspecialpublication800-38d.pdf
 class AES128GCM_OnWireTxHandler : public ceph::crypto::onwire::TxHandler {
   CephContext* const cct;
+  ChunkWorkPool* const pool;
   std::unique_ptr<EVP_CIPHER_CTX, decltype(&::EVP_CIPHER_CTX_free)> ectx;
   ceph::bufferlist buffer;
+  key_t key;
   nonce_t nonce, initial_nonce;
   bool used_initial_nonce;
   bool new_nonce_format;  // 64-bit counter?
   static_assert(sizeof(nonce) == AESGCM_IV_LEN);
 
+  nonce_t get_next_nonce();
+
 public:
   AES128GCM_OnWireTxHandler(CephContext* const cct,
+			    ChunkWorkPool* const pool,
 			    const key_t& key,
 			    const nonce_t& nonce,
 			    bool new_nonce_format)
     : cct(cct),
+      pool(pool),
       ectx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free),
+      key(key),
       nonce(nonce), initial_nonce(nonce), used_initial_nonce(false),
       new_nonce_format(new_nonce_format) {
     ceph_assert_always(ectx);
@@ -68,6 +229,7 @@ public:
   }
 
   ~AES128GCM_OnWireTxHandler() override {
+    ::TOPNSPC::crypto::zeroize_for_security(key.data(), key.size());
     ::TOPNSPC::crypto::zeroize_for_security(&nonce, sizeof(nonce));
     ::TOPNSPC::crypto::zeroize_for_security(&initial_nonce, sizeof(initial_nonce));
   }
@@ -76,10 +238,14 @@ public:
 
   void authenticated_encrypt_update(const ceph::bufferlist& plaintext) override;
   ceph::bufferlist authenticated_encrypt_final() override;
+
+  ceph::bufferlist authenticated_encrypt_chunked(
+    const ceph::bufferlist& plaintext,
+    std::uint32_t chunk_len,
+    ceph::bufferlist& tags) override;
 };
 
-void AES128GCM_OnWireTxHandler::reset_tx_handler(const uint32_t* first,
-                                                 const uint32_t* last)
+nonce_t AES128GCM_OnWireTxHandler::get_next_nonce()
 {
   if (nonce == initial_nonce) {
     if (used_initial_nonce) {
@@ -88,21 +254,22 @@ void AES128GCM_OnWireTxHandler::reset_tx_handler(const uint32_t* first,
     used_initial_nonce = true;
   }
 
+  const nonce_t current = nonce;
+  advance_nonce(nonce, new_nonce_format);
+  return current;
+}
+
+void AES128GCM_OnWireTxHandler::reset_tx_handler(const uint32_t* first,
+                                                 const uint32_t* last)
+{
+  const nonce_t current = get_next_nonce();
   if(1 != EVP_EncryptInit_ex(ectx.get(), nullptr, nullptr, nullptr,
-      reinterpret_cast<const unsigned char*>(&nonce))) {
+      reinterpret_cast<const unsigned char*>(&current))) {
     throw std::runtime_error("EVP_EncryptInit_ex failed");
   }
 
   ceph_assert(buffer.get_append_buffer_unused_tail_length() == 0);
   buffer.reserve(std::accumulate(first, last, AESGCM_TAG_LEN));
-
-  if (!new_nonce_format) {
-    // msgr2.0: 32-bit counter followed by 64-bit fixed field,
-    // susceptible to overflow!
-    nonce.fixed = nonce.fixed + 1;
-  } else {
-    nonce.counter = nonce.counter + 1;
-  }
 }
 
 void AES128GCM_OnWireTxHandler::authenticated_encrypt_update(
@@ -160,20 +327,90 @@ ceph::bufferlist AES128GCM_OnWireTxHandler::authenticated_encrypt_final()
   return std::move(buffer);
 }
 
+ceph::bufferlist AES128GCM_OnWireTxHandler::authenticated_encrypt_chunked(
+  const ceph::bufferlist& plaintext,
+  const std::uint32_t chunk_len,
+  ceph::bufferlist& tags)
+{
+  ceph_assert(chunk_len > 0 && chunk_len % AESGCM_BLOCK_LEN == 0);
+  ceph_assert(buffer.length() == 0);
+  const auto starts = get_chunk_starts(plaintext, chunk_len);
+
+  // nonces are handed out in chunk order, exactly like a sequence of
+  // reset-update-final rounds would do
+  std::vector<nonce_t> nonces;
+  nonces.reserve(starts.size());
+  for (std::size_t i = 0; i < starts.size(); i++) {
+    nonces.push_back(get_next_nonce());
+  }
+
+  ceph::bufferptr ciphertext(plaintext.length());
+  ceph::bufferptr tag_buf(starts.size() * AESGCM_TAG_LEN);
+  run_chunks(pool, starts.size(), [&](std::size_t i) {
+    evp_ctx_ptr_t ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    ceph_assert_always(ctx);
+    if (1 != EVP_EncryptInit_ex(ctx.get(), EVP_aes_128_gcm(), nullptr,
+	  key.data(), reinterpret_cast<const unsigned char*>(&nonces[i]))) {
+      throw std::runtime_error("EVP_EncryptInit_ex failed");
+    }
+
+    auto out = reinterpret_cast<unsigned char*>(ciphertext.c_str()) +
+      i * chunk_len;
+    auto it = starts[i];
+    std::size_t left = std::min<std::size_t>(chunk_len, it.get_remaining());
+    while (left > 0) {
+      const char* in = nullptr;
+      const std::size_t len = it.get_ptr_and_advance(left, &in);
+      int update_len = 0;
+      if (1 != EVP_EncryptUpdate(ctx.get(), out, &update_len,
+	    reinterpret_cast<const unsigned char*>(in), len)) {
+	throw std::runtime_error("EVP_EncryptUpdate failed");
+      }
+      ceph_assert(static_cast<std::size_t>(update_len) == len);
+      out += len;
+      left -= len;
+    }
+
+    int final_len = 0;
+    if (1 != EVP_EncryptFinal_ex(ctx.get(), out, &final_len)) {
+      throw std::runtime_error("EVP_EncryptFinal_ex failed");
+    }
+    ceph_assert_always(final_len == 0);
+    if (1 != EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG,
+	  AESGCM_TAG_LEN, tag_buf.c_str() + i * AESGCM_TAG_LEN)) {
+      throw std::runtime_error("EVP_CIPHER_CTX_ctrl failed");
+    }
+  });
+
+  ldout(cct, 15) << __func__
+		 << " plaintext.length()=" << plaintext.length()
+		 << " chunk_len=" << chunk_len
+		 << " num_chunks=" << starts.size()
+		 << dendl;
+  tags.append(std::move(tag_buf));
+  ceph::bufferlist ret;
+  ret.append(std::move(ciphertext));
+  return ret;
+}
+
 // RX PART
 class AES128GCM_OnWireRxHandler : public ceph::crypto::onwire::RxHandler {
+  ChunkWorkPool* const pool;
   std::unique_ptr<EVP_CIPHER_CTX, decltype(&::EVP_CIPHER_CTX_free)> ectx;
+  key_t key;
   nonce_t nonce;
   bool new_nonce_format;  // 64-bit counter?
   static_assert(sizeof(nonce) == AESGCM_IV_LEN);
 
 public:
   AES128GCM_OnWireRxHandler(CephContext* const cct,
+			    ChunkWorkPool* const pool,
 			    const key_t& key,
 			    const nonce_t& nonce,
 			    bool new_nonce_format)
-    : ectx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free),
-      nonce(nonce), new_nonce_format(new_nonce_format) {
+    : pool(pool),
+      ectx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free),
+      key(key), nonce(nonce), new_nonce_format(new_nonce_format) {
     ceph_assert_always(ectx);
     ceph_assert_always(key.size() * CHAR_BIT == 128);
 
@@ -189,6 +426,7 @@ public:
   }
 
   ~AES128GCM_OnWireRxHandler() override {
+    ::TOPNSPC::crypto::zeroize_for_security(key.data(), key.size());
     ::TOPNSPC::crypto::zeroize_for_security(&nonce, sizeof(nonce));
   }
 
@@ -198,6 +436,9 @@ public:
   void reset_rx_handler() override;
   void authenticated_decrypt_update(ceph::bufferlist& bl) override;
   void authenticated_decrypt_update_final(ceph::bufferlist& bl) override;
+  void authenticated_decrypt_chunked(ceph::bufferlist& bl,
+                                     std::uint32_t chunk_len,
+                                     ceph::bufferlist& tags) override;
 };
 
 void AES128GCM_OnWireRxHandler::reset_rx_handler()
@@ -206,14 +447,7 @@ void AES128GCM_OnWireRxHandler::reset_rx_handler()
 	reinterpret_cast<const unsigned char*>(&nonce))) {
     throw std::runtime_error("EVP_DecryptInit_ex failed");
   }
-
-  if (!new_nonce_format) {
-    // msgr2.0: 32-bit counter followed by 64-bit fixed field,
-    // susceptible to overflow!
-    nonce.fixed = nonce.fixed + 1;
-  } else {
-    nonce.counter = nonce.counter + 1;
-  }
+  advance_nonce(nonce, new_nonce_format);
 }
 
 void AES128GCM_OnWireRxHandler::authenticated_decrypt_update(
@@ -266,6 +500,60 @@ void AES128GCM_OnWireRxHandler::authenticated_decrypt_update_final(
   }
 }
 
+void AES128GCM_OnWireRxHandler::authenticated_decrypt_chunked(
+  ceph::bufferlist& bl,
+  const std::uint32_t chunk_len,
+  ceph::bufferlist& tags)
+{
+  ceph_assert(chunk_len > 0 && chunk_len % AESGCM_BLOCK_LEN == 0);
+  const auto starts = get_chunk_starts(bl, chunk_len);
+  ceph_assert(tags.length() == starts.size() * AESGCM_TAG_LEN);
+
+  std::vector<nonce_t> nonces;
+  nonces.reserve(starts.size());
+  for (std::size_t i = 0; i < starts.size(); i++) {
+    nonces.push_back(nonce);
+    advance_nonce(nonce, new_nonce_format);
+  }
+
+  // discard cached crcs as we will be writing through c_str()
+  bl.invalidate_crc();
+  const char* tag_buf = tags.c_str();
+  run_chunks(pool, starts.size(), [&](std::size_t i) {
+    evp_ctx_ptr_t ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    ceph_assert_always(ctx);
+    if (1 != EVP_DecryptInit_ex(ctx.get(), EVP_aes_128_gcm(), nullptr,
+	  key.data(), reinterpret_cast<const unsigned char*>(&nonces[i]))) {
+      throw std::runtime_error("EVP_DecryptInit_ex failed");
+    }
+
+    auto it = starts[i];
+    std::size_t left = std::min<std::size_t>(chunk_len, it.get_remaining());
+    while (left > 0) {
+      const char* in = nullptr;
+      const std::size_t len = it.get_ptr_and_advance(left, &in);
+      auto p = reinterpret_cast<unsigned char*>(const_cast<char*>(in));
+      int update_len = 0;
+      if (1 != EVP_DecryptUpdate(ctx.get(), p, &update_len, p, len)) {
+	throw std::runtime_error("EVP_DecryptUpdate failed");
+      }
+      ceph_assert(static_cast<std::size_t>(update_len) == len);
+      left -= len;
+    }
+
+    if (1 != EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG,
+	  AESGCM_TAG_LEN,
+	  const_cast<char*>(tag_buf + i * AESGCM_TAG_LEN))) {
+      throw std::runtime_error("EVP_CIPHER_CTX_ctrl failed");
+    }
+    int final_len = 0;
+    if (0 >= EVP_DecryptFinal_ex(ctx.get(), nullptr, &final_len)) {
+      throw MsgAuthError();
+    }
+    ceph_assert_always(final_len == 0);
+  });
+}
+
 ceph::crypto::onwire::rxtx_t ceph::crypto::onwire::rxtx_t::create_handler_pair(
   CephContext* cct,
   const AuthConnectionMeta& auth_meta,
@@ -295,11 +583,19 @@ ceph::crypto::onwire::rxtx_t ceph::crypto::onwire::rxtx_t::create_handler_pair(
       secbuf += sizeof(tx_nonce);
     }
 
+    ChunkWorkPool* pool = nullptr;
+#if !(defined(WITH_SEASTAR) && !defined(WITH_ALIEN))
+    if (cct) {
+      pool = &cct->lookup_or_create_singleton_object<ChunkWorkPool>(
+	"crypto_onwire::ChunkWorkPool", false, cct);
+    }
+#endif
+
     return {
       std::make_unique<AES128GCM_OnWireRxHandler>(
-	cct, key, crossed ? tx_nonce : rx_nonce, new_nonce_format),
+	cct, pool, key, crossed ? tx_nonce : rx_nonce, new_nonce_format),
       std::make_unique<AES128GCM_OnWireTxHandler>(
-	cct, key, crossed ? rx_nonce : tx_nonce, new_nonce_format)
+	cct, pool, key, crossed ? rx_nonce : tx_nonce, new_nonce_format)
     };
   } else {
     return { nullptr, nullptr };
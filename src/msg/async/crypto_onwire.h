@@ -86,6 +86,19 @@ struct TxHandler {
   // Generates authentication signature and returns bufferlist crafted
   // basing on plaintext from preceding call to _update().
   virtual ceph::bufferlist authenticated_encrypt_final() = 0;
+
+  // Encrypt plaintext as a sequence of independently sealed chunks of
+  // chunk_len bytes (the last one may be shorter). Every chunk consumes
+  // its own nonce and gets its own authentication signature, so chunks
+  // can be processed concurrently on the crypto worker pool. Returns the
+  // ciphertext; signatures, one per chunk, are appended to tags.
+  //
+  // This is a self-contained operation: it MUST NOT be called between
+  // _reset() and _final().
+  virtual ceph::bufferlist authenticated_encrypt_chunked(
+    const ceph::bufferlist& plaintext,
+    std::uint32_t chunk_len,
+    ceph::bufferlist& tags) = 0;
 };
 
 class RxHandler {
@@ -109,6 +122,13 @@ public:
   // for overall decryption sequence.
   // Throws on integrity/authenticity checks
   virtual void authenticated_decrypt_update_final(ceph::bufferlist& bl) = 0;
+
+  // Counterpart of TxHandler::authenticated_encrypt_chunked(). Decrypts
+  // bl in place; tags carries one signature per chunk_len-sized chunk.
+  // Throws on integrity/authenticity checks of any chunk.
+  virtual void authenticated_decrypt_chunked(ceph::bufferlist& bl,
+                                             std::uint32_t chunk_len,
+                                             ceph::bufferlist& tags) = 0;
 };
 
 struct rxtx_t {
@@ -220,6 +220,23 @@ bufferlist FrameAssembler::asm_secure_rev1(const preamble_block_t& preamble,
   epilogue_bl.append(reinterpret_cast<const char*>(&epilogue),
                      sizeof(epilogue));
 
+  if (get_num_seal_chunks() > 0) {
+    bufferlist segments_bl;
+    for (size_t i = 1; i < m_descs.size(); i++) {
+      segments_bl.claim_append(segment_bls[i]);
+    }
+    bufferlist tags_bl;
+    frame_bl.claim_append(m_crypto->tx->authenticated_encrypt_chunked(
+        segments_bl, FRAME_SEAL_CHUNK_SIZE, tags_bl));
+    ceph_assert(tags_bl.length() == get_num_seal_chunks() * get_auth_tag_len());
+    frame_bl.claim_append(tags_bl);
+
+    m_crypto->tx->reset_tx_handler({epilogue_bl.length()});
+    m_crypto->tx->authenticated_encrypt_update(epilogue_bl);
+    frame_bl.claim_append(m_crypto->tx->authenticated_encrypt_final());
+    return frame_bl;
+  }
+
   // MAX_NUM_SEGMENTS - 1 + epilogue
   uint32_t onwire_lens[MAX_NUM_SEGMENTS];
   for (size_t i = 1; i < m_descs.size(); i++) {
@@ -406,13 +423,31 @@ void FrameAssembler::disasm_first_secure_rev1(bufferlist& preamble_bl,
 
 bool FrameAssembler::disasm_remaining_secure_rev1(
     bufferlist segment_bls[], bufferlist& epilogue_bl) const {
-  m_crypto->rx->reset_rx_handler();
-  for (size_t i = 1; i < m_descs.size(); i++) {
-    ceph_assert(segment_bls[i].length() == get_segment_padded_len(i));
-    if (segment_bls[i].length() > 0) {
-      m_crypto->rx->authenticated_decrypt_update(segment_bls[i]);
+  if (uint32_t num_chunks = get_num_seal_chunks(); num_chunks > 0) {
+    // segments_bl shares raw buffers with segment_bls, decryption
+    // is done in place
+    bufferlist segments_bl;
+    for (size_t i = 1; i < m_descs.size(); i++) {
+      ceph_assert(segment_bls[i].length() == get_segment_padded_len(i));
+      segments_bl.append(segment_bls[i]);
+    }
+    bufferlist tags_bl;
+    epilogue_bl.splice(0, num_chunks * get_auth_tag_len(), &tags_bl);
+    m_crypto->rx->authenticated_decrypt_chunked(
+        segments_bl, FRAME_SEAL_CHUNK_SIZE, tags_bl);
+    for (size_t i = 1; i < m_descs.size(); i++) {
       unpad_zero(segment_bls[i], m_descs[i].logical_len);
     }
+    m_crypto->rx->reset_rx_handler();
+  } else {
+    m_crypto->rx->reset_rx_handler();
+    for (size_t i = 1; i < m_descs.size(); i++) {
+      ceph_assert(segment_bls[i].length() == get_segment_padded_len(i));
+      if (segment_bls[i].length() > 0) {
+        m_crypto->rx->authenticated_decrypt_update(segment_bls[i]);
+        unpad_zero(segment_bls[i], m_descs[i].logical_len);
+      }
+    }
   }
 
   ceph_assert(epilogue_bl.length() == sizeof(epilogue_secure_rev1_block_t) +
@@ -468,6 +503,7 @@ std::ostream& operator<<(std::ostream& os, const FrameAssembler& frame_asm) {
     os << " + " << frame_asm.get_epilogue_onwire_len() << " ";
   }
   os << "rev1=" << frame_asm.m_is_rev1
+     << " chunked_seal=" << frame_asm.m_is_chunked_seal
      << " rx=" << frame_asm.m_crypto->rx.get()
      << " tx=" << frame_asm.m_crypto->tx.get();
   return os;
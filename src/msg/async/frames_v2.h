@@ -139,6 +139,11 @@ static_assert(std::is_standard_layout_v<epilogue_secure_rev1_block_t>);
 
 static constexpr uint32_t FRAME_CRC_SIZE = 4;
 static constexpr uint32_t FRAME_PREAMBLE_INLINE_SIZE = 48;
+// With CEPH_MSGR2_FEATURE_CHUNKED_SEAL, second to fourth segments of
+// a msgr2.1 secure frame are sealed in chunks of this size if they
+// don't fit into a single one.
+static constexpr uint32_t FRAME_SEAL_CHUNK_SIZE = 128 << 10;
+static_assert(FRAME_SEAL_CHUNK_SIZE % CRYPTO_BLOCK_SIZE == 0);
 static_assert(FRAME_PREAMBLE_INLINE_SIZE % CRYPTO_BLOCK_SIZE == 0);
 // just for performance, nothing should break otherwise
 static_assert(sizeof(ceph_msg_header2) <= FRAME_PREAMBLE_INLINE_SIZE);
@@ -177,7 +182,7 @@ class FrameAssembler {
 public:
   // crypto must be non-null
   FrameAssembler(const ceph::crypto::onwire::rxtx_t* crypto, bool is_rev1)
-      : m_crypto(crypto), m_is_rev1(is_rev1) {}
+      : m_crypto(crypto), m_is_rev1(is_rev1), m_is_chunked_seal(false) {}
 
   void set_is_rev1(bool is_rev1) {
     m_descs.clear();
@@ -188,6 +193,16 @@ public:
     return m_is_rev1;
   }
 
+  // Takes effect only in msgr2.1 secure mode, see get_num_seal_chunks().
+  void set_is_chunked_seal(bool is_chunked_seal) {
+    m_descs.clear();
+    m_is_chunked_seal = is_chunked_seal;
+  }
+
+  bool get_is_chunked_seal() {
+    return m_is_chunked_seal;
+  }
+
   size_t get_num_segments() const {
     ceph_assert(!m_descs.empty());
     return m_descs.size();
@@ -277,6 +292,11 @@ public:
   // Additionally, each variant of the epilogue contains either
   // late_flags or late_status field that directs handling of frames
   // with more than one segment.
+  //
+  // If second to fourth segments of a msgr2.1 secure frame are sealed
+  // in chunks (see get_num_seal_chunks()), the epilogue is preceded by
+  // the auth tags of all chunks and its own auth tag covers just the
+  // epilogue block.
   uint32_t get_epilogue_onwire_len() const {
     ceph_assert(!m_descs.empty());
     if (m_is_rev1 && m_descs.size() == 1) {
@@ -284,7 +304,8 @@ public:
     }
     if (m_crypto->rx) {
       return (m_is_rev1 ? sizeof(epilogue_secure_rev1_block_t) :
-                  sizeof(epilogue_secure_rev0_block_t)) + get_auth_tag_len();
+                  sizeof(epilogue_secure_rev0_block_t)) +
+             (get_num_seal_chunks() + 1) * get_auth_tag_len();
     }
     return m_is_rev1 ? sizeof(epilogue_crc_rev1_block_t) :
                        sizeof(epilogue_crc_rev0_block_t);
@@ -345,6 +366,24 @@ private:
     return m_crypto->rx->get_extra_size_at_final();
   }
 
+  // Number of independently sealed chunks that second to fourth
+  // segments are split into, or 0 if they are sealed together with
+  // the epilogue as usual.  Chunks are encrypted and decrypted on
+  // the shared crypto worker pool.
+  uint32_t get_num_seal_chunks() const {
+    if (!m_is_chunked_seal || !m_is_rev1 || !m_crypto->rx) {
+      return 0;
+    }
+    uint64_t len = 0;
+    for (size_t i = 1; i < m_descs.size(); i++) {
+      len += get_segment_padded_len(i);
+    }
+    if (len <= FRAME_SEAL_CHUNK_SIZE) {
+      return 0;
+    }
+    return div_round_up(len, FRAME_SEAL_CHUNK_SIZE);
+  }
+
   bufferlist asm_crc_rev0(const preamble_block_t& preamble,
                           bufferlist segment_bls[]) const;
   bufferlist asm_secure_rev0(const preamble_block_t& preamble,
@@ -374,6 +413,7 @@ private:
   boost::container::static_vector<segment_desc_t, MAX_NUM_SEGMENTS> m_descs;
   const ceph::crypto::onwire::rxtx_t* m_crypto;
   bool m_is_rev1;  // msgr2.1?
+  bool m_is_chunked_seal;  // CEPH_MSGR2_FEATURE_CHUNKED_SEAL?
 };
 
 template <class T, uint16_t... SegmentAlignmentVs>
@@ -59,6 +59,19 @@ int NetHandler::create_socket(int domain, bool reuse_addr)
   }
 #endif
 
+#ifdef SO_ZEROCOPY
+  // sockets accepted from a listening socket inherit the flag. the kernel
+  // only lets us set it before the connection is established.
+  if (cct->_conf.get_val<bool>("ms_tcp_zerocopy")) {
+    int on = 1;
+    if (::setsockopt(s, SOL_SOCKET, SO_ZEROCOPY, (SOCKOPT_VAL_TYPE)&on, sizeof(on)) == -1) {
+      r = ceph_sock_errno();
+      ldout(cct, 1) << __func__ << " setsockopt SO_ZEROCOPY failed: "
+                    << cpp_strerror(r) << ", sending with copies" << dendl;
+    }
+  }
+#endif
+
   return s;
 }
 
@@ -91,6 +91,9 @@ class Aio {
   // wait for all outstanding completions and return their results
   virtual AioResultList drain() = 0;
 
+  // resize the window of outstanding requests, if there is one
+  virtual void set_window(uint64_t window) {}
+
   static OpFunc librados_op(librados::ObjectReadOperation&& op,
                             optional_yield y);
   static OpFunc librados_op(librados::ObjectWriteOperation&& op,
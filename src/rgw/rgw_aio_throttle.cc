@@ -63,6 +63,12 @@ AioResultList BlockingAioThrottle::get(const RGWSI_RADOS::Obj& obj,
   return std::move(completed);
 }
 
+void BlockingAioThrottle::set_window(uint64_t w)
+{
+  std::scoped_lock lock{mutex};
+  window = w;
+}
+
 void BlockingAioThrottle::put(AioResult& r)
 {
   auto& p = static_cast<Pending&>(r);
@@ -27,7 +27,7 @@ namespace rgw {
 
 class Throttle {
  protected:
-  const uint64_t window;
+  uint64_t window;
   uint64_t pending_size = 0;
 
   AioResultList pending;
@@ -76,6 +76,8 @@ class BlockingAioThrottle final : public Aio, private Throttle {
   AioResultList wait() override final;
 
   AioResultList drain() override final;
+
+  void set_window(uint64_t w) override final;
 };
 
 // a throttle that yields the coroutine instead of blocking. all public
@@ -110,6 +112,9 @@ class YieldingAioThrottle final : public Aio, private Throttle {
   AioResultList wait() override final;
 
   AioResultList drain() override final;
+
+  // n.b., there is no waiter to wake, as it would be the caller
+  void set_window(uint64_t w) override final { window = w; }
 };
 
 // return a smart pointer to Aio
@@ -51,6 +51,13 @@ class ClientIO : public io::RestfulClient,
     return write_data(buf, len);
   }
 
+  size_t send_body_bl(const ceph::bufferlist& bl) override {
+    return write_buffers(bl);
+  }
+
+  /* writes all the buffers of @bl to the client at once */
+  virtual size_t write_buffers(const ceph::bufferlist& bl) = 0;
+
   RGWEnv& get_env() noexcept override {
     return env;
   }
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include <boost/asio.hpp>
+#include <boost/container/small_vector.hpp>
 #include <boost/intrusive/list.hpp>
 
 #include <boost/context/protected_fixedsize_stack.hpp>
@@ -67,14 +68,14 @@ class StreamIO : public rgw::asio::ClientIO {
         cct(cct), stream(stream), yield(yield), buffer(buffer), request_timeout(request_timeout)
   {}
 
-  size_t write_data(const char* buf, size_t len) override {
+  template <typename ConstBufferSequence>
+  size_t write(const ConstBufferSequence& buffers) {
     boost::system::error_code ec;
     auto& timeout = get_lowest_layer(stream);
     if (request_timeout.count()) {
       timeout.expires_after(request_timeout);
     }
-    auto bytes = boost::asio::async_write(stream, boost::asio::buffer(buf, len),
-                                          yield[ec]);
+    auto bytes = boost::asio::async_write(stream, buffers, yield[ec]);
     if (ec) {
       ldout(cct, 4) << "write_data failed: " << ec.message() << dendl;
       if (ec==boost::asio::error::broken_pipe) {
@@ -86,6 +87,21 @@ class StreamIO : public rgw::asio::ClientIO {
     return bytes;
   }
 
+  size_t write_data(const char* buf, size_t len) override {
+    return write(boost::asio::buffer(buf, len));
+  }
+
+  size_t write_buffers(const ceph::bufferlist& bl) override {
+    /* a scatter-gather write straight from the buffers, which for a GET
+     * are the ones the object was read into */
+    boost::container::small_vector<boost::asio::const_buffer, 8> buffers;
+    buffers.reserve(bl.get_num_buffers());
+    for (const auto& ptr : bl.buffers()) {
+      buffers.emplace_back(ptr.c_str(), ptr.length());
+    }
+    return write(buffers);
+  }
+
   size_t recv_body(char* buf, size_t max) override {
     auto& timeout = get_lowest_layer(stream);
     auto& message = parser.get();
@@ -1024,6 +1024,19 @@ AWSv4ComplMulti::ChunkMeta::create_next(CephContext* const cct,
                         semicolon_pos + 83);
 }
 
+/* Finishes the payload hash as a hex string and restarts it for the next
+ * chunk. */
+static std::string finish_payload_hash(rgw::mb_hash::SHA256& hash)
+{
+  unsigned char digest[CEPH_CRYPTO_SHA256_DIGESTSIZE];
+  hash.Final(digest);
+  hash.Restart();
+
+  char hex_str[(CEPH_CRYPTO_SHA256_DIGESTSIZE * 2) + 1];
+  buf_to_hex(digest, CEPH_CRYPTO_SHA256_DIGESTSIZE, hex_str);
+  return std::string(hex_str);
+}
+
 std::string
 AWSv4ComplMulti::calc_chunk_signature(const std::string& payload_hash) const
 {
@@ -1049,7 +1062,7 @@ bool AWSv4ComplMulti::is_signature_mismatched()
 {
   /* The validity of previous chunk can be verified only after getting meta-
    * data of the next one. */
-  const auto payload_hash = calc_hash_sha256_restart_stream(&sha256_hash);
+  const auto payload_hash = finish_payload_hash(sha256_hash);
   const auto calc_signature = calc_chunk_signature(payload_hash);
 
   if (chunk_meta.get_signature() != calc_signature) {
@@ -1128,7 +1141,7 @@ size_t AWSv4ComplMulti::recv_body(char* const buf, const size_t buf_max)
     std::copy(std::begin(parsing_buf), data_end_iter, buf);
     parsing_buf.erase(std::begin(parsing_buf), data_end_iter);
 
-    calc_hash_sha256_update_stream(sha256_hash, buf, data_len);
+    sha256_hash.Update(reinterpret_cast<const unsigned char*>(buf), data_len);
 
     to_extract -= data_len;
     buf_pos += data_len;
@@ -1144,7 +1157,8 @@ size_t AWSv4ComplMulti::recv_body(char* const buf, const size_t buf_max)
       break;
     }
 
-    calc_hash_sha256_update_stream(sha256_hash, buf + buf_pos, received);
+    sha256_hash.Update(reinterpret_cast<const unsigned char*>(buf + buf_pos),
+                       received);
 
     buf_pos += received;
     stream_pos += received;
@@ -1216,7 +1230,7 @@ AWSv4ComplMulti::create(const req_state* const s,
 size_t AWSv4ComplSingle::recv_body(char* const buf, const size_t max)
 {
   const auto received = io_base_t::recv_body(buf, max);
-  calc_hash_sha256_update_stream(sha256_hash, buf, received);
+  sha256_hash.Update(reinterpret_cast<const unsigned char*>(buf), received);
 
   return received;
 }
@@ -1233,7 +1247,7 @@ bool AWSv4ComplSingle::complete()
   /* The completer is only for the cases where signed payload has been
    * requested. It won't be used, for instance, during the query string-based
    * authentication. */
-  const auto payload_hash = calc_hash_sha256_close_stream(&sha256_hash);
+  const auto payload_hash = finish_payload_hash(sha256_hash);
 
   /* Validate x-amz-sha256 */
   if (payload_hash.compare(expected_request_payload_hash) == 0) {
@@ -1253,7 +1267,7 @@ AWSv4ComplSingle::AWSv4ComplSingle(const req_state* const s)
   : io_base_t(nullptr),
     cct(s->cct),
     expected_request_payload_hash(get_v4_exp_payload_hash(s->info)),
-    sha256_hash(calc_hash_sha256_open_stream()) {
+    sha256_hash(rgw::mb_hash::get_sha256_service(s->cct), s->yield) {
 }
 
 rgw::auth::Completer::cmplptr_t
@@ -19,6 +19,7 @@
 #include "rgw_auth.h"
 #include "rgw_auth_filters.h"
 #include "rgw_auth_keystone.h"
+#include "rgw_mb_hash.h"
 
 
 namespace rgw {
@@ -331,7 +332,7 @@ class AWSv4ComplMulti : public rgw::auth::Completer,
 
   size_t stream_pos;
   boost::container::static_vector<char, ChunkMeta::META_MAX_SIZE> parsing_buf;
-  ceph::crypto::SHA256* sha256_hash;
+  rgw::mb_hash::SHA256 sha256_hash;
   std::string prev_chunk_signature;
 
   bool is_signature_mismatched();
@@ -354,16 +355,10 @@ public:
       /* The evolving state. */
       chunk_meta(ChunkMeta::create_first(seed_signature)),
       stream_pos(0),
-      sha256_hash(calc_hash_sha256_open_stream()),
+      sha256_hash(rgw::mb_hash::get_sha256_service(s->cct), s->yield),
       prev_chunk_signature(std::move(seed_signature)) {
   }
 
-  ~AWSv4ComplMulti() {
-    if (sha256_hash) {
-      calc_hash_sha256_close_stream(&sha256_hash);
-    }
-  }
-
   /* rgw::io::DecoratedRestfulClient. */
   size_t recv_body(char* buf, size_t max) override;
 
@@ -387,7 +382,7 @@ class AWSv4ComplSingle : public rgw::auth::Completer,
 
   CephContext* const cct;
   const char* const expected_request_payload_hash;
-  ceph::crypto::SHA256* sha256_hash = nullptr;
+  rgw::mb_hash::SHA256 sha256_hash;
 
 public:
   /* Defined in rgw_auth_s3.cc because of get_v4_exp_payload_hash(). We need
@@ -395,12 +390,6 @@ public:
    * the create() method. */
   explicit AWSv4ComplSingle(const req_state* const s);
 
-  ~AWSv4ComplSingle() {
-    if (sha256_hash) {
-      calc_hash_sha256_close_stream(&sha256_hash);
-    }
-  }
-
   /* rgw::io::DecoratedRestfulClient. */
   size_t recv_body(char* buf, size_t max) override;
 
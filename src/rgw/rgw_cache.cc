@@ -4,20 +4,41 @@
 #include "rgw_cache.h"
 #include "rgw_perf_counters.h"
 
+#include <algorithm>
 #include <errno.h>
 
+#include "include/ceph_hash.h"
+
 #define dout_subsys ceph_subsys_rgw
 
 
-int ObjectCache::get(const DoutPrefixProvider *dpp, const string& name, ObjectCacheInfo& info, uint32_t mask, rgw_cache_entry_info *cache_info)
+void ObjectCache::set_ctx(CephContext *_cct)
 {
+  cct = _cct;
+  const auto num_shards = std::max<uint64_t>(
+      cct->_conf.get_val<uint64_t>("rgw_cache_shards"), 1);
+  shards = std::vector<Shard>(num_shards);
+  lru_window = cct->_conf->rgw_cache_lru_size / num_shards / 2;
+  expiry = std::chrono::seconds(cct->_conf.get_val<uint64_t>(
+				  "rgw_cache_expiry_interval"));
+  negative_expiry = std::chrono::seconds(cct->_conf.get_val<uint64_t>(
+					   "rgw_cache_negative_expiry_interval"));
+}
 
-  std::shared_lock rl{lock};
+size_t ObjectCache::shard_index(const string& name) const
+{
+  return ceph_str_hash_linux(name.c_str(), name.size()) % shards.size();
+}
+
+int ObjectCache::get(const DoutPrefixProvider *dpp, const string& name, ObjectCacheInfo& info, uint32_t mask, rgw_cache_entry_info *cache_info)
+{
+  Shard& shard = shard_of(name);
+  std::shared_lock rl{shard.lock};
   if (!enabled) {
     return -ENOENT;
   }
-  auto iter = cache_map.find(name);
-  if (iter == cache_map.end()) {
+  auto iter = shard.cache_map.find(name);
+  if (iter == shard.cache_map.end()) {
     ldpp_dout(dpp, 10) << "cache get: name=" << name << " : miss" << dendl;
     if (perfcounter) {
       perfcounter->inc(l_rgw_cache_miss);
@@ -25,20 +46,13 @@ int ObjectCache::get(const DoutPrefixProvider *dpp, const string& name, ObjectCa
     return -ENOENT;
   }
 
-  if (expiry.count() &&
-       (ceph::coarse_mono_clock::now() - iter->second.info.time_added) > expiry) {
+  if (is_expired(iter->second.info, ceph::coarse_mono_clock::now())) {
+    /* the entry is left in place: the caller refetches it and put()
+     * replaces it, or it ages out of the lru. either way there's no need
+     * to take the write lock here */
     ldpp_dout(dpp, 10) << "cache get: name=" << name << " : expiry miss" << dendl;
-    rl.unlock();
-    std::unique_lock wl{lock};  // write lock for insertion
-    // check that wasn't already removed by other thread
-    iter = cache_map.find(name);
-    if (iter != cache_map.end()) {
-      for (auto &kv : iter->second.chained_entries)
-        kv.first->invalidate(kv.second);
-      remove_lru(name, iter->second.lru_iter);
-      cache_map.erase(iter);
-    }
     if (perfcounter) {
+      perfcounter->inc(l_rgw_cache_expired);
       perfcounter->inc(l_rgw_cache_miss);
     }
     return -ENOENT;
@@ -46,14 +60,14 @@ int ObjectCache::get(const DoutPrefixProvider *dpp, const string& name, ObjectCa
 
   ObjectCacheEntry *entry = &iter->second;
 
-  if (lru_counter - entry->lru_promotion_ts > lru_window) {
-    ldpp_dout(dpp, 20) << "cache get: touching lru, lru_counter=" << lru_counter
+  if (shard.lru_counter - entry->lru_promotion_ts > lru_window) {
+    ldpp_dout(dpp, 20) << "cache get: touching lru, lru_counter=" << shard.lru_counter
                    << " promotion_ts=" << entry->lru_promotion_ts << dendl;
     rl.unlock();
-    std::unique_lock wl{lock};  // write lock for insertion
+    std::unique_lock wl{shard.lock};  // write lock for insertion
     /* need to redo this because entry might have dropped off the cache */
-    iter = cache_map.find(name);
-    if (iter == cache_map.end()) {
+    iter = shard.cache_map.find(name);
+    if (iter == shard.cache_map.end()) {
       ldpp_dout(dpp, 10) << "lost race! cache get: name=" << name << " : miss" << dendl;
       if(perfcounter) perfcounter->inc(l_rgw_cache_miss);
       return -ENOENT;
@@ -61,15 +75,18 @@ int ObjectCache::get(const DoutPrefixProvider *dpp, const string& name, ObjectCa
 
     entry = &iter->second;
     /* check again, we might have lost a race here */
-    if (lru_counter - entry->lru_promotion_ts > lru_window) {
-      touch_lru(dpp, name, *entry, iter->second.lru_iter);
+    if (shard.lru_counter - entry->lru_promotion_ts > lru_window) {
+      touch_lru(dpp, shard, name, *entry, iter->second.lru_iter);
     }
   }
 
   ObjectCacheInfo& src = iter->second.info;
   if(src.status == -ENOENT) {
     ldpp_dout(dpp, 10) << "cache get: name=" << name << " : hit (negative entry)" << dendl;
-    if (perfcounter) perfcounter->inc(l_rgw_cache_hit);
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_cache_hit);
+      perfcounter->inc(l_rgw_cache_negative_hit);
+    }
     return -ENODATA;
   }
   if ((src.flags & mask) != mask) {
@@ -97,7 +114,21 @@ bool ObjectCache::chain_cache_entry(const DoutPrefixProvider *dpp,
                                     std::initializer_list<rgw_cache_entry_info*> cache_info_entries,
 				    RGWChainedCache::Entry *chained_entry)
 {
-  std::unique_lock l{lock};
+  /* the entries may live in different shards; lock all of them, in index
+   * order so as not to deadlock with another chain_cache_entry() */
+  std::vector<size_t> indexes;
+  indexes.reserve(cache_info_entries.size());
+  for (auto cache_info : cache_info_entries) {
+    indexes.push_back(shard_index(cache_info->cache_locator));
+  }
+  std::sort(indexes.begin(), indexes.end());
+  indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+
+  std::vector<std::unique_lock<ceph::shared_mutex>> locks;
+  locks.reserve(indexes.size());
+  for (auto i : indexes) {
+    locks.emplace_back(shards[i].lock);
+  }
 
   if (!enabled) {
     return false;
@@ -109,6 +140,7 @@ bool ObjectCache::chain_cache_entry(const DoutPrefixProvider *dpp,
   for (auto cache_info : cache_info_entries) {
     ldpp_dout(dpp, 10) << "chain_cache_entry: cache_locator="
 		   << cache_info->cache_locator << dendl;
+    auto& cache_map = shard_of(cache_info->cache_locator).cache_map;
     auto iter = cache_map.find(cache_info->cache_locator);
     if (iter == cache_map.end()) {
       ldpp_dout(dpp, 20) << "chain_cache_entry: couldn't find cache locator" << dendl;
@@ -139,7 +171,8 @@ bool ObjectCache::chain_cache_entry(const DoutPrefixProvider *dpp,
 
 void ObjectCache::put(const DoutPrefixProvider *dpp, const string& name, ObjectCacheInfo& info, rgw_cache_entry_info *cache_info)
 {
-  std::unique_lock l{lock};
+  Shard& shard = shard_of(name);
+  std::unique_lock l{shard.lock};
 
   if (!enabled) {
     return;
@@ -148,11 +181,11 @@ void ObjectCache::put(const DoutPrefixProvider *dpp, const string& name, ObjectC
   ldpp_dout(dpp, 10) << "cache put: name=" << name << " info.flags=0x"
                  << std::hex << info.flags << std::dec << dendl;
 
-  auto [iter, inserted] = cache_map.emplace(name, ObjectCacheEntry{});
+  auto [iter, inserted] = shard.cache_map.emplace(name, ObjectCacheEntry{});
   ObjectCacheEntry& entry = iter->second;
   entry.info.time_added = ceph::coarse_mono_clock::now();
   if (inserted) {
-    entry.lru_iter = lru.end();
+    entry.lru_iter = shard.lru.end();
   }
   ObjectCacheInfo& target = entry.info;
 
@@ -161,7 +194,7 @@ void ObjectCache::put(const DoutPrefixProvider *dpp, const string& name, ObjectC
   entry.chained_entries.clear();
   entry.gen++;
 
-  touch_lru(dpp, name, entry, entry.lru_iter);
+  touch_lru(dpp, shard, name, entry, entry.lru_iter);
 
   target.status = info.status;
 
@@ -214,14 +247,15 @@ void ObjectCache::put(const DoutPrefixProvider *dpp, const string& name, ObjectC
 
 bool ObjectCache::remove(const DoutPrefixProvider *dpp, const string& name)
 {
-  std::unique_lock l{lock};
+  Shard& shard = shard_of(name);
+  std::unique_lock l{shard.lock};
 
   if (!enabled) {
     return false;
   }
 
-  auto iter = cache_map.find(name);
-  if (iter == cache_map.end())
+  auto iter = shard.cache_map.find(name);
+  if (iter == shard.cache_map.end())
     return false;
 
   ldpp_dout(dpp, 10) << "removing " << name << " from cache" << dendl;
@@ -231,16 +265,20 @@ bool ObjectCache::remove(const DoutPrefixProvider *dpp, const string& name)
     kv.first->invalidate(kv.second);
   }
 
-  remove_lru(name, iter->second.lru_iter);
-  cache_map.erase(iter);
+  remove_lru(shard, name, iter->second.lru_iter);
+  shard.cache_map.erase(iter);
   return true;
 }
 
-void ObjectCache::touch_lru(const DoutPrefixProvider *dpp, const string& name, ObjectCacheEntry& entry,
+void ObjectCache::touch_lru(const DoutPrefixProvider *dpp, Shard& shard,
+			    const string& name, ObjectCacheEntry& entry,
 			    std::list<string>::iterator& lru_iter)
 {
-  while (lru_size > (size_t)cct->_conf->rgw_cache_lru_size) {
-    auto iter = lru.begin();
+  // each shard holds its share of rgw_cache_lru_size
+  const size_t max_size = std::max<size_t>(
+      cct->_conf->rgw_cache_lru_size / shards.size(), 1);
+  while (shard.lru_size > max_size) {
+    auto iter = shard.lru.begin();
     if ((*iter).compare(name) == 0) {
       /*
        * if the entry we're touching happens to be at the lru end, don't remove it,
@@ -248,43 +286,46 @@ void ObjectCache::touch_lru(const DoutPrefixProvider *dpp, const string& name, O
        */
       break;
     }
-    auto map_iter = cache_map.find(*iter);
+    auto map_iter = shard.cache_map.find(*iter);
     ldout(cct, 10) << "removing entry: name=" << *iter << " from cache LRU" << dendl;
-    if (map_iter != cache_map.end()) {
+    if (map_iter != shard.cache_map.end()) {
       ObjectCacheEntry& entry = map_iter->second;
       invalidate_lru(entry);
-      cache_map.erase(map_iter);
+      shard.cache_map.erase(map_iter);
+    }
+    shard.lru.pop_front();
+    shard.lru_size--;
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_cache_evict);
     }
-    lru.pop_front();
-    lru_size--;
   }
 
-  if (lru_iter == lru.end()) {
-    lru.push_back(name);
-    lru_size++;
+  if (lru_iter == shard.lru.end()) {
+    shard.lru.push_back(name);
+    shard.lru_size++;
     lru_iter--;
     ldpp_dout(dpp, 10) << "adding " << name << " to cache LRU end" << dendl;
   } else {
     ldpp_dout(dpp, 10) << "moving " << name << " to cache LRU end" << dendl;
-    lru.erase(lru_iter);
-    lru.push_back(name);
-    lru_iter = lru.end();
+    shard.lru.erase(lru_iter);
+    shard.lru.push_back(name);
+    lru_iter = shard.lru.end();
     --lru_iter;
   }
 
-  lru_counter++;
-  entry.lru_promotion_ts = lru_counter;
+  shard.lru_counter++;
+  entry.lru_promotion_ts = shard.lru_counter;
 }
 
-void ObjectCache::remove_lru(const string& name,
+void ObjectCache::remove_lru(Shard& shard, const string& name,
 			     std::list<string>::iterator& lru_iter)
 {
-  if (lru_iter == lru.end())
+  if (lru_iter == shard.lru.end())
     return;
 
-  lru.erase(lru_iter);
-  lru_size--;
-  lru_iter = lru.end();
+  shard.lru.erase(lru_iter);
+  shard.lru_size--;
+  lru_iter = shard.lru.end();
 }
 
 void ObjectCache::invalidate_lru(ObjectCacheEntry& entry)
@@ -298,7 +339,11 @@ void ObjectCache::invalidate_lru(ObjectCacheEntry& entry)
 
 void ObjectCache::set_enabled(bool status)
 {
-  std::unique_lock l{lock};
+  std::vector<std::unique_lock<ceph::shared_mutex>> locks;
+  locks.reserve(shards.size());
+  for (auto& shard : shards) {
+    locks.emplace_back(shard.lock);
+  }
 
   enabled = status;
 
@@ -309,32 +354,39 @@ void ObjectCache::set_enabled(bool status)
 
 void ObjectCache::invalidate_all()
 {
-  std::unique_lock l{lock};
+  std::vector<std::unique_lock<ceph::shared_mutex>> locks;
+  locks.reserve(shards.size());
+  for (auto& shard : shards) {
+    locks.emplace_back(shard.lock);
+  }
 
   do_invalidate_all();
 }
 
+// called with all shards locked
 void ObjectCache::do_invalidate_all()
 {
-  cache_map.clear();
-  lru.clear();
+  for (auto& shard : shards) {
+    shard.cache_map.clear();
+    shard.lru.clear();
 
-  lru_size = 0;
-  lru_counter = 0;
-  lru_window = 0;
+    shard.lru_size = 0;
+    shard.lru_counter = 0;
+  }
 
+  std::lock_guard l{chained_lock};
   for (auto& cache : chained_cache) {
     cache->invalidate_all();
   }
 }
 
 void ObjectCache::chain_cache(RGWChainedCache *cache) {
-  std::unique_lock l{lock};
+  std::lock_guard l{chained_lock};
   chained_cache.push_back(cache);
 }
 
 void ObjectCache::unchain_cache(RGWChainedCache *cache) {
-  std::unique_lock l{lock};
+  std::lock_guard l{chained_lock};
 
   auto iter = chained_cache.begin();
   for (; iter != chained_cache.end(); ++iter) {
@@ -346,10 +398,49 @@ void ObjectCache::unchain_cache(RGWChainedCache *cache) {
   }
 }
 
+bool RGWCacheNotifyBatch::replaces_entry(const RGWCacheNotifyInfo& update)
+{
+  if (update.op == REMOVE_OBJ) {
+    return true;
+  }
+  // a full write replaces everything put() would merge with
+  constexpr uint32_t full = CACHE_FLAG_DATA | CACHE_FLAG_XATTRS | CACHE_FLAG_META;
+  return update.op == UPDATE_OBJ &&
+    update.obj_info.status >= 0 &&
+    (update.obj_info.flags & full) == full &&
+    !(update.obj_info.flags & CACHE_FLAG_MODIFY_XATTRS);
+}
+
+size_t RGWCacheNotifyBatch::add(const string& name, RGWCacheNotifyInfo&& info)
+{
+  if (key.empty()) {
+    key = name;
+  }
+  auto& entry_updates = updates[name];
+  size_t dropped = 0;
+  if (!entry_updates.empty() && replaces_entry(info)) {
+    dropped = entry_updates.size();
+    entry_updates.clear();
+  }
+  entry_updates.push_back(std::move(info));
+  return dropped;
+}
+
+RGWCacheNotifyInfo RGWCacheNotifyBatch::make_notify()
+{
+  RGWCacheNotifyInfo info;
+  info.op = BATCH_OBJS;
+  for (auto& [name, entry_updates] : updates) {
+    std::move(entry_updates.begin(), entry_updates.end(),
+              std::back_inserter(info.batch));
+  }
+  updates.clear();
+  return info;
+}
+
 ObjectCache::~ObjectCache()
 {
   for (auto cache : chained_cache) {
     cache->unregistered();
   }
 }
-
@@ -18,6 +18,7 @@
 enum {
   UPDATE_OBJ,
   REMOVE_OBJ,
+  BATCH_OBJS, // the ops of RGWCacheNotifyInfo::batch, in order
 };
 
 #define CACHE_FLAG_DATA           0x01
@@ -100,25 +101,29 @@ struct RGWCacheNotifyInfo {
   ObjectCacheInfo obj_info;
   off_t ofs;
   string ns;
+  std::vector<RGWCacheNotifyInfo> batch;
 
   RGWCacheNotifyInfo() : op(0), ofs(0) {}
 
   void encode(bufferlist& obl) const {
-    ENCODE_START(2, 2, obl);
+    ENCODE_START(3, 2, obl);
     encode(op, obl);
     encode(obj, obl);
     encode(obj_info, obl);
     encode(ofs, obl);
     encode(ns, obl);
+    encode(batch, obl);
     ENCODE_FINISH(obl);
   }
   void decode(bufferlist::const_iterator& ibl) {
-    DECODE_START_LEGACY_COMPAT_LEN(2, 2, 2, ibl);
+    DECODE_START_LEGACY_COMPAT_LEN(3, 2, 2, ibl);
     decode(op, ibl);
     decode(obj, ibl);
     decode(obj_info, ibl);
     decode(ofs, ibl);
     decode(ns, ibl);
+    if (struct_v >= 3)
+      decode(batch, ibl);
     DECODE_FINISH(ibl);
   }
   void dump(Formatter *f) const;
@@ -126,6 +131,24 @@ struct RGWCacheNotifyInfo {
 };
 WRITE_CLASS_ENCODER(RGWCacheNotifyInfo)
 
+// the cache updates queued for a control object, sent together as one
+// BATCH_OBJS notify
+struct RGWCacheNotifyBatch {
+  string key; // of any of the updates, they all map to the same control object
+  // the updates of each cache entry, in order
+  std::map<string, std::vector<RGWCacheNotifyInfo>> updates;
+
+  // whether applying 'update' leaves the cache entry the same, whatever
+  // updates of the entry were applied before
+  static bool replaces_entry(const RGWCacheNotifyInfo& update);
+
+  // queues an update of the entry 'name', returns the number of its queued
+  // updates dropped as 'info' replaces them
+  size_t add(const string& name, RGWCacheNotifyInfo&& info);
+  // the notify of all the queued updates
+  RGWCacheNotifyInfo make_notify();
+};
+
 class RGWChainedCache {
 public:
   virtual ~RGWChainedCache() {}
@@ -154,29 +177,48 @@ struct ObjectCacheEntry {
   ObjectCacheEntry() : lru_promotion_ts(0), gen(0) {}
 };
 
+// the entries are spread over lock-striped shards by name, each with its
+// own map and LRU, so that lookups of unrelated entries do not contend
 class ObjectCache {
-  std::unordered_map<string, ObjectCacheEntry> cache_map;
-  std::list<string> lru;
-  unsigned long lru_size;
-  unsigned long lru_counter;
+  struct Shard {
+    std::unordered_map<string, ObjectCacheEntry> cache_map;
+    std::list<string> lru;
+    unsigned long lru_size = 0;
+    unsigned long lru_counter = 0;
+    ceph::shared_mutex lock = ceph::make_shared_mutex("ObjectCache::Shard");
+  };
+  std::vector<Shard> shards;
   unsigned long lru_window;
-  ceph::shared_mutex lock = ceph::make_shared_mutex("ObjectCache");
   CephContext *cct;
 
+  ceph::mutex chained_lock = ceph::make_mutex("ObjectCache::chained_lock");
   vector<RGWChainedCache *> chained_cache;
 
+  // only changed with all shards locked
   bool enabled;
   ceph::timespan expiry;
+  ceph::timespan negative_expiry;
 
-  void touch_lru(const DoutPrefixProvider *dpp, const string& name, ObjectCacheEntry& entry,
-		 std::list<string>::iterator& lru_iter);
-  void remove_lru(const string& name, std::list<string>::iterator& lru_iter);
+  size_t shard_index(const string& name) const;
+  Shard& shard_of(const string& name) {
+    return shards[shard_index(name)];
+  }
+  bool is_expired(const ObjectCacheInfo& info,
+		  ceph::coarse_mono_time now) const {
+    const auto& ttl = info.status < 0 ? negative_expiry : expiry;
+    return ttl.count() && (now - info.time_added) > ttl;
+  }
+
+  void touch_lru(const DoutPrefixProvider *dpp, Shard& shard, const string& name,
+		 ObjectCacheEntry& entry, std::list<string>::iterator& lru_iter);
+  void remove_lru(Shard& shard, const string& name,
+		  std::list<string>::iterator& lru_iter);
   void invalidate_lru(ObjectCacheEntry& entry);
 
   void do_invalidate_all();
 
 public:
-  ObjectCache() : lru_size(0), lru_counter(0), lru_window(0), cct(NULL), enabled(false) { }
+  ObjectCache() : lru_window(0), cct(NULL), enabled(false) { }
   ~ObjectCache();
   int get(const DoutPrefixProvider *dpp, const std::string& name, ObjectCacheInfo& bl, uint32_t mask, rgw_cache_entry_info *cache_info);
   std::optional<ObjectCacheInfo> get(const DoutPrefixProvider *dpp, const std::string& name) {
@@ -187,11 +229,14 @@ public:
 
   template<typename F>
   void for_each(const F& f) {
-    std::shared_lock l{lock};
-    if (enabled) {
+    for (auto& shard : shards) {
+      std::shared_lock l{shard.lock};
+      if (!enabled) {
+        return;
+      }
       auto now  = ceph::coarse_mono_clock::now();
-      for (const auto& [name, entry] : cache_map) {
-        if (expiry.count() && (now - entry.info.time_added) < expiry) {
+      for (const auto& [name, entry] : shard.cache_map) {
+        if (!is_expired(entry.info, now)) {
           f(name, entry);
         }
       }
@@ -200,12 +245,7 @@ public:
 
   void put(const DoutPrefixProvider *dpp, const std::string& name, ObjectCacheInfo& bl, rgw_cache_entry_info *cache_info);
   bool remove(const DoutPrefixProvider *dpp, const std::string& name);
-  void set_ctx(CephContext *_cct) {
-    cct = _cct;
-    lru_window = cct->_conf->rgw_cache_lru_size / 2;
-    expiry = std::chrono::seconds(cct->_conf.get_val<uint64_t>(
-						"rgw_cache_expiry_interval"));
-  }
+  void set_ctx(CephContext *_cct);
   bool chain_cache_entry(const DoutPrefixProvider *dpp,
                          std::initializer_list<rgw_cache_entry_info*> cache_info_entries,
 			 RGWChainedCache::Entry *chained_entry);
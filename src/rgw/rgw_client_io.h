@@ -146,6 +146,19 @@ public:
    * of response's body. On failure throws rgw::io::Exception. */
   virtual size_t send_body(const char* buf, size_t len) = 0;
 
+  /* Generate a part of response's body from all the buffers of @bl without
+   * copying them into a contiguous memory area first. The default way hands
+   * them to send_body() one by one, front-ends able to write a scatter-gather
+   * list at once should override it. On success returns number of generated
+   * bytes of response's body. On failure throws rgw::io::Exception. */
+  virtual size_t send_body_bl(const ceph::bufferlist& bl) {
+    size_t sent = 0;
+    for (const auto& ptr : bl.buffers()) {
+      sent += send_body(ptr.c_str(), ptr.length());
+    }
+    return sent;
+  }
+
   /* Flushes all already generated data to a direct client of RadosGW.
    * On failure throws rgw::io::Exception containing errno. */
   virtual void flush() = 0;
@@ -240,6 +253,10 @@ public:
     return get_decoratee().send_body(buf, len);
   }
 
+  size_t send_body_bl(const ceph::bufferlist& bl) override {
+    return get_decoratee().send_body_bl(bl);
+  }
+
   void flush() override {
     return get_decoratee().flush();
   }
@@ -39,44 +39,77 @@ int rgw_compression_info_from_attrset(const map<string, bufferlist>& attrs,
 
 //------------RGWPutObj_Compress---------------
 
-int RGWPutObj_Compress::process(bufferlist&& in, uint64_t logical_offset)
+int RGWPutObj_Compress::handle_compressed(int cr, bufferlist&& in,
+                                          bufferlist&& out,
+                                          uint64_t logical_offset,
+                                          boost::optional<int32_t> message)
 {
-  bufferlist out;
-  if (in.length() > 0) {
-    // compression stuff
-    if ((logical_offset > 0 && compressed) || // if previous part was compressed
-        (logical_offset == 0)) {              // or it's the first part
-      ldout(cct, 10) << "Compression for rgw is enabled, compress part " << in.length() << dendl;
-      int cr = compressor->compress(in, out, compressor_message);
-      if (cr < 0) {
-        if (logical_offset > 0) {
-          lderr(cct) << "Compression failed with exit code " << cr
-              << " for next part, compression process failed" << dendl;
-          return -EIO;
-        }
-        compressed = false;
-        ldout(cct, 5) << "Compression failed with exit code " << cr
-            << " for first part, storing uncompressed" << dendl;
-        out = std::move(in);
-      } else {
-        compressed = true;
-    
-        compression_block newbl;
-        size_t bs = blocks.size();
-        newbl.old_ofs = logical_offset;
-        newbl.new_ofs = bs > 0 ? blocks[bs-1].len + blocks[bs-1].new_ofs : 0;
-        newbl.len = out.length();
-        blocks.push_back(newbl);
+  // parts are compressed ahead of knowing whether the previous part was, so
+  // the decision to keep the result is made here, in order
+  if ((logical_offset > 0 && compressed) || // if previous part was compressed
+      (logical_offset == 0)) {              // or it's the first part
+    if (cr < 0) {
+      if (logical_offset > 0) {
+        lderr(cct) << "Compression failed with exit code " << cr
+            << " for next part, compression process failed" << dendl;
+        return -EIO;
       }
-    } else {
       compressed = false;
+      ldout(cct, 5) << "Compression failed with exit code " << cr
+          << " for first part, storing uncompressed" << dendl;
       out = std::move(in);
+    } else {
+      compressed = true;
+      compressor_message = message;
+
+      compression_block newbl;
+      size_t bs = blocks.size();
+      newbl.old_ofs = logical_offset;
+      newbl.new_ofs = bs > 0 ? blocks[bs-1].len + blocks[bs-1].new_ofs : 0;
+      newbl.len = out.length();
+      blocks.push_back(newbl);
     }
-    // end of compression stuff
+  } else {
+    compressed = false;
+    out = std::move(in);
   }
   return Pipe::process(std::move(out), logical_offset);
 }
 
+int RGWPutObj_Compress::process(bufferlist&& in, uint64_t logical_offset)
+{
+  if (in.length() == 0) {
+    // complete the parts in flight before flushing
+    int r = stage.drain();
+    if (r < 0) {
+      return r;
+    }
+    return Pipe::process({}, logical_offset);
+  }
+  if (logical_offset > 0 && !compressed) {
+    // once a part is stored uncompressed, all of the following are too
+    int r = stage.drain();
+    if (r < 0) {
+      return r;
+    }
+    if (!compressed) {
+      return Pipe::process(std::move(in), logical_offset);
+    }
+  }
+  // compression stuff
+  ldout(cct, 10) << "Compression for rgw is enabled, compress part " << in.length() << dendl;
+  auto message = std::make_shared<boost::optional<int32_t>>();
+  return stage.submit(std::move(in), logical_offset,
+      [compressor = compressor, message] (bufferlist& in, bufferlist& out) {
+        return compressor->compress(in, out, *message);
+      },
+      [this, message] (int cr, bufferlist&& in, bufferlist&& out,
+                       uint64_t logical_offset) {
+        return handle_compressed(cr, std::move(in), std::move(out),
+                                 logical_offset, *message);
+      });
+}
+
 //----------------RGWGetObj_Decompress---------------------
 RGWGetObj_Decompress::RGWGetObj_Decompress(CephContext* cct_, 
                                            RGWCompressionInfo* cs_info_, 
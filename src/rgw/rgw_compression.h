@@ -8,6 +8,7 @@
 
 #include "compressor/Compressor.h"
 #include "rgw_putobj.h"
+#include "rgw_putobj_pipeline.h"
 #include "rgw_op.h"
 #include "rgw_compression_types.h"
 
@@ -47,10 +48,19 @@ class RGWPutObj_Compress : public rgw::putobj::Pipe
   CompressorRef compressor;
   boost::optional<int32_t> compressor_message;
   std::vector<compression_block> blocks;
+  // compresses successive parts concurrently when given an offload pool
+  rgw::putobj::ParallelStage stage;
+
+  int handle_compressed(int cr, bufferlist&& in, bufferlist&& out,
+                        uint64_t logical_offset,
+                        boost::optional<int32_t> message);
 public:
   RGWPutObj_Compress(CephContext* cct_, CompressorRef compressor,
-                     rgw::putobj::DataProcessor *next)
-    : Pipe(next), cct(cct_), compressor(compressor) {}
+                     rgw::putobj::DataProcessor *next,
+                     boost::asio::thread_pool* pool = nullptr,
+                     size_t window = 1,
+                     optional_yield y = null_yield)
+    : Pipe(next), cct(cct_), compressor(compressor), stage(pool, window, y) {}
 
   int process(bufferlist&& data, uint64_t logical_offset) override;
 
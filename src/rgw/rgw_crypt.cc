@@ -792,11 +792,15 @@ int RGWGetObj_BlockDecrypt::flush() {
 
 RGWPutObj_BlockEncrypt::RGWPutObj_BlockEncrypt(CephContext* cct,
                                                rgw::putobj::DataProcessor *next,
-                                               std::unique_ptr<BlockCrypt> crypt)
+                                               std::unique_ptr<BlockCrypt> crypt,
+                                               boost::asio::thread_pool* pool,
+                                               size_t window,
+                                               optional_yield y)
   : Pipe(next),
     cct(cct),
     crypt(std::move(crypt)),
-    block_size(this->crypt->get_block_size())
+    block_size(this->crypt->get_block_size()),
+    stage(pool, window, y)
 {
 }
 
@@ -816,18 +820,32 @@ int RGWPutObj_BlockEncrypt::process(bufferlist&& data, uint64_t logical_offset)
     proc_size = cache.length();
   }
   if (proc_size > 0) {
-    bufferlist in, out;
+    bufferlist in;
     cache.splice(0, proc_size, &in);
-    if (!crypt->encrypt(in, 0, proc_size, out, logical_offset)) {
-      return -ERR_INTERNAL_ERROR;
-    }
-    int r = Pipe::process(std::move(out), logical_offset);
+    /* crypt is stateless, so parts may be encrypted concurrently; they are
+       passed on in order */
+    int r = stage.submit(std::move(in), logical_offset,
+        [this, logical_offset] (bufferlist& in, bufferlist& out) {
+          if (!crypt->encrypt(in, 0, in.length(), out, logical_offset)) {
+            return -ERR_INTERNAL_ERROR;
+          }
+          return 0;
+        },
+        [this] (int r, bufferlist&&, bufferlist&& out, uint64_t ofs) {
+          if (r < 0) {
+            return r;
+          }
+          return Pipe::process(std::move(out), ofs);
+        });
     logical_offset += proc_size;
     if (r < 0)
       return r;
   }
 
   if (flush) {
+    int r = stage.drain();
+    if (r < 0)
+      return r;
     /*replicate 0-sized handle_data*/
     return Pipe::process({}, logical_offset);
   }
@@ -14,6 +14,7 @@
 #include <rgw/rgw_rest.h>
 #include <rgw/rgw_rest_s3.h>
 #include "rgw_putobj.h"
+#include "rgw_putobj_pipeline.h"
 
 /**
  * \brief Interface for block encryption methods
@@ -126,10 +127,15 @@ class RGWPutObj_BlockEncrypt : public rgw::putobj::Pipe
                                           for operations when enough data is accumulated */
   bufferlist cache; /**< stores extra data that could not (yet) be processed by BlockCrypt */
   const size_t block_size; /**< snapshot of \ref BlockCrypt.get_block_size() */
+  rgw::putobj::ParallelStage stage; /**< encrypts successive parts concurrently
+                                         when given an offload pool */
 public:
   RGWPutObj_BlockEncrypt(CephContext* cct,
                          rgw::putobj::DataProcessor *next,
-                         std::unique_ptr<BlockCrypt> crypt);
+                         std::unique_ptr<BlockCrypt> crypt,
+                         boost::asio::thread_pool* pool = nullptr,
+                         size_t window = 1,
+                         optional_yield y = null_yield);
 
   int process(bufferlist&& data, uint64_t logical_offset) override;
 }; /* RGWPutObj_BlockEncrypt */
@@ -229,6 +229,16 @@ void ObjectCacheInfo::generate_test_instances(list<ObjectCacheInfo*>& o)
 void RGWCacheNotifyInfo::generate_test_instances(list<RGWCacheNotifyInfo*>& o)
 {
   o.push_back(new RGWCacheNotifyInfo);
+  RGWCacheNotifyInfo *i = new RGWCacheNotifyInfo;
+  i->op = BATCH_OBJS;
+  i->batch.resize(2);
+  i->batch[0].op = UPDATE_OBJ;
+  i->batch[0].obj = rgw_raw_obj(rgw_pool("pool"), "oid1");
+  i->batch[0].obj_info.flags = CACHE_FLAG_DATA;
+  i->batch[0].obj_info.data.append("data");
+  i->batch[1].op = REMOVE_OBJ;
+  i->batch[1].obj = rgw_raw_obj(rgw_pool("pool"), "oid2");
+  o.push_back(i);
 }
 
 void RGWAccessKey::generate_test_instances(list<RGWAccessKey*>& o)
@@ -41,8 +41,7 @@ void RGWGC::initialize(CephContext *_cct, RGWRados *_store) {
     snprintf(buf, 32, ".%d", i);
     obj_names[i].append(buf);
 
-    auto it = transitioned_objects_cache.begin() + i;
-    transitioned_objects_cache.insert(it, false);
+    transitioned_objects_cache.emplace_back(false);
 
     //version = 0 -> not ready for transition
     //version = 1 -> marked ready for transition
@@ -299,6 +298,7 @@ class RGWGCIOManager {
     string oid;
     int index{-1};
     string tag;
+    ceph::mono_time start;
   };
 
   deque<IO> ios;
@@ -308,14 +308,18 @@ class RGWGCIOManager {
    */
   vector<map<string, size_t> > tag_io_size;
 
-#define MAX_AIO_DEFAULT 10
-  size_t max_aio{MAX_AIO_DEFAULT};
+  RGWGCAioWindow window;
+
+  /* the time of the oldest entry seen, for the gc_backlog_age counter */
+  ceph::real_time oldest_entry = ceph::real_time::max();
 
 public:
   RGWGCIOManager(const DoutPrefixProvider* _dpp, CephContext *_cct, RGWGC *_gc) : dpp(_dpp),
                                                                                   cct(_cct),
-                                                                                  gc(_gc) {
-    max_aio = cct->_conf->rgw_gc_max_concurrent_io;
+                                                                                  gc(_gc),
+    window(std::max<int64_t>(cct->_conf->rgw_gc_max_concurrent_io, 1),
+           std::chrono::milliseconds(
+             cct->_conf.get_val<uint64_t>("rgw_gc_aio_latency_target_ms"))) {
     remove_tags.resize(min(static_cast<int>(cct->_conf->rgw_gc_max_objs), rgw_shards_max()));
     tag_io_size.resize(min(static_cast<int>(cct->_conf->rgw_gc_max_objs), rgw_shards_max()));
   }
@@ -328,7 +332,7 @@ public:
 
   int schedule_io(IoCtx *ioctx, const string& oid, ObjectWriteOperation *op,
 		  int index, const string& tag) {
-    while (ios.size() > max_aio) {
+    while (ios.size() > window.get()) {
       if (gc->going_down()) {
         return 0;
       }
@@ -344,11 +348,28 @@ public:
     if (ret < 0) {
       return ret;
     }
-    ios.push_back(IO{IO::TailIO, c, oid, index, tag});
+    ios.push_back(IO{IO::TailIO, c, oid, index, tag, ceph::mono_clock::now()});
 
     return 0;
   }
 
+  /* the completions are reaped in order, so the latency of an io includes
+   * the time it waited behind the older ones */
+  void adapt_window(int ret, ceph::timespan latency) {
+    if (window.complete(ret, latency)) {
+      ldpp_dout(dpp, 10) << "RGWGC: osds push back, aio window shrunk to "
+                         << window.get() << dendl;
+    }
+  }
+
+  void note_entry_time(const ceph::real_time& t) {
+    oldest_entry = std::min(oldest_entry, t);
+  }
+
+  const ceph::real_time& get_oldest_entry() const {
+    return oldest_entry;
+  }
+
   int handle_next_completion() {
     ceph_assert(!ios.empty());
     IO& io = ios.front();
@@ -356,9 +377,16 @@ public:
     int ret = io.c->get_return_value();
     io.c->release();
 
+    if (io.type == IO::TailIO) {
+      adapt_window(ret, ceph::mono_clock::now() - io.start);
+    }
+
     if (ret == -ENOENT) {
       ret = 0;
     }
+    if (io.type == IO::TailIO && ret == 0 && perfcounter) {
+      perfcounter->inc(l_rgw_gc_tail_remove);
+    }
 
     if (io.type == IO::IndexIO && ! gc->transitioned_objects_cache[io.index]) {
       if (ret < 0) {
@@ -526,7 +554,36 @@ int RGWGC::process(int index, int max_secs, bool expired_only,
   string marker;
   string next_marker;
   bool truncated;
-  IoCtx *ctx = new IoCtx;
+  /* the ioctxs of the pools of the tail objects */
+  std::map<string, IoCtx> ioctxs;
+  /* entries of the queue which were processed, and are removed from its
+   * head in batches of rgw_gc_queue_trim_batch */
+  uint64_t pending_trim = 0;
+  const uint64_t trim_batch =
+    std::max<uint64_t>(cct->_conf.get_val<uint64_t>("rgw_gc_queue_trim_batch"), 1);
+
+  auto trim_pending = [&] {
+    if (pending_trim == 0) {
+      return 0;
+    }
+    int r = io_manager.drain_ios();
+    if (r < 0) {
+      /* the removal of some tail objects failed, they will be retried with
+       * their entries */
+      pending_trim = 0;
+      return r;
+    }
+    ldpp_dout(this, 5) << "RGWGC::process removing " << pending_trim <<
+      " entries, marker: " << marker << dendl;
+    r = io_manager.remove_queue_entries(index, pending_trim);
+    pending_trim = 0;
+    if (r < 0) {
+      ldpp_dout(this, 0) <<
+        "WARNING: failed to remove queue entries" << dendl;
+    }
+    return r;
+  };
+
   do {
     int max = 100;
     std::list<cls_rgw_gc_obj_info> entries;
@@ -576,97 +633,119 @@ int RGWGC::process(int index, int max_secs, bool expired_only,
 
     marker = next_marker;
 
-    string last_pool;
-    std::list<cls_rgw_gc_obj_info>::iterator iter;
-    for (iter = entries.begin(); iter != entries.end(); ++iter) {
-      cls_rgw_gc_obj_info& info = *iter;
-
-      ldpp_dout(this, 20) << "RGWGC::process iterating over entry tag='" <<
-	info.tag << "', time=" << info.time << ", chain.objs.size()=" <<
-	info.chain.objs.size() << dendl;
-
-      std::list<cls_rgw_obj>::iterator liter;
-      cls_rgw_obj_chain& chain = info.chain;
-
-      utime_t now = ceph_clock_now();
-      if (now >= end) {
-        goto done;
-      }
-      if (! transitioned_objects_cache[index]) {
-        if (chain.objs.empty()) {
-          io_manager.schedule_tag_removal(index, info.tag);
-        } else {
-          io_manager.add_tag_io_size(index, info.tag, chain.objs.size());
-        }
-      }
-      if (! chain.objs.empty()) {
-	for (liter = chain.objs.begin(); liter != chain.objs.end(); ++liter) {
-	  cls_rgw_obj& obj = *liter;
-
-	  if (obj.pool != last_pool) {
-	    delete ctx;
-	    ctx = new IoCtx;
-	    ret = rgw_init_ioctx(this, store->get_rados_handle(), obj.pool, *ctx);
+    {
+      /* the tail objects of the listed entries, removed in the order of their
+       * pool and placement group so that consecutive removals go to the same
+       * osds */
+      struct TailObj {
+	IoCtx* ctx;
+	uint32_t pg;
+	const cls_rgw_obj* obj;
+	const string* tag;
+      };
+      std::vector<TailObj> tails;
+
+      std::list<cls_rgw_gc_obj_info>::iterator iter;
+      for (iter = entries.begin(); iter != entries.end(); ++iter) {
+	cls_rgw_gc_obj_info& info = *iter;
+
+	ldpp_dout(this, 20) << "RGWGC::process iterating over entry tag='" <<
+	  info.tag << "', time=" << info.time << ", chain.objs.size()=" <<
+	  info.chain.objs.size() << dendl;
+
+	io_manager.note_entry_time(info.time);
+
+	cls_rgw_obj_chain& chain = info.chain;
+
+	if (! transitioned_objects_cache[index]) {
+	  if (chain.objs.empty()) {
+	    io_manager.schedule_tag_removal(index, info.tag);
+	  } else {
+	    io_manager.add_tag_io_size(index, info.tag, chain.objs.size());
+	  }
+	}
+	for (const auto& obj : chain.objs) {
+	  auto ctx = ioctxs.find(obj.pool);
+	  if (ctx == ioctxs.end()) {
+	    IoCtx ioctx;
+	    ret = rgw_init_ioctx(this, store->get_rados_handle(), obj.pool, ioctx);
 	    if (ret < 0) {
-        if (transitioned_objects_cache[index]) {
-          goto done;
-        }
-	      last_pool = "";
 	      ldpp_dout(this, 0) << "ERROR: failed to create ioctx pool=" <<
 		obj.pool << dendl;
+	      if (transitioned_objects_cache[index]) {
+		goto done;
+	      }
 	      continue;
 	    }
-	    last_pool = obj.pool;
+	    ctx = ioctxs.emplace(obj.pool, std::move(ioctx)).first;
 	  }
+	  uint32_t pg = 0;
+	  ctx->second.get_object_pg_hash_position2(
+	    obj.loc.empty() ? obj.key.name : obj.loc, &pg);
+	  tails.push_back(TailObj{&ctx->second, pg, &obj, &info.tag});
+	}
+      } // entries loop
+
+      std::sort(tails.begin(), tails.end(),
+		[](const TailObj& a, const TailObj& b) {
+		  return std::tie(a.obj->pool, a.pg) < std::tie(b.obj->pool, b.pg);
+		});
 
-	  ctx->locator_set_key(obj.loc);
+      for (auto& tail : tails) {
+	utime_t now = ceph_clock_now();
+	if (now >= end) {
+	  goto done;
+	}
 
-	  const string& oid = obj.key.name; /* just stored raw oid there */
+	const cls_rgw_obj& obj = *tail.obj;
+	tail.ctx->locator_set_key(obj.loc);
 
-	  ldpp_dout(this, 5) << "RGWGC::process removing " << obj.pool <<
-	    ":" << obj.key.name << dendl;
-	  ObjectWriteOperation op;
-	  cls_refcount_put(op, info.tag, true);
+	const string& oid = obj.key.name; /* just stored raw oid there */
 
-	  ret = io_manager.schedule_io(ctx, oid, &op, index, info.tag);
-	  if (ret < 0) {
-	    ldpp_dout(this, 0) <<
-	      "WARNING: failed to schedule deletion for oid=" << oid << dendl;
-      if (transitioned_objects_cache[index]) {
-        //If deleting oid failed for any of them, we will not delete queue entries
-        goto done;
-      }
-	  }
-	  if (going_down()) {
-	    // leave early, even if tag isn't removed, it's ok since it
-	    // will be picked up next time around
+	ldpp_dout(this, 5) << "RGWGC::process removing " << obj.pool <<
+	  ":" << obj.key.name << dendl;
+	ObjectWriteOperation op;
+	cls_refcount_put(op, *tail.tag, true);
+
+	ret = io_manager.schedule_io(tail.ctx, oid, &op, index, *tail.tag);
+	if (ret < 0) {
+	  ldpp_dout(this, 0) <<
+	    "WARNING: failed to schedule deletion for oid=" << oid << dendl;
+	  if (transitioned_objects_cache[index]) {
+	    //If deleting oid failed for any of them, we will not delete queue entries
+	    pending_trim = 0;
 	    goto done;
 	  }
-	} // chains loop
-      } // else -- chains not empty
-    } // entries loop
+	}
+	if (going_down()) {
+	  // leave early, even if tag isn't removed, it's ok since it
+	  // will be picked up next time around
+	  goto done;
+	}
+      } // tails loop
+    }
     if (transitioned_objects_cache[index] && entries.size() > 0) {
-      ret = io_manager.drain_ios();
-      if (ret < 0) {
-        goto done;
-      }
-      //Remove the entries from the queue
-      ldpp_dout(this, 5) << "RGWGC::process removing entries, marker: " << marker << dendl;
-      ret = io_manager.remove_queue_entries(index, entries.size());
-      if (ret < 0) {
-        ldpp_dout(this, 0) <<
-          "WARNING: failed to remove queue entries" << dendl;
-        goto done;
+      /* the entries are removed from the queue once the removal of their
+       * tail objects completes. deferring it keeps the removals of the
+       * following entries in flight meanwhile */
+      pending_trim += entries.size();
+      if (pending_trim >= trim_batch) {
+        ret = trim_pending();
+        if (ret < 0) {
+          goto done;
+        }
       }
     }
   } while (truncated);
 
 done:
+  if (!going_down()) {
+    trim_pending();
+  }
   /* we don't drain here, because if we're going down we don't want to
    * hold the system if backend is unresponsive
    */
   l.unlock(&store->gc_pool_ctx, obj_names[index]);
-  delete ctx;
 
   return 0;
 }
@@ -676,20 +755,79 @@ int RGWGC::process(bool expired_only)
   int max_secs = cct->_conf->rgw_gc_processor_max_time;
 
   const int start = ceph::util::generate_random_number(0, max_objs - 1);
+  const auto cycle_start = ceph::mono_clock::now();
+
+  /* the shards are taken in turn by up to rgw_gc_max_concurrent_shards
+   * threads, each with its own window of ios */
+  const int num_threads = std::clamp<int>(
+    cct->_conf.get_val<uint64_t>("rgw_gc_max_concurrent_shards"), 1, max_objs);
+  std::atomic<int> next_shard{0};
+  std::atomic<int> error{0};
+  ceph::mutex oldest_lock = ceph::make_mutex("RGWGC::process");
+  ceph::real_time oldest_entry = ceph::real_time::max();
+
+  auto process_shards = [&] {
+    RGWGCIOManager io_manager(this, store->ctx(), this);
+
+    for (int i = next_shard++; i < max_objs && error == 0; i = next_shard++) {
+      int index = (i + start) % max_objs;
+      int ret = process(index, max_secs, expired_only, io_manager);
+      if (ret < 0) {
+        int expected = 0;
+        error.compare_exchange_strong(expected, ret);
+        break;
+      }
+    }
+    if (error == 0 && !going_down()) {
+      io_manager.drain();
+    }
 
-  RGWGCIOManager io_manager(this, store->ctx(), this);
+    std::lock_guard l{oldest_lock};
+    oldest_entry = std::min(oldest_entry, io_manager.get_oldest_entry());
+  };
 
-  for (int i = 0; i < max_objs; i++) {
-    int index = (i + start) % max_objs;
-    int ret = process(index, max_secs, expired_only, io_manager);
-    if (ret < 0)
-      return ret;
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; i++) {
+    threads.push_back(make_named_thread("gc_shard", process_shards));
   }
-  if (!going_down()) {
-    io_manager.drain();
+  process_shards();
+  for (auto& t : threads) {
+    t.join();
   }
 
-  return 0;
+  if (perfcounter) {
+    /* how long the oldest expired entry waited for this cycle */
+    const auto now = ceph::real_clock::now();
+    uint64_t age = 0;
+    if (oldest_entry < now) {
+      age = std::chrono::duration_cast<std::chrono::seconds>(now - oldest_entry).count();
+    }
+    perfcounter->set(l_rgw_gc_backlog_age, age);
+    perfcounter->tinc(l_rgw_gc_cycle_lat, ceph::mono_clock::now() - cycle_start);
+  }
+
+  return error;
+}
+
+bool RGWGCAioWindow::complete(int ret, ceph::timespan latency)
+{
+  /* a pushback anywhere in the window counts for the whole window, the ios
+   * in flight saw the same congestion */
+  pushback |= (ret == -EBUSY || ret == -EAGAIN || ret == -ETIMEDOUT ||
+               (latency_target != ceph::timespan::zero() &&
+                latency > latency_target));
+  if (++completions < size) {
+    return false;
+  }
+  const bool shrink = pushback;
+  if (shrink) {
+    size = std::max<size_t>(size / 2, 1);
+  } else if (size < limit) {
+    ++size;
+  }
+  completions = 0;
+  pushback = false;
+  return shrink;
 }
 
 bool RGWGC::going_down()
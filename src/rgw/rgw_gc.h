@@ -16,9 +16,33 @@
 #include "cls/rgw/cls_rgw_types.h"
 
 #include <atomic>
+#include <deque>
 
 class RGWGCIOManager;
 
+/* sizes the window of tail deletions to what the cluster keeps up with.
+ * the window halves after a window of completions in which the osds pushed
+ * back, by failing with EBUSY, EAGAIN or ETIMEDOUT or by taking longer than
+ * the latency target, and grows by one after a window without pushback */
+class RGWGCAioWindow {
+  size_t size;
+  const size_t limit;
+  const ceph::timespan latency_target;
+  /* since the start of the current window */
+  size_t completions{0};
+  bool pushback{false};
+
+public:
+  RGWGCAioWindow(size_t limit, ceph::timespan latency_target)
+    : size(std::max<size_t>(limit, 1)), limit(size),
+      latency_target(latency_target) {}
+
+  size_t get() const { return size; }
+
+  /* returns whether the window shrank */
+  bool complete(int ret, ceph::timespan latency);
+};
+
 class RGWGC : public DoutPrefixProvider {
   CephContext *cct;
   RGWRados *store;
@@ -50,7 +74,9 @@ public:
     stop_processor();
     finalize();
   }
-  vector<bool> transitioned_objects_cache;
+  /* n.b., std::deque so that the shards processed concurrently, and the
+   * defer callbacks, don't share the words of a vector<bool> */
+  std::deque<std::atomic<bool>> transitioned_objects_cache;
   int send_chain(cls_rgw_obj_chain& chain, const string& tag);
 
   // asynchronously defer garbage collection on an object that's still being read
@@ -281,6 +281,7 @@ void RGWCacheNotifyInfo::dump(Formatter *f) const
   encode_json("obj_info", obj_info, f);
   encode_json("ofs", ofs, f);
   encode_json("ns", ns, f);
+  encode_json("batch", batch, f);
 }
 
 void RGWAccessKey::dump(Formatter *f) const
@@ -438,6 +438,15 @@ public:
     list_params.prefix = prefix;
   }
 
+  /* lists a single shard of the bucket index */
+  void set_shard(int shard_id) {
+    list_params.shard_id = shard_id;
+  }
+
+  void set_marker(const rgw_obj_key& marker) {
+    list_params.marker = marker;
+  }
+
   int init(const DoutPrefixProvider *dpp) {
     return fetch(dpp);
   }
@@ -503,6 +512,32 @@ public:
 
 }; /* LCObjsLister */
 
+/* counts the work items queued by a lister which are not processed yet */
+class LCPendingItems {
+  std::mutex mtx;
+  std::condition_variable cv;
+  uint64_t count = 0;
+
+public:
+  void add() {
+    std::lock_guard l(mtx);
+    ++count;
+  }
+  void done() {
+    std::lock_guard l(mtx);
+    if (--count == 0) {
+      cv.notify_all();
+    }
+  }
+  /* waits for the items to be processed, unless lc goes down */
+  void wait(RGWLC* lc) {
+    std::unique_lock l(mtx);
+    while (count > 0 && !lc->going_down()) {
+      cv.wait_for(l, 200ms);
+    }
+  }
+}; /* LCPendingItems */
+
 struct op_env {
 
   using LCWorker = RGWLC::LCWorker;
@@ -511,7 +546,8 @@ struct op_env {
   rgw::sal::Store* store;
   LCWorker* worker;
   rgw::sal::Bucket* bucket;
-  LCObjsLister& ol;
+  LCObjsLister& ol; // only used by the listing thread
+  std::shared_ptr<LCPendingItems> pending; // of the lister, if it waits
 
   op_env(lc_op& _op, rgw::sal::Store* _store, LCWorker* _worker,
 	 rgw::sal::Bucket* _bucket, LCObjsLister& _ol)
@@ -532,7 +568,6 @@ struct lc_op_ctx {
   rgw::sal::Store* store;
   rgw::sal::Bucket* bucket;
   lc_op& op; // ok--refers to expanded env.op
-  LCObjsLister& ol;
 
   std::unique_ptr<rgw::sal::Object> obj;
   RGWObjectCtx rctx;
@@ -545,7 +580,7 @@ struct lc_op_ctx {
 	    const DoutPrefixProvider *dpp, WorkQ* wq)
     : cct(env.store->ctx()), env(env), o(o), next_key_name(next_key_name),
       effective_mtime(effective_mtime),
-      store(env.store), bucket(env.bucket), op(env.op), ol(env.ol),
+      store(env.store), bucket(env.bucket), op(env.op),
       rctx(env.store), dpp(dpp), wq(wq)
     {
       obj = bucket->get_object(o.key);
@@ -654,6 +689,10 @@ public:
     return actions;
   }
 
+  op_env& get_env() {
+    return env;
+  }
+
   void build();
   void update();
   int process(rgw_bucket_dir_entry& o, const DoutPrefixProvider *dpp,
@@ -770,7 +809,10 @@ class RGWLC::WorkPool
 {
   using TVector = ceph::containers::tiny_vector<WorkQ, 3>;
   TVector wqs;
-  uint64_t ix;
+  std::atomic<uint64_t> ix;
+
+  std::mutex throttle_mtx;
+  ceph::mono_time next_action;
 
 public:
   WorkPool(RGWLC::LCWorker* wk, uint16_t n_threads, uint32_t qmax)
@@ -794,12 +836,30 @@ public:
     }
   }
 
+  /* n.b., called by the listers of a bucket concurrently */
   void enqueue(WorkItem item) {
-    const auto tix = ix;
-    ix = (ix+1) % wqs.size();
+    const auto tix = ix++ % wqs.size();
     (wqs[tix]).enqueue(std::move(item));
   }
 
+  /* spaces out the lifecycle actions of the worker to at most
+   * rgw_lc_max_ops_per_sec */
+  void throttle(CephContext* cct) {
+    const auto rate = cct->_conf.get_val<uint64_t>("rgw_lc_max_ops_per_sec");
+    if (rate == 0) {
+      return;
+    }
+    const auto interval = ceph::make_timespan(1.0 / rate);
+    ceph::mono_time at;
+    {
+      std::lock_guard l(throttle_mtx);
+      next_action = std::max(next_action, ceph::mono_clock::now());
+      at = next_action;
+      next_action += interval;
+    }
+    std::this_thread::sleep_until(at);
+  }
+
   void drain() {
     for (auto& wq : wqs) {
       wq.drain();
@@ -1412,6 +1472,7 @@ int LCOpRule::process(rgw_bucket_dir_entry& o,
       return 0;
     }
 
+    env.worker->get_workpool()->throttle(env.store->ctx());
     int r = (*selected)->process(ctx);
     if (r < 0) {
       ldpp_dout(dpp, 0) << "ERROR: remove_expired_obj " 
@@ -1420,6 +1481,7 @@ int LCOpRule::process(rgw_bucket_dir_entry& o,
 			<< " " << wq->thr_name() << dendl;
       return r;
     }
+    ++env.worker->actions_applied;
     ldpp_dout(dpp, 20) << "processed:" << env.bucket << ":"
 		       << o.key << " " << wq->thr_name() << dendl;
   }
@@ -1428,6 +1490,61 @@ int LCOpRule::process(rgw_bucket_dir_entry& o,
 
 }
 
+/* the part of the bucket index a lister goes through for a rule: one
+ * shard, or all of them with RGW_NO_SHARD. the shard count keeps the
+ * markers of a resharded bucket from being used */
+static string lc_part_name(int num_shards, int shard, const string& rule_id)
+{
+  return fmt::format("{}/{}/{}", num_shards, shard, rule_id);
+}
+
+/* queues the entries of a part of the bucket index to the worker pool,
+ * starting after 'marker', and waits for them to be processed, so that the
+ * next rule of the part sees their results. if the session ends first,
+ * returns -EAGAIN with 'marker' set to where the part resumes */
+static int lc_list_part(const DoutPrefixProvider *dpp, rgw::sal::Store* store,
+			RGWLC::LCWorker* worker, rgw::sal::Bucket* bucket,
+			lc_op& op, const string& prefix, int shard,
+			rgw_obj_key& marker, time_t stop_at, bool once)
+{
+  LCObjsLister ol(store, bucket);
+  ol.set_prefix(prefix);
+  ol.set_shard(shard);
+  ol.set_marker(marker);
+
+  int ret = ol.init(dpp);
+  if (ret < 0) {
+    if (ret == (-ENOENT))
+      return 0;
+    ldpp_dout(dpp, 0) << "ERROR: store->list_objects():" <<dendl;
+    return ret;
+  }
+
+  op_env oenv(op, store, worker, bucket, ol);
+  oenv.pending = std::make_shared<LCPendingItems>();
+  LCOpRule orule(oenv);
+  orule.build(); // why can't ctor do it?
+  LCResumeMarker resume(marker);
+  ret = 0;
+  rgw_bucket_dir_entry* o{nullptr};
+  for (; ol.get_obj(dpp, &o /* , fetch_barrier */); ol.next()) {
+    resume.next(o->key);
+    if (worker_should_stop(stop_at, once) ||
+	worker->get_lc()->going_down()) {
+      marker = resume.get();
+      ret = -EAGAIN;
+      break;
+    }
+    orule.update();
+    std::tuple<LCOpRule, rgw_bucket_dir_entry> t1 = {orule, *o};
+    oenv.pending->add();
+    worker->get_workpool()->enqueue(WorkItem{t1});
+    ++worker->objs_listed;
+  }
+  oenv.pending->wait(worker->get_lc());
+  return ret;
+}
+
 int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
 			     time_t stop_at, bool once)
 {
@@ -1497,6 +1614,9 @@ int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
 	<< wq->thr_name() 
 	<< dendl;
     }
+    if (auto& pending = op_rule.get_env().pending; pending) {
+      pending->done();
+    }
   };
   worker->workpool->setf(pf);
 
@@ -1505,53 +1625,125 @@ int RGWLC::bucket_lc_process(string& shard_id, LCWorker* worker,
 		      << prefix_map.size()
 		      << dendl;
 
-  rgw_obj_key pre_marker;
-  rgw_obj_key next_marker;
-  for(auto prefix_iter = prefix_map.begin(); prefix_iter != prefix_map.end();
-      ++prefix_iter) {
-
-    if (worker_should_stop(stop_at, once)) {
-      ldout(cct, 5) << __func__ << " interval budget EXPIRED worker "
-		     << worker->ix
-		     << dendl;
-      return 0;
+  /* the index shards of a large bucket are listed by several threads, each
+   * taking every n-th shard. all the versions of an object live in the same
+   * shard, in the order the rules expect */
+  const int num_shards =
+    bucket->get_info().layout.current_index.layout.normal.num_shards;
+  const uint64_t listers = (num_shards > 1)
+    ? std::min<uint64_t>(
+        cct->_conf.get_val<uint64_t>("rgw_lc_bucket_shard_parallelism"),
+        num_shards)
+    : 1;
+
+  /* the parts of the bucket which an earlier session processed, or where
+   * it stopped */
+  std::map<string, bufferlist> progress;
+  ret = sal_lc->get_progress(shard_id, progress);
+  if (ret < 0) {
+    ldpp_dout(this, 0) << "WARNING: failed to read lc progress of "
+		       << shard_id << ", starting over: "
+		       << cpp_strerror(ret) << dendl;
+    progress.clear();
+  }
+
+  ceph::mutex progress_lock = ceph::make_mutex("RGWLC::bucket_lc_process");
+  std::map<string, bufferlist> new_progress;
+  bool interrupted = false;
+  int error = 0;
+
+  auto list_parts = [&](int shard) {
+    for (auto prefix_iter = prefix_map.begin(); prefix_iter != prefix_map.end();
+	 ++prefix_iter) {
+      auto& op = prefix_iter->second;
+      if (!is_valid_op(op)) {
+	continue;
+      }
+      const string part = lc_part_name(num_shards, shard, op.id);
+      rgw_obj_key marker;
+      if (auto p = progress.find(part); p != progress.end()) {
+	if (p->second.length() == 0) {
+	  /* done by an earlier session */
+	  std::lock_guard l{progress_lock};
+	  new_progress[part];
+	  continue;
+	}
+	try {
+	  auto biter = p->second.cbegin();
+	  decode(marker, biter);
+	} catch (const buffer::error& e) {
+	  ldpp_dout(this, 0) << "WARNING: bad lc progress marker of " << shard_id
+			     << " part " << part << ", starting over" << dendl;
+	  marker = rgw_obj_key();
+	}
+      }
+      ldpp_dout(this, 20) << __func__ << "(): prefix=" << prefix_iter->first
+			  << " shard=" << shard << " marker=" << marker
+			  << dendl;
+
+      int r = lc_list_part(this, store, worker, bucket.get(), op,
+			   prefix_iter->first, shard, marker, stop_at, once);
+      std::lock_guard l{progress_lock};
+      if (r == -EAGAIN) {
+	encode(marker, new_progress[part]);
+	interrupted = true;
+	return;
+      }
+      if (r < 0) {
+	ldpp_dout(this, 0) << "ERROR: listing " << shard_id << " part " << part
+			   << " failed: " << cpp_strerror(r) << dendl;
+	if (error == 0) {
+	  error = r;
+	}
+	return;
+      }
+      new_progress[part];
     }
+  };
 
-    auto& op = prefix_iter->second;
-    if (!is_valid_op(op)) {
-      continue;
+  if (listers == 1) {
+    list_parts(RGW_NO_SHARD);
+  } else {
+    auto list_shards = [&](uint64_t first) {
+      for (int shard = first; shard < num_shards; shard += listers) {
+	list_parts(shard);
+	std::lock_guard l{progress_lock};
+	if (interrupted || error < 0) {
+	  break;
+	}
+      }
+    };
+    std::vector<std::thread> threads;
+    for (uint64_t i = 1; i < listers; ++i) {
+      threads.push_back(make_named_thread("lc_lister", list_shards, i));
     }
-    ldpp_dout(this, 20) << __func__ << "(): prefix=" << prefix_iter->first
-			<< dendl;
-    if (prefix_iter != prefix_map.begin() && 
-        (prefix_iter->first.compare(0, prev(prefix_iter)->first.length(),
-				    prev(prefix_iter)->first) == 0)) {
-      next_marker = pre_marker;
-    } else {
-      pre_marker = next_marker;
+    list_shards(0);
+    for (auto& t : threads) {
+      t.join();
     }
+  }
+  /* the markers are only good once everything before them is processed */
+  worker->get_workpool()->drain();
 
-    LCObjsLister ol(store, bucket.get());
-    ol.set_prefix(prefix_iter->first);
-
-    ret = ol.init(this);
+  if (interrupted || error < 0) {
+    ret = sal_lc->set_progress(shard_id, new_progress);
     if (ret < 0) {
-      if (ret == (-ENOENT))
-        return 0;
-      ldpp_dout(this, 0) << "ERROR: store->list_objects():" <<dendl;
-      return ret;
+      ldpp_dout(this, 0) << "ERROR: failed to save lc progress of "
+			 << shard_id << ": " << cpp_strerror(ret) << dendl;
     }
-
-    op_env oenv(op, store, worker, bucket.get(), ol);
-    LCOpRule orule(oenv);
-    orule.build(); // why can't ctor do it?
-    rgw_bucket_dir_entry* o{nullptr};
-    for (; ol.get_obj(this, &o /* , fetch_barrier */); ol.next()) {
-      orule.update();
-      std::tuple<LCOpRule, rgw_bucket_dir_entry> t1 = {orule, *o};
-      worker->workpool->enqueue(WorkItem{t1});
+    if (interrupted) {
+      ldout(cct, 5) << __func__ << " interval budget EXPIRED worker "
+		    << worker->ix << ", " << shard_id
+		    << " resumes in the next session" << dendl;
+    }
+    return error;
+  }
+  if (!progress.empty()) {
+    ret = sal_lc->rm_progress(shard_id);
+    if (ret < 0) {
+      ldpp_dout(this, 0) << "WARNING: failed to remove lc progress of "
+			 << shard_id << ": " << cpp_strerror(ret) << dendl;
     }
-    worker->workpool->drain();
   }
 
   ret = handle_multipart_expiration(bucket.get(), prefix_map, worker, stop_at, once);
@@ -1928,15 +2120,20 @@ void RGWLifecycleConfiguration::generate_test_instances(
   o.push_back(new RGWLifecycleConfiguration);
 }
 
-static inline void get_lc_oid(CephContext *cct,
-			      const string& shard_id, string *oid)
+static inline int get_lc_index(CephContext *cct, const string& shard_id)
 {
   int max_objs =
     (cct->_conf->rgw_lc_max_objs > HASH_PRIME ? HASH_PRIME :
      cct->_conf->rgw_lc_max_objs);
   /* n.b. review hash algo */
-  int index = ceph_str_hash_linux(shard_id.c_str(),
-				  shard_id.size()) % HASH_PRIME % max_objs;
+  return ceph_str_hash_linux(shard_id.c_str(),
+			     shard_id.size()) % HASH_PRIME % max_objs;
+}
+
+static inline void get_lc_oid(CephContext *cct,
+			      const string& shard_id, string *oid)
+{
+  int index = get_lc_index(cct, shard_id);
   *oid = lc_oid_prefix;
   char buf[32];
   snprintf(buf, 32, ".%d", index);
@@ -1948,6 +2145,63 @@ static std::string get_lc_shard_name(const rgw_bucket& bucket){
   return string_join_reserve(':', bucket.tenant, bucket.name, bucket.marker);
 }
 
+/* processes the rules of a single bucket right away, whatever its schedule */
+int RGWLC::process_bucket(rgw::sal::Bucket* bucket, LCWorker* worker)
+{
+  const string shard_id = get_lc_shard_name(bucket->get_key());
+  const int index = get_lc_index(cct, shard_id);
+  const int max_lock_secs = cct->_conf->rgw_lc_lock_max_time;
+
+  /* claim the entry of the bucket under the lock of its lc shard, as
+   * process() does, so that no worker processes it meanwhile */
+  std::unique_ptr<rgw::sal::LCSerializer> lock(
+    sal_lc->get_serializer(lc_index_lock_name, obj_names[index], cookie));
+  int ret;
+  do {
+    ret = lock->try_lock(this, utime_t(max_lock_secs, 0), null_yield);
+    if (ret == -EBUSY || ret == -EEXIST) {
+      /* already locked by another lc processor */
+      ldpp_dout(this, 0) << "RGWLC::process_bucket() failed to acquire lock on "
+          << obj_names[index] << ", sleep 5, try again" << dendl;
+      sleep(5);
+    }
+  } while (ret == -EBUSY || ret == -EEXIST);
+  if (ret < 0) {
+    return ret;
+  }
+
+  rgw::sal::Lifecycle::LCEntry entry;
+  ret = sal_lc->get_entry(obj_names[index], shard_id, entry);
+  if (ret < 0) {
+    lock->unlock();
+    ldpp_dout(this, 0) << "RGWLC::process_bucket() failed to get lc entry of "
+        << shard_id << ", ret=" << ret << dendl;
+    return ret;
+  }
+  if (entry.status == lc_processing &&
+      !expired_session(entry.start_time)) {
+    lock->unlock();
+    ldpp_dout(this, 0) << "RGWLC::process_bucket() " << shard_id
+        << " is being processed by another lc worker" << dendl;
+    return -EBUSY;
+  }
+  entry.status = lc_processing;
+  entry.start_time = ceph_clock_now();
+  ret = sal_lc->set_entry(obj_names[index], entry);
+  lock->unlock();
+  if (ret < 0) {
+    ldpp_dout(this, 0) << "RGWLC::process_bucket() failed to set lc entry of "
+        << shard_id << ", ret=" << ret << dendl;
+    return ret;
+  }
+
+  ret = bucket_lc_process(entry.bucket, worker, thread_stop_at(),
+			  true /* once */);
+  int result = ret;
+  bucket_lc_post(index, max_lock_secs, entry, result, worker);
+  return ret;
+}
+
 template<typename F>
 static int guard_lc_modify(const DoutPrefixProvider *dpp,
                            rgw::sal::Store* store,
@@ -2048,6 +2302,12 @@ int RGWLC::remove_bucket_config(rgw::sal::Bucket* bucket,
     return sal_lc->rm_entry(oid, entry);
   });
 
+  int r = sal_lc->rm_progress(get_lc_shard_name(b));
+  if (r < 0) {
+    ldpp_dout(this, 0) << "WARNING: failed to remove lc progress of bucket="
+        << b.name << " returned err=" << r << dendl;
+  }
+
   return ret;
 } /* RGWLC::remove_bucket_config */
 
@@ -459,6 +459,27 @@ public:
 };
 WRITE_CLASS_ENCODER(RGWLifecycleConfiguration)
 
+/* where a listing of the bucket index that stops resumes. the rules compare
+ * the versions of an object with each other, so it resumes at the first
+ * version of an object: after the last entry of the last object before the
+ * one being listed */
+class LCResumeMarker {
+  rgw_obj_key marker;
+  rgw_obj_key prev;
+public:
+  explicit LCResumeMarker(const rgw_obj_key& start) : marker(start) {}
+
+  /* called with each entry listed, before it is processed */
+  void next(const rgw_obj_key& key) {
+    if (!prev.name.empty() && prev.name != key.name) {
+      marker = prev;
+    }
+    prev = key;
+  }
+
+  const rgw_obj_key& get() const { return marker; }
+};
+
 class RGWLC : public DoutPrefixProvider {
   CephContext *cct;
   rgw::sal::Store* store;
@@ -487,9 +508,14 @@ public:
     using lock_guard = std::lock_guard<std::mutex>;
     using unique_lock = std::unique_lock<std::mutex>;
 
+    /* objects listed and lifecycle actions applied by this worker */
+    std::atomic<uint64_t> objs_listed{0};
+    std::atomic<uint64_t> actions_applied{0};
+
     LCWorker(const DoutPrefixProvider* dpp, CephContext *_cct, RGWLC *_lc,
 	     int ix);
     RGWLC* get_lc() { return lc; }
+    WorkPool* get_workpool() { return workpool; }
     void *entry() override;
     void stop();
     bool should_work(utime_t& now);
@@ -521,6 +547,9 @@ public:
   int bucket_lc_prepare(int index, LCWorker* worker);
   int bucket_lc_process(string& shard_id, LCWorker* worker, time_t stop_at,
 			bool once);
+  /* n.b., claims the lc entry of the bucket like process() does, fails
+   * with -EBUSY while a worker processes the bucket */
+  int process_bucket(rgw::sal::Bucket* bucket, LCWorker* worker);
   int bucket_lc_post(int index, int max_lock_sec,
 		     rgw::sal::Lifecycle::LCEntry& entry, int& result, LCWorker* worker);
   bool going_down();
@@ -0,0 +1,466 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/ceph_context.h"
+#include "rgw_mb_hash.h"
+
+namespace rgw::mb_hash {
+
+// the vectors never cross a call boundary, everything is inlined
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace {
+
+// one 32-bit word of each lane. the compiler maps the operations on it to
+// the widest SIMD registers the target has
+typedef uint32_t lanes_t __attribute__((vector_size(LANES * sizeof(uint32_t))));
+
+// the kernels below are written once for V = uint32_t (one stream) and for
+// V = lanes_t (LANES streams). they are always inlined so that each entry
+// point is compiled for its own target
+#define MB_INLINE inline __attribute__((always_inline))
+
+MB_INLINE void set_lane(uint32_t& v, size_t, uint32_t x) { v = x; }
+MB_INLINE void set_lane(lanes_t& v, size_t l, uint32_t x) { v[l] = x; }
+MB_INLINE uint32_t get_lane(uint32_t v, size_t) { return v; }
+MB_INLINE uint32_t get_lane(const lanes_t& v, size_t l) { return v[l]; }
+
+template <typename V>
+MB_INLINE V rotl(V x, int n) { return (x << n) | (x >> (32 - n)); }
+template <typename V>
+MB_INLINE V rotr(V x, int n) { return (x >> n) | (x << (32 - n)); }
+
+MB_INLINE uint32_t load_le32(const unsigned char* p) {
+  return uint32_t(p[0]) | uint32_t(p[1]) << 8 |
+    uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+MB_INLINE uint32_t load_be32(const unsigned char* p) {
+  return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 |
+    uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+constexpr uint32_t md5_k[64] = {
+  0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+  0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+  0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+  0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+  0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+  0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+  0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+  0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+  0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+  0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+  0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+  0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+  0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+  0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+  0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+  0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+constexpr int md5_s[64] = {
+  7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+  5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+  4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+  6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+template <typename V, size_t L>
+MB_INLINE void md5_blocks(State* const* states,
+                          const unsigned char* const* data, size_t blocks)
+{
+  V a, b, c, d;
+  for (size_t l = 0; l < L; l++) {
+    set_lane(a, l, (*states[l])[0]);
+    set_lane(b, l, (*states[l])[1]);
+    set_lane(c, l, (*states[l])[2]);
+    set_lane(d, l, (*states[l])[3]);
+  }
+  for (size_t n = 0; n < blocks; n++) {
+    V m[16];
+    for (size_t i = 0; i < 16; i++) {
+      for (size_t l = 0; l < L; l++) {
+        set_lane(m[i], l, load_le32(data[l] + n * BLOCK_SIZE + i * 4));
+      }
+    }
+    const V aa = a, bb = b, cc = c, dd = d;
+    for (int i = 0; i < 64; i++) {
+      V f;
+      int g;
+      if (i < 16) {
+        f = (b & c) | (~b & d);
+        g = i;
+      } else if (i < 32) {
+        f = (d & b) | (~d & c);
+        g = (5 * i + 1) % 16;
+      } else if (i < 48) {
+        f = b ^ c ^ d;
+        g = (3 * i + 5) % 16;
+      } else {
+        f = c ^ (b | ~d);
+        g = (7 * i) % 16;
+      }
+      f = f + a + md5_k[i] + m[g];
+      a = d;
+      d = c;
+      c = b;
+      b = b + rotl(f, md5_s[i]);
+    }
+    a += aa;
+    b += bb;
+    c += cc;
+    d += dd;
+  }
+  for (size_t l = 0; l < L; l++) {
+    (*states[l])[0] = get_lane(a, l);
+    (*states[l])[1] = get_lane(b, l);
+    (*states[l])[2] = get_lane(c, l);
+    (*states[l])[3] = get_lane(d, l);
+  }
+}
+
+constexpr uint32_t sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+template <typename V, size_t L>
+MB_INLINE void sha256_blocks(State* const* states,
+                             const unsigned char* const* data, size_t blocks)
+{
+  V s[8];
+  for (size_t i = 0; i < 8; i++) {
+    for (size_t l = 0; l < L; l++) {
+      set_lane(s[i], l, (*states[l])[i]);
+    }
+  }
+  for (size_t n = 0; n < blocks; n++) {
+    V w[64];
+    for (size_t i = 0; i < 16; i++) {
+      for (size_t l = 0; l < L; l++) {
+        set_lane(w[i], l, load_be32(data[l] + n * BLOCK_SIZE + i * 4));
+      }
+    }
+    for (size_t i = 16; i < 64; i++) {
+      const V s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+      const V s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+      w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+    V a = s[0], b = s[1], c = s[2], d = s[3];
+    V e = s[4], f = s[5], g = s[6], h = s[7];
+    for (size_t i = 0; i < 64; i++) {
+      const V S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+      const V ch = (e & f) ^ (~e & g);
+      const V t1 = h + S1 + ch + sha256_k[i] + w[i];
+      const V S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+      const V maj = (a & b) ^ (a & c) ^ (b & c);
+      const V t2 = S0 + maj;
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+    s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+  }
+  for (size_t i = 0; i < 8; i++) {
+    for (size_t l = 0; l < L; l++) {
+      (*states[l])[i] = get_lane(s[i], l);
+    }
+  }
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// the lanes fill a single register with avx2, two without
+#define HAVE_LANES_AVX2
+__attribute__((target("avx2")))
+void md5_lanes_avx2(State* const* states, const unsigned char* const* data,
+                    size_t blocks)
+{
+  md5_blocks<lanes_t, LANES>(states, data, blocks);
+}
+
+__attribute__((target("avx2")))
+void sha256_lanes_avx2(State* const* states, const unsigned char* const* data,
+                       size_t blocks)
+{
+  sha256_blocks<lanes_t, LANES>(states, data, blocks);
+}
+
+bool have_avx2()
+{
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+}
+#endif
+
+} // anonymous namespace
+
+void MD5Alg::init(State& state)
+{
+  state = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+}
+
+void MD5Alg::compress(State& state, const unsigned char* data, size_t blocks)
+{
+  State* states[] = {&state};
+  md5_blocks<uint32_t, 1>(states, &data, blocks);
+}
+
+void MD5Alg::compress_lanes(State* const* states,
+                            const unsigned char* const* data, size_t blocks)
+{
+#ifdef HAVE_LANES_AVX2
+  if (have_avx2()) {
+    md5_lanes_avx2(states, data, blocks);
+    return;
+  }
+#endif
+  md5_blocks<lanes_t, LANES>(states, data, blocks);
+}
+
+void SHA256Alg::init(State& state)
+{
+  state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+           0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+}
+
+void SHA256Alg::compress(State& state, const unsigned char* data,
+                         size_t blocks)
+{
+  State* states[] = {&state};
+  sha256_blocks<uint32_t, 1>(states, &data, blocks);
+}
+
+void SHA256Alg::compress_lanes(State* const* states,
+                               const unsigned char* const* data, size_t blocks)
+{
+#ifdef HAVE_LANES_AVX2
+  if (have_avx2()) {
+    sha256_lanes_avx2(states, data, blocks);
+    return;
+  }
+#endif
+  sha256_blocks<lanes_t, LANES>(states, data, blocks);
+}
+
+
+template <typename Alg>
+void Service<Alg>::hash(State& state, const unsigned char* data, size_t blocks,
+                        optional_yield y)
+{
+  if (blocks < min_blocks) {
+    Alg::compress(state, data, blocks);
+    return;
+  }
+  Job job{&state, data, blocks};
+  std::unique_lock l{lock};
+  queue.push_back(&job);
+  while (!job.done) {
+    if (!job.claimed) {
+      combine(l, job);
+      continue;
+    }
+    // until the combiner which claimed it is done or hands it back
+    job.waiter.wait(l, y, [&job] { return job.done || !job.claimed; });
+  }
+}
+
+template <typename Alg>
+void Service<Alg>::combine(std::unique_lock<ceph::mutex>& l, Job& mine)
+{
+  std::array<Job*, LANES> lanes{};
+  queue.erase(std::find(queue.begin(), queue.end(), &mine));
+  mine.claimed = true;
+  lanes[0] = &mine;
+  while (!mine.done) {
+    // fill the free lanes from the queue
+    size_t active = 0;
+    for (auto& lane : lanes) {
+      if (!lane && !queue.empty()) {
+        lane = queue.front();
+        queue.pop_front();
+        lane->claimed = true;
+      }
+      if (lane) {
+        ++active;
+      }
+    }
+    l.unlock();
+
+    // advance all of the lanes by the same number of blocks
+    size_t n = step_blocks;
+    for (auto lane : lanes) {
+      if (lane) {
+        n = std::min(n, lane->blocks);
+      }
+    }
+    if (active == 1) {
+      auto lane = *std::find_if(lanes.begin(), lanes.end(),
+                                [] (Job* j) { return j != nullptr; });
+      Alg::compress(*lane->state, lane->data, n);
+    } else {
+      // the idle lanes hash a copy of a busy one, into a scratch state
+      State scratch;
+      State* states[LANES];
+      const unsigned char* data[LANES];
+      Job* busy = nullptr;
+      for (size_t i = 0; i < LANES; i++) {
+        if (lanes[i]) {
+          busy = lanes[i];
+        }
+      }
+      for (size_t i = 0; i < LANES; i++) {
+        states[i] = lanes[i] ? lanes[i]->state : &scratch;
+        data[i] = lanes[i] ? lanes[i]->data : busy->data;
+      }
+      Alg::compress_lanes(states, data, n);
+    }
+    for (auto lane : lanes) {
+      if (lane) {
+        lane->data += n * BLOCK_SIZE;
+        lane->blocks -= n;
+      }
+    }
+
+    l.lock();
+    for (auto& lane : lanes) {
+      if (lane && lane->blocks == 0) {
+        lane->done = true;
+        lane->waiter.notify();
+        lane = nullptr;
+      }
+    }
+  }
+  // hand the unfinished streams back in their order, their submitters
+  // combine them
+  for (auto lane = lanes.rbegin(); lane != lanes.rend(); ++lane) {
+    if (*lane) {
+      (*lane)->claimed = false;
+      queue.push_front(*lane);
+      (*lane)->waiter.notify();
+    }
+  }
+}
+
+template class Service<MD5Alg>;
+template class Service<SHA256Alg>;
+
+Service<MD5Alg>* get_md5_service(CephContext* cct)
+{
+  if (!cct->_conf.get_val<bool>("rgw_hash_multibuffer_md5")) {
+    return nullptr;
+  }
+  return &cct->lookup_or_create_singleton_object<Service<MD5Alg>>(
+      "rgw::mb_hash::md5_service", false);
+}
+
+Service<SHA256Alg>* get_sha256_service(CephContext* cct)
+{
+  if (!cct->_conf.get_val<bool>("rgw_hash_multibuffer_sha256")) {
+    return nullptr;
+  }
+  return &cct->lookup_or_create_singleton_object<Service<SHA256Alg>>(
+      "rgw::mb_hash::sha256_service", false);
+}
+
+
+template <typename Alg>
+Stream<Alg>::Stream(Service<Alg>* service, optional_yield y)
+  : service(service), y(y)
+{
+  Alg::init(state);
+}
+
+template <typename Alg>
+void Stream<Alg>::Restart()
+{
+  Alg::init(state);
+  partial_len = 0;
+  length = 0;
+}
+
+template <typename Alg>
+void Stream<Alg>::Update(const unsigned char* input, size_t len)
+{
+  length += len;
+  if (partial_len > 0) {
+    const size_t n = std::min(len, BLOCK_SIZE - partial_len);
+    memcpy(partial + partial_len, input, n);
+    partial_len += n;
+    input += n;
+    len -= n;
+    if (partial_len < BLOCK_SIZE) {
+      return;
+    }
+    Alg::compress(state, partial, 1);
+    partial_len = 0;
+  }
+  if (const size_t blocks = len / BLOCK_SIZE; blocks > 0) {
+    service->hash(state, input, blocks, y);
+    input += blocks * BLOCK_SIZE;
+    len -= blocks * BLOCK_SIZE;
+  }
+  if (len > 0) {
+    memcpy(partial, input, len);
+    partial_len = len;
+  }
+}
+
+template <typename Alg>
+void Stream<Alg>::Final(unsigned char* digest)
+{
+  unsigned char pad[2 * BLOCK_SIZE] = {};
+  memcpy(pad, partial, partial_len);
+  pad[partial_len] = 0x80;
+  const size_t padded = partial_len < BLOCK_SIZE - 8 ? BLOCK_SIZE : 2 * BLOCK_SIZE;
+  const uint64_t bits = length * 8;
+  for (size_t i = 0; i < 8; i++) {
+    pad[padded - 8 + i] = Alg::big_endian ? bits >> (56 - 8 * i) : bits >> (8 * i);
+  }
+  Alg::compress(state, pad, padded / BLOCK_SIZE);
+
+  for (size_t i = 0; i < Alg::digest_size / 4; i++) {
+    for (size_t j = 0; j < 4; j++) {
+      digest[i * 4 + j] = Alg::big_endian ? state[i] >> (24 - 8 * j) : state[i] >> (8 * j);
+    }
+  }
+}
+
+template class Stream<MD5Alg>;
+template class Stream<SHA256Alg>;
+
+} // namespace rgw::mb_hash
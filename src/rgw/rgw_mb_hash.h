@@ -0,0 +1,163 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+#include "include/common_fwd.h"
+#include "common/async/yield_context.h"
+#include "common/ceph_crypto.h"
+#include "common/ceph_mutex.h"
+#include "rgw_waiter.h"
+
+// Multi-buffer hashing: MD5 and SHA256 are serial within a stream, but the
+// streams of concurrent requests are independent. The streams registered with
+// a Service are hashed together, one per SIMD lane, by the threads which
+// submitted them, instead of each thread hashing its own.
+
+namespace rgw::mb_hash {
+
+// number of streams hashed together
+inline constexpr size_t LANES = 8;
+inline constexpr size_t BLOCK_SIZE = 64;
+
+using State = std::array<uint32_t, 8>;
+
+struct MD5Alg {
+  static constexpr size_t digest_size = CEPH_CRYPTO_MD5_DIGESTSIZE;
+  static constexpr bool big_endian = false;
+
+  static void init(State& state);
+  // hashes 'blocks' blocks of one stream
+  static void compress(State& state, const unsigned char* data, size_t blocks);
+  // hashes 'blocks' blocks of each of LANES streams at once
+  static void compress_lanes(State* const* states,
+                             const unsigned char* const* data, size_t blocks);
+};
+
+struct SHA256Alg {
+  static constexpr size_t digest_size = CEPH_CRYPTO_SHA256_DIGESTSIZE;
+  static constexpr bool big_endian = true;
+
+  static void init(State& state);
+  static void compress(State& state, const unsigned char* data, size_t blocks);
+  static void compress_lanes(State* const* states,
+                             const unsigned char* const* data, size_t blocks);
+};
+
+// hashes the full blocks submitted by concurrent streams. there is no thread
+// of its own: a submitter whose blocks are still queued claims them along
+// with up to LANES - 1 other queued streams and hashes them until its own
+// are done, then hands the others back. several submitters combine at once,
+// each with lanes of its own. the submitters whose streams were claimed by
+// another one wait for it, a coroutine is suspended meanwhile
+template <typename Alg>
+class Service {
+  struct Job {
+    State* state;
+    const unsigned char* data;
+    size_t blocks;
+    bool claimed = false; // in the lanes of a combining submitter
+    bool done = false;
+    Waiter waiter;
+
+    Job(State* state, const unsigned char* data, size_t blocks)
+      : state(state), data(data), blocks(blocks) {}
+  };
+
+  ceph::mutex lock = ceph::make_mutex("rgw::mb_hash::Service");
+  std::deque<Job*> queue; // unclaimed
+
+  void combine(std::unique_lock<ceph::mutex>& l, Job& mine);
+ public:
+  // fewer blocks than this are hashed by the caller alone
+  static constexpr size_t min_blocks = 4;
+  // the lanes are refilled after at most this many blocks
+  static constexpr size_t step_blocks = 16;
+
+  void hash(State& state, const unsigned char* data, size_t blocks,
+            optional_yield y = null_yield);
+};
+
+// the services shared by the requests, or nullptr unless enabled by
+// rgw_hash_multibuffer_md5 and rgw_hash_multibuffer_sha256
+Service<MD5Alg>* get_md5_service(CephContext* cct);
+Service<SHA256Alg>* get_sha256_service(CephContext* cct);
+
+// a stream hashed through a Service
+template <typename Alg>
+class Stream {
+  Service<Alg>* service;
+  optional_yield y;
+  State state;
+  unsigned char partial[BLOCK_SIZE];
+  size_t partial_len = 0;
+  uint64_t length = 0;
+ public:
+  // 'y' is that of the thread which updates the stream
+  explicit Stream(Service<Alg>* service, optional_yield y = null_yield);
+
+  void Restart();
+  void Update(const unsigned char* input, size_t len);
+  void Final(unsigned char* digest);
+};
+
+// a digest with the interface of ceph::crypto's, hashed through the service
+// if there is one and by OpenSSL otherwise
+template <typename Alg, typename Fallback>
+class Digest {
+  std::optional<Stream<Alg>> mb;
+  std::optional<Fallback> ssl;
+ public:
+  static constexpr size_t digest_size = Alg::digest_size;
+
+  explicit Digest(Service<Alg>* service, optional_yield y = null_yield) {
+    if (service) {
+      mb.emplace(service, y);
+    } else {
+      ssl.emplace();
+    }
+  }
+
+  void Restart() {
+    if (mb) {
+      mb->Restart();
+    } else {
+      ssl->Restart();
+    }
+  }
+  void Update(const unsigned char* input, size_t len) {
+    if (mb) {
+      mb->Update(input, len);
+    } else {
+      ssl->Update(input, len);
+    }
+  }
+  void Final(unsigned char* digest) {
+    if (mb) {
+      mb->Final(digest);
+    } else {
+      ssl->Final(digest);
+    }
+  }
+};
+
+using MD5 = Digest<MD5Alg, ceph::crypto::MD5>;
+using SHA256 = Digest<SHA256Alg, ceph::crypto::SHA256>;
+
+} // namespace rgw::mb_hash
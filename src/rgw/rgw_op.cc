@@ -45,6 +45,7 @@
 #include "rgw_role.h"
 #include "rgw_tag_s3.h"
 #include "rgw_putobj_processor.h"
+#include "rgw_putobj_pipeline.h"
 #include "rgw_crypt.h"
 #include "rgw_perf_counters.h"
 #include "rgw_notify.h"
@@ -3721,7 +3722,12 @@ void RGWPutObj::execute(optional_yield y)
   char supplied_md5[CEPH_CRYPTO_MD5_DIGESTSIZE * 2 + 1];
   char calc_md5[CEPH_CRYPTO_MD5_DIGESTSIZE * 2 + 1];
   unsigned char m[CEPH_CRYPTO_MD5_DIGESTSIZE];
-  MD5 hash;
+  // hash and transform successive chunks on the offload pool, if any, while
+  // the next chunk is read from the client
+  auto offload_pool = rgw::putobj::get_offload_pool(s->cct);
+  const size_t offload_window = s->cct->_conf.get_val<uint64_t>("rgw_put_obj_offload_window");
+  rgw::putobj::OffloadedMD5 hash(offload_pool, offload_window, y,
+                                 rgw::mb_hash::get_md5_service(s->cct));
   bufferlist bl, aclbl, bs;
   int len;
   
@@ -3917,7 +3923,8 @@ void RGWPutObj::execute(optional_yield y)
         ldpp_dout(this, 1) << "Cannot load plugin for compression type "
             << compression_type << dendl;
       } else {
-        compressor.emplace(s->cct, plugin, filter);
+        compressor.emplace(s->cct, plugin, filter, offload_pool,
+                           offload_window, y);
         filter = &*compressor;
       }
     }
@@ -3947,7 +3954,7 @@ void RGWPutObj::execute(optional_yield y)
     }
 
     if (need_calc_md5) {
-      hash.Update((const unsigned char *)data.c_str(), data.length());
+      hash.Update(data);
     }
 
     /* update torrrent */
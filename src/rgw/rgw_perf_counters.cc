@@ -30,11 +30,34 @@ int rgw_perf_start(CephContext *cct)
 
   plb.add_u64_counter(l_rgw_cache_hit, "cache_hit", "Cache hits");
   plb.add_u64_counter(l_rgw_cache_miss, "cache_miss", "Cache miss");
+  plb.add_u64_counter(l_rgw_cache_negative_hit, "cache_negative_hit",
+		      "Cache hits of objects cached as nonexistent");
+  plb.add_u64_counter(l_rgw_cache_expired, "cache_expired",
+		      "Cache misses on expired entries");
+  plb.add_u64_counter(l_rgw_cache_evict, "cache_evict", "Cache LRU evictions");
+  plb.add_u64_counter(l_rgw_cache_notify_updates, "cache_notify_updates",
+		      "Cache updates distributed to the other gateways");
+  plb.add_u64_counter(l_rgw_cache_notify_coalesced, "cache_notify_coalesced",
+		      "Cache updates dropped for a later update of the same entry");
+  plb.add_u64_counter(l_rgw_cache_notify_sent, "cache_notify_sent",
+		      "Cache notifications sent");
+  plb.add_u64_counter(l_rgw_cache_notify_received, "cache_notify_received",
+		      "Cache updates received from the other gateways");
+
+  plb.add_u64_counter(l_rgw_stripe_cache_hit, "stripe_cache_hit",
+		      "GET reads served by the stripes of other GETs");
+  plb.add_u64_counter(l_rgw_stripe_cache_miss, "stripe_cache_miss",
+		      "GET reads not found among the stripes of other GETs");
 
   plb.add_u64_counter(l_rgw_keystone_token_cache_hit, "keystone_token_cache_hit", "Keystone token cache hits");
   plb.add_u64_counter(l_rgw_keystone_token_cache_miss, "keystone_token_cache_miss", "Keystone token cache miss");
 
   plb.add_u64_counter(l_rgw_gc_retire, "gc_retire_object", "GC object retires");
+  plb.add_u64_counter(l_rgw_gc_tail_remove, "gc_tail_remove",
+		      "GC tail objects removed");
+  plb.add_u64(l_rgw_gc_backlog_age, "gc_backlog_age",
+	      "Age in seconds of the oldest expired GC entry in the last cycle");
+  plb.add_time_avg(l_rgw_gc_cycle_lat, "gc_cycle_lat", "GC cycle duration");
 
   plb.add_u64_counter(l_rgw_lc_expire_current, "lc_expire_current",
 		      "Lifecycle current expiration");
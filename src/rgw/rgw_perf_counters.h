@@ -27,11 +27,24 @@ enum {
 
   l_rgw_cache_hit,
   l_rgw_cache_miss,
+  l_rgw_cache_negative_hit,
+  l_rgw_cache_expired,
+  l_rgw_cache_evict,
+  l_rgw_cache_notify_updates,
+  l_rgw_cache_notify_coalesced,
+  l_rgw_cache_notify_sent,
+  l_rgw_cache_notify_received,
+
+  l_rgw_stripe_cache_hit,
+  l_rgw_stripe_cache_miss,
 
   l_rgw_keystone_token_cache_hit,
   l_rgw_keystone_token_cache_miss,
 
   l_rgw_gc_retire,
+  l_rgw_gc_tail_remove,
+  l_rgw_gc_backlog_age,
+  l_rgw_gc_cycle_lat,
 
   l_rgw_lc_expire_current,
   l_rgw_lc_expire_noncurrent,
@@ -0,0 +1,206 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include <boost/asio/post.hpp>
+
+#include "common/ceph_context.h"
+#include "rgw_putobj_pipeline.h"
+
+namespace rgw::putobj {
+
+namespace {
+
+struct OffloadPool {
+  boost::asio::thread_pool pool;
+
+  explicit OffloadPool(size_t threads) : pool(threads) {}
+  ~OffloadPool() {
+    pool.join();
+  }
+};
+
+} // anonymous namespace
+
+boost::asio::thread_pool* get_offload_pool(CephContext* cct)
+{
+  const auto threads = cct->_conf.get_val<uint64_t>("rgw_put_obj_offload_threads");
+  if (threads == 0) {
+    return nullptr;
+  }
+  auto& p = cct->lookup_or_create_singleton_object<OffloadPool>(
+      "rgw::putobj::offload_pool", true, threads);
+  return &p.pool;
+}
+
+
+struct ParallelStage::Chunk {
+  bufferlist in;
+  bufferlist out;
+  uint64_t offset;
+  Done done;
+  int r = 0;
+
+  ceph::mutex lock = ceph::make_mutex("rgw::putobj::ParallelStage::Chunk");
+  Waiter waiter;
+  bool finished = false;
+
+  Chunk(bufferlist&& in, uint64_t offset, Done&& done)
+    : in(std::move(in)), offset(offset), done(std::move(done))
+  {}
+
+  void wait(optional_yield y) {
+    std::unique_lock l{lock};
+    waiter.wait(l, y, [this] { return finished; });
+  }
+};
+
+ParallelStage::~ParallelStage()
+{
+  for (auto& c : chunks) {
+    c->wait(y);
+  }
+}
+
+int ParallelStage::complete_front()
+{
+  auto c = std::move(chunks.front());
+  chunks.pop_front();
+  c->wait(y);
+  if (error < 0) {
+    // nothing past a failed chunk is passed on
+    return error;
+  }
+  int r = c->done(c->r, std::move(c->in), std::move(c->out), c->offset);
+  if (r < 0 && error == 0) {
+    error = r;
+  }
+  return r;
+}
+
+int ParallelStage::submit(bufferlist&& in, uint64_t offset,
+                          Work work, Done done)
+{
+  if (error < 0) {
+    return error;
+  }
+  if (!pool) {
+    bufferlist out;
+    int r = work(in, out);
+    r = done(r, std::move(in), std::move(out), offset);
+    if (r < 0) {
+      error = r;
+    }
+    return r;
+  }
+
+  // make room in the window by completing the oldest chunk
+  while (chunks.size() >= window) {
+    int r = complete_front();
+    if (r < 0) {
+      return r;
+    }
+  }
+
+  auto c = std::make_shared<Chunk>(std::move(in), offset, std::move(done));
+  chunks.push_back(c);
+  boost::asio::post(*pool, [c, work = std::move(work)] {
+      int r = work(c->in, c->out);
+      std::lock_guard l{c->lock};
+      c->r = r;
+      c->finished = true;
+      c->waiter.notify();
+    });
+
+  // hand back whatever already finished, without waiting on the rest
+  while (!chunks.empty()) {
+    {
+      auto& front = chunks.front();
+      std::lock_guard l{front->lock};
+      if (!front->finished) {
+        break;
+      }
+    }
+    int r = complete_front();
+    if (r < 0) {
+      return r;
+    }
+  }
+  return 0;
+}
+
+int ParallelStage::drain()
+{
+  while (!chunks.empty()) {
+    int r = complete_front();
+    if (r < 0) {
+      return r;
+    }
+  }
+  return error;
+}
+
+
+OffloadedMD5::OffloadedMD5(boost::asio::thread_pool* pool, size_t window,
+                           optional_yield y,
+                           mb_hash::Service<mb_hash::MD5Alg>* service)
+  : hash(service, pool ? null_yield : y), // the pool threads update it
+    window(std::max<size_t>(window, 1)), y(y)
+{
+  if (pool) {
+    strand.emplace(pool->get_executor());
+  }
+}
+
+OffloadedMD5::~OffloadedMD5()
+{
+  // the queued updates reference this object
+  wait_below(1);
+}
+
+void OffloadedMD5::wait_below(size_t count)
+{
+  std::unique_lock l{lock};
+  waiter.wait(l, y, [this, count] { return pending < count; });
+}
+
+void OffloadedMD5::Update(const bufferlist& data)
+{
+  if (!strand) {
+    for (const auto& p : data.buffers()) {
+      hash.Update((const unsigned char *)p.c_str(), p.length());
+    }
+    return;
+  }
+  wait_below(window);
+  {
+    std::lock_guard l{lock};
+    ++pending;
+  }
+  // the bufferlist copy shares the underlying buffers
+  boost::asio::post(*strand, [this, data] {
+      for (const auto& p : data.buffers()) {
+        hash.Update((const unsigned char *)p.c_str(), p.length());
+      }
+      std::lock_guard l{lock};
+      --pending;
+      waiter.notify();
+    });
+}
+
+void OffloadedMD5::Final(unsigned char* digest)
+{
+  wait_below(1);
+  hash.Final(digest);
+}
+
+} // namespace rgw::putobj
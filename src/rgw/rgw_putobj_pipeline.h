@@ -0,0 +1,97 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include "include/buffer.h"
+#include "include/common_fwd.h"
+#include "common/async/yield_context.h"
+#include "common/ceph_mutex.h"
+#include "rgw_mb_hash.h"
+#include "rgw_waiter.h"
+
+namespace rgw::putobj {
+
+// the threads shared by the PUT pipelines of the process, or nullptr if
+// rgw_put_obj_offload_threads is 0
+boost::asio::thread_pool* get_offload_pool(CephContext* cct);
+
+// runs a transform of successive chunks on the offload pool, up to 'window'
+// chunks at a time, and hands their results back in submission order. with
+// no pool, each chunk is transformed and completed within submit()
+class ParallelStage {
+ public:
+  // runs on a pool thread, concurrently with the work of other chunks
+  using Work = std::function<int(bufferlist& in, bufferlist& out)>;
+  // runs on the submitting thread, in submission order
+  using Done = std::function<int(int r, bufferlist&& in, bufferlist&& out,
+                                 uint64_t offset)>;
+
+  // the waits for chunks suspend the coroutine of 'y', if any
+  ParallelStage(boost::asio::thread_pool* pool, size_t window,
+                optional_yield y = null_yield)
+    : pool(pool), window(std::max<size_t>(window, 1)), y(y)
+  {}
+  // waits for the chunks in flight, their results are dropped
+  ~ParallelStage();
+
+  // returns the error of the first chunk which failed, if any
+  int submit(bufferlist&& in, uint64_t offset, Work work, Done done);
+  // completes all chunks in flight
+  int drain();
+
+ private:
+  struct Chunk;
+
+  boost::asio::thread_pool* pool;
+  const size_t window;
+  optional_yield y;
+  std::deque<std::shared_ptr<Chunk>> chunks;
+  int error = 0;
+
+  int complete_front();
+};
+
+// the MD5 of the object data, updated on the offload pool while the caller
+// goes on with the next chunk. the updates are serialized on a strand, and
+// at most 'window' of them are queued at a time
+class OffloadedMD5 {
+  mb_hash::MD5 hash;
+  std::optional<boost::asio::strand<boost::asio::thread_pool::executor_type>> strand;
+  const size_t window;
+  optional_yield y;
+  ceph::mutex lock = ceph::make_mutex("rgw::putobj::OffloadedMD5");
+  Waiter waiter;
+  size_t pending = 0;
+
+  void wait_below(size_t count);
+ public:
+  OffloadedMD5(boost::asio::thread_pool* pool, size_t window,
+               optional_yield y = null_yield,
+               mb_hash::Service<mb_hash::MD5Alg>* service = nullptr);
+  ~OffloadedMD5();
+
+  // the buffers are shared, not copied; they must not be modified
+  void Update(const bufferlist& data);
+  void Final(unsigned char* digest);
+};
+
+} // namespace rgw::putobj
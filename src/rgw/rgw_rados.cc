@@ -779,6 +779,7 @@ struct complete_op_data {
   bool log_op;
   uint16_t bilog_op;
   rgw_zone_set zones_trace;
+  bool batched{false};
 
   bool stopped{false};
 
@@ -868,6 +869,30 @@ int RGWIndexCompletionThread::process(const DoutPrefixProvider *dpp)
   return 0;
 }
 
+// complete ops of a bucket index shard sent as a single operation
+struct complete_op_batch {
+  RGWIndexCompletionManager *manager{nullptr};
+  RGWSI_RADOS::Obj bucket_obj;
+  vector<complete_op_data *> ops;
+};
+
+class RGWIndexCompleteBatchThread : public RGWRadosThread {
+  RGWIndexCompletionManager *manager;
+  uint64_t window_msec;
+
+  uint64_t interval_msec() override {
+    return window_msec;
+  }
+public:
+  RGWIndexCompleteBatchThread(RGWRados *_store,
+                              RGWIndexCompletionManager *_manager,
+                              uint64_t _window_msec)
+    : RGWRadosThread(_store, "index-batch"),
+      manager(_manager), window_msec(_window_msec) {}
+
+  int process(const DoutPrefixProvider *dpp) override;
+};
+
 class RGWIndexCompletionManager {
   RGWRados *store{nullptr};
   ceph::containers::tiny_vector<ceph::mutex> locks;
@@ -879,6 +904,14 @@ class RGWIndexCompletionManager {
 
   std::atomic<int> cur_shard {0};
 
+  const uint64_t batch_window_msec;
+  const uint64_t batch_size;
+  ceph::mutex batch_lock = ceph::make_mutex("RGWIndexCompletionManager::batch_lock");
+  map<rgw_raw_obj, complete_op_batch *> batches;
+  RGWIndexCompleteBatchThread *batch_thread{nullptr};
+
+  void send_batch(complete_op_batch *batch);
+
 
 public:
   RGWIndexCompletionManager(RGWRados *_store) :
@@ -888,7 +921,9 @@ public:
       [](const size_t i) {
         return ceph::make_mutex("RGWIndexCompletionManager::lock::" +
 				std::to_string(i));
-      })}
+      })},
+    batch_window_msec(store->ctx()->_conf.get_val<uint64_t>("rgw_bucket_index_complete_batch_window_ms")),
+    batch_size(store->ctx()->_conf.get_val<uint64_t>("rgw_bucket_index_complete_batch_size"))
   {
     num_shards = store->ctx()->_conf->rgw_thread_pool_size;
     completions.resize(num_shards);
@@ -911,8 +946,19 @@ public:
                          list<cls_rgw_obj_key> *remove_objs, bool log_op,
                          uint16_t bilog_op,
                          rgw_zone_set *zones_trace,
-                         complete_op_data **result);
+                         complete_op_data **result,
+                         bool batched = false);
   bool handle_completion(completion_t cb, complete_op_data *arg);
+  bool handle_completion(int r, complete_op_data *arg);
+
+  bool batching() const {
+    return batch_window_msec > 0;
+  }
+  // queue a completion created with batched=true, it is sent along with
+  // the other completions of its shard when the batch is full, or when
+  // the batch window ends
+  void add_to_batch(const RGWSI_RADOS::Obj& bucket_obj, complete_op_data *arg);
+  void flush_batches();
 
   int start(const DoutPrefixProvider *dpp) {
     completion_thread = new RGWIndexCompletionThread(store);
@@ -921,9 +967,21 @@ public:
       return ret;
     }
     completion_thread->start();
+    if (batching()) {
+      batch_thread = new RGWIndexCompleteBatchThread(store, this, batch_window_msec);
+      batch_thread->start();
+    }
     return 0;
   }
   void stop() {
+    if (batch_thread) {
+      batch_thread->stop();
+      delete batch_thread;
+      batch_thread = nullptr;
+    }
+    // nobody would send what is still queued
+    flush_batches();
+
     if (completion_thread) {
       completion_thread->stop();
       delete completion_thread;
@@ -964,7 +1022,8 @@ void RGWIndexCompletionManager::create_completion(const rgw_obj& obj,
                                                   list<cls_rgw_obj_key> *remove_objs, bool log_op,
                                                   uint16_t bilog_op,
                                                   rgw_zone_set *zones_trace,
-                                                  complete_op_data **result)
+                                                  complete_op_data **result,
+                                                  bool batched)
 {
   complete_op_data *entry = new complete_op_data;
 
@@ -995,13 +1054,21 @@ void RGWIndexCompletionManager::create_completion(const rgw_obj& obj,
 
   *result = entry;
 
-  entry->rados_completion = librados::Rados::aio_create_completion(entry, obj_complete_cb);
+  entry->batched = batched;
+  if (!batched) {
+    entry->rados_completion = librados::Rados::aio_create_completion(entry, obj_complete_cb);
+  }
 
   std::lock_guard l{locks[shard_id]};
   completions[shard_id].insert(entry);
 }
 
 bool RGWIndexCompletionManager::handle_completion(completion_t cb, complete_op_data *arg)
+{
+  return handle_completion(rados_aio_get_return_value(cb), arg);
+}
+
+bool RGWIndexCompletionManager::handle_completion(int r, complete_op_data *arg)
 {
   int shard_id = arg->manager_shard_id;
   {
@@ -1017,14 +1084,115 @@ bool RGWIndexCompletionManager::handle_completion(completion_t cb, complete_op_d
     comps.erase(iter);
   }
 
-  int r = rados_aio_get_return_value(cb);
-  if (r != -ERR_BUSY_RESHARDING) {
+  // the ops of a failed batch, which applied none of them, or of a batch
+  // sent to an osd without bucket_complete_ops, are completed one by one
+  // by the completion thread
+  if (r != -ERR_BUSY_RESHARDING &&
+      !(arg->batched && r < 0)) {
     return true;
   }
   completion_thread->add_completion(arg);
   return false;
 }
 
+static void complete_batch(complete_op_batch *batch, int r)
+{
+  for (auto c : batch->ops) {
+    c->lock.lock();
+    if (c->stopped) {
+      c->lock.unlock();
+      delete c;
+      continue;
+    }
+    bool need_delete = batch->manager->handle_completion(r, c);
+    c->lock.unlock();
+    if (need_delete) {
+      delete c;
+    }
+  }
+  delete batch;
+}
+
+static void batch_complete_cb(completion_t cb, void *arg)
+{
+  complete_batch(static_cast<complete_op_batch *>(arg),
+                 rados_aio_get_return_value(cb));
+}
+
+void RGWIndexCompletionManager::add_to_batch(const RGWSI_RADOS::Obj& bucket_obj,
+                                             complete_op_data *arg)
+{
+  complete_op_batch *full = nullptr;
+  {
+    std::lock_guard l{batch_lock};
+    auto& batch = batches[bucket_obj.get_raw_obj()];
+    if (!batch) {
+      batch = new complete_op_batch;
+      batch->manager = this;
+      batch->bucket_obj = bucket_obj;
+      batch->ops.reserve(batch_size);
+    }
+    batch->ops.push_back(arg);
+    if (batch->ops.size() >= batch_size) {
+      full = batch;
+      batches.erase(bucket_obj.get_raw_obj());
+    }
+  }
+  if (full) {
+    send_batch(full);
+  }
+}
+
+void RGWIndexCompletionManager::flush_batches()
+{
+  map<rgw_raw_obj, complete_op_batch *> pending;
+  {
+    std::lock_guard l{batch_lock};
+    pending.swap(batches);
+  }
+  for (auto& [obj, batch] : pending) {
+    send_batch(batch);
+  }
+}
+
+void RGWIndexCompletionManager::send_batch(complete_op_batch *batch)
+{
+  vector<rgw_cls_obj_complete_op> ops;
+  ops.reserve(batch->ops.size());
+  for (auto c : batch->ops) {
+    rgw_cls_obj_complete_op& call = ops.emplace_back();
+    call.op = c->op;
+    call.tag = c->tag;
+    call.key = c->key;
+    call.ver = c->ver;
+    call.meta = c->dir_meta;
+    call.log_op = c->log_op;
+    call.bilog_flags = c->bilog_op;
+    call.remove_objs = c->remove_objs;
+    call.zones_trace = c->zones_trace;
+  }
+
+  librados::ObjectWriteOperation o;
+  cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING);
+  cls_rgw_bucket_complete_ops(o, ops);
+
+  librados::AioCompletion *completion =
+    librados::Rados::aio_create_completion(batch, batch_complete_cb);
+  int r = batch->bucket_obj.aio_operate(completion, &o);
+  completion->release(); /* can't reference batch here, as it might have already been released */
+  if (r < 0) {
+    ldout(store->ctx(), 0) << "ERROR: " << __func__ <<
+      "(): failed to send bucket index completions r=" << r << dendl;
+    complete_batch(batch, r);
+  }
+}
+
+int RGWIndexCompleteBatchThread::process(const DoutPrefixProvider *dpp)
+{
+  manager->flush_batches();
+  return 0;
+}
+
 void RGWRados::finalize()
 {
   if (run_sync_thread) {
@@ -1173,6 +1341,9 @@ int RGWRados::init_complete(const DoutPrefixProvider *dpp)
    */
   sync_module = svc.sync_modules->get_sync_module();
 
+  stripe_cache.set_max_size(
+    cct->_conf.get_val<Option::size_t>("rgw_get_obj_stripe_cache_size"));
+
   ret = open_root_pool_ctx(dpp);
   if (ret < 0)
     return ret;
@@ -6340,12 +6511,60 @@ struct get_obj_data {
   uint64_t offset; // next offset to write to client
   rgw::AioResultList completed; // completed read results, sorted by offset
   optional_yield yield;
+  RGWGetObjWindow window{0, 0};
+
+  struct Read {
+    ceph::mono_time issued;
+    rgw_raw_obj obj;
+    uint64_t ofs;
+    bool cacheable; // tail object data, for RGWStripeCache
+    /* the range asked for within the data read, the cacheable reads are
+     * rounded out to chunk boundaries */
+    uint64_t skip;
+    uint64_t len;
+  };
+  std::map<uint64_t, Read> reads; // in flight, by id
 
   get_obj_data(RGWRados* store, RGWGetDataCB* cb, rgw::Aio* aio,
                uint64_t offset, optional_yield yield)
     : store(store), client_cb(cb), aio(aio), offset(offset), yield(yield) {}
 
+  void set_window(uint64_t min, uint64_t max) {
+    window = RGWGetObjWindow{min, max};
+  }
+
+  void adapt_window() {
+    if (window.adapt(ceph::mono_clock::now())) {
+      aio->set_window(window.get());
+    }
+  }
+
+  void complete_reads(rgw::AioResultList& results) {
+    const auto now = ceph::mono_clock::now();
+    for (auto& r : results) {
+      auto iter = reads.find(r.id);
+      if (iter == reads.end()) {
+        continue;
+      }
+      auto& read = iter->second;
+      window.add_latency(now - read.issued);
+      if (read.cacheable && r.result >= 0) {
+        store->stripe_cache.put(read.obj, read.ofs, r.data);
+        /* a short read ends at the end of the object */
+        bufferlist bl;
+        if (r.data.length() > read.skip) {
+          bl.substr_of(r.data, read.skip,
+                       std::min<uint64_t>(read.len, r.data.length() - read.skip));
+        }
+        r.data = std::move(bl);
+      }
+      reads.erase(iter);
+    }
+  }
+
   int flush(rgw::AioResultList&& results) {
+    complete_reads(results);
+
     int r = rgw::check_for_errors(results);
     if (r < 0) {
       return r;
@@ -6360,11 +6579,13 @@ struct get_obj_data {
       completed.pop_front_and_dispose(std::default_delete<rgw::AioResultEntry>{});
 
       offset += bl.length();
+      window.add_delivered(bl.length());
       int r = client_cb->handle_data(bl, 0, bl.length());
       if (r < 0) {
         return r;
       }
     }
+    adapt_window();
     return 0;
   }
 
@@ -6387,6 +6608,29 @@ struct get_obj_data {
   }
 };
 
+bool RGWGetObjWindow::adapt(ceph::mono_time now)
+{
+  if (max_window <= min_window || latency == ceph::timespan::zero()) {
+    return false;
+  }
+  const double elapsed = std::chrono::duration<double>(now - start).count();
+  if (elapsed <= 0) {
+    return false;
+  }
+  /* twice the data consumed while a read is in flight. as long as the
+   * reads are what holds the client back, the rate follows the window
+   * and this doubles it */
+  const double rate = delivered / elapsed;
+  const auto want = static_cast<uint64_t>(
+    2 * rate * std::chrono::duration<double>(latency).count());
+  const auto w = std::clamp(want, min_window, max_window);
+  if (w == window) {
+    return false;
+  }
+  window = w;
+  return true;
+}
+
 static int _get_obj_iterate_cb(const DoutPrefixProvider *dpp, 
                                const rgw_raw_obj& read_obj, off_t obj_ofs,
                                off_t read_ofs, off_t len, bool is_head_obj,
@@ -6430,6 +6674,22 @@ int RGWRados::get_obj_iterate_cb(const DoutPrefixProvider *dpp,
     }
   }
 
+  const uint64_t id = obj_ofs; // use logical object offset for sorting replies
+
+  /* the head object may be overwritten, only tail data is shared */
+  const bool cacheable = !is_head_obj && stripe_cache.enabled();
+  if (cacheable) {
+    auto cached = std::make_unique<rgw::AioResultEntry>();
+    if (stripe_cache.get(read_obj, read_ofs, len, cached->data)) {
+      ldpp_dout(dpp, 20) << "rados->get_obj_iterate_cb oid=" << read_obj.oid
+          << " read_ofs=" << read_ofs << " len=" << len << " from stripe cache" << dendl;
+      cached->id = id;
+      rgw::AioResultList completed;
+      completed.push_back(*cached.release());
+      return d->flush(std::move(completed));
+    }
+  }
+
   auto obj = d->store->svc.rados->obj(read_obj);
   int r = obj.open(dpp);
   if (r < 0) {
@@ -6438,11 +6698,27 @@ int RGWRados::get_obj_iterate_cb(const DoutPrefixProvider *dpp,
   }
 
   ldpp_dout(dpp, 20) << "rados->get_obj_iterate_cb oid=" << read_obj.oid << " obj-ofs=" << obj_ofs << " read_ofs=" << read_ofs << " len=" << len << dendl;
-  op.read(read_ofs, len, nullptr, nullptr);
-
-  const uint64_t cost = len;
-  const uint64_t id = obj_ofs; // use logical object offset for sorting replies
 
+  /* the cached ranges start and end on chunk boundaries, so that GETs of
+   * different ranges of an object share them. small ranges are read as
+   * they are, rounding them out would multiply what they read */
+  uint64_t ofs = read_ofs;
+  uint64_t read_len = len;
+  const uint64_t chunk = cct->_conf->rgw_max_chunk_size;
+  if (cacheable && chunk > 0 && static_cast<uint64_t>(len) >= chunk / 4) {
+    ofs = read_ofs / chunk * chunk;
+    read_len = (read_ofs + len + chunk - 1) / chunk * chunk - ofs;
+  }
+  op.read(ofs, read_len, nullptr, nullptr);
+
+  /* the throttle fails a read that costs more than its window, only charge
+   * the rounding while it fits */
+  const uint64_t cost = std::min(read_len,
+                                 std::max<uint64_t>(len, d->window.get()));
+
+  d->reads[id] = get_obj_data::Read{ceph::mono_clock::now(), read_obj, ofs,
+                                    cacheable, read_ofs - ofs,
+                                    static_cast<uint64_t>(len)};
   auto completed = d->aio->get(obj, rgw::Aio::librados_op(std::move(op), d->yield), cost, id);
 
   return d->flush(std::move(completed));
@@ -6459,6 +6735,8 @@ int RGWRados::Object::Read::iterate(const DoutPrefixProvider *dpp, int64_t ofs,
 
   auto aio = rgw::make_throttle(window_size, y);
   get_obj_data data(store, cb, &*aio, ofs, y);
+  data.set_window(window_size,
+                  cct->_conf.get_val<Option::size_t>("rgw_get_obj_max_window_size"));
 
   int r = store->iterate_obj(dpp, obj_ctx, source->get_bucket_info(), state.obj,
                              ofs, end, chunk_size, _get_obj_iterate_cb, &data, y);
@@ -6753,7 +7031,8 @@ int RGWRados::block_while_resharding(RGWRados::BucketShard *bs,
       return ret;
     }
 
-    if (!entry.resharding_in_progress()) {
+    // an osd which does not know about IN_LOGRECORD blocks writes too
+    if (!entry.resharding_in_progress() && !entry.resharding_log_record()) {
       return fetch_new_bucket_id("get_bucket_resharding_succeeded",
 				 new_bucket_id);
     }
@@ -8201,12 +8480,24 @@ int RGWRados::list_lc_progress(string& marker, uint32_t max_entries,
   return lc->list_lc_progress(marker, max_entries, progress_map, index);
 }
 
-int RGWRados::process_lc()
+int RGWRados::process_lc(rgw::sal::Bucket* bucket,
+                         uint64_t* objs_listed, uint64_t* actions)
 {
   RGWLC lc;
   lc.initialize(cct, this->store);
   RGWLC::LCWorker worker(&lc, cct, &lc, 0);
-  auto ret = lc.process(&worker, true /* once */);
+  int ret;
+  if (bucket) {
+    ret = lc.process_bucket(bucket, &worker);
+  } else {
+    ret = lc.process(&worker, true /* once */);
+  }
+  if (objs_listed) {
+    *objs_listed = worker.objs_listed;
+  }
+  if (actions) {
+    *actions = worker.actions_applied;
+  }
   lc.stop_processor(); // sets down_flag, but returns immediately
   return ret;
 }
@@ -8252,6 +8543,15 @@ int RGWRados::cls_obj_complete_op(BucketShard& bs, const rgw_obj& obj, RGWModify
   ver.pool = pool;
   ver.epoch = epoch;
   cls_rgw_obj_key key(ent.key.name, ent.key.instance);
+  if (index_completion_manager->batching()) {
+    complete_op_data *arg;
+    index_completion_manager->create_completion(obj, op, tag, ver, key, dir_meta, remove_objs,
+                                                svc.zone->get_zone().log_data, bilog_flags, &zones_trace, &arg,
+                                                true /* batched */);
+    index_completion_manager->add_to_batch(bs.bucket_obj, arg);
+    return 0;
+  }
+
   cls_rgw_guard_bucket_resharding(o, -ERR_BUSY_RESHARDING);
   cls_rgw_bucket_complete_op(o, op, tag, ver, key, dir_meta, remove_objs,
                              svc.zone->get_zone().log_data, bilog_flags, &zones_trace);
@@ -8425,6 +8725,9 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
     const std::string& oid_name;
     RGWRados::ent_map_t::iterator cursor;
     RGWRados::ent_map_t::iterator end;
+    // where to resume listing this shard; the entries themselves are
+    // moved out as they are consumed
+    cls_rgw_obj_key last_key;
 
     // manages an iterator through a shard and provides other
     // accessors
@@ -8433,10 +8736,19 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
 		 const std::string& _oid_name):
       shard_idx(_shard_idx),
       result(_result),
-      oid_name(_oid_name),
-      cursor(_result.dir.m.begin()),
-      end(_result.dir.m.end())
-    {}
+      oid_name(_oid_name)
+    {
+      reset();
+    }
+
+    // start over with the entries in result, e.g. after a refill
+    void reset() {
+      cursor = result.dir.m.begin();
+      end = result.dir.m.end();
+      if (cursor != end) {
+	last_key = result.dir.m.rbegin()->second.key;
+      }
+    }
 
     inline const std::string& entry_name() const {
       return cursor->first;
@@ -8470,6 +8782,30 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
     }
   };
 
+  // list the next entries of a truncated shard which ran out, so the
+  // merge can go on without listing all of the other shards again; the
+  // window is cut to what is left to return
+  uint32_t count = 0; // entries returned so far
+  uint32_t refills = 0;
+  auto refill = [&](ShardTracker& t) {
+    map<int, string> oids{{int(t.shard_idx), t.oid_name}};
+    map<int, rgw_cls_list_ret> results;
+    const uint32_t num = std::min(num_entries_per_shard, num_entries - count);
+    int r = CLSRGWIssueBucketList(ioctx, t.last_key, prefix, delimiter,
+				  num, list_versions, oids, results, 1)();
+    if (r < 0) {
+      return r;
+    }
+    t.result = std::move(results[t.shard_idx]);
+    t.reset();
+    *cls_filtered = *cls_filtered && t.result.cls_filtered;
+    ++refills;
+    ldpp_dout(dpp, 20) << "RGWRados::cls_bucket_list_ordered: refilled shard " <<
+      t.shard_idx << " after " << t.last_key << " with " <<
+      t.result.dir.m.size() << " entries" << dendl;
+    return 0;
+  };
+
   // one tracker per shard requested (may not be all shards)
   std::vector<ShardTracker> results_trackers;
   results_trackers.reserve(shard_list_results.size());
@@ -8501,8 +8837,9 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
 
   rgw_bucket_dir_entry*
     last_entry_visited = nullptr; // to set last_entry (marker)
+  // a skipped entry lives in its shard's results, which a refill replaces
+  rgw_bucket_dir_entry last_entry_skipped;
   map<string, bufferlist> updates;
-  uint32_t count = 0;
   while (count < num_entries && !candidates.empty()) {
     r = 0;
     // select the next entry in lexical order (first key in map);
@@ -8548,7 +8885,9 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
       last_entry_visited = &it->second;
       if (inserted) {
 	++count;
-      } else {
+      } else if (!it->second.is_common_prefix()) {
+	// a common prefix spanning several shards is listed again by a
+	// refilled shard
 	ldpp_dout(dpp, 0) << "WARNING: RGWRados::" << __func__ <<
 	  ": reassigned map value at \"" << name <<
 	  "\", which should not happen" << dendl;
@@ -8556,7 +8895,8 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
     } else {
       ldpp_dout(dpp, 10) << "RGWRados::" << __func__ << ": skipping " <<
 	dirent.key.name << "[" << dirent.key.instance << "]" << dendl;
-      last_entry_visited = &tracker.dir_entry();
+      last_entry_skipped.key = dirent.key;
+      last_entry_visited = &last_entry_skipped;
     }
 
     // refresh the candidates map
@@ -8565,12 +8905,19 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
 
     next_candidate(cct, tracker, candidates, tracker_idx);
 
-    if (tracker.at_end() && tracker.is_truncated()) {
-      // once we exhaust one shard that is truncated, we need to stop,
-      // as we cannot be certain that one of the next entries needs to
-      // come from that shard; S3 and swift protocols allow returning
-      // fewer than what was requested
-      break;
+    if (tracker.at_end() && tracker.is_truncated() && count < num_entries) {
+      // one of the next entries may come from this shard, so we need
+      // more of it before going on
+      r = refill(tracker);
+      if (r < 0) {
+	return r;
+      }
+      next_candidate(cct, tracker, candidates, tracker_idx);
+      if (tracker.at_end() && tracker.is_truncated()) {
+	// no progress on this shard, so stop here; S3 and swift
+	// protocols allow returning fewer than what was requested
+	break;
+      }
     }
   } // while we haven't provided requested # of result entries
 
@@ -8599,7 +8946,7 @@ int RGWRados::cls_bucket_list_ordered(const DoutPrefixProvider *dpp,
 
   ldpp_dout(dpp, 20) << "RGWRados::" << __func__ <<
     ": returning, count=" << count << ", is_truncated=" << *is_truncated <<
-    dendl;
+    ", refills=" << refills << dendl;
 
   if (*is_truncated && count < num_entries) {
     ldpp_dout(dpp, 10) << "RGWRados::" << __func__ <<
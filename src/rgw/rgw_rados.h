@@ -26,6 +26,7 @@
 #include "rgw_trim_bilog.h"
 #include "rgw_service.h"
 #include "rgw_sal.h"
+#include "rgw_stripe_cache.h"
 
 #include "services/svc_rados.h"
 #include "services/svc_bi_rados.h"
@@ -144,6 +145,35 @@ public:
   virtual ~RGWGetDataCB() {}
 };
 
+/* readahead of a GET: the window of reads in flight follows the rate at
+ * which the client takes the data times the latency of the reads, between
+ * rgw_get_obj_window_size and rgw_get_obj_max_window_size */
+class RGWGetObjWindow {
+  uint64_t min_window;
+  uint64_t max_window;
+  uint64_t window;
+  ceph::mono_time start;
+  uint64_t delivered = 0;
+  ceph::timespan latency = ceph::timespan::zero(); // moving average
+
+public:
+  RGWGetObjWindow(uint64_t min, uint64_t max,
+                  ceph::mono_time start = ceph::mono_clock::now())
+    : min_window(min), max_window(std::max(min, max)), window(min),
+      start(start) {}
+
+  uint64_t get() const { return window; }
+
+  void add_latency(ceph::timespan lat) {
+    latency = (latency == ceph::timespan::zero()) ? lat : (latency * 7 + lat) / 8;
+  }
+
+  void add_delivered(uint64_t len) { delivered += len; }
+
+  /* returns whether the window changed */
+  bool adapt(ceph::mono_time now);
+};
+
 struct RGWCloneRangeInfo {
   rgw_obj src;
   off_t src_ofs;
@@ -346,6 +376,7 @@ class RGWGetUserHeader_CB;
 namespace rgw { namespace sal {
   class Store;
   class RadosStore;
+  class Bucket;
   class MPRadosSerializer;
   class LCRadosSerializer;
 } }
@@ -560,6 +591,8 @@ public:
 
   RGWCtl *pctl{nullptr};
 
+  RGWStripeCache stripe_cache; // tail object reads shared by GETs
+
   /**
    * AmazonS3 errors contain a HostId string, but is an opaque base64 blob; we
    * try to be more transparent. This has a wrapper so we can update it when zonegroup/zone are changed.
@@ -1447,7 +1480,10 @@ public:
   bool process_expire_objects(const DoutPrefixProvider *dpp);
   int defer_gc(const DoutPrefixProvider *dpp, void *ctx, const RGWBucketInfo& bucket_info, const rgw_obj& obj, optional_yield y);
 
-  int process_lc();
+  /* with a bucket, processes the lifecycle of that bucket only, and counts
+   * the objects listed and the actions applied */
+  int process_lc(rgw::sal::Bucket* bucket = nullptr,
+                 uint64_t* objs_listed = nullptr, uint64_t* actions = nullptr);
   int list_lc_progress(string& marker, uint32_t max_entries,
 		       vector<rgw::sal::Lifecycle::LCEntry>& progress_map, int& index);
 
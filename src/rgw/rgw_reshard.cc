@@ -250,6 +250,128 @@ public:
   }
 }; // class BucketReshardManager
 
+static int get_target_shard(rgw::sal::RadosStore* store,
+			    const RGWBucketInfo& new_bucket_info,
+			    const cls_rgw_obj_key& cls_key,
+			    int *shard_index,
+			    const DoutPrefixProvider *dpp)
+{
+  rgw_obj_key key(cls_key);
+  rgw_obj obj(new_bucket_info.bucket, key);
+  RGWMPObj mp;
+  if (key.ns == RGW_OBJ_NS_MULTIPART && mp.from_meta(key.name)) {
+    // place the multipart .meta object on the same shard as its head object
+    obj.index_hash_source = mp.get_key();
+  }
+  int target_shard_id;
+  int ret = store->getRados()->get_target_shard_id(new_bucket_info.layout.current_index.layout.normal, obj.get_hash_object(), &target_shard_id);
+  if (ret < 0) {
+    ldpp_dout(dpp, -1) << "ERROR: get_target_shard_id() returned ret=" << ret << dendl;
+    return ret;
+  }
+  *shard_index = (target_shard_id > 0 ? target_shard_id : 0);
+  return 0;
+}
+
+static void add_stats(map<RGWObjCategory, rgw_bucket_category_stats>& stats,
+		      RGWObjCategory category,
+		      const rgw_bucket_category_stats& entry_stats,
+		      bool negate)
+{
+  // cls_rgw_bucket_update_stats() adds the deltas with unsigned
+  // arithmetic, so a negated delta subtracts
+  rgw_bucket_category_stats& target = stats[category];
+  if (negate) {
+    target.num_entries -= entry_stats.num_entries;
+    target.total_size -= entry_stats.total_size;
+    target.total_size_rounded -= entry_stats.total_size_rounded;
+    target.actual_size -= entry_stats.actual_size;
+  } else {
+    target.num_entries += entry_stats.num_entries;
+    target.total_size += entry_stats.total_size;
+    target.total_size_rounded += entry_stats.total_size_rounded;
+    target.actual_size += entry_stats.actual_size;
+  }
+}
+
+/*
+ * Copy the entries of an object once more, replacing whatever the copy
+ * pass wrote to the target shard for it: the object was modified on the
+ * source shard while its entries were being copied.
+ */
+static int recopy_entries(rgw::sal::RadosStore* store,
+			  const RGWBucketInfo& bucket_info,
+			  int source_shard,
+			  const RGWBucketInfo& new_bucket_info,
+			  int target_shard,
+			  const string& name,
+			  int max_entries,
+			  const DoutPrefixProvider *dpp)
+{
+  RGWRados::BucketShard target_bs(store->getRados());
+  int ret = target_bs.init(new_bucket_info.bucket, target_shard,
+			   new_bucket_info.layout.current_index,
+			   nullptr /* no RGWBucketInfo */, dpp);
+  if (ret < 0) {
+    return ret;
+  }
+
+  librados::ObjectWriteOperation op;
+  map<RGWObjCategory, rgw_bucket_category_stats> stats;
+  list<rgw_cls_bi_entry> entries;
+
+  // drop the stale copies first, the same keys may be written again below
+  std::set<string> stale_keys;
+  string marker;
+  bool is_truncated = true;
+  while (is_truncated) {
+    entries.clear();
+    ret = store->getRados()->bi_list(target_bs, name, marker, max_entries,
+				     &entries, &is_truncated);
+    if (ret < 0 && ret != -ENOENT) {
+      return ret;
+    }
+    for (auto& entry : entries) {
+      marker = entry.idx;
+      stale_keys.insert(entry.idx);
+      cls_rgw_obj_key cls_key;
+      RGWObjCategory category;
+      rgw_bucket_category_stats entry_stats;
+      if (entry.get_info(&cls_key, &category, &entry_stats)) {
+	add_stats(stats, category, entry_stats, true);
+      }
+    }
+  }
+  if (!stale_keys.empty()) {
+    op.omap_rm_keys(stale_keys);
+  }
+
+  marker.clear();
+  is_truncated = true;
+  while (is_truncated) {
+    entries.clear();
+    ret = store->getRados()->bi_list(dpp, bucket_info, source_shard, name,
+				     marker, max_entries, &entries,
+				     &is_truncated);
+    if (ret < 0 && ret != -ENOENT) {
+      return ret;
+    }
+    for (auto& entry : entries) {
+      marker = entry.idx;
+      store->getRados()->bi_put(op, target_bs, entry);
+      cls_rgw_obj_key cls_key;
+      RGWObjCategory category;
+      rgw_bucket_category_stats entry_stats;
+      if (entry.get_info(&cls_key, &category, &entry_stats)) {
+	add_stats(stats, category, entry_stats, false);
+      }
+    }
+  }
+  cls_rgw_bucket_update_stats(op, false, stats);
+
+  return target_bs.bucket_obj.operate(dpp, &op, null_yield);
+}
+
 RGWBucketReshard::RGWBucketReshard(rgw::sal::RadosStore* _store,
 				   const RGWBucketInfo& _bucket_info,
 				   const map<string, bufferlist>& _bucket_attrs,
@@ -539,9 +661,76 @@ int RGWBucketReshardLock::renew(const Clock::time_point& now) {
 }
 
 
+int RGWBucketReshard::replay_reshard_log(const RGWBucketInfo& new_bucket_info,
+					 int max_entries,
+					 const DoutPrefixProvider *dpp)
+{
+  const int num_source_shards =
+    (bucket_info.layout.current_index.layout.normal.num_shards > 0 ? bucket_info.layout.current_index.layout.normal.num_shards : 1);
+  const bool target_sharded =
+    new_bucket_info.layout.current_index.layout.normal.num_shards > 0;
+  uint64_t total_names = 0;
+
+  for (int i = 0; i < num_source_shards; ++i) {
+    RGWRados::BucketShard bs(store->getRados());
+    int ret = bs.init(bucket_info.bucket, i, bucket_info.layout.current_index,
+		      nullptr /* no RGWBucketInfo */, dpp);
+    if (ret < 0) {
+      return ret;
+    }
+    auto& ref = bs.bucket_obj.get_ref();
+
+    string marker;
+    bool is_truncated = true;
+    while (is_truncated) {
+      list<string> names;
+      ret = cls_rgw_reshard_log_list(ref.pool.ioctx(), ref.obj.oid, marker,
+				     max_entries, &names, &is_truncated);
+      if (ret == -EOPNOTSUPP) {
+	// the osd does not know about IN_LOGRECORD and kept blocking
+	// writes, so there is nothing to replay
+	ldpp_dout(dpp, 5) << __func__ << ": no reshard log on shard " << i <<
+	  dendl;
+	break;
+      }
+      if (ret < 0) {
+	ldpp_dout(dpp, -1) << "ERROR: " << __func__ <<
+	  ": failed to list reshard log of shard " << i << ": " <<
+	  cpp_strerror(-ret) << dendl;
+	return ret;
+      }
+
+      for (auto& name : names) {
+	marker = name;
+	int shard_index;
+	ret = get_target_shard(store, new_bucket_info, cls_rgw_obj_key(name),
+			       &shard_index, dpp);
+	if (ret < 0) {
+	  return ret;
+	}
+	ret = recopy_entries(store, bucket_info, i, new_bucket_info,
+			     (target_sharded ? shard_index : -1), name,
+			     max_entries, dpp);
+	if (ret < 0) {
+	  ldpp_dout(dpp, -1) << "ERROR: " << __func__ <<
+	    ": failed to copy entries of " << name << ": " <<
+	    cpp_strerror(-ret) << dendl;
+	  return ret;
+	}
+	++total_names;
+      }
+    }
+  }
+
+  ldpp_dout(dpp, 10) << __func__ << ": copied " << total_names <<
+    " objects modified during the reshard once more" << dendl;
+  return 0;
+}
+
 int RGWBucketReshard::do_reshard(int num_shards,
 				 RGWBucketInfo& new_bucket_info,
 				 int max_entries,
+				 bool log_writes,
 				 bool verbose,
 				 ostream *out,
 				 Formatter *formatter,
@@ -619,26 +808,17 @@ int RGWBucketReshard::do_reshard(int num_shards,
 
 	marker = entry.idx;
 
-	int target_shard_id;
 	cls_rgw_obj_key cls_key;
 	RGWObjCategory category;
 	rgw_bucket_category_stats stats;
 	bool account = entry.get_info(&cls_key, &category, &stats);
-	rgw_obj_key key(cls_key);
-	rgw_obj obj(new_bucket_info.bucket, key);
-	RGWMPObj mp;
-	if (key.ns == RGW_OBJ_NS_MULTIPART && mp.from_meta(key.name)) {
-	  // place the multipart .meta object on the same shard as its head object
-	  obj.index_hash_source = mp.get_key();
-	}
-	int ret = store->getRados()->get_target_shard_id(new_bucket_info.layout.current_index.layout.normal, obj.get_hash_object(), &target_shard_id);
+	int shard_index;
+	int ret = get_target_shard(store, new_bucket_info, cls_key,
+				   &shard_index, dpp);
 	if (ret < 0) {
-	  ldpp_dout(dpp, -1) << "ERROR: get_target_shard_id() returned ret=" << ret << dendl;
 	  return ret;
 	}
 
-	int shard_index = (target_shard_id > 0 ? target_shard_id : 0);
-
 	ret = target_shards_mgr.add_entry(shard_index, entry, account,
 					  category, stats);
 	if (ret < 0) {
@@ -684,6 +864,20 @@ int RGWBucketReshard::do_reshard(int num_shards,
     return -EIO;
   }
 
+  if (log_writes) {
+    // writes were accepted during the copy; block them now, and copy
+    // the objects they touched once more
+    ret = set_resharding_status(dpp, new_bucket_info.bucket.bucket_id,
+				num_shards, cls_rgw_reshard_status::IN_PROGRESS);
+    if (ret < 0) {
+      return ret;
+    }
+    ret = replay_reshard_log(new_bucket_info, max_entries, dpp);
+    if (ret < 0) {
+      return ret;
+    }
+  }
+
   ret = store->ctl()->bucket->link_bucket(new_bucket_info.owner, new_bucket_info.bucket, bucket_info.creation_time, null_yield, dpp);
   if (ret < 0) {
     ldpp_dout(dpp, -1) << "failed to link new bucket instance (bucket_id=" << new_bucket_info.bucket.bucket_id << ": " << cpp_strerror(-ret) << ")" << dendl;
@@ -717,6 +911,7 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
   }
 
   RGWBucketInfo new_bucket_info;
+  bool log_writes;
   ret = create_new_bucket_instance(num_shards, new_bucket_info, dpp);
   if (ret < 0) {
     // shard state is uncertain, but this will attempt to remove them anyway
@@ -731,9 +926,14 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
   }
 
   // set resharding status of current bucket_info & shards with
-  // information about planned resharding
+  // information about planned resharding; with rgw_reshard_log_writes
+  // the index shards keep accepting writes until the entries are copied
+  log_writes = store->ctx()->_conf.get_val<bool>("rgw_reshard_log_writes");
   ret = set_resharding_status(dpp, new_bucket_info.bucket.bucket_id,
-			      num_shards, cls_rgw_reshard_status::IN_PROGRESS);
+			      num_shards,
+			      (log_writes ?
+			       cls_rgw_reshard_status::IN_LOGRECORD :
+			       cls_rgw_reshard_status::IN_PROGRESS));
   if (ret < 0) {
     goto error_out;
   }
@@ -741,6 +941,7 @@ int RGWBucketReshard::execute(int num_shards, int max_op_entries,
   ret = do_reshard(num_shards,
 		   new_bucket_info,
 		   max_op_entries,
+		   log_writes,
                    verbose, out, formatter, dpp);
   if (ret < 0) {
     goto error_out;
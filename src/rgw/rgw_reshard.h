@@ -87,9 +87,13 @@ private:
   int create_new_bucket_instance(int new_num_shards,
 				 RGWBucketInfo& new_bucket_info,
                                  const DoutPrefixProvider *dpp);
+  int replay_reshard_log(const RGWBucketInfo& new_bucket_info,
+			 int max_entries,
+			 const DoutPrefixProvider *dpp);
   int do_reshard(int num_shards,
 		 RGWBucketInfo& new_bucket_info,
 		 int max_entries,
+		 bool log_writes,
                  bool verbose,
                  ostream *os,
 		 Formatter *formatter,
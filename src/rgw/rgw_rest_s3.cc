@@ -431,7 +431,11 @@ done:
 
 send_data:
   if (get_data && !op_ret) {
-    int r = dump_body(s, bl.c_str() + bl_ofs, bl_len);
+    /* hands the buffers the data was read into to the front-end, rather than
+     * flattening them with c_str() */
+    bufferlist data;
+    data.substr_of(bl, bl_ofs, bl_len);
+    int r = dump_body(s, data);
     if (r < 0)
       return r;
   }
@@ -2587,7 +2591,10 @@ int RGWPutObj_ObjStore_S3::get_encrypt_filter(
        * We use crypto mode that configured as if we were decrypting. */
       res = rgw_s3_prepare_decrypt(s, obj->get_attrs(), &block_crypt, crypt_http_responses);
       if (res == 0 && block_crypt != nullptr)
-        filter->reset(new RGWPutObj_BlockEncrypt(s->cct, cb, std::move(block_crypt)));
+        filter->reset(new RGWPutObj_BlockEncrypt(s->cct, cb, std::move(block_crypt),
+                                                 rgw::putobj::get_offload_pool(s->cct),
+                                                 s->cct->_conf.get_val<uint64_t>("rgw_put_obj_offload_window"),
+                                                 s->yield));
     }
     /* it is ok, to not have encryption at all */
   }
@@ -2596,7 +2603,10 @@ int RGWPutObj_ObjStore_S3::get_encrypt_filter(
     std::unique_ptr<BlockCrypt> block_crypt;
     res = rgw_s3_prepare_encrypt(s, attrs, nullptr, &block_crypt, crypt_http_responses);
     if (res == 0 && block_crypt != nullptr) {
-      filter->reset(new RGWPutObj_BlockEncrypt(s->cct, cb, std::move(block_crypt)));
+      filter->reset(new RGWPutObj_BlockEncrypt(s->cct, cb, std::move(block_crypt),
+                                               rgw::putobj::get_offload_pool(s->cct),
+                                               s->cct->_conf.get_val<uint64_t>("rgw_put_obj_offload_window"),
+                                               s->yield));
     }
   }
   return res;
@@ -830,6 +830,13 @@ public:
   virtual int rm_entry(const std::string& oid, const LCEntry& entry) = 0;
   virtual int get_head(const std::string& oid, LCHead& head) = 0;
   virtual int put_head(const std::string& oid, const LCHead& head) = 0;
+  /* the markers at which the processing of the parts of a bucket resumes,
+   * kept while a bucket is only partly processed */
+  virtual int get_progress(const std::string& bucket,
+			   std::map<std::string, bufferlist>& markers) = 0;
+  virtual int set_progress(const std::string& bucket,
+			   const std::map<std::string, bufferlist>& markers) = 0;
+  virtual int rm_progress(const std::string& bucket) = 0;
 
   virtual LCSerializer* get_serializer(const std::string& lock_name, const std::string& oid, const std::string& cookie) = 0;
 };
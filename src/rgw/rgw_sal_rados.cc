@@ -1904,6 +1904,47 @@ int RadosLifecycle::put_head(const std::string& oid, const LCHead& head)
   return cls_rgw_lc_put_head(*store->getRados()->get_lc_pool_ctx(), oid, cls_head);
 }
 
+static std::string lc_progress_oid(const std::string& bucket)
+{
+  return "lc_progress." + bucket;
+}
+
+int RadosLifecycle::get_progress(const std::string& bucket,
+				 std::map<std::string, bufferlist>& markers)
+{
+  markers.clear();
+
+  librados::ObjectReadOperation op;
+  int rval = 0;
+  op.omap_get_vals2("", std::numeric_limits<uint64_t>::max(), &markers,
+		    nullptr, &rval);
+  int ret = store->getRados()->get_lc_pool_ctx()->operate(
+    lc_progress_oid(bucket), &op, nullptr);
+  if (ret == -ENOENT) {
+    return 0;
+  }
+  return ret;
+}
+
+int RadosLifecycle::set_progress(const std::string& bucket,
+				 const std::map<std::string, bufferlist>& markers)
+{
+  librados::ObjectWriteOperation op;
+  op.omap_clear();
+  op.omap_set(markers);
+  return store->getRados()->get_lc_pool_ctx()->operate(
+    lc_progress_oid(bucket), &op);
+}
+
+int RadosLifecycle::rm_progress(const std::string& bucket)
+{
+  int ret = store->getRados()->get_lc_pool_ctx()->remove(lc_progress_oid(bucket));
+  if (ret == -ENOENT) {
+    return 0;
+  }
+  return ret;
+}
+
 LCSerializer* RadosLifecycle::get_serializer(const std::string& lock_name, const std::string& oid, const std::string& cookie)
 {
   return new LCRadosSerializer(store, oid, lock_name, cookie);
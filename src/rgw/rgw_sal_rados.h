@@ -529,6 +529,11 @@ public:
   virtual int rm_entry(const std::string& oid, const LCEntry& entry) override;
   virtual int get_head(const std::string& oid, LCHead& head) override;
   virtual int put_head(const std::string& oid, const LCHead& head) override;
+  virtual int get_progress(const std::string& bucket,
+			   std::map<std::string, bufferlist>& markers) override;
+  virtual int set_progress(const std::string& bucket,
+			   const std::map<std::string, bufferlist>& markers) override;
+  virtual int rm_progress(const std::string& bucket) override;
   virtual LCSerializer* get_serializer(const std::string& lock_name, const std::string& oid, const std::string& cookie) override;
 };
 
@@ -261,10 +261,11 @@ void RGWServices_Def::shutdown()
 
   sysobj->shutdown();
   sysobj_core->shutdown();
-  notify->shutdown();
+  // before notify, which sends the cache updates still queued
   if (sysobj_cache) {
     sysobj_cache->shutdown();
   }
+  notify->shutdown();
   quota->shutdown();
   zone_utils->shutdown();
   zone->shutdown();
@@ -0,0 +1,77 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#include "rgw_stripe_cache.h"
+#include "rgw_perf_counters.h"
+
+void RGWStripeCache::trim(uint64_t max)
+{
+  while (size > max && !lru.empty()) {
+    auto iter = entries.find(lru.back());
+    size -= iter->second.data.length();
+    entries.erase(iter);
+    lru.pop_back();
+  }
+}
+
+void RGWStripeCache::set_max_size(uint64_t max)
+{
+  std::lock_guard l{lock};
+  max_size = max;
+  trim(max_size);
+}
+
+bool RGWStripeCache::get(const rgw_raw_obj& obj, uint64_t ofs, uint64_t len,
+			 bufferlist& bl)
+{
+  std::lock_guard l{lock};
+  /* the last range starting at or before ofs */
+  auto iter = entries.upper_bound(key_type{obj, ofs});
+  if (iter == entries.begin() || !(std::prev(iter)->first.first == obj)) {
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_stripe_cache_miss);
+    }
+    return false;
+  }
+  --iter;
+  const uint64_t start = iter->first.second;
+  auto& entry = iter->second;
+  if (ofs + len > start + entry.data.length()) {
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_stripe_cache_miss);
+    }
+    return false;
+  }
+  bl.substr_of(entry.data, ofs - start, len);
+  lru.splice(lru.begin(), lru, entry.lru_iter);
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_stripe_cache_hit);
+  }
+  return true;
+}
+
+void RGWStripeCache::put(const rgw_raw_obj& obj, uint64_t ofs,
+			 const bufferlist& bl)
+{
+  std::lock_guard l{lock};
+  if (bl.length() == 0 || bl.length() > max_size) {
+    return;
+  }
+  key_type key{obj, ofs};
+  auto [iter, inserted] = entries.try_emplace(key);
+  auto& entry = iter->second;
+  if (inserted) {
+    lru.push_front(key);
+    entry.lru_iter = lru.begin();
+  } else {
+    if (entry.data.length() >= bl.length()) {
+      /* already holds the range */
+      return;
+    }
+    size -= entry.data.length();
+    lru.splice(lru.begin(), lru, entry.lru_iter);
+  }
+  entry.data = bl;
+  size += bl.length();
+  trim(max_size);
+}
@@ -0,0 +1,56 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+#ifndef CEPH_RGW_STRIPE_CACHE_H
+#define CEPH_RGW_STRIPE_CACHE_H
+
+#include <list>
+#include <map>
+#include <utility>
+
+#include "include/types.h"
+#include "common/ceph_mutex.h"
+#include "rgw_common.h"
+
+/* Recently read ranges of tail objects, which lets concurrent GETs of the
+ * same object, e.g. the parallel range GETs of a download manager, share
+ * the stripes one of them read. Tail objects are written once, under a
+ * unique prefix, so their data is never stale. The size is bounded by
+ * rgw_get_obj_stripe_cache_size, 0 disables the cache. */
+class RGWStripeCache {
+  using key_type = std::pair<rgw_raw_obj, uint64_t>; // object, offset
+
+  struct Entry {
+    bufferlist data;
+    std::list<key_type>::iterator lru_iter;
+  };
+
+  ceph::mutex lock = ceph::make_mutex("RGWStripeCache");
+  std::map<key_type, Entry> entries;
+  std::list<key_type> lru; // most recently used at the front
+  uint64_t size = 0;
+  uint64_t max_size = 0;
+
+  void trim(uint64_t max);
+
+public:
+  void set_max_size(uint64_t max);
+
+  bool enabled() const {
+    return max_size > 0;
+  }
+
+  /* fills @bl with @len bytes at @ofs of @obj, if a cached range holds
+   * them all */
+  bool get(const rgw_raw_obj& obj, uint64_t ofs, uint64_t len, bufferlist& bl);
+
+  /* shares the buffers of @bl, read at @ofs of @obj */
+  void put(const rgw_raw_obj& obj, uint64_t ofs, const bufferlist& bl);
+
+  uint64_t get_size() {
+    std::lock_guard l{lock};
+    return size;
+  }
+};
+
+#endif
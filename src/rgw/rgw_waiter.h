@@ -0,0 +1,82 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab ft=cpp
+
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "common/async/completion.h"
+#include "common/async/yield_context.h"
+#include "common/ceph_mutex.h"
+
+namespace rgw {
+
+// waits for a condition made true by other threads. a coroutine is
+// suspended until notified, other callers block on a condition variable
+class Waiter {
+  using Completion = ceph::async::Completion<void(boost::system::error_code)>;
+  ceph::condition_variable cond;
+  std::unique_ptr<Completion> completion;
+
+  template <typename CompletionToken>
+  auto async_wait(boost::asio::io_context& context,
+                  std::unique_lock<ceph::mutex>& l, CompletionToken&& token);
+ public:
+  // called with 'l' locked, returns with it locked
+  template <typename Pred>
+  void wait(std::unique_lock<ceph::mutex>& l, optional_yield y, Pred ready);
+  // called with the lock held
+  void notify();
+};
+
+template <typename CompletionToken>
+auto Waiter::async_wait(boost::asio::io_context& context,
+                        std::unique_lock<ceph::mutex>& l,
+                        CompletionToken&& token)
+{
+  using boost::asio::async_completion;
+  using Signature = void(boost::system::error_code);
+  async_completion<CompletionToken, Signature> init(token);
+  completion = Completion::create(context.get_executor(),
+                                  std::move(init.completion_handler));
+  // a notify() from here on posts the completion, which resumes the
+  // coroutine once it is suspended
+  l.unlock();
+  return init.result.get();
+}
+
+template <typename Pred>
+void Waiter::wait(std::unique_lock<ceph::mutex>& l, optional_yield y,
+                  Pred ready)
+{
+  if (!y) {
+    cond.wait(l, std::move(ready));
+    return;
+  }
+  while (!ready()) {
+    ceph_assert(!completion);
+    boost::system::error_code ec;
+    async_wait(y.get_io_context(), l, y.get_yield_context()[ec]);
+    l.lock();
+  }
+}
+
+inline void Waiter::notify()
+{
+  cond.notify_all();
+  if (completion) {
+    ceph::async::post(std::move(completion), boost::system::error_code{});
+  }
+}
+
+} // namespace rgw
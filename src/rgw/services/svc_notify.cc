@@ -159,10 +159,17 @@ string RGWSI_Notify::get_control_oid(int i)
 // do not call pick_obj_control before init_watch
 RGWSI_RADOS::Obj RGWSI_Notify::pick_control_obj(const string& key)
 {
+  return notify_objs[control_obj_index(key)];
+}
+
+int RGWSI_Notify::control_obj_index(const string& key) const
+{
+  if (num_watchers <= 0) {
+    return -1;
+  }
   uint32_t r = ceph_str_hash_linux(key.c_str(), key.size());
 
-  int i = r % num_watchers;
-  return notify_objs[i];
+  return r % num_watchers;
 }
 
 int RGWSI_Notify::init_watch(const DoutPrefixProvider *dpp, optional_yield y)
@@ -99,6 +99,9 @@ public:
   };
 
   int distribute(const DoutPrefixProvider *dpp, const string& key, bufferlist& bl, optional_yield y);
+  // the index of the control object the notifications for 'key' are sent
+  // to, or -1 before the watches are set up
+  int control_obj_index(const string& key) const;
 
   void register_watch_cb(CB *cb);
 };
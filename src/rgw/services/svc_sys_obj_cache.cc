@@ -3,6 +3,7 @@
 // vim: ts=8 sw=2 smarttab ft=cpp
 
 #include "common/admin_socket.h"
+#include "common/Thread.h"
 
 #include "svc_sys_obj_cache.h"
 #include "svc_zone.h"
@@ -10,6 +11,7 @@
 
 #include "rgw/rgw_zone.h"
 #include "rgw/rgw_tools.h"
+#include "rgw/rgw_perf_counters.h"
 
 #define dout_subsys ceph_subsys_rgw
 
@@ -54,11 +56,24 @@ int RGWSI_SysObj_Cache::do_start(optional_yield y, const DoutPrefixProvider *dpp
 
   notify_svc->register_watch_cb(cb.get());
 
+  if (notify_batch_window_ms > 0) {
+    batch_thread = make_named_thread("rgw_cache_ntfy",
+				     &RGWSI_SysObj_Cache::notify_batch_run, this);
+  }
+
   return 0;
 }
 
 void RGWSI_SysObj_Cache::shutdown()
 {
+  if (batch_thread.joinable()) {
+    {
+      std::lock_guard l{batch_lock};
+      batch_stopping = true;
+    }
+    batch_cond.notify_all();
+    batch_thread.join();
+  }
   asocket.shutdown();
   RGWSI_SysObj_Core::shutdown();
 }
@@ -430,11 +445,71 @@ int RGWSI_SysObj_Cache::distribute_cache(const DoutPrefixProvider *dpp,
   info.op = op;
   info.obj_info = obj_info;
   info.obj = obj;
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_cache_notify_updates);
+  }
+  if (batch_thread.joinable()) {
+    int index = notify_svc->control_obj_index(normal_name);
+    if (index >= 0) {
+      queue_notify(index, normal_name, std::move(info));
+      return 0;
+    }
+  }
   bufferlist bl;
   encode(info, bl);
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_cache_notify_sent);
+  }
   return notify_svc->distribute(dpp, normal_name, bl, y);
 }
 
+void RGWSI_SysObj_Cache::queue_notify(int index, const string& normal_name,
+                                      RGWCacheNotifyInfo&& info)
+{
+  std::lock_guard l{batch_lock};
+  size_t dropped = notify_batches[index].add(normal_name, std::move(info));
+  if (dropped && perfcounter) {
+    perfcounter->inc(l_rgw_cache_notify_coalesced, dropped);
+  }
+}
+
+void RGWSI_SysObj_Cache::flush_notify_batches(const DoutPrefixProvider *dpp)
+{
+  std::map<int, RGWCacheNotifyBatch> batches;
+  {
+    std::lock_guard l{batch_lock};
+    batches.swap(notify_batches);
+  }
+  for (auto& [index, batch] : batches) {
+    RGWCacheNotifyInfo info = batch.make_notify();
+    bufferlist bl;
+    encode(info, bl);
+    ldpp_dout(dpp, 20) << "distributing " << info.batch.size()
+        << " cache updates to control object " << index << dendl;
+    if (perfcounter) {
+      perfcounter->inc(l_rgw_cache_notify_sent);
+    }
+    int r = notify_svc->distribute(dpp, batch.key, bl, null_yield);
+    if (r < 0) {
+      ldpp_dout(dpp, 0) << "ERROR: " << __func__ << "(): failed to distribute cache: r=" << r << dendl;
+    }
+  }
+}
+
+void RGWSI_SysObj_Cache::notify_batch_run()
+{
+  NoDoutPrefix dpp(cct, dout_subsys);
+  const auto window = std::chrono::milliseconds(notify_batch_window_ms);
+  std::unique_lock l{batch_lock};
+  while (!batch_stopping) {
+    batch_cond.wait_for(l, window, [this] { return batch_stopping; });
+    l.unlock();
+    // also sends what is queued on shutdown
+    flush_notify_batches(&dpp);
+    l.lock();
+  }
+}
+
 int RGWSI_SysObj_Cache::watch_cb(const DoutPrefixProvider *dpp,
                                  uint64_t notify_id,
                                  uint64_t cookie,
@@ -454,17 +529,19 @@ int RGWSI_SysObj_Cache::watch_cb(const DoutPrefixProvider *dpp,
     return -EIO;
   }
 
-  rgw_pool pool;
-  string oid;
-  normalize_pool_and_obj(info.obj.pool, info.obj.oid, pool, oid);
-  string name = normal_name(pool, oid);
-  
   switch (info.op) {
   case UPDATE_OBJ:
-    cache.put(dpp, name, info.obj_info, NULL);
-    break;
   case REMOVE_OBJ:
-    cache.remove(dpp, name);
+    apply_notify(dpp, info);
+    break;
+  case BATCH_OBJS:
+    for (auto& update : info.batch) {
+      if (update.op != UPDATE_OBJ && update.op != REMOVE_OBJ) {
+        ldout(cct, 0) << "WARNING: got unknown notification op in batch: " << update.op << dendl;
+        continue;
+      }
+      apply_notify(dpp, update);
+    }
     break;
   default:
     ldout(cct, 0) << "WARNING: got unknown notification op: " << info.op << dendl;
@@ -474,6 +551,24 @@ int RGWSI_SysObj_Cache::watch_cb(const DoutPrefixProvider *dpp,
   return 0;
 }
 
+void RGWSI_SysObj_Cache::apply_notify(const DoutPrefixProvider *dpp,
+                                      RGWCacheNotifyInfo& info)
+{
+  rgw_pool pool;
+  string oid;
+  normalize_pool_and_obj(info.obj.pool, info.obj.oid, pool, oid);
+  string name = normal_name(pool, oid);
+
+  if (perfcounter) {
+    perfcounter->inc(l_rgw_cache_notify_received);
+  }
+  if (info.op == UPDATE_OBJ) {
+    cache.put(dpp, name, info.obj_info, NULL);
+  } else {
+    cache.remove(dpp, name);
+  }
+}
+
 void RGWSI_SysObj_Cache::set_enabled(bool status)
 {
   cache.set_enabled(status);
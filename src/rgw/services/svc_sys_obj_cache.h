@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <thread>
+
 #include "common/RWLock.h"
 #include "rgw/rgw_service.h"
 #include "rgw/rgw_cache.h"
@@ -25,6 +27,17 @@ class RGWSI_SysObj_Cache : public RGWSI_SysObj_Core
 
   std::shared_ptr<RGWSI_SysObj_Cache_CB> cb;
 
+  const uint64_t notify_batch_window_ms;
+  ceph::mutex batch_lock = ceph::make_mutex("RGWSI_SysObj_Cache::batch_lock");
+  ceph::condition_variable batch_cond;
+  std::map<int, RGWCacheNotifyBatch> notify_batches;
+  bool batch_stopping{false};
+  std::thread batch_thread;
+
+  void queue_notify(int index, const string& normal_name, RGWCacheNotifyInfo&& info);
+  void flush_notify_batches(const DoutPrefixProvider *dpp);
+  void notify_batch_run();
+
   void normalize_pool_and_obj(const rgw_pool& src_pool, const string& src_obj, rgw_pool& dst_pool, string& dst_obj);
 protected:
   void init(RGWSI_RADOS *_rados_svc,
@@ -96,11 +109,15 @@ protected:
                uint64_t cookie,
                uint64_t notifier_id,
                bufferlist& bl);
+  void apply_notify(const DoutPrefixProvider *dpp, RGWCacheNotifyInfo& info);
 
   void set_enabled(bool status);
 
 public:
-  RGWSI_SysObj_Cache(const DoutPrefixProvider *dpp, CephContext *cct) : RGWSI_SysObj_Core(cct), asocket(dpp, this) {
+  RGWSI_SysObj_Cache(const DoutPrefixProvider *dpp, CephContext *cct)
+    : RGWSI_SysObj_Core(cct),
+      notify_batch_window_ms(cct->_conf.get_val<uint64_t>("rgw_cache_notify_batch_window_ms")),
+      asocket(dpp, this) {
     cache.set_ctx(cct);
   }
 
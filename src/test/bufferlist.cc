@@ -2303,6 +2303,45 @@ TEST(BufferList, c_str) {
   EXPECT_EQ(0, ::memcmp("AB", bl.c_str(), 2));
 }
 
+TEST(BufferList, c_str_adjacent) {
+  bufferptr ptr(100);
+  for (unsigned i = 0; i < ptr.length(); i++) {
+    ptr[i] = i;
+  }
+  {
+    // views of the same raw, one after the other: no need to copy
+    bufferlist bl;
+    bl.push_back(bufferptr(ptr, 0, 10));
+    bl.push_back(bufferptr(ptr, 10, 20));
+    EXPECT_EQ(2u, bl.get_num_buffers());
+    EXPECT_EQ(ptr.c_str(), bl.c_str());
+    EXPECT_EQ(1u, bl.get_num_buffers());
+    EXPECT_EQ(30u, bl.length());
+  }
+  {
+    bufferlist bl;
+    bl.push_back(bufferptr(ptr, 0, 10));
+    bl.push_back(bufferptr(ptr, 20, 10));
+    EXPECT_NE(ptr.c_str(), bl.c_str());
+    EXPECT_EQ(1u, bl.get_num_buffers());
+    EXPECT_EQ(20, bl[10]);
+  }
+  {
+    // the append_buffer is resumed after a foreign ptr, which sits in
+    // between the two parts of it
+    bufferlist bl;
+    bl.append("abc", 3);
+    bufferlist other;
+    other.append("x", 1);
+    bl.append(other);
+    bl.append("def", 3);
+    EXPECT_EQ(3u, bl.get_num_buffers());
+    EXPECT_EQ(0, ::memcmp("abcxdef", bl.c_str(), 7));
+    bl.append("ghi", 3);
+    EXPECT_EQ(0, ::memcmp("abcxdefghi", bl.c_str(), 10));
+  }
+}
+
 TEST(BufferList, substr_of) {
   bufferlist bl;
   EXPECT_THROW(bl.substr_of(bl, 1, 1), buffer::end_of_buffer);
@@ -2884,6 +2923,141 @@ TEST(BufferList, ContiguousAppender) {
   EXPECT_EQ(bl.length(), 2u * sizeof(int64_t) + 3u);
 }
 
+TEST(BufferList, SmallContiguousAppends) {
+  // the size of a normal append_buffer
+  const unsigned append_size = [] {
+    bufferlist bl;
+    bl.obtain_contiguous_space(1);
+    return bl.get_append_buffer_unused_tail_length();
+  }();
+  ASSERT_GT(append_size, 64u * sizeof(uint64_t));
+
+  // small contiguous_appenders share an append_buffer
+  bufferlist bl;
+  for (uint64_t i = 0; i < 64; i++) {
+    auto ap = bl.get_contiguous_appender(sizeof(i));
+    denc(i, ap);
+  }
+  EXPECT_EQ(1u, bl.get_num_buffers());
+  EXPECT_EQ(64u * sizeof(uint64_t), bl.length());
+  EXPECT_GE(bl.get_append_buffer_unused_tail_length(),
+	    append_size - 64u * sizeof(uint64_t));
+  auto p = bl.cbegin();
+  for (uint64_t i = 0; i < 64; i++) {
+    uint64_t v;
+    denc(v, p);
+    EXPECT_EQ(i, v);
+  }
+  EXPECT_TRUE(p.end());
+
+  // a small request into a full list refills it with a normal-sized
+  // append_buffer
+  {
+    bufferlist full;
+    full.push_back(buffer::create(16));
+    ASSERT_EQ(0u, full.get_append_buffer_unused_tail_length());
+    auto space = full.obtain_contiguous_space(8);
+    ASSERT_NE(nullptr, space.bp_data);
+    EXPECT_EQ(2u, full.get_num_buffers());
+    EXPECT_EQ(append_size, full.get_append_buffer_unused_tail_length());
+    // the space is reserved only, nothing was appended
+    EXPECT_EQ(16u, full.length());
+  }
+
+  // large ones get a buffer of exactly their size
+  {
+    bufferlist big;
+    const unsigned len = append_size;
+    for (int i = 0; i < 2; i++) {
+      auto ap = big.get_contiguous_appender(len);
+      memset(ap.get_pos_add(len), 'a' + i, len);
+    }
+    EXPECT_EQ(2u, big.get_num_buffers());
+    EXPECT_EQ(0u, big.get_append_buffer_unused_tail_length());
+    EXPECT_EQ(2u * len, big.length());
+  }
+}
+
+static void bench_small_encodes(const size_t per, const size_t num)
+{
+  size_t buffers = 0;
+  utime_t start = ceph_clock_now();
+  for (size_t i = 0; i < num; i++) {
+    bufferlist bl;
+    for (size_t j = 0; j < per; j++) {
+      encode(uint64_t(j), bl);
+      encode(uint32_t(j), bl);
+    }
+    buffers += bl.get_num_buffers();
+  }
+  utime_t end = ceph_clock_now();
+  cout << num << " lists of " << per << " small denc encodes in "
+       << (end - start) << ", " << double(buffers) / num
+       << " buffers per list" << std::endl;
+}
+
+TEST(BufferList, BenchSmallEncodes) {
+  bench_small_encodes(1, 1000000);
+  bench_small_encodes(4, 1000000);
+  bench_small_encodes(16, 100000);
+  bench_small_encodes(64, 100000);
+}
+
+static void bench_segmented_decode(const size_t segment, const size_t num)
+{
+  // each segment holds a few bounded values, as a message received in
+  // many pieces would
+  bufferlist bl;
+  size_t values = 0;
+  while (values < num) {
+    bufferlist seg;
+    while (seg.length() + sizeof(uint64_t) <= segment) {
+      encode(uint64_t(values++), seg);
+    }
+    bl.append(seg);
+  }
+  utime_t start = ceph_clock_now();
+  auto p = bl.cbegin();
+  for (size_t i = 0; i < values; i++) {
+    uint64_t v;
+    decode(v, p);
+    ceph_assert(v == i);
+  }
+  utime_t end = ceph_clock_now();
+  cout << values << " bounded decodes over " << bl.get_num_buffers()
+       << " segments of " << segment << " bytes in " << (end - start)
+       << std::endl;
+}
+
+TEST(BufferList, BenchSegmentedDecode) {
+  bench_segmented_decode(64, 100000);
+  bench_segmented_decode(512, 100000);
+  bench_segmented_decode(4096, 100000);
+}
+
+static void bench_c_str_adjacent(const size_t segments, const size_t num)
+{
+  bufferptr ptr(segments * 16);
+  ptr.zero();
+  utime_t start = ceph_clock_now();
+  for (size_t i = 0; i < num; i++) {
+    bufferlist bl;
+    for (size_t j = 0; j < segments; j++) {
+      bl.push_back(bufferptr(ptr, j * 16, 16));
+    }
+    ceph_assert(bl.c_str());
+  }
+  utime_t end = ceph_clock_now();
+  cout << num << " c_str() over " << segments << " adjacent segments in "
+       << (end - start) << std::endl;
+}
+
+TEST(BufferList, BenchCStrAdjacent) {
+  bench_c_str_adjacent(2, 1000000);
+  bench_c_str_adjacent(16, 100000);
+  bench_c_str_adjacent(256, 10000);
+}
+
 TEST(BufferList, TestPtrAppend) {
   bufferlist bl;
   char correct[MAX_TEST];
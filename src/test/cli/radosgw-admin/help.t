@@ -123,7 +123,8 @@
                                --include-all to process all entries, including unexpired)
     lc list                    list all bucket lifecycle progress
     lc get                     get a lifecycle bucket configuration
-    lc process                 manually process lifecycle
+    lc process                 manually process lifecycle, of a single bucket
+                               with --bucket, reporting its throughput
     lc reshard fix             fix LC for a resharded bucket
     metadata get               get metadata info
     metadata put               put metadata info
@@ -1140,3 +1140,263 @@ TEST_F(cls_rgw, bi_log_trim)
     EXPECT_FALSE(truncated);
   }
 }
+
+TEST_F(cls_rgw, reshard_log_record)
+{
+  string bucket_oid = str_int("bucket", 8);
+
+  ObjectWriteOperation op;
+  cls_rgw_bucket_init_index(op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+
+  uint64_t obj_size = 1024;
+  auto write_obj = [&] (int i) {
+    cls_rgw_obj_key obj = str_int("obj", i);
+    string tag = str_int("tag", i);
+    string loc = str_int("loc", i);
+    index_prepare(ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, obj, loc);
+    rgw_bucket_dir_entry_meta meta;
+    meta.category = RGWObjCategory::None;
+    meta.size = obj_size;
+    index_complete(ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, 1, obj, meta);
+  };
+  auto guarded_write = [&] (int i) {
+    ObjectWriteOperation op;
+    cls_rgw_guard_bucket_resharding(op, -EBUSY);
+    rgw_zone_set zones_trace;
+    string tag = str_int("tag", i);
+    cls_rgw_bucket_prepare_op(op, CLS_RGW_OP_ADD, tag, str_int("obj", i),
+                              str_int("loc", i), true, 0, zones_trace);
+    return ioctx.operate(bucket_oid, &op);
+  };
+  auto list_log = [&] {
+    list<string> names;
+    bool truncated{false};
+    EXPECT_EQ(0, cls_rgw_reshard_log_list(ioctx, bucket_oid, "", 128,
+                                          &names, &truncated));
+    EXPECT_FALSE(truncated);
+    return names;
+  };
+
+  // not recorded before resharding starts
+  write_obj(0);
+  EXPECT_TRUE(list_log().empty());
+
+  cls_rgw_bucket_instance_entry entry;
+  entry.set_status("new_instance", 3, cls_rgw_reshard_status::IN_LOGRECORD);
+  ASSERT_EQ(0, cls_rgw_set_bucket_resharding(ioctx, bucket_oid, entry));
+
+  // writes are accepted, and recorded
+  ASSERT_EQ(0, guarded_write(1));
+  write_obj(2);
+  write_obj(2);
+  EXPECT_EQ(list<string>({str_int("obj", 1), str_int("obj", 2)}), list_log());
+  test_stats(ioctx, bucket_oid, RGWObjCategory::None, 2, obj_size * 2);
+
+  // the log is not part of the entries copied by resharding
+  {
+    list<rgw_cls_bi_entry> entries;
+    bool truncated{false};
+    ASSERT_EQ(0, cls_rgw_bi_list(ioctx, bucket_oid, "", "", 128,
+                                 &entries, &truncated));
+    EXPECT_EQ(3u, entries.size());
+  }
+
+  // writes are blocked once the log is being replayed, which keeps it
+  entry.set_status("new_instance", 3, cls_rgw_reshard_status::IN_PROGRESS);
+  ASSERT_EQ(0, cls_rgw_set_bucket_resharding(ioctx, bucket_oid, entry));
+  ASSERT_EQ(-EBUSY, guarded_write(3));
+  EXPECT_EQ(2u, list_log().size());
+
+  ASSERT_EQ(0, cls_rgw_clear_bucket_resharding(ioctx, bucket_oid));
+  EXPECT_TRUE(list_log().empty());
+  ASSERT_EQ(0, guarded_write(3));
+  EXPECT_TRUE(list_log().empty());
+}
+
+TEST_F(cls_rgw, reshard_log_record_olh)
+{
+  string bucket_oid = str_int("bucket", 10);
+
+  ObjectWriteOperation op;
+  cls_rgw_bucket_init_index(op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+
+  // a versioned object, linked at epoch 5
+  const cls_rgw_obj_key obj{"vobj", "v1"};
+  const cls_rgw_obj_key olh_key{"vobj"};
+  string tag = "tag1";
+  string loc;
+  index_prepare(ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, obj, loc);
+  rgw_bucket_dir_entry_meta meta;
+  meta.category = RGWObjCategory::None;
+  meta.size = 1024;
+  index_complete(ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, 5, obj, meta);
+
+  auto list_log = [&] {
+    list<string> names;
+    bool truncated{false};
+    EXPECT_EQ(0, cls_rgw_reshard_log_list(ioctx, bucket_oid, "", 128,
+                                          &names, &truncated));
+    return names;
+  };
+  auto start_logging = [&] {
+    ASSERT_EQ(0, cls_rgw_clear_bucket_resharding(ioctx, bucket_oid));
+    cls_rgw_bucket_instance_entry entry;
+    entry.set_status("new_instance", 3, cls_rgw_reshard_status::IN_LOGRECORD);
+    ASSERT_EQ(0, cls_rgw_set_bucket_resharding(ioctx, bucket_oid, entry));
+    ASSERT_TRUE(list_log().empty());
+  };
+  const list<string> expected{"vobj"};
+
+  // a link with an older epoch still writes the instance entry
+  start_logging();
+  {
+    ObjectWriteOperation op;
+    cls_rgw_guard_bucket_resharding(op, -EBUSY);
+    bufferlist olh_tag;
+    olh_tag.append(tag);
+    rgw_zone_set zones_trace;
+    cls_rgw_bucket_link_olh(op, obj, olh_tag, false, tag, &meta, 1,
+                            ceph::real_time{}, true, true, zones_trace);
+    ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+  }
+  EXPECT_EQ(expected, list_log());
+
+  // trimming the olh log
+  start_logging();
+  {
+    ObjectWriteOperation op;
+    cls_rgw_guard_bucket_resharding(op, -EBUSY);
+    cls_rgw_trim_olh_log(op, olh_key, 5, tag);
+    ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+  }
+  EXPECT_EQ(expected, list_log());
+
+  // an unlink with an older epoch still removes the list entry
+  start_logging();
+  {
+    ObjectWriteOperation op;
+    cls_rgw_guard_bucket_resharding(op, -EBUSY);
+    rgw_zone_set zones_trace;
+    cls_rgw_bucket_unlink_instance(op, obj, "tag2", tag, 2, true,
+                                   zones_trace);
+    ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+  }
+  EXPECT_EQ(expected, list_log());
+
+  ASSERT_EQ(0, cls_rgw_clear_bucket_resharding(ioctx, bucket_oid));
+  EXPECT_TRUE(list_log().empty());
+}
+
+static rgw_cls_obj_complete_op make_complete_op(librados::IoCtx& ioctx,
+                                                RGWModifyOp index_op,
+                                                const string& tag, int epoch,
+                                                const cls_rgw_obj_key& key,
+                                                uint64_t size)
+{
+  rgw_cls_obj_complete_op call;
+  call.op = index_op;
+  call.tag = tag;
+  call.key = key;
+  call.ver.pool = ioctx.get_id();
+  call.ver.epoch = epoch;
+  call.meta.category = RGWObjCategory::None;
+  call.meta.size = size;
+  call.meta.accounted_size = size;
+  call.log_op = true;
+  return call;
+}
+
+TEST_F(cls_rgw, index_complete_batch)
+{
+  string bucket_oid = str_int("bucket", 9);
+
+  ObjectWriteOperation op;
+  cls_rgw_bucket_init_index(op);
+  ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+
+  uint64_t obj_size = 1024;
+  const int num_objs = 10;
+
+  std::vector<rgw_cls_obj_complete_op> ops;
+  for (int i = 0; i < num_objs; i++) {
+    cls_rgw_obj_key obj = str_int("obj", i);
+    string tag = str_int("tag", i);
+    string loc = str_int("loc", i);
+    index_prepare(ioctx, bucket_oid, CLS_RGW_OP_ADD, tag, obj, loc);
+    ops.push_back(make_complete_op(ioctx, CLS_RGW_OP_ADD, tag, 1, obj, obj_size));
+  }
+  // a failing op fails the whole batch, none of it is applied
+  ops.push_back(make_complete_op(ioctx, CLS_RGW_OP_ADD, "no-such-tag", 1,
+                                 str_int("obj", num_objs), obj_size));
+  {
+    ObjectWriteOperation op;
+    cls_rgw_bucket_complete_ops(op, ops);
+    ASSERT_EQ(-EINVAL, ioctx.operate(bucket_oid, &op));
+  }
+  test_stats(ioctx, bucket_oid, RGWObjCategory::None, 0, 0);
+  {
+    cls_rgw_bi_log_list_ret bilog;
+    ASSERT_EQ(0, bilog_list(ioctx, bucket_oid, &bilog));
+    EXPECT_EQ(0u, bilog.entries.size());
+  }
+
+  ops.pop_back();
+  {
+    ObjectWriteOperation op;
+    cls_rgw_bucket_complete_ops(op, ops);
+    ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+  }
+  test_stats(ioctx, bucket_oid, RGWObjCategory::None, num_objs,
+             obj_size * num_objs);
+
+  // every op got its own bilog entry
+  {
+    cls_rgw_bi_log_list_ret bilog;
+    ASSERT_EQ(0, bilog_list(ioctx, bucket_oid, &bilog));
+    ASSERT_EQ(size_t(num_objs), bilog.entries.size());
+    std::set<string> ids;
+    for (auto& entry : bilog.entries) {
+      EXPECT_EQ(CLS_RGW_OP_ADD, entry.op);
+      EXPECT_EQ(CLS_RGW_STATE_COMPLETE, entry.state);
+      ids.insert(entry.id);
+    }
+    EXPECT_EQ(size_t(num_objs), ids.size());
+  }
+
+  // overwrite, delete and cancel in one batch, same results as one by one
+  ops.clear();
+  for (int i = 0; i < 3; i++) {
+    cls_rgw_obj_key obj = str_int("obj", i);
+    string tag = str_int("tag2", i);
+    string loc = str_int("loc", i);
+    RGWModifyOp index_op = (i == 1 ? CLS_RGW_OP_DEL : CLS_RGW_OP_ADD);
+    index_prepare(ioctx, bucket_oid, index_op, tag, obj, loc);
+    if (i == 2) {
+      ops.push_back(make_complete_op(ioctx, CLS_RGW_OP_CANCEL, tag, 2, obj, 0));
+    } else {
+      ops.push_back(make_complete_op(ioctx, index_op, tag, 2, obj,
+                                     obj_size * 2));
+    }
+  }
+  {
+    ObjectWriteOperation op;
+    cls_rgw_bucket_complete_ops(op, ops);
+    ASSERT_EQ(0, ioctx.operate(bucket_oid, &op));
+  }
+  // obj-0 doubled in size, obj-1 is gone
+  test_stats(ioctx, bucket_oid, RGWObjCategory::None, num_objs - 1,
+             obj_size * num_objs);
+
+  map<int, string> oids = { {0, bucket_oid} };
+  map<int, struct rgw_cls_list_ret> list_results;
+  cls_rgw_obj_key start_key("", "");
+  ASSERT_EQ(0, CLSRGWIssueBucketList(ioctx, start_key, "", "", 1000, true,
+                                     oids, list_results, 1)());
+  auto& m = list_results.begin()->second.dir.m;
+  ASSERT_EQ(size_t(num_objs - 1), m.size());
+  EXPECT_EQ(0u, m.count(str_int("obj", 1)));
+  EXPECT_EQ(obj_size * 2, m[str_int("obj", 0)].meta.size);
+  EXPECT_TRUE(m[str_int("obj", 2)].pending_map.empty());
+}
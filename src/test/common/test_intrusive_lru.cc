@@ -147,3 +147,55 @@ TEST(LRU, eviction_live_ref) {
     }
   }
 }
+
+TEST(LRU, eviction_charged) {
+  LRUTest cache;
+  cache.set_target_size(10);
+
+  {
+    auto [ref, existed] = cache.add(0, 0);
+    ASSERT_TRUE(ref && !existed);
+    cache.set_charge(*ref, 6);
+  }
+  ASSERT_EQ(6u, cache.get_charged());
+
+  {
+    auto [ref, existed] = cache.add(1, 1);
+    ASSERT_TRUE(ref && !existed);
+    // 0 is unreferenced, and has to go to make room
+    cache.set_charge(*ref, 6);
+    ASSERT_EQ(6u, cache.get_charged());
+  }
+
+  {
+    auto [ref, existed] = cache.add(0, 0);
+    ASSERT_TRUE(ref && !existed);
+  }
+  {
+    auto [ref, existed] = cache.add(1, 1);
+    ASSERT_TRUE(ref && existed);
+  }
+}
+
+TEST(LRU, eviction_hot) {
+  const unsigned SIZE = 3;
+  LRUTest cache;
+  cache.set_target_size(SIZE);
+  cache.set_hot_threshold(SIZE);
+
+  for (unsigned i = 0; i <= SIZE; ++i) {
+    auto [ref, existed] = cache.add(0, 0);
+    ASSERT_TRUE(ref);
+  }
+
+  // would evict 0 first if it was not hot
+  for (unsigned i = 1; i <= SIZE + 1; ++i) {
+    auto [ref, existed] = cache.add(i, i);
+    ASSERT_TRUE(ref && !existed);
+  }
+
+  {
+    auto [ref, existed] = cache.add(0, 0);
+    ASSERT_TRUE(ref && existed);
+  }
+}
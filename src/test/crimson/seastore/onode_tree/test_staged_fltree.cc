@@ -1724,3 +1724,57 @@ TEST_F(d_seastore_tm_test_t, 7_tree_insert_erase_eagain)
     tree.reset();
   });
 }
+
+TEST_F(d_seastore_tm_test_t, 8_tree_insert_sorted)
+{
+  run_async([this] {
+    constexpr bool TRACK_CURSORS = false;
+    auto kvs = KVPool<test_item_t>::create_raw_range(
+        {8, 11,  64, 256, 301, 320},
+        {8, 11,  64, 256, 301, 320},
+        {8, 16, 128, 512, 576, 640},
+        {0, 16}, {0, 10}, {0, 4});
+    auto tree = std::make_unique<TreeBuilder<TRACK_CURSORS, BoundedValue>>(
+        kvs, NodeExtentManager::create_seastore(*tm));
+    {
+      auto t = tm->create_transaction();
+      tree->bootstrap(*t).unsafe_get();
+      tm->submit_transaction(std::move(t)).unsafe_get();
+      segment_cleaner->run_until_halt().get0();
+    }
+
+    // append every key to the rightmost leaf through the hint
+    {
+      auto t = tm->create_transaction();
+      tree->insert_sorted(*t, true).unsafe_get();
+      tm->submit_transaction(std::move(t)).unsafe_get();
+      segment_cleaner->run_until_halt().get0();
+    }
+    {
+      auto t = tm->create_transaction();
+      tree->get_stats(*t).unsafe_get();
+      tree->validate(*t).unsafe_get();
+      EXPECT_GT(tree->height(*t).unsafe_get0(), 1);
+    }
+    {
+      // every key but the first one had a hint. most of them were appended
+      // to the rightmost leaf, the others filled it up and went through the
+      // split path from the root
+      auto& stats = tree->get_hint_stats();
+      logger().info("hinted inserts: {} appended, {} fell back",
+                    stats.appended, stats.fallbacks);
+      EXPECT_EQ(stats.appended + stats.fallbacks, kvs.size() - 1);
+      EXPECT_GT(stats.appended, 0u);
+      EXPECT_GT(stats.appended, stats.fallbacks);
+    }
+    logger().info("seastore replay insert begin");
+    restart();
+    tree->reload(NodeExtentManager::create_seastore(*tm));
+    logger().info("seastore replay insert end");
+    {
+      auto t = tm->create_transaction();
+      tree->validate(*t).unsafe_get();
+    }
+    tree.reset();
+  });
+}
@@ -299,3 +299,28 @@ TEST_F(object_data_handler_test_t, truncate)
     read(base, 64<<10);
   });
 }
+
+TEST_F(object_data_handler_test_t, large_read)
+{
+  run_async([this] {
+    // lay out the 4MB object as many small extents with holes in between,
+    // so that a read of the whole object spans several LBA leaves
+    constexpr extent_len_t block = 16<<10;
+    for (objaddr_t off = 0; off < known_contents.length(); off += 2 * block) {
+      write(off, block, 'a' + (off / (2 * block)) % 26);
+    }
+    restart();
+
+    auto start = std::chrono::steady_clock::now();
+    read(0, known_contents.length());
+    std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+    logger().info(
+      "large_read: read {} bytes over {} extents in {}s",
+      known_contents.length(),
+      known_contents.length() / (2 * block),
+      elapsed.count());
+
+    read_near(1<<20, 1<<20, block / 4);
+  });
+}
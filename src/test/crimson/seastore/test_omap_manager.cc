@@ -237,6 +237,57 @@ TEST_F(omap_manager_test_t, basic)
   });
 }
 
+TEST_F(omap_manager_test_t, conflict_by_key)
+{
+  run_async([this] {
+    omap_root_t omap_root(L_ADDR_NULL, 0);
+    {
+      auto t = tm->create_transaction();
+      omap_root = omap_manager->initialize_omap(*t).unsafe_get0();
+      submit_transaction(std::move(t));
+    }
+    {
+      auto t = tm->create_transaction();
+      for (auto key : {"a", "b", "c"}) {
+	set_key(omap_root, *t, key, "v1");
+      }
+      submit_transaction(std::move(t));
+    }
+
+    // all the keys are in the same leaf
+    auto reads_a = tm->create_transaction(Transaction::src_t::READ);
+    get_value(omap_root, *reads_a, "a");
+    auto reads_b = tm->create_transaction(Transaction::src_t::READ);
+    get_value(omap_root, *reads_b, "b");
+    auto lists = tm->create_transaction(Transaction::src_t::READ);
+    list(omap_root, *lists, std::nullopt);
+    {
+      auto t = tm->create_transaction();
+      set_key(omap_root, *t, "b", "v2");
+      submit_transaction(std::move(t));
+    }
+    EXPECT_FALSE(reads_a->is_conflicted());
+    EXPECT_TRUE(reads_b->is_conflicted());
+    EXPECT_TRUE(lists->is_conflicted());
+
+    // the leaf reads_a holds was replaced, it cannot be read any further
+    using ertr = OMapManager::omap_get_value_ertr;
+    bool eagain = omap_manager->omap_get_value(omap_root, *reads_a, "a"
+    ).safe_then([](auto) {
+      return ertr::make_ready_future<bool>(false);
+    }).handle_error(
+      [](const crimson::ct_error::eagain &e) {
+	return seastar::make_ready_future<bool>(true);
+      },
+      crimson::ct_error::assert_all{"omap_get_value hit invalid error"}
+    ).get0();
+    EXPECT_TRUE(eagain);
+
+    // a retry reads the new leaf
+    check_mappings(omap_root);
+  });
+}
+
 TEST_F(omap_manager_test_t, force_leafnode_split)
 {
   run_async([this] {
@@ -356,3 +356,51 @@ TEST_F(rbm_test_t, check_free_blocks)
    ASSERT_TRUE(rbm_manager->get_free_blocks() == free + 4);
  });
 }
+
+TEST_F(rbm_test_t, alloc_abort_and_reopen)
+{
+ run_async([this] {
+   mkfs();
+   open();
+   auto free = rbm_manager->get_free_blocks();
+   auto t = tm->create_transaction();
+   rbm_manager->alloc_extent(*t, DEFAULT_BLOCK_SIZE * 4).unsafe_get0();
+   auto reserved = t->get_rbm_alloc_info_blocks().front().alloc_blk_ids;
+
+   // blocks reserved by an in-flight transaction are not handed out twice
+   auto t2 = tm->create_transaction();
+   rbm_manager->alloc_extent(*t2, DEFAULT_BLOCK_SIZE * 4).unsafe_get0();
+   auto alloc_ids = t2->get_rbm_alloc_info_blocks().front().alloc_blk_ids;
+   interval_set<blk_id_t> overlap;
+   overlap.intersection_of(reserved, alloc_ids);
+   ASSERT_TRUE(overlap.empty());
+
+   rbm_manager->abort_allocation(*t).unsafe_get0();
+   ASSERT_TRUE(check_ids_are_allocated(reserved, false));
+   rbm_manager->complete_allocation(*t2).unsafe_get0();
+   ASSERT_TRUE(check_ids_are_allocated(alloc_ids));
+   ASSERT_EQ(rbm_manager->get_free_blocks(), free - 4);
+
+   // aborted blocks can be allocated again
+   auto t3 = tm->create_transaction();
+   rbm_manager->alloc_extent(*t3, DEFAULT_BLOCK_SIZE * 4).unsafe_get0();
+   ASSERT_EQ(t3->get_rbm_alloc_info_blocks().front().alloc_blk_ids, reserved);
+   rbm_manager->abort_allocation(*t3).unsafe_get0();
+
+   // the in-memory allocator is loaded from the bitmap blocks
+   rbm_manager->close().unsafe_get0();
+   open();
+   ASSERT_EQ(rbm_manager->get_free_blocks(), free - 4);
+   auto t4 = tm->create_transaction();
+   rbm_manager->alloc_extent(*t4, DEFAULT_BLOCK_SIZE * 4).unsafe_get0();
+   ASSERT_EQ(t4->get_rbm_alloc_info_blocks().front().alloc_blk_ids, reserved);
+   rbm_manager->free_extent(
+     *t4,
+     alloc_ids.range_start() * DEFAULT_BLOCK_SIZE,
+     alloc_ids.size() * DEFAULT_BLOCK_SIZE).unsafe_get0();
+   rbm_manager->complete_allocation(*t4).unsafe_get0();
+   ASSERT_TRUE(check_ids_are_allocated(reserved));
+   ASSERT_TRUE(check_ids_are_allocated(alloc_ids, false));
+   ASSERT_EQ(rbm_manager->get_free_blocks(), free - 4);
+ });
+}
@@ -3,6 +3,7 @@
 
 #include "test/crimson/gtest_seastar.h"
 
+#include "crimson/common/config_proxy.h"
 #include "crimson/common/log.h"
 #include "crimson/os/seastore/cache.h"
 #include "crimson/os/seastore/segment_manager/ephemeral.h"
@@ -20,18 +21,20 @@ namespace {
 }
 
 struct cache_test_t : public seastar_test_suite_t {
+  // clean extents the cache may hold on to
+  static constexpr unsigned CACHE_BLOCKS = 8;
+
   segment_manager::EphemeralSegmentManagerRef segment_manager;
-  Cache cache;
+  CacheRef cache;
   paddr_t current{0, 0};
   journal_seq_t seq;
 
   cache_test_t()
-    : segment_manager(segment_manager::create_test_ephemeral()),
-      cache(*segment_manager) {}
+    : segment_manager(segment_manager::create_test_ephemeral()) {}
 
   seastar::future<std::optional<paddr_t>> submit_transaction(
     TransactionRef t) {
-    auto record = cache.try_construct_record(*t);
+    auto record = cache->try_construct_record(*t);
     if (!record) {
       return seastar::make_ready_future<std::optional<paddr_t>>(
 	std::nullopt);
@@ -56,7 +59,7 @@ struct cache_test_t : public seastar_test_suite_t {
       true
     ).safe_then(
       [this, prev, t=std::move(t)]() mutable {
-	cache.complete_commit(*t, prev, seq /* TODO */);
+	cache->complete_commit(*t, prev, seq /* TODO */);
 	return seastar::make_ready_future<std::optional<paddr_t>>(prev);
       },
       crimson::ct_error::all_same_way([](auto e) {
@@ -66,18 +69,23 @@ struct cache_test_t : public seastar_test_suite_t {
   }
 
   auto get_transaction() {
-    return cache.create_transaction();
+    return cache->create_transaction();
   }
 
   seastar::future<> set_up_fut() final {
-    return segment_manager->init(
-    ).safe_then(
+    return crimson::common::local_conf().set_val(
+      "seastore_cache_size",
+      std::to_string(CACHE_BLOCKS * TestBlockPhysical::SIZE)
+    ).then([this] {
+      cache = std::make_unique<Cache>(*segment_manager);
+      return segment_manager->init();
+    }).safe_then(
       [this] {
 	return seastar::do_with(
-	  cache.create_transaction(),
+	  cache->create_transaction(),
 	  [this](auto &transaction) {
-	    cache.init();
-	    return cache.mkfs(*transaction).safe_then(
+	    cache->init();
+	    return cache->mkfs(*transaction).safe_then(
 	      [this, &transaction] {
 		return submit_transaction(std::move(transaction)).then(
 		  [](auto p) {
@@ -93,8 +101,32 @@ struct cache_test_t : public seastar_test_suite_t {
   }
 
   seastar::future<> tear_down_fut() final {
-    return cache.close().handle_error(
-      Cache::close_ertr::assert_all{});
+    return cache->close().handle_error(
+      Cache::close_ertr::assert_all{}
+    ).then([this] {
+      cache.reset();
+    });
+  }
+
+  paddr_t write_block(char c) {
+    auto t = get_transaction();
+    auto extent = cache->alloc_new_extent<TestBlockPhysical>(
+      *t,
+      TestBlockPhysical::SIZE);
+    extent->set_contents(c);
+    auto ret = submit_transaction(std::move(t)).get0();
+    EXPECT_TRUE(ret);
+    return extent->get_paddr();
+  }
+
+  void read_block(paddr_t addr, char c) {
+    auto t = get_transaction();
+    auto extent = cache->get_extent<TestBlockPhysical>(
+      *t,
+      addr,
+      TestBlockPhysical::SIZE).unsafe_get0();
+    ASSERT_EQ(addr, extent->get_paddr());
+    ASSERT_EQ(c, extent->get_bptr().c_str()[0]);
   }
 };
 
@@ -105,7 +137,7 @@ TEST_F(cache_test_t, test_addr_fixup)
     int csum = 0;
     {
       auto t = get_transaction();
-      auto extent = cache.alloc_new_extent<TestBlockPhysical>(
+      auto extent = cache->alloc_new_extent<TestBlockPhysical>(
 	*t,
 	TestBlockPhysical::SIZE);
       extent->set_contents('c');
@@ -116,7 +148,7 @@ TEST_F(cache_test_t, test_addr_fixup)
     }
     {
       auto t = get_transaction();
-      auto extent = cache.get_extent<TestBlockPhysical>(
+      auto extent = cache->get_extent<TestBlockPhysical>(
 	*t,
 	addr,
 	TestBlockPhysical::SIZE).unsafe_get0();
@@ -135,7 +167,7 @@ TEST_F(cache_test_t, test_dirty_extent)
     {
       // write out initial test block
       auto t = get_transaction();
-      auto extent = cache.alloc_new_extent<TestBlockPhysical>(
+      auto extent = cache->alloc_new_extent<TestBlockPhysical>(
 	*t,
 	TestBlockPhysical::SIZE);
       extent->set_contents('c');
@@ -145,7 +177,7 @@ TEST_F(cache_test_t, test_dirty_extent)
       {
 	// test that read with same transaction sees new block though
 	// uncommitted
-	auto extent = cache.get_extent<TestBlockPhysical>(
+	auto extent = cache->get_extent<TestBlockPhysical>(
 	  *t,
 	  reladdr,
 	  TestBlockPhysical::SIZE).unsafe_get0();
@@ -162,12 +194,12 @@ TEST_F(cache_test_t, test_dirty_extent)
     {
       // test that consecutive reads on the same extent get the same ref
       auto t = get_transaction();
-      auto extent = cache.get_extent<TestBlockPhysical>(
+      auto extent = cache->get_extent<TestBlockPhysical>(
 	*t,
 	addr,
 	TestBlockPhysical::SIZE).unsafe_get0();
       auto t2 = get_transaction();
-      auto extent2 = cache.get_extent<TestBlockPhysical>(
+      auto extent2 = cache->get_extent<TestBlockPhysical>(
 	*t2,
 	addr,
 	TestBlockPhysical::SIZE).unsafe_get0();
@@ -176,12 +208,12 @@ TEST_F(cache_test_t, test_dirty_extent)
     {
       // read back test block
       auto t = get_transaction();
-      auto extent = cache.get_extent<TestBlockPhysical>(
+      auto extent = cache->get_extent<TestBlockPhysical>(
 	*t,
 	addr,
 	TestBlockPhysical::SIZE).unsafe_get0();
       // duplicate and reset contents
-      extent = cache.duplicate_for_write(*t, extent)->cast<TestBlockPhysical>();
+      extent = cache->duplicate_for_write(*t, extent)->cast<TestBlockPhysical>();
       extent->set_contents('c');
       csum2 = extent->get_crc32c();
       ASSERT_EQ(extent->get_paddr(), addr);
@@ -189,7 +221,7 @@ TEST_F(cache_test_t, test_dirty_extent)
 	// test that concurrent read with fresh transaction sees old
         // block
 	auto t2 = get_transaction();
-	auto extent = cache.get_extent<TestBlockPhysical>(
+	auto extent = cache->get_extent<TestBlockPhysical>(
 	  *t2,
 	  addr,
 	  TestBlockPhysical::SIZE).unsafe_get0();
@@ -201,7 +233,7 @@ TEST_F(cache_test_t, test_dirty_extent)
       }
       {
 	// test that read with same transaction sees new block
-	auto extent = cache.get_extent<TestBlockPhysical>(
+	auto extent = cache->get_extent<TestBlockPhysical>(
 	  *t,
 	  addr,
 	  TestBlockPhysical::SIZE).unsafe_get0();
@@ -222,7 +254,7 @@ TEST_F(cache_test_t, test_dirty_extent)
     {
       // test that fresh transaction now sees newly dirty block
       auto t = get_transaction();
-      auto extent = cache.get_extent<TestBlockPhysical>(
+      auto extent = cache->get_extent<TestBlockPhysical>(
 	*t,
 	addr,
 	TestBlockPhysical::SIZE).unsafe_get0();
@@ -233,3 +265,41 @@ TEST_F(cache_test_t, test_dirty_extent)
     }
   });
 }
+
+TEST_F(cache_test_t, test_clean_extent_eviction)
+{
+  run_async([this] {
+    std::vector<paddr_t> addrs;
+    for (unsigned i = 0; i < 4 * CACHE_BLOCKS; ++i) {
+      addrs.push_back(write_block('a' + i % 26));
+    }
+    ASSERT_EQ(CACHE_BLOCKS * TestBlockPhysical::SIZE,
+	      cache->get_cached_bytes());
+    auto &stats = cache->get_stats();
+    auto hits = stats.hits;
+    auto misses = stats.misses;
+
+    // the last blocks written are still cached
+    auto last = addrs.size() - 1;
+    read_block(addrs[last], 'a' + last % 26);
+    ASSERT_EQ(hits + 1, stats.hits);
+
+    // read back after being evicted from probation: promoted to main
+    auto hot = addrs.size() - CACHE_BLOCKS - 2;
+    read_block(addrs[hot], 'a' + hot % 26);
+    ASSERT_EQ(misses + 1, stats.misses);
+
+    // a scan of twice the cache size only goes through probation
+    for (unsigned i = 0; i < 2 * CACHE_BLOCKS; ++i) {
+      read_block(addrs[i], 'a' + i % 26);
+    }
+    ASSERT_EQ(misses + 1 + 2 * CACHE_BLOCKS, stats.misses);
+    ASSERT_GE(stats.evictions, 2 * CACHE_BLOCKS);
+
+    hits = stats.hits;
+    read_block(addrs[hot], 'a' + hot % 26);
+    ASSERT_EQ(hits + 1, stats.hits);
+    ASSERT_EQ(CACHE_BLOCKS * TestBlockPhysical::SIZE,
+	      cache->get_cached_bytes());
+  });
+}
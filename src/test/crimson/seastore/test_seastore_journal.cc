@@ -5,6 +5,9 @@
 
 #include <random>
 
+#include <seastar/core/later.hh>
+
+#include "crimson/common/config_proxy.h"
 #include "crimson/common/log.h"
 #include "crimson/os/seastore/journal.h"
 #include "crimson/os/seastore/segment_manager/ephemeral.h"
@@ -107,6 +110,7 @@ struct journal_test_t : seastar_test_suite_t, JournalSegmentProvider {
   auto replay(T &&f) {
     return journal->close(
     ).safe_then([this, f=std::move(f)]() mutable {
+      journal.reset();
       journal.reset(new Journal(*segment_manager));
       journal->set_segment_provider(this);
       journal->set_write_pipeline(&pipeline);
@@ -264,3 +268,89 @@ TEST_F(journal_test_t, roll_journal_and_replay)
    replay_and_check();
  });
 }
+
+TEST_F(journal_test_t, batch_concurrent_records)
+{
+ run_async([this] {
+   constexpr unsigned NUM_RECORDS = 8;
+   // reopen the journal with the new batching latency, so the records
+   // submitted below are queued behind the first one
+   crimson::common::local_conf().set_val(
+     "seastore_journal_batch_latency_us", "1000").get0();
+   replay_and_check();
+
+   std::vector<OrderingHandle> handles;
+   handles.reserve(NUM_RECORDS);
+   std::vector<Journal::submit_record_ret> futs;
+   for (unsigned i = 0; i < NUM_RECORDS; ++i) {
+     records.emplace_back(record_t{
+       { generate_extent(1 + i % 3) },
+       { generate_delta(23 + i), generate_delta(40) }
+     });
+     handles.push_back(get_dummy_ordering_handle());
+     futs.push_back(journal->submit_record(
+       record_t(records.back().record),
+       handles.back()));
+   }
+   paddr_t last;
+   for (unsigned i = 0; i < NUM_RECORDS; ++i) {
+     auto [addr, _] = futs[i].unsafe_get0();
+     if (i > 0) {
+       ASSERT_LT(last, addr);
+     }
+     records[records.size() - NUM_RECORDS + i].record_final_offset = addr;
+     last = addr;
+   }
+   const auto &stats = journal->get_stats();
+   EXPECT_EQ(stats.records, NUM_RECORDS);
+   EXPECT_LT(stats.batches, NUM_RECORDS);
+
+   crimson::common::local_conf().set_val(
+     "seastore_journal_batch_latency_us", "0").get0();
+   replay_and_check();
+ });
+}
+
+TEST_F(journal_test_t, close_with_batch_in_flight)
+{
+ run_async([this] {
+   constexpr unsigned NUM_RECORDS = 4;
+   // the records wait for the batching latency, close() writes them out
+   crimson::common::local_conf().set_val(
+     "seastore_journal_batch_latency_us", "1000000").get0();
+   replay_and_check();
+
+   std::vector<OrderingHandle> handles;
+   handles.reserve(NUM_RECORDS);
+   std::vector<Journal::submit_record_ret> futs;
+   for (unsigned i = 0; i < NUM_RECORDS; ++i) {
+     records.emplace_back(record_t{
+       { generate_extent(1) },
+       { generate_delta(23 + i) }
+     });
+     handles.push_back(get_dummy_ordering_handle());
+     futs.push_back(journal->submit_record(
+       record_t(records.back().record),
+       handles.back()));
+   }
+   // let the records reach the pending batch
+   seastar::yield().get0();
+   EXPECT_EQ(journal->get_stats().records, 0u);
+
+   journal->close().unsafe_get0();
+   // the batch was written before the segment was closed
+   EXPECT_EQ(journal->get_stats().records, NUM_RECORDS);
+   for (unsigned i = 0; i < NUM_RECORDS; ++i) {
+     auto [addr, _] = futs[i].unsafe_get0();
+     records[records.size() - NUM_RECORDS + i].record_final_offset = addr;
+   }
+   // the journal goes away with nothing left to write
+   journal.reset(new Journal(*segment_manager));
+   journal->set_segment_provider(this);
+   journal->set_write_pipeline(&pipeline);
+
+   crimson::common::local_conf().set_val(
+     "seastore_journal_batch_latency_us", "0").get0();
+   replay_and_check();
+ });
+}
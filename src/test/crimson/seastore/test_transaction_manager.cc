@@ -676,8 +676,11 @@ TEST_F(transaction_manager_test_t, mutate_lba_conflict)
 
       mutate_addr(t, ADDR, SIZE);
       mutate_addr(t2, ADDR, SIZE);
+      EXPECT_FALSE(t2.t->is_conflicted());
 
       submit_transaction(std::move(t));
+      // flagged by the commit of t, before t2 gets to submit
+      EXPECT_TRUE(t2.t->is_conflicted());
       submit_transaction_expect_conflict(std::move(t2));
     }
     check();
@@ -952,3 +955,60 @@ TEST_F(transaction_manager_test_t, random_writes_concurrent)
     );
   });
 }
+
+TEST_F(transaction_manager_test_t, random_overwrites_write_amplification)
+{
+  // 64MB, 10% of which gets 90% of the overwrites. writing 256MB in all
+  // is just enough for the dead space to reach the reclaim threshold of
+  // the default SegmentCleaner config on the 1GB test device
+  constexpr size_t TOTAL = 64<<20;
+  constexpr size_t BSIZE = 64<<10;
+  constexpr size_t BLOCKS = TOTAL / BSIZE;
+  constexpr size_t HOT_BLOCKS = BLOCKS / 10;
+  constexpr unsigned OVERWRITES = 3 * BLOCKS;
+  run_async([this] {
+    std::vector<laddr_t> laddrs;
+    for (unsigned i = 0; i < BLOCKS; ++i) {
+      auto t = create_transaction();
+      auto extent = alloc_extent(
+	t,
+	i * BSIZE,
+	BSIZE);
+      laddrs.push_back(extent->get_laddr());
+      submit_transaction(std::move(t));
+    }
+
+    auto before = segment_cleaner->get_stats();
+    std::uniform_int_distribution<unsigned> percent(0, 99);
+    std::uniform_int_distribution<size_t> hot(0, HOT_BLOCKS - 1);
+    std::uniform_int_distribution<size_t> cold(HOT_BLOCKS, BLOCKS - 1);
+    for (unsigned i = 0; i < OVERWRITES; ++i) {
+      auto idx = percent(gen) < 90 ? hot(gen) : cold(gen);
+      auto t = create_transaction();
+      dec_ref(t, laddrs[idx]);
+      auto extent = alloc_extent(
+	t,
+	laddrs[idx],
+	BSIZE);
+      laddrs[idx] = extent->get_laddr();
+      submit_transaction(std::move(t));
+    }
+    auto &after = segment_cleaner->get_stats();
+
+    auto written = after.written_bytes - before.written_bytes;
+    auto reclaimed = after.reclaimed_bytes - before.reclaimed_bytes;
+    logger().info(
+      "random_overwrites_write_amplification: "
+      "written {}, reclaimed {}, segments released {}, "
+      "dead extents skipped {}, write amplification {}",
+      written,
+      reclaimed,
+      after.segments_released - before.segments_released,
+      after.reclaim_skipped_extents - before.reclaim_skipped_extents,
+      (double)written / (written - reclaimed));
+    EXPECT_GT(after.segments_released, before.segments_released);
+
+    replay();
+    check();
+  });
+}
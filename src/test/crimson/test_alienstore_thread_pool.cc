@@ -35,6 +35,22 @@ seastar::future<> test_void_return(ThreadPool& tp) {
   });
 }
 
+// not a test as such: how long the round trip of an empty task takes, with
+// the queue of the submitting reactor kept full
+seastar::future<> bench_round_trip(ThreadPool& tp) {
+  static constexpr auto N = 100000;
+  auto start = std::chrono::steady_clock::now();
+  return seastar::parallel_for_each(boost::irange(0, N), [&tp](int i) {
+    return tp.submit(i % tp.size(), [] {});
+  }).then([start] {
+    std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+    std::cout << "round trip: " << N << " tasks in "
+              << elapsed.count() / 1000 << " ms, "
+              << elapsed.count() * 1000 / N << " ns/task" << std::endl;
+  });
+}
+
 int main(int argc, char** argv)
 {
   seastar::app_template app;
@@ -56,6 +72,8 @@ int main(int argc, char** argv)
           return test_accumulate(*tp);
         }).then([&tp] {
           return test_void_return(*tp);
+        }).then([&tp] {
+          return bench_round_trip(*tp);
         }).finally([&tp] {
           return tp->stop();
         });
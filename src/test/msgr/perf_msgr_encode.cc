@@ -0,0 +1,221 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+/*
+ * Encodes and decodes the hot OSD messages in a tight loop and reports the
+ * heap allocations and time spent per message, with and without the
+ * message encode arena (see msg/EncodeArena.h).
+ */
+
+#include <stdlib.h>
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "common/ceph_argparse.h"
+#include "common/Cycles.h"
+#include "global/global_init.h"
+#include "include/mempool.h"
+#include "msg/EncodeArena.h"
+#include "messages/MOSDOp.h"
+#include "messages/MOSDOpReply.h"
+#include "messages/MOSDRepOp.h"
+#include "messages/MOSDRepOpReply.h"
+
+using namespace std;
+
+static std::atomic<uint64_t> num_news{0};
+
+void* operator new(size_t size)
+{
+  num_news.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  free(p);
+}
+
+namespace {
+
+using message_factory_t = std::function<ceph::ref_t<Message>()>;
+
+struct result_t {
+  double news = 0;       // operator new calls
+  double raws = 0;       // buffers allocated outside of the arena
+  double chunks = 0;     // arena chunks
+  double encode_ns = 0;
+  double decode_ns = 0;
+
+  double allocs() const {
+    return news + raws + chunks;
+  }
+};
+
+uint64_t live_raws()
+{
+  return mempool::get_pool(mempool::mempool_buffer_anon).allocated_items();
+}
+
+result_t run(const message_factory_t& factory, unsigned count, bool arena)
+{
+  ceph::msgr::EncodeArena::set_enabled(arena);
+  const uint64_t features = CEPH_FEATURES_ALL;
+  result_t r;
+
+  vector<ceph::ref_t<Message>> msgs;
+  msgs.reserve(count);
+  for (unsigned i = 0; i < count; ++i) {
+    msgs.push_back(factory());
+  }
+
+  // messages stay alive until we are done counting, so the raw buffers
+  // pinned by their payloads show up in the mempool
+  auto stats_before = ceph::msgr::EncodeArena::get_stats();
+  uint64_t raws_before = live_raws();
+  uint64_t news_before = num_news.load();
+  uint64_t start = Cycles::rdtsc();
+  for (auto& m : msgs) {
+    m->encode(features, MSG_CRC_ALL);
+  }
+  uint64_t stop = Cycles::rdtsc();
+  auto stats_after = ceph::msgr::EncodeArena::get_stats();
+  r.news = double(num_news.load() - news_before) / count;
+  // arena slices are raws too, but they don't come from the heap
+  r.raws = double(live_raws() - raws_before -
+		  (stats_after.slices - stats_before.slices)) / count;
+  r.chunks = double(stats_after.chunks - stats_before.chunks) / count;
+  r.encode_ns = double(Cycles::to_nanoseconds(stop - start)) / count;
+
+  vector<Message*> decoded;
+  decoded.reserve(count);
+  start = Cycles::rdtsc();
+  for (auto& m : msgs) {
+    ceph::bufferlist front = m->get_payload();
+    ceph::bufferlist middle = m->get_middle();
+    ceph::bufferlist data = m->get_data();
+    decoded.push_back(decode_message(g_ceph_context, 0, m->get_header(),
+				     m->get_footer(), front, middle, data,
+				     nullptr));
+  }
+  stop = Cycles::rdtsc();
+  r.decode_ns = double(Cycles::to_nanoseconds(stop - start)) / count;
+  for (auto m : decoded) {
+    ceph_assert(m);
+    m->put();
+  }
+  return r;
+}
+
+void report(const string& name, const message_factory_t& factory,
+	    unsigned count)
+{
+  // warm up, e.g. the first arena chunk of this thread
+  run(factory, 100, true);
+  result_t before = run(factory, count, false);
+  result_t after = run(factory, count, true);
+  cout << std::fixed << std::setprecision(2)
+       << name << ":\n"
+       << "  without arena: " << before.allocs() << " allocs/msg ("
+       << before.news << " new, " << before.raws << " buffers), encode "
+       << before.encode_ns << " ns, decode " << before.decode_ns << " ns\n"
+       << "  with arena:    " << after.allocs() << " allocs/msg ("
+       << after.news << " new, " << after.raws << " buffers, "
+       << after.chunks << " chunks), encode "
+       << after.encode_ns << " ns, decode " << after.decode_ns << " ns"
+       << std::endl;
+}
+
+hobject_t make_hobj()
+{
+  return hobject_t(object_t("rbd_data.10226b8b4567.0000000000000042"),
+		   "", CEPH_NOSNAP, 0x1234abcd, 1, "");
+}
+
+ceph::ref_t<MOSDOp> make_osd_op(unsigned len)
+{
+  spg_t pgid(pg_t(0x1234abcd, 1));
+  auto m = ceph::make_message<MOSDOp>(
+    1, 42, make_hobj(), pgid, 100,
+    CEPH_OSD_FLAG_WRITE | CEPH_OSD_FLAG_ONDISK, CEPH_FEATURES_ALL);
+  ceph::bufferlist bl;
+  bl.append_zero(len);
+  m->write(0, len, bl);
+  return m;
+}
+
+void usage(const char *name) {
+  cerr << "Usage: " << name << " [messages] [data bytes]" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+  vector<const char*> args;
+  argv_to_vec(argc, (const char **)argv, args);
+
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+
+  if (args.size() > 2) {
+    usage(argv[0]);
+    return 1;
+  }
+  unsigned count = args.size() > 0 ? atoi(args[0]) : 100000;
+  unsigned len = args.size() > 1 ? atoi(args[1]) : 4096;
+  Cycles::init();
+
+  report("MOSDOp", [len] { return make_osd_op(len); }, count);
+  report("MOSDOpReply", [len] {
+    auto req = make_osd_op(len);
+    return ceph::make_message<MOSDOpReply>(
+      req.get(), 0, 100, CEPH_OSD_FLAG_ACK | CEPH_OSD_FLAG_ONDISK, true);
+  }, count);
+  report("MOSDRepOp", [] {
+    auto m = ceph::make_message<MOSDRepOp>(
+      osd_reqid_t(entity_name_t::CLIENT(4242), 0, 42),
+      pg_shard_t(0, shard_id_t::NO_SHARD),
+      spg_t(pg_t(0x1234abcd, 1)), make_hobj(),
+      CEPH_OSD_FLAG_ACK | CEPH_OSD_FLAG_ONDISK, 100, 90, 43,
+      eversion_t(100, 7));
+    m->logbl.append_zero(256);
+    return m;
+  }, count);
+  report("MOSDRepOpReply", [] {
+    auto req = ceph::make_message<MOSDRepOp>(
+      osd_reqid_t(entity_name_t::CLIENT(4242), 0, 42),
+      pg_shard_t(0, shard_id_t::NO_SHARD),
+      spg_t(pg_t(0x1234abcd, 1)), make_hobj(),
+      CEPH_OSD_FLAG_ACK | CEPH_OSD_FLAG_ONDISK, 100, 90, 43,
+      eversion_t(100, 7));
+    return ceph::make_message<MOSDRepOpReply>(
+      req.get(), pg_shard_t(1, shard_id_t::NO_SHARD), 0, 100, 90,
+      CEPH_OSD_FLAG_ONDISK);
+  }, count);
+  return 0;
+}
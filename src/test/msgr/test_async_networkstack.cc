@@ -22,6 +22,7 @@
 #include <string>
 #include <set>
 #include <vector>
+#include <sys/resource.h>
 #include <gtest/gtest.h>
 
 #include "acconfig.h"
@@ -1054,6 +1055,195 @@ TEST_P(NetworkWorkerTest, StressTest) {
   ASSERT_EQ(0, factory.message_left);
 }
 
+/*
+ * Pushes data through a loopback connection and reports the CPU time spent
+ * per GB, with and without ms_tcp_zerocopy. Over loopback the kernel copies
+ * zerocopy sends too, and the socket stops using MSG_ZEROCOPY after the
+ * first such completion, so the "zerocopy=true" figures here are for
+ * copied sends and the test says so. It mostly checks that the buffers
+ * pinned by zerocopy sends come through intact and are released; measuring
+ * the gain takes a NIC, e.g. with ceph_perf_msgr_server/client.
+ */
+TEST_P(NetworkWorkerTest, ZeroCopyThroughputTest) {
+  if (strcmp(GetParam(), "posix")) {
+    GTEST_SKIP() << "MSG_ZEROCOPY is only used by the posix stack";
+  }
+  entity_addr_t bind_addr;
+  ASSERT_TRUE(bind_addr.parse(get_addr().c_str()));
+  const uint64_t total = 512 << 20;
+  const unsigned chunk_len = 1 << 20;
+  const unsigned max_queued = 4 << 20;
+
+  for (auto zerocopy : {"false", "true"}) {
+    // only applies to new sockets
+    g_ceph_context->_conf.set_val_or_die("ms_tcp_zerocopy", zerocopy);
+    exec_events([&](Worker *worker) mutable {
+      if (worker->id != 0) {
+	return;
+      }
+      EventCenter *center = &worker->center;
+      SocketOptions options;
+      ServerSocket bind_socket;
+      ASSERT_EQ(0, worker->listen(bind_addr, 0, options, &bind_socket));
+      ConnectedSocket cli_socket, srv_socket;
+      ASSERT_EQ(0, worker->connect(bind_addr, options, &cli_socket));
+      {
+	C_poll cb(center);
+	center->create_file_event(bind_socket.fd(), EVENT_READABLE, &cb);
+	ASSERT_TRUE(cb.poll(500));
+	center->delete_file_event(bind_socket.fd(), EVENT_READABLE);
+	entity_addr_t cli_addr;
+	ASSERT_EQ(0, bind_socket.accept(&srv_socket, options, &cli_addr, worker));
+	cb.reset();
+	center->create_file_event(cli_socket.fd(), EVENT_READABLE, &cb);
+	int r = cli_socket.is_connected();
+	if (r == 0) {
+	  ASSERT_TRUE(cb.poll(500));
+	  r = cli_socket.is_connected();
+	}
+	ASSERT_EQ(1, r);
+	center->delete_file_event(cli_socket.fd(), EVENT_READABLE);
+      }
+
+      bufferptr chunk(buffer::create_page_aligned(chunk_len));
+      for (unsigned i = 0; i < chunk_len; i++) {
+	chunk[i] = i % 251;
+      }
+      C_poll cb(center);
+      center->create_file_event(srv_socket.fd(), EVENT_READABLE, &cb);
+      center->create_file_event(cli_socket.fd(), EVENT_WRITABLE, &cb);
+
+      auto logger = worker->get_perf_counter();
+      const uint64_t zc_sends = logger->get(l_msgr_zerocopy_sends);
+      const uint64_t zc_disabled = logger->get(l_msgr_zerocopy_disabled);
+      struct rusage start_usage, end_usage;
+      ASSERT_EQ(0, getrusage(RUSAGE_THREAD, &start_usage));
+      auto start = ceph::mono_clock::now();
+      bufferlist out;
+      uint64_t queued = 0, received = 0;
+      std::vector<char> buf(chunk_len);
+      while (received < total) {
+	bool progress = false;
+	while (queued < total && out.length() < max_queued) {
+	  out.append(chunk);
+	  queued += chunk_len;
+	}
+	if (out.length()) {
+	  ssize_t r = cli_socket.send(out, false);
+	  ASSERT_GE(r, 0);
+	  progress |= r > 0;
+	}
+	ssize_t r = srv_socket.read(buf.data(), buf.size());
+	if (r > 0) {
+	  // the chunks are sent one after the other
+	  for (ssize_t done = 0; done < r; ) {
+	    unsigned off = (received + done) % chunk_len;
+	    unsigned len = std::min<uint64_t>(chunk_len - off, r - done);
+	    ASSERT_EQ(0, memcmp(buf.data() + done, chunk.c_str() + off, len));
+	    done += len;
+	  }
+	  received += r;
+	  progress = true;
+	} else {
+	  ASSERT_EQ(-EAGAIN, r);
+	}
+	if (!progress) {
+	  center->process_events(1000);
+	}
+      }
+      auto elapsed = ceph::mono_clock::now() - start;
+      ASSERT_EQ(0, getrusage(RUSAGE_THREAD, &end_usage));
+      ASSERT_EQ(0u, out.length());
+
+      auto cpu_us = [](const struct rusage& u) {
+	return (u.ru_utime.tv_sec + u.ru_stime.tv_sec) * 1000000ull +
+	  u.ru_utime.tv_usec + u.ru_stime.tv_usec;
+      };
+      double gb = double(total) / (1 << 30);
+      double cpu_sec = double(cpu_us(end_usage) - cpu_us(start_usage)) / 1000000;
+      cerr << "zerocopy=" << zerocopy << ": "
+	   << double(total) / (1 << 20) / ceph::to_seconds<double>(elapsed)
+	   << " MB/s, " << cpu_sec / gb << " cpu sec/GB" << std::endl;
+      const uint64_t sends = logger->get(l_msgr_zerocopy_sends) - zc_sends;
+      const uint64_t disabled =
+	logger->get(l_msgr_zerocopy_disabled) - zc_disabled;
+      if (!strcmp(zerocopy, "false")) {
+	ASSERT_EQ(0u, sends);
+      } else if (!sends) {
+	cerr << "zerocopy=true: MSG_ZEROCOPY is not supported here,"
+	     << " all sends were copied" << std::endl;
+      } else if (disabled) {
+	cerr << "zerocopy=true: only " << sends << " sends used MSG_ZEROCOPY,"
+	     << " the kernel copied them and the socket disabled it:"
+	     << " the figures above are for copied sends" << std::endl;
+      }
+
+      center->delete_file_event(srv_socket.fd(), EVENT_READABLE);
+      center->delete_file_event(cli_socket.fd(), EVENT_WRITABLE);
+      bind_socket.abort_accept();
+    });
+  }
+  g_ceph_context->_conf.set_val_or_die("ms_tcp_zerocopy", "false");
+}
+
+TEST(NetworkStackTest, MigrationTarget) {
+  g_ceph_context->_conf.set_val_or_die("ms_async_op_threads", "3");
+  g_ceph_context->_conf.set_val_or_die("ms_async_rebalance_threshold", "20");
+  // workers are not started, so nothing but us updates their load
+  auto stack = NetworkStack::create(g_ceph_context, "posix");
+  ASSERT_TRUE(stack->support_connection_migration());
+  Worker *w0 = stack->get_worker(0);
+  Worker *w1 = stack->get_worker(1);
+  Worker *w2 = stack->get_worker(2);
+
+  w0->load = 900;
+  w1->load = 300;
+  w2->load = 100;
+  // too light to be worth moving
+  ASSERT_EQ(nullptr, stack->get_migration_target(w0, 5));
+  // would overload the target
+  ASSERT_EQ(nullptr, stack->get_migration_target(w0, 800));
+  ASSERT_EQ(w2, stack->get_migration_target(w0, 300));
+  ASSERT_EQ(600u, w0->load.load());
+  ASSERT_EQ(400u, w2->load.load());
+  ASSERT_EQ(w1, stack->get_migration_target(w0, 100));
+  ASSERT_EQ(500u, w0->load.load());
+  ASSERT_EQ(400u, w1->load.load());
+  // within the threshold, nothing to do
+  ASSERT_EQ(nullptr, stack->get_migration_target(w0, 50));
+  // never moves towards a busier worker
+  ASSERT_EQ(nullptr, stack->get_migration_target(w2, 50));
+}
+
+TEST(NetworkStackTest, WorkerLoad) {
+  g_ceph_context->_conf.set_val_or_die("ms_async_op_threads", "1");
+  g_ceph_context->_conf.set_val_or_die("ms_async_rebalance_worker_byte_rate",
+				       "100M");
+  auto stack = NetworkStack::create(g_ceph_context, "posix");
+  Worker *w = stack->get_worker(0);
+
+  // busy for a quarter of the period, receiving little
+  w->update_load(std::chrono::milliseconds(250), std::chrono::seconds(2),
+		 2 << 20);
+  ASSERT_EQ(125u, w->cpu_load.load());
+  ASSERT_EQ(1u << 20, w->recv_byte_rate.load());
+  ASSERT_EQ(125u, w->load.load());
+
+  // cheap on CPU, but receiving half of the byte rate
+  w->update_load(std::chrono::milliseconds(100), std::chrono::seconds(2),
+		 100ull << 20);
+  ASSERT_EQ(50u, w->cpu_load.load());
+  ASSERT_EQ(500u, w->load.load());
+
+  // saturated either way
+  w->update_load(std::chrono::seconds(1), std::chrono::seconds(1),
+		 1ull << 30);
+  ASSERT_EQ(1000u, w->load.load());
+  ASSERT_EQ(1000u, w->byte_load(1ull << 40));
+
+  g_ceph_context->_conf.set_val_or_die("ms_async_rebalance_worker_byte_rate",
+				       "1G");
+}
 
 INSTANTIATE_TEST_SUITE_P(
   NetworkStack,
@@ -388,6 +388,106 @@ INSTANTIATE_TEST_SUITE_P(
         ::testing::ValuesIn(round_trip_instances),
         ::testing::ValuesIn(modes)));
 
+class ChunkedSealTest : public ::testing::TestWithParam<uint32_t> {
+protected:
+  ChunkedSealTest()
+      : m_tx_frame_asm(&m_tx_crypto, true),
+        m_rx_frame_asm(&m_rx_crypto, true) {
+    AuthConnectionMeta auth_meta;
+    auth_meta.con_mode = CEPH_CON_MODE_SECURE;
+    auth_meta.connection_secret.resize(64);
+    g_ceph_context->random()->get_bytes(auth_meta.connection_secret.data(),
+                                        auth_meta.connection_secret.size());
+    m_tx_crypto = ceph::crypto::onwire::rxtx_t::create_handler_pair(
+        g_ceph_context, auth_meta, /*new_nonce_format=*/true,
+        /*crossed=*/false);
+    m_rx_crypto = ceph::crypto::onwire::rxtx_t::create_handler_pair(
+        g_ceph_context, auth_meta, /*new_nonce_format=*/true,
+        /*crossed=*/true);
+    m_tx_frame_asm.set_is_chunked_seal(true);
+    m_rx_frame_asm.set_is_chunked_seal(true);
+  }
+
+  static bufferlist make_random_bufferlist(size_t len) {
+    bufferlist bl;
+    if (len > 0) {
+      std::string s(len, '\0');
+      g_ceph_context->random()->get_bytes(s.data(), s.size());
+      bl.append(s);
+    }
+    return bl;
+  }
+
+  ceph::crypto::onwire::rxtx_t m_tx_crypto;
+  ceph::crypto::onwire::rxtx_t m_rx_crypto;
+  FrameAssembler m_tx_frame_asm;
+  FrameAssembler m_rx_frame_asm;
+};
+
+TEST_P(ChunkedSealTest, RoundTrip) {
+  const auto data_len = GetParam();
+  const auto header = make_random_bufferlist(20);
+  const auto front = make_random_bufferlist(70);
+  const auto data = make_random_bufferlist(data_len);
+  const uint32_t padded_len = p2roundup<uint32_t>(70, CRYPTO_BLOCK_SIZE) +
+                              p2roundup<uint32_t>(data_len, CRYPTO_BLOCK_SIZE);
+  const uint32_t num_chunks = padded_len > FRAME_SEAL_CHUNK_SIZE ?
+      div_round_up(padded_len, FRAME_SEAL_CHUNK_SIZE) : 0;
+
+  for (int i = 0; i < 3; i++) {
+    auto tx_frame = TestFrame::Encode(header, front, bufferlist(), data);
+    auto onwire_bl = tx_frame.get_buffer(m_tx_frame_asm);
+    EXPECT_EQ(m_tx_frame_asm.get_frame_onwire_len(), onwire_bl.length());
+    EXPECT_EQ(sizeof(epilogue_secure_rev1_block_t) + 16 * (num_chunks + 1),
+              m_tx_frame_asm.get_epilogue_onwire_len());
+
+    Tag rx_tag;
+    segment_bls_t rx_segment_bls;
+    EXPECT_TRUE(disassemble_frame(m_rx_frame_asm, onwire_bl, rx_tag,
+                                  rx_segment_bls));
+    EXPECT_EQ(m_tx_frame_asm.get_epilogue_onwire_len(),
+              m_rx_frame_asm.get_epilogue_onwire_len());
+    EXPECT_EQ(0, onwire_bl.length());
+    EXPECT_EQ(TestFrame::tag, rx_tag);
+
+    auto rx_frame = TestFrame::Decode(rx_segment_bls);
+    EXPECT_TRUE(header.contents_equal(rx_frame.header()));
+    EXPECT_TRUE(front.contents_equal(rx_frame.front()));
+    EXPECT_EQ(0, rx_frame.middle().length());
+    EXPECT_TRUE(data.contents_equal(rx_frame.data()));
+  }
+}
+
+TEST_P(ChunkedSealTest, Tampered) {
+  const auto data_len = GetParam();
+  auto tx_frame = TestFrame::Encode(make_random_bufferlist(20),
+                                    make_random_bufferlist(70), bufferlist(),
+                                    make_random_bufferlist(data_len));
+  auto onwire_bl = tx_frame.get_buffer(m_tx_frame_asm);
+
+  // flip a bit in the last byte of the data segment
+  const uint32_t off = onwire_bl.length() -
+                       m_tx_frame_asm.get_epilogue_onwire_len() - 1;
+  char c;
+  onwire_bl.begin(off).copy(1, &c);
+  c ^= 1;
+  onwire_bl.begin(off).copy_in(1, &c);
+
+  Tag rx_tag;
+  segment_bls_t rx_segment_bls;
+  EXPECT_THROW(disassemble_frame(m_rx_frame_asm, onwire_bl, rx_tag,
+                                 rx_segment_bls),
+               ceph::crypto::onwire::MsgAuthError);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ChunkedSealTests, ChunkedSealTest, ::testing::Values(
+        // sealed together with the epilogue
+        303, FRAME_SEAL_CHUNK_SIZE - 80,
+        // chunked, last chunk full or partial
+        FRAME_SEAL_CHUNK_SIZE - 79, 2 * FRAME_SEAL_CHUNK_SIZE - 80,
+        4194304 + 1));
+
 class RoundTripPerfTest : public RoundTripTestBase {};
 
 TEST_P(RoundTripPerfTest, DISABLED_Basic) {
@@ -30,6 +30,8 @@
 #include "msg/Message.h"
 #include "msg/Messenger.h"
 #include "msg/Connection.h"
+#include "msg/async/AsyncConnection.h"
+#include "msg/async/AsyncMessenger.h"
 #include "messages/MPing.h"
 #include "messages/MCommand.h"
 
@@ -1057,6 +1059,62 @@ TEST_P(MessengerTest, SimpleMsgr2Test) {
   server_msgr->wait();
 }
 
+TEST_P(MessengerTest, ConnectionMigrationTest) {
+  AsyncMessenger *async_client = dynamic_cast<AsyncMessenger*>(client_msgr);
+  if (!async_client ||
+      !async_client->get_stack()->support_connection_migration()) {
+    GTEST_SKIP() << "connection migration not supported";
+  }
+  FakeDispatcher cli_dispatcher(false), srv_dispatcher(true);
+  entity_addr_t bind_addr;
+  bind_addr.parse("v2:127.0.0.1");
+  server_msgr->bind(bind_addr);
+  server_msgr->add_dispatcher_head(&srv_dispatcher);
+  server_msgr->start();
+
+  client_msgr->add_dispatcher_head(&cli_dispatcher);
+  client_msgr->start();
+
+  auto round_trip = [&](ConnectionRef conn) {
+    ASSERT_EQ(conn->send_message(new MPing()), 0);
+    std::unique_lock l{cli_dispatcher.lock};
+    cli_dispatcher.cond.wait(l, [&] { return cli_dispatcher.got_new; });
+    cli_dispatcher.got_new = false;
+  };
+  ConnectionRef conn = client_msgr->connect_to(
+    server_msgr->get_mytype(),
+    server_msgr->get_myaddrs());
+  round_trip(conn);
+  ASSERT_TRUE(conn->is_connected());
+
+  // move the established connection to another worker, back and forth
+  auto async_conn = static_cast<AsyncConnection*>(conn.get());
+  NetworkStack *stack = async_client->get_stack();
+  for (int i = 0; i < 4; i++) {
+    unsigned from = async_conn->get_worker_id();
+    Worker *target = stack->get_worker((from + 1) % stack->get_num_worker());
+    ASSERT_NE(from, target->id);
+    uint64_t migrated = target->perf_logger->get(l_msgr_migrated_connections);
+    async_conn->request_migration(target);
+    CHECK_AND_WAIT_TRUE(async_conn->get_worker_id() == target->id);
+    ASSERT_EQ(target->id, async_conn->get_worker_id());
+    ASSERT_EQ(migrated + 1,
+	      target->perf_logger->get(l_msgr_migrated_connections));
+
+    // the moved connection keeps its session and delivers in order
+    for (int j = 0; j < 8; j++) {
+      round_trip(conn);
+    }
+    ASSERT_TRUE(conn->is_connected());
+  }
+  ASSERT_EQ(33u, static_cast<Session*>(conn->get_priv().get())->get_count());
+
+  client_msgr->shutdown();
+  client_msgr->wait();
+  server_msgr->shutdown();
+  server_msgr->wait();
+}
+
 TEST_P(MessengerTest, FeatureTest) {
   FakeDispatcher cli_dispatcher(false), srv_dispatcher(true);
   entity_addr_t bind_addr;
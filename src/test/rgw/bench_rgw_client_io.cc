@@ -0,0 +1,160 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+/*
+ * Measures the CPU spent per GiB of GET data between the read bufferlists
+ * and the front-end: sending each read flattened through c_str() and
+ * send_body(), as GETs used to, or as it is through send_body_bl(). The
+ * data goes through the accounting and chunking filters of the beast
+ * front-end to a stand-in for its socket, which only counts the bytes.
+ *
+ *   ceph_bench_rgw_client_io --mode bl --read-size 4194304 --segments 64
+ */
+
+#include <ctime>
+#include <iostream>
+
+#include "common/ceph_argparse.h"
+#include "common/common_init.h"
+#include "global/global_init.h"
+#include "global/global_context.h"
+#include "rgw/rgw_client_io.h"
+#include "rgw/rgw_client_io_filters.h"
+
+using namespace rgw::io;
+
+// stands in for the socket of the front-end
+class SocketStandIn : public RestfulClient {
+  RGWEnv env;
+
+public:
+  uint64_t bytes = 0;
+  uint64_t writes = 0;
+
+  int init_env(CephContext *cct) override { return 0; }
+  RGWEnv& get_env() noexcept override { return env; }
+  size_t send_100_continue() override { return 0; }
+  size_t send_status(int status, const char *status_name) override { return 0; }
+  size_t send_header(const std::string_view& name,
+                     const std::string_view& value) override { return 0; }
+  size_t send_content_length(uint64_t len) override { return 0; }
+  size_t complete_header() override { return 0; }
+  size_t recv_body(char* buf, size_t max) override { return 0; }
+  void flush() override {}
+  size_t complete_request() override { return 0; }
+
+  size_t send_body(const char* buf, size_t len) override {
+    bytes += len;
+    ++writes;
+    return len;
+  }
+
+  // a scatter-gather write of all the buffers
+  size_t send_body_bl(const ceph::bufferlist& bl) override {
+    bytes += bl.length();
+    ++writes;
+    return bl.length();
+  }
+};
+
+static void usage(const char* name)
+{
+  std::cerr << "usage: " << name << " [options]\n"
+      << "  --mode <copy|bl>      send_body() of c_str(), or send_body_bl() (default bl)\n"
+      << "  --chunked             use the chunked transfer encoding\n"
+      << "  --read-size <bytes>   size of each read (default 4M)\n"
+      << "  --segments <n>        buffers in each read bufferlist (default 64)\n"
+      << "  --total <bytes>       data sent (default 16G)\n"
+      << std::endl;
+}
+
+int main(int argc, const char **argv)
+{
+  std::vector<const char*> args;
+  argv_to_vec(argc, argv, args);
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+
+  std::string mode = "bl";
+  bool chunked = false;
+  long long read_size = 4 << 20;
+  int segments = 64;
+  long long total = 16ll << 30;
+  std::ostringstream err;
+  for (auto i = args.begin(); i != args.end();) {
+    if (ceph_argparse_witharg(args, i, &mode, "--mode", (char*)NULL)) {
+    } else if (ceph_argparse_flag(args, i, "--chunked", (char*)NULL)) {
+      chunked = true;
+    } else if (ceph_argparse_witharg(args, i, &read_size, err, "--read-size", (char*)NULL) ||
+               ceph_argparse_witharg(args, i, &segments, err, "--segments", (char*)NULL) ||
+               ceph_argparse_witharg(args, i, &total, err, "--total", (char*)NULL)) {
+      if (!err.str().empty()) {
+	std::cerr << argv[0] << ": " << err.str() << std::endl;
+	return EXIT_FAILURE;
+      }
+    } else if (ceph_argparse_flag(args, i, "-h", "--help", (char*)NULL)) {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else {
+      std::cerr << argv[0] << ": unknown option " << *i << std::endl;
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if ((mode != "copy" && mode != "bl") || segments < 1 ||
+      read_size < segments || total < read_size) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // a read as it comes from rados, in several buffers
+  bufferlist source;
+  for (int i = 0; i < segments; i++) {
+    bufferptr p(read_size / segments);
+    memset(p.c_str(), 'a' + i % 16, p.length());
+    source.append(std::move(p));
+  }
+
+  SocketStandIn socket;
+  AccountingFilter<ChunkingFilter<SocketStandIn*>> client(
+    g_ceph_context, ChunkingFilter<SocketStandIn*>(&socket));
+  client.set_account(true);
+  if (chunked) {
+    client.send_chunked_transfer_encoding();
+  }
+
+  uint64_t sent = 0;
+  const auto start = std::clock();
+  while (sent < (uint64_t)total) {
+    // shares the buffers of the source, as the read results do
+    bufferlist bl = source;
+    if (mode == "copy") {
+      client.send_body(bl.c_str(), bl.length());
+    } else {
+      client.send_body_bl(bl);
+    }
+    sent += bl.length();
+  }
+  client.complete_request();
+  const double cpu = double(std::clock() - start) / CLOCKS_PER_SEC;
+
+  std::cout << "mode=" << mode << " chunked=" << chunked
+      << " read_size=" << read_size << " segments=" << segments
+      << " sent=" << sent << " accounted=" << client.get_bytes_sent()
+      << " writes=" << socket.writes
+      << " cpu=" << cpu << "s"
+      << " cpu_per_gib=" << (cpu / (double(sent) / (1ll << 30))) << "s"
+      << std::endl;
+  return EXIT_SUCCESS;
+}
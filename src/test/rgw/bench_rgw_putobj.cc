@@ -0,0 +1,210 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+/*
+ * Measures the throughput of the PUT data path above the RADOS writes: the
+ * MD5 of the object data plus compression or encryption, run inline or on
+ * the offload pool. The writes go to a stand-in for RADOS which only counts
+ * the bytes and optionally waits a fixed latency per write.
+ *
+ *   ceph_bench_rgw_putobj --filter compress --threads 4 --window 4
+ */
+
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <thread>
+
+#include "common/ceph_argparse.h"
+#include "common/ceph_crypto.h"
+#include "common/common_init.h"
+#include "common/errno.h"
+#include "compressor/Compressor.h"
+#include "global/global_init.h"
+#include "global/global_context.h"
+#include "rgw/rgw_compression.h"
+#include "rgw/rgw_crypt.h"
+#include "rgw/rgw_putobj.h"
+#include "rgw/rgw_putobj_pipeline.h"
+
+std::unique_ptr<BlockCrypt> AES_256_CBC_create(CephContext* cct, const uint8_t* key, size_t len);
+
+using namespace std::chrono;
+
+// stands in for the rados writes of the object processor
+struct RadosStandIn : rgw::putobj::DataProcessor {
+  microseconds latency;
+  uint64_t bytes = 0;
+  uint64_t writes = 0;
+
+  explicit RadosStandIn(microseconds latency) : latency(latency) {}
+
+  int process(bufferlist&& data, uint64_t offset) override {
+    if (data.length() == 0) {
+      return 0;
+    }
+    bytes += data.length();
+    ++writes;
+    if (latency.count()) {
+      std::this_thread::sleep_for(latency);
+    }
+    return 0;
+  }
+};
+
+static void usage(const char* name)
+{
+  std::cerr << "usage: " << name << " [options]\n"
+      << "  --filter <none|compress|encrypt>  transform of the object data (default none)\n"
+      << "  --compression <plugin>             compression plugin (default zlib)\n"
+      << "  --threads <n>                      offload threads, 0 runs inline (default 0)\n"
+      << "  --window <n>                       chunks in flight per stage (default 4)\n"
+      << "  --obj-size <bytes>                 size of each object (default 64M)\n"
+      << "  --recv-size <bytes>                size of each frontend read (default 4M)\n"
+      << "  --objects <n>                      objects written (default 16)\n"
+      << "  --write-latency-us <us>            latency of each rados write (default 0)\n"
+      << std::endl;
+}
+
+int main(int argc, const char **argv)
+{
+  std::vector<const char*> args;
+  argv_to_vec(argc, argv, args);
+  auto cct = global_init(NULL, args, CEPH_ENTITY_TYPE_CLIENT,
+			 CODE_ENVIRONMENT_UTILITY,
+			 CINIT_FLAG_NO_DEFAULT_CONFIG_FILE);
+  common_init_finish(g_ceph_context);
+
+  std::string filter_type = "none";
+  std::string compression = "zlib";
+  int threads = 0;
+  int window = 4;
+  long long obj_size = 64 << 20;
+  long long recv_size = 4 << 20;
+  int objects = 16;
+  int write_latency_us = 0;
+  std::ostringstream err;
+  for (auto i = args.begin(); i != args.end();) {
+    if (ceph_argparse_witharg(args, i, &filter_type, "--filter", (char*)NULL)) {
+    } else if (ceph_argparse_witharg(args, i, &compression, "--compression", (char*)NULL)) {
+    } else if (ceph_argparse_witharg(args, i, &threads, err, "--threads", (char*)NULL) ||
+               ceph_argparse_witharg(args, i, &window, err, "--window", (char*)NULL) ||
+               ceph_argparse_witharg(args, i, &obj_size, err, "--obj-size", (char*)NULL) ||
+               ceph_argparse_witharg(args, i, &recv_size, err, "--recv-size", (char*)NULL) ||
+               ceph_argparse_witharg(args, i, &objects, err, "--objects", (char*)NULL) ||
+               ceph_argparse_witharg(args, i, &write_latency_us, err, "--write-latency-us", (char*)NULL)) {
+      if (!err.str().empty()) {
+	std::cerr << argv[0] << ": " << err.str() << std::endl;
+	return EXIT_FAILURE;
+      }
+    } else if (ceph_argparse_flag(args, i, "-h", "--help", (char*)NULL)) {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else {
+      std::cerr << argv[0] << ": unknown option " << *i << std::endl;
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (filter_type != "none" && filter_type != "compress" &&
+      filter_type != "encrypt") {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (threads < 0 || window < 1 || obj_size < 1 || recv_size < 1 || objects < 1) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  CompressorRef plugin;
+  if (filter_type == "compress") {
+    plugin = Compressor::create(g_ceph_context, compression);
+    if (!plugin) {
+      std::cerr << "cannot load compression plugin " << compression << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  uint8_t key[32];
+  for (size_t i = 0; i < sizeof(key); i++) {
+    key[i] = i;
+  }
+
+  // somewhat compressible data, as received from the frontend
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> dist('a', 'p');
+  bufferptr source(recv_size);
+  for (unsigned i = 0; i < source.length(); i++) {
+    source.c_str()[i] = dist(rng);
+  }
+
+  std::optional<boost::asio::thread_pool> pool;
+  if (threads > 0) {
+    pool.emplace(threads);
+  }
+  auto pool_ptr = pool ? &*pool : nullptr;
+
+  RadosStandIn rados(microseconds(write_latency_us));
+  uint64_t received = 0;
+  const auto start = steady_clock::now();
+  for (int n = 0; n < objects; n++) {
+    rgw::putobj::DataProcessor* filter = &rados;
+    std::optional<RGWPutObj_Compress> compressor;
+    std::optional<RGWPutObj_BlockEncrypt> encrypt;
+    if (filter_type == "compress") {
+      compressor.emplace(g_ceph_context, plugin, filter, pool_ptr, window);
+      filter = &*compressor;
+    } else if (filter_type == "encrypt") {
+      encrypt.emplace(g_ceph_context, filter,
+                      AES_256_CBC_create(g_ceph_context, key, sizeof(key)),
+                      pool_ptr, window);
+      filter = &*encrypt;
+    }
+    rgw::putobj::OffloadedMD5 hash(pool_ptr, window);
+
+    uint64_t ofs = 0;
+    while (ofs < (uint64_t)obj_size) {
+      bufferlist data;
+      data.append(source, 0, std::min<uint64_t>(recv_size, obj_size - ofs));
+      const auto len = data.length();
+      hash.Update(data);
+      int r = filter->process(std::move(data), ofs);
+      if (r < 0) {
+        std::cerr << "process failed: " << cpp_strerror(r) << std::endl;
+        return EXIT_FAILURE;
+      }
+      ofs += len;
+    }
+    int r = filter->process({}, ofs);
+    if (r < 0) {
+      std::cerr << "flush failed: " << cpp_strerror(r) << std::endl;
+      return EXIT_FAILURE;
+    }
+    unsigned char m[CEPH_CRYPTO_MD5_DIGESTSIZE];
+    hash.Final(m);
+    received += ofs;
+  }
+  const auto elapsed = duration<double>(steady_clock::now() - start).count();
+  if (pool) {
+    pool->join();
+  }
+
+  std::cout << "filter=" << filter_type
+      << " threads=" << threads << " window=" << window
+      << " objects=" << objects << " obj_size=" << obj_size
+      << " received=" << received << " written=" << rados.bytes
+      << " writes=" << rados.writes
+      << " elapsed=" << elapsed << "s"
+      << " throughput=" << (received / elapsed / (1 << 20)) << "MiB/s"
+      << std::endl;
+  return EXIT_SUCCESS;
+}
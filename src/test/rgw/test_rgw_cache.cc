@@ -0,0 +1,341 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include <set>
+#include <thread>
+
+#include "rgw/rgw_cache.h"
+#include "common/dout.h"
+#include "global/global_context.h"
+#include <gtest/gtest.h>
+
+#define dout_subsys ceph_subsys_rgw
+
+struct TestChainedCache : RGWChainedCache {
+  std::set<string> entries;
+  bool all_invalidated = false;
+
+  void chain_cb(const string& key, void *data) override {
+    entries.insert(key);
+  }
+  void invalidate(const string& key) override {
+    entries.erase(key);
+  }
+  void invalidate_all() override {
+    entries.clear();
+    all_invalidated = true;
+  }
+};
+
+class ObjectCacheTest : public ::testing::Test {
+ protected:
+  NoDoutPrefix dpp{g_ceph_context, dout_subsys};
+  ObjectCache cache;
+
+  void SetUp() override {
+    g_ceph_context->_conf.set_val("rgw_cache_lru_size", "10000");
+    g_ceph_context->_conf.set_val("rgw_cache_negative_expiry_interval", "60");
+    cache.set_ctx(g_ceph_context);
+    cache.set_enabled(true);
+  }
+
+  void put_data(const string& name, const string& data,
+                rgw_cache_entry_info *cache_info = nullptr) {
+    ObjectCacheInfo info;
+    info.flags = CACHE_FLAG_DATA;
+    info.data.append(data);
+    cache.put(&dpp, name, info, cache_info);
+  }
+
+  size_t count() {
+    size_t n = 0;
+    cache.for_each([&n] (const string&, const ObjectCacheEntry&) { ++n; });
+    return n;
+  }
+};
+
+TEST_F(ObjectCacheTest, PutGetRemove)
+{
+  for (int i = 0; i < 100; i++) {
+    put_data("obj" + std::to_string(i), std::to_string(i));
+  }
+  EXPECT_EQ(100u, count());
+  for (int i = 0; i < 100; i++) {
+    ObjectCacheInfo info;
+    ASSERT_EQ(0, cache.get(&dpp, "obj" + std::to_string(i), info,
+                           CACHE_FLAG_DATA, nullptr));
+    EXPECT_EQ(std::to_string(i), info.data.to_str());
+  }
+  ObjectCacheInfo info;
+  EXPECT_EQ(-ENOENT, cache.get(&dpp, "obj5", info, CACHE_FLAG_XATTRS, nullptr));
+
+  EXPECT_TRUE(cache.remove(&dpp, "obj5"));
+  EXPECT_FALSE(cache.remove(&dpp, "obj5"));
+  EXPECT_EQ(-ENOENT, cache.get(&dpp, "obj5", info, CACHE_FLAG_DATA, nullptr));
+  EXPECT_EQ(99u, count());
+
+  cache.invalidate_all();
+  EXPECT_EQ(0u, count());
+}
+
+TEST_F(ObjectCacheTest, NegativeEntry)
+{
+  ObjectCacheInfo info;
+  info.status = -ENOENT;
+  cache.put(&dpp, "missing", info, nullptr);
+  EXPECT_EQ(-ENODATA, cache.get(&dpp, "missing", info, 0, nullptr));
+
+  put_data("missing", "created");
+  ASSERT_EQ(0, cache.get(&dpp, "missing", info, CACHE_FLAG_DATA, nullptr));
+  EXPECT_EQ("created", info.data.to_str());
+}
+
+TEST_F(ObjectCacheTest, NegativeExpiry)
+{
+  g_ceph_context->_conf.set_val("rgw_cache_negative_expiry_interval", "1");
+  cache.set_ctx(g_ceph_context);
+  cache.set_enabled(true);
+
+  ObjectCacheInfo info;
+  info.status = -ENOENT;
+  cache.put(&dpp, "missing", info, nullptr);
+  put_data("present", "data");
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+  // the negative entry expires sooner than the others
+  EXPECT_EQ(-ENOENT, cache.get(&dpp, "missing", info, 0, nullptr));
+  EXPECT_EQ(0, cache.get(&dpp, "present", info, CACHE_FLAG_DATA, nullptr));
+}
+
+TEST_F(ObjectCacheTest, LRUSizeAcrossShards)
+{
+  g_ceph_context->_conf.set_val("rgw_cache_lru_size", "64");
+  cache.set_ctx(g_ceph_context);
+  cache.set_enabled(true);
+
+  for (int i = 0; i < 1000; i++) {
+    put_data("obj" + std::to_string(i), "x");
+  }
+  // each shard may go over its share by the entry being touched
+  const auto shards = g_ceph_context->_conf.get_val<uint64_t>("rgw_cache_shards");
+  EXPECT_LE(count(), 64 + shards);
+  // the last ones written are still there
+  ObjectCacheInfo info;
+  EXPECT_EQ(0, cache.get(&dpp, "obj999", info, CACHE_FLAG_DATA, nullptr));
+}
+
+TEST_F(ObjectCacheTest, ChainAcrossShards)
+{
+  TestChainedCache chained;
+  cache.chain_cache(&chained);
+
+  std::vector<rgw_cache_entry_info> infos(8);
+  for (size_t i = 0; i < infos.size(); i++) {
+    put_data("obj" + std::to_string(i), "x", &infos[i]);
+  }
+  const string key = "chained";
+  RGWChainedCache::Entry entry(&chained, key, nullptr);
+  ASSERT_TRUE(cache.chain_cache_entry(&dpp, {&infos[0], &infos[3], &infos[7]},
+                                      &entry));
+  EXPECT_EQ(1u, chained.entries.count(key));
+
+  // an update of any of the entries invalidates the chained entry
+  put_data("obj3", "y");
+  EXPECT_EQ(0u, chained.entries.count(key));
+
+  // entries which changed since they were read can't be chained
+  EXPECT_FALSE(cache.chain_cache_entry(&dpp, {&infos[0], &infos[3]}, &entry));
+  EXPECT_EQ(0u, chained.entries.count(key));
+
+  cache.invalidate_all();
+  EXPECT_TRUE(chained.all_invalidated);
+  cache.unchain_cache(&chained);
+}
+
+TEST_F(ObjectCacheTest, Concurrent)
+{
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([this, t] {
+        for (int i = 0; i < 2000; i++) {
+          const auto name = "obj" + std::to_string((i * 7 + t) % 500);
+          ObjectCacheInfo info;
+          if (cache.get(&dpp, name, info, CACHE_FLAG_DATA, nullptr) < 0) {
+            put_data(name, name);
+          } else {
+            ASSERT_EQ(name, info.data.to_str());
+          }
+          if (i % 100 == 0) {
+            cache.remove(&dpp, name);
+          }
+        }
+      });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_LE(count(), 500u);
+}
+
+static RGWCacheNotifyInfo make_update(const string& oid, uint32_t flags,
+                                      const string& xattr = "")
+{
+  RGWCacheNotifyInfo info;
+  info.op = UPDATE_OBJ;
+  info.obj = rgw_raw_obj(rgw_pool("pool"), oid);
+  info.obj_info.flags = flags;
+  if (!xattr.empty()) {
+    info.obj_info.xattrs[xattr].append("value");
+  }
+  return info;
+}
+
+static RGWCacheNotifyInfo make_remove(const string& oid)
+{
+  RGWCacheNotifyInfo info;
+  info.op = REMOVE_OBJ;
+  info.obj = rgw_raw_obj(rgw_pool("pool"), oid);
+  return info;
+}
+
+constexpr uint32_t FULL_WRITE = CACHE_FLAG_DATA | CACHE_FLAG_XATTRS | CACHE_FLAG_META;
+constexpr uint32_t XATTR_DELTA = CACHE_FLAG_MODIFY_XATTRS;
+
+TEST(RGWCacheNotifyBatch, Coalesce)
+{
+  RGWCacheNotifyBatch batch;
+  EXPECT_EQ(0u, batch.add("a", make_update("a", XATTR_DELTA, "x1")));
+  EXPECT_EQ(0u, batch.add("a", make_update("a", XATTR_DELTA, "x2")));
+  EXPECT_EQ(0u, batch.add("b", make_update("b", XATTR_DELTA, "x1")));
+  EXPECT_EQ("a", batch.key);
+
+  // a full write replaces the updates queued for its entry only
+  EXPECT_EQ(2u, batch.add("a", make_update("a", FULL_WRITE)));
+  ASSERT_EQ(1u, batch.updates["a"].size());
+  EXPECT_EQ(1u, batch.updates["b"].size());
+
+  // a remove too
+  EXPECT_EQ(1u, batch.add("a", make_remove("a")));
+  ASSERT_EQ(1u, batch.updates["a"].size());
+  EXPECT_EQ((uint32_t)REMOVE_OBJ, batch.updates["a"][0].op);
+
+  // and a full write following the remove
+  EXPECT_EQ(1u, batch.add("a", make_update("a", FULL_WRITE)));
+
+  auto notify = batch.make_notify();
+  EXPECT_EQ((uint32_t)BATCH_OBJS, notify.op);
+  ASSERT_EQ(2u, notify.batch.size());
+  EXPECT_EQ("a", notify.batch[0].obj.oid);
+  EXPECT_EQ(FULL_WRITE, notify.batch[0].obj_info.flags);
+  EXPECT_EQ("b", notify.batch[1].obj.oid);
+  EXPECT_TRUE(batch.updates.empty());
+}
+
+TEST(RGWCacheNotifyBatch, PartialUpdatesKeepOrder)
+{
+  RGWCacheNotifyBatch batch;
+  // none of these replaces the entry: xattr deltas, a write of the data
+  // alone, a full write of a negative entry
+  EXPECT_EQ(0u, batch.add("a", make_update("a", FULL_WRITE)));
+  EXPECT_EQ(0u, batch.add("a", make_update("a", XATTR_DELTA, "x1")));
+  EXPECT_EQ(0u, batch.add("a", make_update("a", CACHE_FLAG_DATA)));
+  auto negative = make_update("a", FULL_WRITE);
+  negative.obj_info.status = -ENOENT;
+  EXPECT_EQ(0u, batch.add("a", std::move(negative)));
+  EXPECT_EQ(0u, batch.add("a", make_update("a", FULL_WRITE | XATTR_DELTA, "x2")));
+
+  auto notify = batch.make_notify();
+  ASSERT_EQ(5u, notify.batch.size());
+  EXPECT_EQ(FULL_WRITE, notify.batch[0].obj_info.flags);
+  EXPECT_EQ(1u, notify.batch[1].obj_info.xattrs.count("x1"));
+  EXPECT_EQ((uint32_t)CACHE_FLAG_DATA, notify.batch[2].obj_info.flags);
+  EXPECT_EQ(-ENOENT, notify.batch[3].obj_info.status);
+  EXPECT_EQ(1u, notify.batch[4].obj_info.xattrs.count("x2"));
+}
+
+// RGWCacheNotifyInfo as encoded and decoded before BATCH_OBJS
+struct RGWCacheNotifyInfoV2 {
+  uint32_t op = 0;
+  rgw_raw_obj obj;
+  ObjectCacheInfo obj_info;
+  off_t ofs = 0;
+  string ns;
+
+  void encode(bufferlist& bl) const {
+    ENCODE_START(2, 2, bl);
+    encode(op, bl);
+    encode(obj, bl);
+    encode(obj_info, bl);
+    encode(ofs, bl);
+    encode(ns, bl);
+    ENCODE_FINISH(bl);
+  }
+  void decode(bufferlist::const_iterator& bl) {
+    DECODE_START_LEGACY_COMPAT_LEN(2, 2, 2, bl);
+    decode(op, bl);
+    decode(obj, bl);
+    decode(obj_info, bl);
+    decode(ofs, bl);
+    decode(ns, bl);
+    DECODE_FINISH(bl);
+  }
+};
+WRITE_CLASS_ENCODER(RGWCacheNotifyInfoV2)
+
+TEST(RGWCacheNotifyInfo, EncodeBatch)
+{
+  RGWCacheNotifyBatch batch;
+  batch.add("a", make_update("a", FULL_WRITE));
+  batch.add("b", make_remove("b"));
+  bufferlist bl;
+  encode(batch.make_notify(), bl);
+
+  RGWCacheNotifyInfo info;
+  auto p = bl.cbegin();
+  decode(info, p);
+  EXPECT_EQ((uint32_t)BATCH_OBJS, info.op);
+  ASSERT_EQ(2u, info.batch.size());
+  EXPECT_EQ((uint32_t)UPDATE_OBJ, info.batch[0].op);
+  EXPECT_EQ("a", info.batch[0].obj.oid);
+  EXPECT_EQ(FULL_WRITE, info.batch[0].obj_info.flags);
+  EXPECT_EQ((uint32_t)REMOVE_OBJ, info.batch[1].op);
+  EXPECT_EQ("b", info.batch[1].obj.oid);
+
+  // an older gateway skips the batch, and ignores the unknown op
+  RGWCacheNotifyInfoV2 old;
+  p = bl.cbegin();
+  decode(old, p);
+  EXPECT_EQ((uint32_t)BATCH_OBJS, old.op);
+  EXPECT_TRUE(p.end());
+}
+
+TEST(RGWCacheNotifyInfo, DecodeV2)
+{
+  RGWCacheNotifyInfoV2 old;
+  old.op = UPDATE_OBJ;
+  old.obj = rgw_raw_obj(rgw_pool("pool"), "a");
+  old.obj_info.flags = FULL_WRITE;
+  old.obj_info.data.append("data");
+  old.ns = "ns";
+  bufferlist bl;
+  encode(old, bl);
+
+  RGWCacheNotifyInfo info;
+  auto p = bl.cbegin();
+  decode(info, p);
+  EXPECT_EQ((uint32_t)UPDATE_OBJ, info.op);
+  EXPECT_EQ(old.obj, info.obj);
+  EXPECT_EQ(FULL_WRITE, info.obj_info.flags);
+  EXPECT_EQ("data", info.obj_info.data.to_str());
+  EXPECT_EQ("ns", info.ns);
+  EXPECT_TRUE(info.batch.empty());
+}
@@ -0,0 +1,203 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include "rgw/rgw_client_io.h"
+#include "rgw/rgw_client_io_filters.h"
+#include "global/global_context.h"
+#include <gtest/gtest.h>
+
+using namespace rgw::io;
+
+// records what the filters hand to the front-end
+class MockClient : public RestfulClient {
+  RGWEnv env;
+
+public:
+  int init_env(CephContext *cct) override {
+    return 0;
+  }
+
+  std::string headers;
+  std::string body;
+  std::optional<uint64_t> content_length;
+  size_t body_writes = 0;
+  bool completed = false;
+  /* everything written to the client */
+  uint64_t sent = 0;
+
+  RGWEnv& get_env() noexcept override {
+    return env;
+  }
+
+  size_t send_100_continue() override {
+    return 0;
+  }
+
+  size_t send_status(int status, const char *status_name) override {
+    const auto line = std::to_string(status) + " " + status_name + "\r\n";
+    headers += line;
+    sent += line.size();
+    return line.size();
+  }
+
+  size_t send_header(const std::string_view& name,
+                     const std::string_view& value) override {
+    const auto line = std::string(name) + ": " + std::string(value) + "\r\n";
+    headers += line;
+    sent += line.size();
+    return line.size();
+  }
+
+  size_t send_content_length(uint64_t len) override {
+    content_length = len;
+    return send_header("Content-Length", std::to_string(len));
+  }
+
+  size_t complete_header() override {
+    headers += "\r\n";
+    sent += 2;
+    return 2;
+  }
+
+  size_t recv_body(char* buf, size_t max) override {
+    return 0;
+  }
+
+  size_t send_body(const char* buf, size_t len) override {
+    body.append(buf, len);
+    ++body_writes;
+    sent += len;
+    return len;
+  }
+
+  size_t send_body_bl(const ceph::bufferlist& bl) override {
+    body += bl.to_str();
+    ++body_writes;
+    sent += bl.length();
+    return bl.length();
+  }
+
+  void flush() override {}
+
+  size_t complete_request() override {
+    completed = true;
+    return 0;
+  }
+};
+
+// a bufferlist of several buffers, like the data of a GET
+static ceph::bufferlist make_data()
+{
+  ceph::bufferlist bl;
+  bl.append(std::string(1000, 'a'));
+  bl.append(std::string(24, 'b'));
+  bl.append(std::string(3000, 'c'));
+  return bl;
+}
+
+TEST(ClientIOChunking, FramingMatchesSendBody)
+{
+  const auto data = make_data();
+  ASSERT_GT(data.get_num_buffers(), 1u);
+
+  MockClient plain;
+  ChunkingFilter<MockClient*> chunked_plain(&plain);
+  chunked_plain.send_chunked_transfer_encoding();
+  chunked_plain.send_body(data.to_str().data(), data.length());
+  chunked_plain.complete_request();
+
+  MockClient bl;
+  ChunkingFilter<MockClient*> chunked_bl(&bl);
+  chunked_bl.send_chunked_transfer_encoding();
+  const auto sent = chunked_bl.send_body_bl(data);
+  chunked_bl.complete_request();
+
+  const auto expected = "fb8\r\n" + data.to_str() + "\r\n0\r\n\r\n";
+  EXPECT_EQ(expected, plain.body);
+  EXPECT_EQ(expected, bl.body);
+  EXPECT_EQ(plain.headers, bl.headers);
+  EXPECT_EQ(expected.size() - 5, sent);
+  // the header, data and trailer of a chunk go out in a single write
+  EXPECT_EQ(3u + 1u, plain.body_writes);
+  EXPECT_EQ(1u + 1u, bl.body_writes);
+}
+
+TEST(ClientIOChunking, Disabled)
+{
+  const auto data = make_data();
+  MockClient client;
+  ChunkingFilter<MockClient*> chunked(&client);
+  EXPECT_EQ(data.length(), chunked.send_body_bl(data));
+  chunked.complete_request();
+  EXPECT_EQ(data.to_str(), client.body);
+  EXPECT_EQ(1u, client.body_writes);
+}
+
+TEST(ClientIOBuffering, DeferredUntilComplete)
+{
+  const auto data = make_data();
+  MockClient client;
+  BufferingFilter<MockClient*> buffering(g_ceph_context, &client);
+  buffering.send_status(200, "OK");
+  // no content length, the body is held back to compute it
+  EXPECT_EQ(0u, buffering.complete_header());
+  EXPECT_EQ(0u, buffering.send_body_bl(data));
+  EXPECT_EQ(0u, buffering.send_body("xyz", 3));
+  EXPECT_TRUE(client.body.empty());
+  EXPECT_FALSE(client.content_length);
+
+  EXPECT_EQ(data.length() + 3, buffering.complete_request());
+  EXPECT_EQ(data.length() + 3, client.content_length);
+  EXPECT_EQ(data.to_str() + "xyz", client.body);
+  EXPECT_EQ(1u, client.body_writes);
+  EXPECT_TRUE(client.completed);
+}
+
+TEST(ClientIOBuffering, ContentLength)
+{
+  const auto data = make_data();
+  MockClient client;
+  BufferingFilter<MockClient*> buffering(g_ceph_context, &client);
+  buffering.send_status(200, "OK");
+  buffering.send_content_length(data.length());
+  buffering.complete_header();
+  // sent through at once
+  EXPECT_EQ(data.length(), buffering.send_body_bl(data));
+  EXPECT_EQ(data.to_str(), client.body);
+  buffering.complete_request();
+  EXPECT_EQ(1u, client.body_writes);
+}
+
+TEST(ClientIOAccounting, Totals)
+{
+  const auto data = make_data();
+  MockClient client;
+  AccountingFilter<ChunkingFilter<MockClient*>> accounting(
+    g_ceph_context, ChunkingFilter<MockClient*>(&client));
+
+  // not accounted yet
+  accounting.send_body_bl(data);
+  EXPECT_EQ(0u, accounting.get_bytes_sent());
+  const auto before = client.sent;
+
+  accounting.set_account(true);
+  accounting.send_status(200, "OK");
+  accounting.send_chunked_transfer_encoding();
+  accounting.complete_header();
+  accounting.send_body_bl(data);
+  accounting.send_body(data.to_str().data(), data.length());
+  accounting.complete_request();
+
+  // the chunk framing is counted as well as the data
+  EXPECT_EQ(client.sent - before, accounting.get_bytes_sent());
+  EXPECT_GT(accounting.get_bytes_sent(), 2 * data.length());
+}
@@ -0,0 +1,107 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include "rgw/rgw_gc.h"
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+static const ceph::timespan target = 100ms;
+
+/* completes a whole window with the results of @ret, returns whether the
+ * window shrank on its last completion */
+static bool complete_window(RGWGCAioWindow& window, std::vector<int> ret)
+{
+  const size_t size = window.get();
+  bool shrunk = false;
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_FALSE(shrunk);
+    shrunk = window.complete(i < ret.size() ? ret[i] : 0, 1ms);
+  }
+  return shrunk;
+}
+
+TEST(RGWGCAioWindow, Grow)
+{
+  RGWGCAioWindow window(8, target);
+  EXPECT_EQ(8u, window.get());
+
+  // doesn't grow past the limit
+  EXPECT_FALSE(complete_window(window, {}));
+  EXPECT_EQ(8u, window.get());
+
+  EXPECT_TRUE(complete_window(window, {-EBUSY}));
+  EXPECT_EQ(4u, window.get());
+  EXPECT_FALSE(complete_window(window, {}));
+  EXPECT_EQ(5u, window.get());
+  EXPECT_FALSE(complete_window(window, {}));
+  EXPECT_EQ(6u, window.get());
+}
+
+TEST(RGWGCAioWindow, StickyPushback)
+{
+  RGWGCAioWindow window(8, target);
+
+  // a pushback early in the window shrinks it at the window's end
+  EXPECT_TRUE(complete_window(window, {0, -EAGAIN}));
+  EXPECT_EQ(4u, window.get());
+
+  // only once per window, however many ios were pushed back
+  EXPECT_TRUE(complete_window(window, {-ETIMEDOUT, -EBUSY, -EAGAIN, -EBUSY}));
+  EXPECT_EQ(2u, window.get());
+
+  // slow ios push back too
+  EXPECT_FALSE(window.complete(0, 200ms));
+  EXPECT_TRUE(window.complete(0, 1ms));
+  EXPECT_EQ(1u, window.get());
+
+  // down to one io at a time
+  EXPECT_TRUE(window.complete(-EBUSY, 1ms));
+  EXPECT_EQ(1u, window.get());
+}
+
+TEST(RGWGCAioWindow, ResetPerWindow)
+{
+  RGWGCAioWindow window(4, target);
+  EXPECT_TRUE(complete_window(window, {-EBUSY}));
+  EXPECT_EQ(2u, window.get());
+
+  // the pushback of the last window doesn't carry over
+  EXPECT_FALSE(complete_window(window, {}));
+  EXPECT_EQ(3u, window.get());
+
+  // nor do its completions, the next window takes 3 more
+  EXPECT_FALSE(window.complete(0, 1ms));
+  EXPECT_FALSE(window.complete(0, 1ms));
+  EXPECT_EQ(3u, window.get());
+  EXPECT_FALSE(window.complete(0, 1ms));
+  EXPECT_EQ(4u, window.get());
+}
+
+TEST(RGWGCAioWindow, OtherErrors)
+{
+  RGWGCAioWindow window(4, target);
+  EXPECT_TRUE(complete_window(window, {-EBUSY}));
+  EXPECT_EQ(2u, window.get());
+
+  // the osds didn't push back on missing objects
+  EXPECT_FALSE(complete_window(window, {-ENOENT, -EIO}));
+  EXPECT_EQ(3u, window.get());
+
+  // no latency target
+  RGWGCAioWindow untimed(4, ceph::timespan::zero());
+  EXPECT_FALSE(untimed.complete(0, 10s));
+  EXPECT_FALSE(untimed.complete(0, 10s));
+  EXPECT_FALSE(untimed.complete(0, 10s));
+  EXPECT_FALSE(untimed.complete(0, 10s));
+  EXPECT_EQ(4u, untimed.get());
+}
@@ -0,0 +1,81 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include "rgw/rgw_rados.h"
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+static constexpr uint64_t MB = 1024 * 1024;
+
+TEST(RGWGetObjWindow, NoLatency)
+{
+  const auto start = ceph::mono_clock::now();
+  RGWGetObjWindow window(4 * MB, 64 * MB, start);
+  EXPECT_EQ(4 * MB, window.get());
+
+  // nothing to go on before a read completes
+  window.add_delivered(100 * MB);
+  EXPECT_FALSE(window.adapt(start + 1s));
+  EXPECT_EQ(4 * MB, window.get());
+}
+
+TEST(RGWGetObjWindow, FollowsRate)
+{
+  const auto start = ceph::mono_clock::now();
+  RGWGetObjWindow window(4 * MB, 64 * MB, start);
+  window.add_latency(100ms);
+
+  // 100MB/s for 100ms, twice
+  window.add_delivered(100 * MB);
+  ASSERT_TRUE(window.adapt(start + 1s));
+  EXPECT_NEAR(20 * MB, window.get(), 1);
+  EXPECT_FALSE(window.adapt(start + 1s));
+
+  // the client slows down
+  ASSERT_TRUE(window.adapt(start + 2s));
+  EXPECT_NEAR(10 * MB, window.get(), 1);
+
+  // the latency is a moving average
+  window.add_latency(900ms);
+  ASSERT_TRUE(window.adapt(start + 2s));
+  EXPECT_NEAR(20 * MB, window.get(), 1);
+}
+
+TEST(RGWGetObjWindow, Bounds)
+{
+  const auto start = ceph::mono_clock::now();
+  RGWGetObjWindow window(4 * MB, 64 * MB, start);
+  window.add_latency(100ms);
+
+  window.add_delivered(1000 * MB);
+  ASSERT_TRUE(window.adapt(start + 1s));
+  EXPECT_EQ(64 * MB, window.get());
+
+  ASSERT_TRUE(window.adapt(start + 1000s));
+  EXPECT_EQ(4 * MB, window.get());
+
+  // no time elapsed
+  EXPECT_FALSE(window.adapt(start));
+  EXPECT_EQ(4 * MB, window.get());
+}
+
+TEST(RGWGetObjWindow, Fixed)
+{
+  const auto start = ceph::mono_clock::now();
+  // a max below the min leaves the window fixed
+  RGWGetObjWindow window(16 * MB, 4 * MB, start);
+  window.add_latency(100ms);
+  window.add_delivered(1000 * MB);
+  EXPECT_FALSE(window.adapt(start + 1s));
+  EXPECT_EQ(16 * MB, window.get());
+}
@@ -0,0 +1,56 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include "rgw/rgw_lc.h"
+#include <gtest/gtest.h>
+
+TEST(LCResumeMarker, Unversioned)
+{
+  LCResumeMarker resume{rgw_obj_key()};
+  resume.next(rgw_obj_key("a"));
+  // stopping before the first entry starts over
+  EXPECT_EQ(rgw_obj_key(), resume.get());
+  resume.next(rgw_obj_key("b"));
+  EXPECT_EQ(rgw_obj_key("a"), resume.get());
+  resume.next(rgw_obj_key("c"));
+  EXPECT_EQ(rgw_obj_key("b"), resume.get());
+}
+
+TEST(LCResumeMarker, Versioned)
+{
+  LCResumeMarker resume{rgw_obj_key()};
+  resume.next(rgw_obj_key("a", "v2"));
+  resume.next(rgw_obj_key("a", "v1"));
+  EXPECT_EQ(rgw_obj_key(), resume.get());
+  // stopping at any version of b resumes at the first one
+  resume.next(rgw_obj_key("b", "v3"));
+  EXPECT_EQ(rgw_obj_key("a", "v1"), resume.get());
+  resume.next(rgw_obj_key("b", "v2"));
+  EXPECT_EQ(rgw_obj_key("a", "v1"), resume.get());
+  resume.next(rgw_obj_key("b", "v1"));
+  EXPECT_EQ(rgw_obj_key("a", "v1"), resume.get());
+  resume.next(rgw_obj_key("c"));
+  EXPECT_EQ(rgw_obj_key("b", "v1"), resume.get());
+}
+
+TEST(LCResumeMarker, Resumed)
+{
+  // a resumed listing starts after the marker it was given
+  const rgw_obj_key start("a", "v1");
+  LCResumeMarker resume{start};
+  resume.next(rgw_obj_key("b", "v2"));
+  EXPECT_EQ(start, resume.get());
+  resume.next(rgw_obj_key("b", "v1"));
+  EXPECT_EQ(start, resume.get());
+  resume.next(rgw_obj_key("c", "v1"));
+  EXPECT_EQ(rgw_obj_key("b", "v1"), resume.get());
+}
@@ -0,0 +1,199 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include "rgw/rgw_mb_hash.h"
+#include <atomic>
+#include <random>
+#include <thread>
+#include <boost/asio/io_context.hpp>
+#include <spawn/spawn.hpp>
+#include <gtest/gtest.h>
+
+using namespace rgw::mb_hash;
+
+static std::string random_data(std::mt19937& rng, size_t len)
+{
+  std::string data(len, 0);
+  for (auto& c : data) {
+    c = rng();
+  }
+  return data;
+}
+
+// hashes 'data' through the stream in pieces of random size
+template <typename Stream>
+static std::string hash_pieces(Stream& stream, const std::string& data,
+                               std::mt19937& rng, size_t max_piece)
+{
+  size_t pos = 0;
+  while (pos < data.size()) {
+    const size_t n = std::min<size_t>(data.size() - pos, rng() % max_piece);
+    stream.Update(reinterpret_cast<const unsigned char*>(data.data() + pos), n);
+    pos += n;
+  }
+  unsigned char digest[Stream::digest_size];
+  stream.Final(digest);
+  return std::string(reinterpret_cast<char*>(digest), sizeof(digest));
+}
+
+template <typename Expected>
+static std::string expected_hash(const std::string& data)
+{
+  Expected hash;
+  hash.Update(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+  unsigned char digest[Expected::digest_size];
+  hash.Final(digest);
+  return std::string(reinterpret_cast<char*>(digest), sizeof(digest));
+}
+
+template <typename Alg, typename Expected>
+static void test_lengths()
+{
+  Service<Alg> service;
+  Digest<Alg, Expected> digest(&service);
+  std::mt19937 rng(0);
+  // every length around the padding boundaries of the first blocks
+  for (size_t len = 0; len < 5 * BLOCK_SIZE; len++) {
+    const auto data = random_data(rng, len);
+    digest.Restart();
+    EXPECT_EQ(expected_hash<Expected>(data),
+              hash_pieces(digest, data, rng, BLOCK_SIZE * 3)) << "len=" << len;
+  }
+}
+
+TEST(MBHash, MD5Lengths)
+{
+  test_lengths<MD5Alg, ceph::crypto::MD5>();
+}
+
+TEST(MBHash, SHA256Lengths)
+{
+  test_lengths<SHA256Alg, ceph::crypto::SHA256>();
+}
+
+template <typename Alg, typename Expected>
+static void test_lanes()
+{
+  std::mt19937 rng(0);
+  const size_t blocks = 5;
+  std::string data[LANES];
+  State states[LANES];
+  State* state_ptrs[LANES];
+  const unsigned char* data_ptrs[LANES];
+  for (size_t l = 0; l < LANES; l++) {
+    data[l] = random_data(rng, blocks * BLOCK_SIZE);
+    Alg::init(states[l]);
+    state_ptrs[l] = &states[l];
+    data_ptrs[l] = reinterpret_cast<const unsigned char*>(data[l].data());
+  }
+  Alg::compress_lanes(state_ptrs, data_ptrs, blocks);
+  for (size_t l = 0; l < LANES; l++) {
+    State expected;
+    Alg::init(expected);
+    Alg::compress(expected, data_ptrs[l], blocks);
+    EXPECT_EQ(expected, states[l]) << "lane " << l;
+  }
+}
+
+TEST(MBHash, MD5Lanes)
+{
+  test_lanes<MD5Alg, ceph::crypto::MD5>();
+}
+
+TEST(MBHash, SHA256Lanes)
+{
+  test_lanes<SHA256Alg, ceph::crypto::SHA256>();
+}
+
+template <typename Alg, typename Expected>
+static void test_concurrent()
+{
+  Service<Alg> service;
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches = 0;
+  for (int t = 0; t < 16; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < 20; i++) {
+        const auto data = random_data(rng, rng() % (256 << 10));
+        Digest<Alg, Expected> digest(&service);
+        if (expected_hash<Expected>(data) !=
+            hash_pieces(digest, data, rng, 16 << 10)) {
+          ++mismatches;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(0, mismatches);
+}
+
+TEST(MBHash, MD5Concurrent)
+{
+  test_concurrent<MD5Alg, ceph::crypto::MD5>();
+}
+
+TEST(MBHash, SHA256Concurrent)
+{
+  test_concurrent<SHA256Alg, ceph::crypto::SHA256>();
+}
+
+// streams of coroutines, several on each thread. a coroutine whose stream
+// is hashed by another thread is suspended, and lets the others on its
+// thread submit theirs
+template <typename Alg, typename Expected>
+static void test_yield()
+{
+  Service<Alg> service;
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches = 0;
+  std::atomic<int> finished = 0;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      boost::asio::io_context context;
+      for (int c = 0; c < 4; c++) {
+        spawn::spawn(context,
+          [&, seed = t * 4 + c] (spawn::yield_context yield) {
+            optional_yield y{context, yield};
+            std::mt19937 rng(seed);
+            for (int i = 0; i < 10; i++) {
+              const auto data = random_data(rng, rng() % (256 << 10));
+              Digest<Alg, Expected> digest(&service, y);
+              if (expected_hash<Expected>(data) !=
+                  hash_pieces(digest, data, rng, 16 << 10)) {
+                ++mismatches;
+              }
+            }
+            ++finished;
+          });
+      }
+      context.run();
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(0, mismatches);
+  EXPECT_EQ(16, finished);
+}
+
+TEST(MBHash, MD5Yield)
+{
+  test_yield<MD5Alg, ceph::crypto::MD5>();
+}
+
+TEST(MBHash, SHA256Yield)
+{
+  test_yield<SHA256Alg, ceph::crypto::SHA256>();
+}
@@ -13,6 +13,10 @@
  */
 
 #include "rgw/rgw_putobj.h"
+#include "rgw/rgw_putobj_pipeline.h"
+#include <thread>
+#include <boost/asio/steady_timer.hpp>
+#include <spawn/spawn.hpp>
 #include <gtest/gtest.h>
 
 inline bufferlist string_buf(const char* buf) {
@@ -194,3 +198,138 @@ TEST(PutObj_Stripe, SkipFirstChunk)
   ASSERT_EQ(4u, mock.ops.size());
   EXPECT_EQ(Op({"", 4}), mock.ops[3]); // flush
 }
+
+// reverses its input, slower for earlier chunks so they finish out of order
+static int reverse_work(bufferlist& in, bufferlist& out) {
+  const auto str = in.to_str();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10 - str.size()));
+  out.append(std::string(str.rbegin(), str.rend()));
+  return 0;
+}
+
+static void test_parallel_stage(boost::asio::thread_pool* pool, size_t window,
+                                optional_yield y = null_yield)
+{
+  MockProcessor mock;
+  rgw::putobj::ParallelStage stage(pool, window, y);
+  auto done = [&mock] (int r, bufferlist&& in, bufferlist&& out,
+                       uint64_t offset) {
+    if (r < 0) {
+      return r;
+    }
+    return mock.process(std::move(out), offset);
+  };
+  ASSERT_EQ(0, stage.submit(string_buf("1"), 0, reverse_work, done));
+  ASSERT_EQ(0, stage.submit(string_buf("22"), 1, reverse_work, done));
+  ASSERT_EQ(0, stage.submit(string_buf("123"), 3, reverse_work, done));
+  ASSERT_EQ(0, stage.submit(string_buf("1234"), 6, reverse_work, done));
+  ASSERT_EQ(0, stage.drain());
+  ASSERT_EQ(4u, mock.ops.size());
+  EXPECT_EQ(Op({"1", 0}), mock.ops[0]);
+  EXPECT_EQ(Op({"22", 1}), mock.ops[1]);
+  EXPECT_EQ(Op({"321", 3}), mock.ops[2]);
+  EXPECT_EQ(Op({"4321", 6}), mock.ops[3]);
+}
+
+TEST(PutObj_ParallelStage, Inline)
+{
+  test_parallel_stage(nullptr, 1);
+}
+
+TEST(PutObj_ParallelStage, Ordered)
+{
+  boost::asio::thread_pool pool(4);
+  test_parallel_stage(&pool, 1);
+  test_parallel_stage(&pool, 3);
+  test_parallel_stage(&pool, 8);
+  pool.join();
+}
+
+TEST(PutObj_ParallelStage, Error)
+{
+  boost::asio::thread_pool pool(4);
+  MockProcessor mock;
+  rgw::putobj::ParallelStage stage(&pool, 4);
+  auto done = [&mock] (int r, bufferlist&& in, bufferlist&& out,
+                       uint64_t offset) {
+    if (r < 0) {
+      return r;
+    }
+    return mock.process(std::move(out), offset);
+  };
+  auto fail = [] (bufferlist& in, bufferlist& out) { return -EIO; };
+  ASSERT_EQ(0, stage.submit(string_buf("1"), 0, reverse_work, done));
+  stage.submit(string_buf("22"), 1, fail, done);
+  stage.submit(string_buf("123"), 3, reverse_work, done);
+  ASSERT_EQ(-EIO, stage.drain());
+  // nothing past the failed chunk is passed on
+  ASSERT_EQ(1u, mock.ops.size());
+  EXPECT_EQ(Op({"1", 0}), mock.ops[0]);
+  ASSERT_EQ(-EIO, stage.submit(string_buf("1234"), 6, reverse_work, done));
+  ASSERT_EQ(1u, mock.ops.size());
+  pool.join();
+}
+
+TEST(PutObj_OffloadedMD5, MatchesInline)
+{
+  boost::asio::thread_pool pool(4);
+  ceph::crypto::MD5 expected;
+  rgw::putobj::OffloadedMD5 inline_hash(nullptr, 1);
+  rgw::putobj::OffloadedMD5 offloaded(&pool, 2);
+  for (int i = 0; i < 64; i++) {
+    bufferlist bl;
+    bl.append(std::string(1000 + i, 'a' + i % 26));
+    bl.append(std::string(i, 'z'));
+    expected.Update((const unsigned char*)bl.c_str(), bl.length());
+    inline_hash.Update(bl);
+    offloaded.Update(bl);
+  }
+  unsigned char m1[CEPH_CRYPTO_MD5_DIGESTSIZE];
+  unsigned char m2[CEPH_CRYPTO_MD5_DIGESTSIZE];
+  unsigned char m3[CEPH_CRYPTO_MD5_DIGESTSIZE];
+  expected.Final(m1);
+  inline_hash.Final(m2);
+  offloaded.Final(m3);
+  EXPECT_EQ(0, memcmp(m1, m2, sizeof(m1)));
+  EXPECT_EQ(0, memcmp(m1, m3, sizeof(m1)));
+  pool.join();
+}
+
+TEST(PutObj_ParallelStage, Yield)
+{
+  boost::asio::thread_pool pool(4);
+  boost::asio::io_context context;
+  bool finished = false;
+  int ticks = 0; // while the stage waited
+  spawn::spawn(context,
+    [&] (spawn::yield_context yield) {
+      optional_yield y{context, yield};
+      test_parallel_stage(&pool, 1, y);
+      test_parallel_stage(&pool, 3, y);
+
+      rgw::putobj::OffloadedMD5 offloaded(&pool, 1, y);
+      for (int i = 0; i < 16; i++) {
+        bufferlist bl;
+        bl.append(std::string(1000 + i, 'a' + i));
+        offloaded.Update(bl);
+      }
+      unsigned char m[CEPH_CRYPTO_MD5_DIGESTSIZE];
+      offloaded.Final(m);
+      finished = true;
+    });
+  // runs on the same thread, only when the coroutine above is suspended
+  spawn::spawn(context,
+    [&] (spawn::yield_context yield) {
+      boost::asio::steady_timer timer(context);
+      while (!finished) {
+        ++ticks;
+        boost::system::error_code ec;
+        timer.expires_after(std::chrono::milliseconds(1));
+        timer.async_wait(yield[ec]);
+      }
+    });
+  context.run();
+  EXPECT_TRUE(finished);
+  EXPECT_LT(1, ticks);
+  pool.join();
+}
@@ -0,0 +1,89 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include "rgw/rgw_stripe_cache.h"
+#include <gtest/gtest.h>
+
+static bufferlist make_data(char c, size_t len)
+{
+  bufferlist bl;
+  bl.append(std::string(len, c));
+  return bl;
+}
+
+TEST(RGWStripeCache, Disabled)
+{
+  RGWStripeCache cache;
+  EXPECT_FALSE(cache.enabled());
+  const rgw_raw_obj obj{rgw_pool("data"), "tail.1"};
+  cache.put(obj, 0, make_data('a', 16));
+  bufferlist bl;
+  EXPECT_FALSE(cache.get(obj, 0, 16, bl));
+  EXPECT_EQ(0u, cache.get_size());
+}
+
+TEST(RGWStripeCache, Ranges)
+{
+  RGWStripeCache cache;
+  cache.set_max_size(1024);
+  const rgw_raw_obj obj{rgw_pool("data"), "tail.1"};
+  const rgw_raw_obj other{rgw_pool("data"), "tail.2"};
+
+  bufferlist data = make_data('a', 64);
+  data.append(make_data('b', 64));
+  cache.put(obj, 128, data);
+
+  bufferlist bl;
+  ASSERT_TRUE(cache.get(obj, 128, 128, bl));
+  EXPECT_TRUE(bl.contents_equal(data));
+
+  // a range inside the cached one
+  bl.clear();
+  ASSERT_TRUE(cache.get(obj, 160, 64, bl));
+  EXPECT_EQ(std::string(32, 'a') + std::string(32, 'b'), bl.to_str());
+
+  // ranges reaching out of it
+  bl.clear();
+  EXPECT_FALSE(cache.get(obj, 64, 128, bl));
+  EXPECT_FALSE(cache.get(obj, 192, 128, bl));
+  EXPECT_FALSE(cache.get(obj, 256, 1, bl));
+  EXPECT_FALSE(cache.get(other, 128, 1, bl));
+}
+
+TEST(RGWStripeCache, LRU)
+{
+  RGWStripeCache cache;
+  cache.set_max_size(300);
+  const rgw_raw_obj obj{rgw_pool("data"), "tail.1"};
+
+  cache.put(obj, 0, make_data('a', 100));
+  cache.put(obj, 100, make_data('b', 100));
+  cache.put(obj, 200, make_data('c', 100));
+  EXPECT_EQ(300u, cache.get_size());
+
+  // the first one becomes the most recently used
+  bufferlist bl;
+  ASSERT_TRUE(cache.get(obj, 0, 100, bl));
+
+  cache.put(obj, 300, make_data('d', 100));
+  EXPECT_EQ(300u, cache.get_size());
+  EXPECT_TRUE(cache.get(obj, 0, 100, bl));
+  EXPECT_FALSE(cache.get(obj, 100, 100, bl));
+  EXPECT_TRUE(cache.get(obj, 300, 100, bl));
+
+  // more than the whole cache isn't kept
+  cache.put(obj, 1000, make_data('e', 400));
+  EXPECT_FALSE(cache.get(obj, 1000, 1, bl));
+
+  cache.set_max_size(100);
+  EXPECT_LE(cache.get_size(), 100u);
+}
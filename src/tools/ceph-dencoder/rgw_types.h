@@ -46,6 +46,7 @@ TYPE(rgw_usage_log_entry)
 #include "cls/rgw/cls_rgw_ops.h"
 TYPE(rgw_cls_obj_prepare_op)
 TYPE(rgw_cls_obj_complete_op)
+TYPE(rgw_cls_obj_complete_ops_op)
 TYPE(rgw_cls_list_op)
 TYPE(rgw_cls_list_ret)
 TYPE(cls_rgw_gc_defer_entry_op)
@@ -75,6 +76,8 @@ TYPE(cls_rgw_reshard_get_ret)
 TYPE(cls_rgw_reshard_remove_op)
 TYPE(cls_rgw_set_bucket_resharding_op)
 TYPE(cls_rgw_clear_bucket_resharding_op)
+TYPE(cls_rgw_reshard_log_list_op)
+TYPE(cls_rgw_reshard_log_list_ret)
 TYPE(cls_rgw_lc_obj_head)
 
 #include "cls/rgw/cls_rgw_client.h"
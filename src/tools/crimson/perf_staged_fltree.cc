@@ -27,9 +27,10 @@ class PerfTree : public TMTestState {
  public:
   PerfTree(bool is_dummy) : is_dummy{is_dummy} {}
 
-  seastar::future<> run(KVPool<test_item_t>& kvs, double erase_ratio) {
-    return tm_setup().then([this, &kvs, erase_ratio] {
-      return seastar::async([this, &kvs, erase_ratio] {
+  seastar::future<> run(KVPool<test_item_t>& kvs, double erase_ratio,
+                        const std::string& insert_order) {
+    return tm_setup().then([this, &kvs, erase_ratio, &insert_order] {
+      return seastar::async([this, &kvs, erase_ratio, &insert_order] {
         auto tree = std::make_unique<TreeBuilder<TRACK, ExtendedValue>>(kvs,
             (is_dummy ? NodeExtentManager::create_dummy(true)
                       : NodeExtentManager::create_seastore(*tm)));
@@ -41,7 +42,11 @@ class PerfTree : public TMTestState {
         }
         {
           auto t = tm->create_transaction();
-          tree->insert(*t).unsafe_get();
+          if (insert_order == "random") {
+            tree->insert(*t).unsafe_get();
+          } else {
+            tree->insert_sorted(*t, insert_order == "sorted-hint").unsafe_get();
+          }
           auto start_time = mono_clock::now();
           tm->submit_transaction(std::move(t)).unsafe_get();
           segment_cleaner->run_until_halt().get0();
@@ -100,6 +105,12 @@ seastar::future<> run(const bpo::variables_map& config) {
     auto erase_ratio = config["erase-ratio"].as<double>();
     ceph_assert(erase_ratio >= 0);
     ceph_assert(erase_ratio <= 1);
+    auto insert_order = config["insert-order"].as<std::string>();
+    if (insert_order != "random" &&
+        insert_order != "sorted" &&
+        insert_order != "sorted-hint") {
+      ceph_abort(false && "invalid insert-order");
+    }
 
     using crimson::common::sharded_conf;
     sharded_conf().start(EntityName{}, string_view{"ceph"}).get();
@@ -119,7 +130,7 @@ seastar::future<> run(const bpo::variables_map& config) {
         {range1[0], range1[1]},
         {range0[0], range0[1]});
     PerfTree<TRACK> perf{is_dummy};
-    perf.run(kvs, erase_ratio).get0();
+    perf.run(kvs, erase_ratio, insert_order).get0();
   });
 }
 
@@ -152,7 +163,10 @@ int main(int argc, char** argv)
      "range of snap-gen [a, b)")
     ("erase-ratio", bpo::value<double>()->default_value(
         0.8),
-     "erase-ratio of all the inserted onodes");
+     "erase-ratio of all the inserted onodes")
+    ("insert-order", bpo::value<std::string>()->default_value("random"),
+     "order of inserted onodes: random, sorted, sorted-hint "
+     "(sorted, each insert appending after the previous cursor)");
   return app.run(argc, argv, [&app] {
     auto&& config = app.configuration();
     auto tracked = config["tracked"].as<bool>();